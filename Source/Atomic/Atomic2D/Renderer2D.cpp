@@ -325,20 +325,6 @@ SharedPtr<Material> Renderer2D::CreateMaterial(Texture2D* texture, BlendMode ble
     return newMaterial;
 }
 
-void CheckDrawableVisibilityWork(const WorkItem* item, unsigned threadIndex)
-{
-    Renderer2D* renderer = reinterpret_cast<Renderer2D*>(item->aux_);
-    Drawable2D** start = reinterpret_cast<Drawable2D**>(item->start_);
-    Drawable2D** end = reinterpret_cast<Drawable2D**>(item->end_);
-
-    while (start != end)
-    {
-        Drawable2D* drawable = *start++;
-        if (renderer->CheckVisibility(drawable))
-            drawable->MarkInView(renderer->frame_);
-    }
-}
-
 void Renderer2D::HandleBeginViewUpdate(StringHash eventType, VariantMap& eventData)
 {
     using namespace BeginViewUpdate;
@@ -359,30 +345,18 @@ void Renderer2D::HandleBeginViewUpdate(StringHash eventType, VariantMap& eventDa
     {
         ATOMIC_PROFILE(CheckDrawableVisibility);
 
+        // ATOMIC BEGIN
         WorkQueue* queue = GetSubsystem<WorkQueue>();
-        int numWorkItems = queue->GetNumThreads() + 1; // Worker threads + main thread
-        int drawablesPerItem = drawables_.Size() / numWorkItems;
-
-        PODVector<Drawable2D*>::Iterator start = drawables_.Begin();
-        for (int i = 0; i < numWorkItems; ++i)
+        queue->ParallelFor(0, drawables_.Size(), 0, [this](unsigned begin, unsigned end, unsigned threadIndex)
         {
-            SharedPtr<WorkItem> item = queue->GetFreeItem();
-            item->priority_ = M_MAX_UNSIGNED;
-            item->workFunction_ = CheckDrawableVisibilityWork;
-            item->aux_ = this;
-
-            PODVector<Drawable2D*>::Iterator end = drawables_.End();
-            if (i < numWorkItems - 1 && end - start > drawablesPerItem)
-                end = start + drawablesPerItem;
-
-            item->start_ = &(*start);
-            item->end_ = &(*end);
-            queue->AddWorkItem(item);
-
-            start = end;
-        }
-
-        queue->Complete(M_MAX_UNSIGNED);
+            for (unsigned i = begin; i < end; ++i)
+            {
+                Drawable2D* drawable = drawables_[i];
+                if (CheckVisibility(drawable))
+                    drawable->MarkInView(frame_);
+            }
+        });
+        // ATOMIC END
     }
 
     ViewBatchInfo2D& viewBatchInfo = viewBatchInfos_[camera];
@@ -69,8 +69,6 @@ class ATOMIC_API Renderer2D : public Drawable
 {
     ATOMIC_OBJECT(Renderer2D, Drawable);
 
-    friend void CheckDrawableVisibilityWork(const WorkItem* item, unsigned threadIndex);
-
 public:
     /// Construct.
     Renderer2D(Context* context);
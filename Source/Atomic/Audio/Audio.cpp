@@ -31,6 +31,9 @@
 #include "../Core/ProcessUtils.h"
 #include "../Core/Profiler.h"
 #include "../IO/Log.h"
+// ATOMIC BEGIN
+#include "../Metrics/FrameStatistics.h"
+// ATOMIC END
 
 // ATOMIC BEGIN
 #include <SDL/include/SDL.h>
@@ -282,6 +285,10 @@ void SDLAudioCallback(void* userdata, Uint8* stream, int len)
 
 void Audio::MixOutput(void* dest, unsigned samples)
 {
+    // ATOMIC BEGIN
+    ATOMIC_FRAMESTAT(STAT_AUDIOMIX);
+    // ATOMIC END
+
     if (!playing_ || !clipBuffer_)
     {
         memset(dest, 0, samples * sampleSize_ * SAMPLE_SIZE_MUL);
@@ -0,0 +1,108 @@
+//
+// Copyright (c) 2014-2017 THUNDERBEAST GAMES LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../Precompiled.h"
+
+#include "../Container/FrameAllocator.h"
+
+#ifdef ATOMIC_ALLOCATION_COUNTER
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#endif
+
+// This file replaces the global operator new and delete when built with ATOMIC_ALLOCATION_COUNTER, so it must not include
+// DebugNew.h. The replacements live in the same compilation unit as FrameAllocator::GetTotalHeapAllocations() to ensure they
+// are linked in from the static library.
+
+#ifdef ATOMIC_ALLOCATION_COUNTER
+
+/// Number of heap allocations made through operator new.
+static std::atomic<unsigned long long> numHeapAllocations(0);
+
+static void* CountedAllocate(size_t size)
+{
+    numHeapAllocations.fetch_add(1, std::memory_order_relaxed);
+    void* ptr = malloc(size ? size : 1);
+    if (!ptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+void* operator new(size_t size)
+{
+    return CountedAllocate(size);
+}
+
+void* operator new[](size_t size)
+{
+    return CountedAllocate(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    numHeapAllocations.fetch_add(1, std::memory_order_relaxed);
+    return malloc(size ? size : 1);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    numHeapAllocations.fetch_add(1, std::memory_order_relaxed);
+    return malloc(size ? size : 1);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept
+{
+    free(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept
+{
+    free(ptr);
+}
+
+#endif
+
+namespace Atomic
+{
+
+unsigned long long FrameAllocator::GetTotalHeapAllocations()
+{
+#ifdef ATOMIC_ALLOCATION_COUNTER
+    return numHeapAllocations.load(std::memory_order_relaxed);
+#else
+    return 0;
+#endif
+}
+
+}
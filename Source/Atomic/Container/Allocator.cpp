@@ -22,6 +22,13 @@
 
 #include "../Precompiled.h"
 
+// ATOMIC BEGIN
+#include "../Container/Vector.h"
+
+#include <atomic>
+#include <mutex>
+// ATOMIC END
+
 #include "../DebugNew.h"
 
 namespace Atomic
@@ -119,4 +126,320 @@ void AllocatorFree(AllocatorBlock* allocator, void* ptr)
     allocator->free_ = node;
 }
 
+// ATOMIC BEGIN
+
+/// Maximum number of memory blocks in a concurrent allocator. Block sizes double, so this is never the limiting factor.
+static const unsigned CONCURRENT_ALLOCATOR_MAX_BLOCKS = 32;
+/// Number of nodes exchanged between a thread cache and the global free list at once.
+static const unsigned CONCURRENT_ALLOCATOR_BATCH = 32;
+/// Maximum number of nodes in a thread cache before a batch is returned to the global free list.
+static const unsigned CONCURRENT_ALLOCATOR_MAX_CACHED = CONCURRENT_ALLOCATOR_BATCH * 2;
+
+/// Concurrent allocator node header. Data follows.
+struct ConcurrentAllocatorNode
+{
+    /// Node index within the allocator.
+    unsigned index_;
+    /// Next free node index + 1, or 0 for none.
+    std::atomic<unsigned> next_;
+};
+
+/// Concurrent allocator. Nodes are addressed by 32-bit index, so that the global free list head can hold an index and an ABA tag in one 64-bit word. Block k holds baseCapacity_ << k nodes.
+struct ConcurrentAllocatorPool
+{
+    /// Return node by index.
+    ConcurrentAllocatorNode* GetNode(unsigned index) const
+    {
+        unsigned blockIndex = 0;
+        unsigned blockStart = 0;
+        unsigned blockCapacity = baseCapacity_;
+        while (index - blockStart >= blockCapacity)
+        {
+            blockStart += blockCapacity;
+            blockCapacity <<= 1;
+            ++blockIndex;
+        }
+        unsigned char* block = blocks_[blockIndex].load(std::memory_order_acquire);
+        return reinterpret_cast<ConcurrentAllocatorNode*>(block + (index - blockStart) * stride_);
+    }
+
+    /// ID for indexing the thread caches. Reused after the allocator is uninitialized.
+    unsigned id_;
+    /// Unique instance tag, which tells a thread cache left over from a previous allocator with the same ID.
+    unsigned tag_;
+    /// Size of a node including the header.
+    unsigned stride_;
+    /// Number of nodes in the first block.
+    unsigned baseCapacity_;
+    /// Global free list head: ABA tag in the high 32 bits, first free node index + 1 in the low 32 bits.
+    std::atomic<unsigned long long> freeHead_;
+    /// Number of blocks claimed.
+    std::atomic<unsigned> numBlocks_;
+    /// Memory blocks.
+    std::atomic<unsigned char*> blocks_[CONCURRENT_ALLOCATOR_MAX_BLOCKS];
+};
+
+/// Per-thread cache of free nodes for one allocator.
+struct ConcurrentAllocatorCache
+{
+    /// First cached node index + 1, or 0 for none.
+    unsigned head_;
+    /// Number of cached nodes.
+    unsigned count_;
+    /// Tag of the allocator the cache belongs to.
+    unsigned tag_;
+};
+
+/// Mutex for the concurrent allocator ID bookkeeping.
+static std::mutex concurrentAllocatorIDMutex;
+/// Next unused concurrent allocator ID.
+static unsigned nextConcurrentAllocatorID = 0;
+/// IDs of uninitialized concurrent allocators available for reuse, so that the thread cache vectors stay as small as the number of live allocators.
+static PODVector<unsigned> freeConcurrentAllocatorIDs;
+/// Next concurrent allocator instance tag. Zero is never used, so that a zero-initialized cache never matches.
+static std::atomic<unsigned> nextConcurrentAllocatorTag(1);
+/// Live concurrent allocators indexed by ID, or null for an unused ID. Guarded by concurrentAllocatorIDMutex.
+static PODVector<ConcurrentAllocatorPool*> concurrentAllocators;
+
+static void ConcurrentAllocatorPushChain(ConcurrentAllocatorPool* allocator, ConcurrentAllocatorNode* first, ConcurrentAllocatorNode* last);
+
+/// Free node caches of one thread, indexed by allocator ID. Returns the cached nodes to the global free lists when the thread exits.
+struct ConcurrentAllocatorThreadCaches
+{
+    /// Destruct. Flush the caches of allocators that are still alive.
+    ~ConcurrentAllocatorThreadCaches()
+    {
+        // Hold the ID mutex so that the allocator can not be uninitialized during the flush
+        std::lock_guard<std::mutex> lock(concurrentAllocatorIDMutex);
+        for (unsigned i = 0; i < caches_.Size() && i < concurrentAllocators.Size(); ++i)
+        {
+            ConcurrentAllocatorCache& cache = caches_[i];
+            ConcurrentAllocatorPool* allocator = concurrentAllocators[i];
+            if (!cache.head_ || !allocator || allocator->tag_ != cache.tag_)
+                continue;
+
+            ConcurrentAllocatorNode* first = allocator->GetNode(cache.head_ - 1);
+            ConcurrentAllocatorNode* last = first;
+            for (unsigned j = 1; j < cache.count_; ++j)
+                last = allocator->GetNode(last->next_.load(std::memory_order_relaxed) - 1);
+            ConcurrentAllocatorPushChain(allocator, first, last);
+        }
+    }
+
+    /// Caches.
+    PODVector<ConcurrentAllocatorCache> caches_;
+};
+
+/// Free node caches of the calling thread.
+static thread_local ConcurrentAllocatorThreadCaches concurrentAllocatorThreadCaches;
+
+static ConcurrentAllocatorCache& GetConcurrentAllocatorCache(ConcurrentAllocatorPool* allocator)
+{
+    PODVector<ConcurrentAllocatorCache>& concurrentAllocatorCaches = concurrentAllocatorThreadCaches.caches_;
+    if (allocator->id_ >= concurrentAllocatorCaches.Size())
+    {
+        unsigned oldSize = concurrentAllocatorCaches.Size();
+        concurrentAllocatorCaches.Resize(allocator->id_ + 1);
+        for (unsigned i = oldSize; i < concurrentAllocatorCaches.Size(); ++i)
+        {
+            concurrentAllocatorCaches[i].head_ = 0;
+            concurrentAllocatorCaches[i].count_ = 0;
+            concurrentAllocatorCaches[i].tag_ = 0;
+        }
+    }
+
+    // Discard nodes cached for a previous allocator with the same ID; its memory has already been freed
+    ConcurrentAllocatorCache& cache = concurrentAllocatorCaches[allocator->id_];
+    if (cache.tag_ != allocator->tag_)
+    {
+        cache.head_ = 0;
+        cache.count_ = 0;
+        cache.tag_ = allocator->tag_;
+    }
+
+    return cache;
+}
+
+/// Push a chain of nodes linked through next_ to the global free list.
+static void ConcurrentAllocatorPushChain(ConcurrentAllocatorPool* allocator, ConcurrentAllocatorNode* first, ConcurrentAllocatorNode* last)
+{
+    unsigned long long head = allocator->freeHead_.load(std::memory_order_relaxed);
+    unsigned long long newHead;
+    do
+    {
+        last->next_.store((unsigned)head, std::memory_order_relaxed);
+        newHead = (((head >> 32) + 1) << 32) | (first->index_ + 1);
+    }
+    while (!allocator->freeHead_.compare_exchange_weak(head, newHead, std::memory_order_release, std::memory_order_relaxed));
+}
+
+/// Pop one node from the global free list. Return null if empty.
+static ConcurrentAllocatorNode* ConcurrentAllocatorPop(ConcurrentAllocatorPool* allocator)
+{
+    unsigned long long head = allocator->freeHead_.load(std::memory_order_acquire);
+    for (;;)
+    {
+        unsigned first = (unsigned)head;
+        if (!first)
+            return 0;
+
+        // The node may be popped and reused by another thread meanwhile; blocks are never freed so reading is safe, and the tag makes the exchange fail
+        ConcurrentAllocatorNode* node = allocator->GetNode(first - 1);
+        unsigned long long newHead = (((head >> 32) + 1) << 32) | node->next_.load(std::memory_order_relaxed);
+        if (allocator->freeHead_.compare_exchange_weak(head, newHead, std::memory_order_acquire, std::memory_order_acquire))
+            return node;
+    }
+}
+
+/// Allocate a new block. Keep a batch of its nodes in the cache and push the rest to the global free list. Return false if the maximum block count is exceeded.
+static bool ConcurrentAllocatorGrow(ConcurrentAllocatorPool* allocator, ConcurrentAllocatorCache& cache)
+{
+    unsigned blockIndex = allocator->numBlocks_.fetch_add(1, std::memory_order_relaxed);
+    if (blockIndex >= CONCURRENT_ALLOCATOR_MAX_BLOCKS || (allocator->baseCapacity_ << blockIndex) >> blockIndex != allocator->baseCapacity_)
+        return false;
+
+    unsigned capacity = allocator->baseCapacity_ << blockIndex;
+    unsigned firstIndex = allocator->baseCapacity_ * ((1u << blockIndex) - 1);
+    unsigned char* block = new unsigned char[capacity * allocator->stride_];
+    allocator->blocks_[blockIndex].store(block, std::memory_order_release);
+
+    // Link the nodes
+    for (unsigned i = 0; i < capacity; ++i)
+    {
+        ConcurrentAllocatorNode* node = reinterpret_cast<ConcurrentAllocatorNode*>(block + i * allocator->stride_);
+        node->index_ = firstIndex + i;
+        new(&node->next_) std::atomic<unsigned>(i + 1 < capacity ? firstIndex + i + 2 : 0);
+    }
+
+    unsigned numCached = capacity < CONCURRENT_ALLOCATOR_BATCH ? capacity : CONCURRENT_ALLOCATOR_BATCH;
+    ConcurrentAllocatorNode* lastCached = reinterpret_cast<ConcurrentAllocatorNode*>(block + (numCached - 1) * allocator->stride_);
+    lastCached->next_.store(cache.head_, std::memory_order_relaxed);
+    cache.head_ = firstIndex + 1;
+    cache.count_ += numCached;
+
+    if (capacity > numCached)
+    {
+        ConcurrentAllocatorNode* first = reinterpret_cast<ConcurrentAllocatorNode*>(block + numCached * allocator->stride_);
+        ConcurrentAllocatorNode* last = reinterpret_cast<ConcurrentAllocatorNode*>(block + (capacity - 1) * allocator->stride_);
+        ConcurrentAllocatorPushChain(allocator, first, last);
+    }
+
+    return true;
+}
+
+ConcurrentAllocatorPool* ConcurrentAllocatorInitialize(unsigned nodeSize, unsigned initialCapacity)
+{
+    ConcurrentAllocatorPool* allocator = new ConcurrentAllocatorPool();
+    {
+        std::lock_guard<std::mutex> lock(concurrentAllocatorIDMutex);
+        if (freeConcurrentAllocatorIDs.Size())
+        {
+            allocator->id_ = freeConcurrentAllocatorIDs.Back();
+            freeConcurrentAllocatorIDs.Pop();
+        }
+        else
+            allocator->id_ = nextConcurrentAllocatorID++;
+        if (allocator->id_ >= concurrentAllocators.Size())
+            concurrentAllocators.Resize(allocator->id_ + 1);
+        concurrentAllocators[allocator->id_] = allocator;
+    }
+    allocator->tag_ = nextConcurrentAllocatorTag.fetch_add(1, std::memory_order_relaxed);
+    // Keep the data of each node aligned to the header size
+    unsigned headerSize = (unsigned)sizeof(ConcurrentAllocatorNode);
+    allocator->stride_ = headerSize + (nodeSize + headerSize - 1) / headerSize * headerSize;
+    allocator->baseCapacity_ = initialCapacity ? initialCapacity : 1;
+    allocator->freeHead_.store(0, std::memory_order_relaxed);
+    allocator->numBlocks_.store(0, std::memory_order_relaxed);
+    for (unsigned i = 0; i < CONCURRENT_ALLOCATOR_MAX_BLOCKS; ++i)
+        allocator->blocks_[i].store(0, std::memory_order_relaxed);
+
+    return allocator;
+}
+
+void ConcurrentAllocatorUninitialize(ConcurrentAllocatorPool* allocator)
+{
+    if (!allocator)
+        return;
+
+    // Unregister first, so that exiting threads no longer flush their caches to this allocator
+    {
+        std::lock_guard<std::mutex> lock(concurrentAllocatorIDMutex);
+        concurrentAllocators[allocator->id_] = 0;
+        freeConcurrentAllocatorIDs.Push(allocator->id_);
+    }
+
+    for (unsigned i = 0; i < CONCURRENT_ALLOCATOR_MAX_BLOCKS; ++i)
+        delete[] allocator->blocks_[i].load(std::memory_order_relaxed);
+
+    // Forget the nodes cached by the calling thread. Caches of other threads are discarded on their next use, as the tag of an allocator reusing the ID differs
+    PODVector<ConcurrentAllocatorCache>& concurrentAllocatorCaches = concurrentAllocatorThreadCaches.caches_;
+    if (allocator->id_ < concurrentAllocatorCaches.Size())
+    {
+        concurrentAllocatorCaches[allocator->id_].head_ = 0;
+        concurrentAllocatorCaches[allocator->id_].count_ = 0;
+        concurrentAllocatorCaches[allocator->id_].tag_ = 0;
+    }
+
+    delete allocator;
+}
+
+void* ConcurrentAllocatorReserve(ConcurrentAllocatorPool* allocator)
+{
+    if (!allocator)
+        return 0;
+
+    ConcurrentAllocatorCache& cache = GetConcurrentAllocatorCache(allocator);
+
+    if (!cache.head_)
+    {
+        // Refill the cache from the global free list, or allocate a new block if it is empty
+        while (cache.count_ < CONCURRENT_ALLOCATOR_BATCH)
+        {
+            ConcurrentAllocatorNode* node = ConcurrentAllocatorPop(allocator);
+            if (!node)
+                break;
+            node->next_.store(cache.head_, std::memory_order_relaxed);
+            cache.head_ = node->index_ + 1;
+            ++cache.count_;
+        }
+
+        if (!cache.head_ && !ConcurrentAllocatorGrow(allocator, cache))
+            return 0;
+    }
+
+    ConcurrentAllocatorNode* node = allocator->GetNode(cache.head_ - 1);
+    cache.head_ = node->next_.load(std::memory_order_relaxed);
+    --cache.count_;
+
+    return reinterpret_cast<unsigned char*>(node) + sizeof(ConcurrentAllocatorNode);
+}
+
+void ConcurrentAllocatorFree(ConcurrentAllocatorPool* allocator, void* ptr)
+{
+    if (!allocator || !ptr)
+        return;
+
+    ConcurrentAllocatorNode* node = reinterpret_cast<ConcurrentAllocatorNode*>(static_cast<unsigned char*>(ptr) - sizeof(ConcurrentAllocatorNode));
+    ConcurrentAllocatorCache& cache = GetConcurrentAllocatorCache(allocator);
+
+    node->next_.store(cache.head_, std::memory_order_relaxed);
+    cache.head_ = node->index_ + 1;
+    ++cache.count_;
+
+    // Return a batch to the global free list when the cache is full
+    if (cache.count_ > CONCURRENT_ALLOCATOR_MAX_CACHED)
+    {
+        ConcurrentAllocatorNode* first = node;
+        ConcurrentAllocatorNode* last = node;
+        for (unsigned i = 1; i < CONCURRENT_ALLOCATOR_BATCH; ++i)
+            last = allocator->GetNode(last->next_.load(std::memory_order_relaxed) - 1);
+
+        cache.head_ = last->next_.load(std::memory_order_relaxed);
+        cache.count_ -= CONCURRENT_ALLOCATOR_BATCH;
+        ConcurrentAllocatorPushChain(allocator, first, last);
+    }
+}
+
+// ATOMIC END
+
 }
@@ -31,6 +31,9 @@ namespace Atomic
 
 struct AllocatorBlock;
 struct AllocatorNode;
+// ATOMIC BEGIN
+struct ConcurrentAllocatorPool;
+// ATOMIC END
 
 /// %Allocator memory block.
 struct AllocatorBlock
@@ -63,8 +66,40 @@ ATOMIC_API void* AllocatorReserve(AllocatorBlock* allocator);
 /// Free a node. Does not free any blocks.
 ATOMIC_API void AllocatorFree(AllocatorBlock* allocator, void* ptr);
 
-/// %Allocator template class. Allocates objects of a specific class.
-template <class T> class Allocator
+// ATOMIC BEGIN
+
+/// Container allocation policy using the heap for buffers and fixed-size node pools for hash nodes. Default for Vector, PODVector and HashMap.
+struct HeapAllocatorPolicy
+{
+    /// Allocate a buffer.
+    static unsigned char* AllocateBuffer(unsigned size) { return new unsigned char[size]; }
+    /// Free a buffer.
+    static void FreeBuffer(unsigned char* buffer) { delete[] buffer; }
+    /// Initialize the node pool of a hash container.
+    static AllocatorBlock* InitializeNodes(unsigned nodeSize, unsigned initialCapacity = 1) { return AllocatorInitialize(nodeSize, initialCapacity); }
+    /// Uninitialize the node pool of a hash container.
+    static void UninitializeNodes(AllocatorBlock* allocator) { AllocatorUninitialize(allocator); }
+    /// Reserve a node from the node pool.
+    static void* ReserveNode(AllocatorBlock* allocator, unsigned nodeSize) { return AllocatorReserve(allocator); }
+    /// Free a node back to the node pool.
+    static void FreeNode(AllocatorBlock* allocator, void* node) { AllocatorFree(allocator, node); }
+};
+
+/// Initialize a thread-safe fixed-size allocator with the node size and initial capacity. Nodes are reserved and freed through a per-thread cache, which exchanges nodes in batches with a lock-free global free list. A thread's cache is returned to the global free list when the thread exits.
+ATOMIC_API ConcurrentAllocatorPool* ConcurrentAllocatorInitialize(unsigned nodeSize, unsigned initialCapacity = 64);
+/// Uninitialize a thread-safe fixed-size allocator. Frees all blocks. No other thread may be using the allocator.
+ATOMIC_API void ConcurrentAllocatorUninitialize(ConcurrentAllocatorPool* allocator);
+/// Reserve a node from any thread. Creates a new block if necessary.
+ATOMIC_API void* ConcurrentAllocatorReserve(ConcurrentAllocatorPool* allocator);
+/// Free a node from any thread, which need not be the thread that reserved it. Does not free any blocks.
+ATOMIC_API void ConcurrentAllocatorFree(ConcurrentAllocatorPool* allocator, void* ptr);
+
+// ATOMIC END
+
+// ATOMIC BEGIN
+/// %Allocator template class. Allocates objects of a specific class. If ThreadSafe is true, objects can be reserved and freed concurrently from any thread.
+template <class T, bool ThreadSafe = false> class Allocator
+// ATOMIC END
 {
 public:
     /// Construct.
@@ -120,4 +155,59 @@ private:
     AllocatorBlock* allocator_;
 };
 
+// ATOMIC BEGIN
+
+/// Thread-safe %Allocator template class. Allocates objects of a specific class from any thread.
+template <class T> class Allocator<T, true>
+{
+public:
+    /// Construct.
+    Allocator(unsigned initialCapacity = 64) :
+        allocator_(ConcurrentAllocatorInitialize((unsigned)sizeof(T), initialCapacity))
+    {
+    }
+
+    /// Destruct. No other thread may be using the allocator.
+    ~Allocator()
+    {
+        ConcurrentAllocatorUninitialize(allocator_);
+    }
+
+    /// Reserve and default-construct an object.
+    T* Reserve()
+    {
+        T* newObject = static_cast<T*>(ConcurrentAllocatorReserve(allocator_));
+        new(newObject) T();
+
+        return newObject;
+    }
+
+    /// Reserve and copy-construct an object.
+    T* Reserve(const T& object)
+    {
+        T* newObject = static_cast<T*>(ConcurrentAllocatorReserve(allocator_));
+        new(newObject) T(object);
+
+        return newObject;
+    }
+
+    /// Destruct and free an object.
+    void Free(T* object)
+    {
+        (object)->~T();
+        ConcurrentAllocatorFree(allocator_, object);
+    }
+
+private:
+    /// Prevent copy construction.
+    Allocator(const Allocator<T, true>& rhs);
+    /// Prevent assignment.
+    Allocator<T, true>& operator =(const Allocator<T, true>& rhs);
+
+    /// Concurrent allocator pool.
+    ConcurrentAllocatorPool* allocator_;
+};
+
+// ATOMIC END
+
 }
@@ -0,0 +1,895 @@
+//
+// Copyright (c) 2014-2017 THUNDERBEAST GAMES LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "../Container/Hash.h"
+#include "../Container/Pair.h"
+#include "../Container/Sort.h"
+#include "../Container/Vector.h"
+
+#include <cassert>
+#include <cstring>
+#if ATOMIC_CXX11
+#include <initializer_list>
+#endif
+
+namespace Atomic
+{
+
+/// Hash map template class using open addressing, with the API of HashMap. Stores the first N pairs inline. Pairs are stored in chunks that are never moved, so references and iterators stay valid when inserting or erasing other pairs. Iterates in insertion order, except that a new pair fills the slot of the most recently erased pair if there is one. N must be at least 1.
+template <class T, class U, unsigned N = 4> class FlatHashMap
+{
+public:
+    typedef T KeyType;
+    typedef U ValueType;
+
+    /// Hash map key-value pair with const key.
+    class KeyValue
+    {
+        friend class FlatHashMap<T, U, N>;
+
+    public:
+        /// Construct with default key.
+        KeyValue() :
+            first_(T()),
+            alive_(1)
+        {
+        }
+
+        /// Construct with key and value.
+        KeyValue(const T& first, const U& second) :
+            first_(first),
+            alive_(1),
+            second_(second)
+        {
+        }
+
+        /// Copy-construct.
+        KeyValue(const KeyValue& value) :
+            first_(value.first_),
+            alive_(1),
+            second_(value.second_)
+        {
+        }
+
+        /// Test for equality with another pair.
+        bool operator ==(const KeyValue& rhs) const { return first_ == rhs.first_ && second_ == rhs.second_; }
+
+        /// Test for inequality with another pair.
+        bool operator !=(const KeyValue& rhs) const { return first_ != rhs.first_ || second_ != rhs.second_; }
+
+        /// Key.
+        const T first_;
+
+    private:
+        /// Prevent assignment.
+        KeyValue& operator =(const KeyValue& rhs);
+
+        /// Nonzero while the pair has not been erased. Placed in the padding after the key.
+        unsigned char alive_;
+
+    public:
+        /// Value.
+        U second_;
+    };
+
+    /// Hash map iterator.
+    struct Iterator
+    {
+        /// Construct.
+        Iterator() :
+            map_(0),
+            index_(0),
+            ptr_(0)
+        {
+        }
+
+        /// Construct with a map and pair index.
+        Iterator(FlatHashMap<T, U, N>* map, unsigned index) :
+            map_(map),
+            index_(index),
+            ptr_(index < map->used_ ? map->GetPair(index) : 0)
+        {
+        }
+
+        /// Construct with a map, pair index and pair pointer.
+        Iterator(FlatHashMap<T, U, N>* map, unsigned index, KeyValue* ptr) :
+            map_(map),
+            index_(index),
+            ptr_(ptr)
+        {
+        }
+
+        /// Preincrement the pointer.
+        Iterator& operator ++()
+        {
+            map_->Advance(index_, ptr_);
+            return *this;
+        }
+
+        /// Postincrement the pointer.
+        Iterator operator ++(int)
+        {
+            Iterator it = *this;
+            map_->Advance(index_, ptr_);
+            return it;
+        }
+
+        /// Predecrement the pointer.
+        Iterator& operator --()
+        {
+            index_ = map_->PrevIndex(index_);
+            ptr_ = map_->GetPair(index_);
+            return *this;
+        }
+
+        /// Postdecrement the pointer.
+        Iterator operator --(int)
+        {
+            Iterator it = *this;
+            index_ = map_->PrevIndex(index_);
+            ptr_ = map_->GetPair(index_);
+            return it;
+        }
+
+        /// Test for equality with another iterator.
+        bool operator ==(const Iterator& rhs) const { return index_ == rhs.index_ && map_ == rhs.map_; }
+
+        /// Test for inequality with another iterator.
+        bool operator !=(const Iterator& rhs) const { return index_ != rhs.index_ || map_ != rhs.map_; }
+
+        /// Point to the pair.
+        KeyValue* operator ->() const { return ptr_; }
+
+        /// Dereference the pair.
+        KeyValue& operator *() const { return *ptr_; }
+
+        /// Map.
+        FlatHashMap<T, U, N>* map_;
+        /// Pair index.
+        unsigned index_;
+        /// Pair, or null at the end.
+        KeyValue* ptr_;
+    };
+
+    /// Hash map const iterator.
+    struct ConstIterator
+    {
+        /// Construct.
+        ConstIterator() :
+            map_(0),
+            index_(0),
+            ptr_(0)
+        {
+        }
+
+        /// Construct with a map and pair index.
+        ConstIterator(const FlatHashMap<T, U, N>* map, unsigned index) :
+            map_(map),
+            index_(index),
+            ptr_(index < map->used_ ? map->GetPair(index) : 0)
+        {
+        }
+
+        /// Construct with a map, pair index and pair pointer.
+        ConstIterator(const FlatHashMap<T, U, N>* map, unsigned index, KeyValue* ptr) :
+            map_(map),
+            index_(index),
+            ptr_(ptr)
+        {
+        }
+
+        /// Construct from a non-const iterator.
+        ConstIterator(const Iterator& rhs) :
+            map_(rhs.map_),
+            index_(rhs.index_),
+            ptr_(rhs.ptr_)
+        {
+        }
+
+        /// Assign from a non-const iterator.
+        ConstIterator& operator =(const Iterator& rhs)
+        {
+            map_ = rhs.map_;
+            index_ = rhs.index_;
+            ptr_ = rhs.ptr_;
+            return *this;
+        }
+
+        /// Preincrement the pointer.
+        ConstIterator& operator ++()
+        {
+            map_->Advance(index_, ptr_);
+            return *this;
+        }
+
+        /// Postincrement the pointer.
+        ConstIterator operator ++(int)
+        {
+            ConstIterator it = *this;
+            map_->Advance(index_, ptr_);
+            return it;
+        }
+
+        /// Predecrement the pointer.
+        ConstIterator& operator --()
+        {
+            index_ = map_->PrevIndex(index_);
+            ptr_ = map_->GetPair(index_);
+            return *this;
+        }
+
+        /// Postdecrement the pointer.
+        ConstIterator operator --(int)
+        {
+            ConstIterator it = *this;
+            index_ = map_->PrevIndex(index_);
+            ptr_ = map_->GetPair(index_);
+            return it;
+        }
+
+        /// Test for equality with another iterator.
+        bool operator ==(const ConstIterator& rhs) const { return index_ == rhs.index_ && map_ == rhs.map_; }
+
+        /// Test for inequality with another iterator.
+        bool operator !=(const ConstIterator& rhs) const { return index_ != rhs.index_ || map_ != rhs.map_; }
+
+        /// Point to the pair.
+        const KeyValue* operator ->() const { return ptr_; }
+
+        /// Dereference the pair.
+        const KeyValue& operator *() const { return *ptr_; }
+
+        /// Map.
+        const FlatHashMap<T, U, N>* map_;
+        /// Pair index.
+        unsigned index_;
+        /// Pair, or null at the end.
+        KeyValue* ptr_;
+    };
+
+    /// Construct empty.
+    FlatHashMap() :
+        index_(0),
+        indexMask_(0),
+        indexed_(0),
+        size_(0),
+        used_(0),
+        capacity_(N)
+    {
+    }
+
+    /// Construct from another hash map.
+    FlatHashMap(const FlatHashMap<T, U, N>& map) :
+        index_(0),
+        indexMask_(0),
+        indexed_(0),
+        size_(0),
+        used_(0),
+        capacity_(N)
+    {
+        *this = map;
+    }
+
+#if ATOMIC_CXX11
+    /// Aggregate initialization constructor.
+    FlatHashMap(const std::initializer_list<Pair<T, U> >& list) :
+        index_(0),
+        indexMask_(0),
+        indexed_(0),
+        size_(0),
+        used_(0),
+        capacity_(N)
+    {
+        for (typename std::initializer_list<Pair<T, U> >::const_iterator it = list.begin(); it != list.end(); ++it)
+            Insert(*it);
+    }
+#endif
+
+    /// Destruct.
+    ~FlatHashMap()
+    {
+        DestructPairs();
+        for (unsigned i = 0; i < chunks_.Size(); ++i)
+            delete[] reinterpret_cast<unsigned char*>(chunks_[i]);
+        delete[] index_;
+    }
+
+    /// Assign a hash map.
+    FlatHashMap& operator =(const FlatHashMap<T, U, N>& rhs)
+    {
+        // In case of self-assignment do nothing
+        if (&rhs != this)
+        {
+            Clear();
+            Reserve(rhs.Size());
+            for (ConstIterator i = rhs.Begin(); i != rhs.End(); ++i)
+                InsertPair(i->first_, i->second_);
+        }
+        return *this;
+    }
+
+    /// Add-assign a pair.
+    FlatHashMap& operator +=(const Pair<T, U>& rhs)
+    {
+        Insert(rhs);
+        return *this;
+    }
+
+    /// Add-assign a hash map.
+    FlatHashMap& operator +=(const FlatHashMap<T, U, N>& rhs)
+    {
+        Insert(rhs);
+        return *this;
+    }
+
+    /// Test for equality with another hash map.
+    bool operator ==(const FlatHashMap<T, U, N>& rhs) const
+    {
+        if (rhs.Size() != Size())
+            return false;
+
+        for (ConstIterator i = Begin(); i != End(); ++i)
+        {
+            ConstIterator j = rhs.Find(i->first_);
+            if (j == rhs.End() || j->second_ != i->second_)
+                return false;
+        }
+
+        return true;
+    }
+
+    /// Test for inequality with another hash map.
+    bool operator !=(const FlatHashMap<T, U, N>& rhs) const { return !(*this == rhs); }
+
+    /// Index the map. Create a new pair if key not found.
+    U& operator [](const T& key)
+    {
+        unsigned index;
+        if (KeyValue* pair = FindPair(key, index))
+            return pair->second_;
+        return GetPair(InsertPair(key, U()))->second_;
+    }
+
+    /// Index the map. Return null if key is not found, does not create a new pair.
+    U* operator [](const T& key) const
+    {
+        unsigned index;
+        KeyValue* pair = FindPair(key, index);
+        return pair ? &pair->second_ : 0;
+    }
+
+#if ATOMIC_CXX11
+    /// Populate the map using variadic template. This handles the base case.
+    FlatHashMap& Populate(const T& key, const U& value)
+    {
+        this->operator [](key) = value;
+        return *this;
+    }
+
+    /// Populate the map using variadic template.
+    template <typename... Args> FlatHashMap& Populate(const T& key, const U& value, Args... args)
+    {
+        this->operator [](key) = value;
+        return Populate(args...);
+    }
+#endif
+
+    /// Insert a pair. Return an iterator to it.
+    Iterator Insert(const Pair<T, U>& pair)
+    {
+        unsigned index;
+        if (KeyValue* existing = FindPair(pair.first_, index))
+            existing->second_ = pair.second_;
+        else
+            index = InsertPair(pair.first_, pair.second_);
+        return Iterator(this, index);
+    }
+
+    /// Insert a pair. Return iterator and set exists flag according to whether the key already existed.
+    Iterator Insert(const Pair<T, U>& pair, bool& exists)
+    {
+        unsigned index;
+        KeyValue* existing = FindPair(pair.first_, index);
+        exists = existing != 0;
+        if (existing)
+            existing->second_ = pair.second_;
+        else
+            index = InsertPair(pair.first_, pair.second_);
+        return Iterator(this, index);
+    }
+
+    /// Insert a map.
+    void Insert(const FlatHashMap<T, U, N>& map)
+    {
+        for (ConstIterator i = map.Begin(); i != map.End(); ++i)
+        {
+            unsigned index;
+            if (KeyValue* existing = FindPair(i->first_, index))
+                existing->second_ = i->second_;
+            else
+                InsertPair(i->first_, i->second_);
+        }
+    }
+
+    /// Insert a pair by iterator. Return iterator to the value.
+    Iterator Insert(const ConstIterator& it) { return Insert(MakePair(it->first_, it->second_)); }
+
+    /// Insert a range by iterators.
+    void Insert(const ConstIterator& start, const ConstIterator& end)
+    {
+        ConstIterator it = start;
+        while (it != end)
+        {
+            Insert(MakePair(it->first_, it->second_));
+            ++it;
+        }
+    }
+
+    /// Insert a pair only if a corresponding key does not already exist.
+    Iterator InsertNew(const T& key, const U& value)
+    {
+        unsigned index;
+        if (!FindPair(key, index))
+            index = InsertPair(key, value);
+        return Iterator(this, index);
+    }
+
+    /// Erase a pair. Return true if was found.
+    bool Erase(const T& key)
+    {
+        unsigned index;
+        if (!FindPair(key, index))
+            return false;
+
+        ErasePair(index);
+        freeSlots_.Push(index);
+        return true;
+    }
+
+    /// Erase a pair by iterator. Return iterator to the next pair.
+    Iterator Erase(const Iterator& it)
+    {
+        if (it.index_ >= used_)
+            return End();
+
+        ErasePair(it.index_);
+        freeSlots_.Push(it.index_);
+        Iterator next = it;
+        return ++next;
+    }
+
+    /// Clear the map. The allocated memory is kept for reuse.
+    void Clear()
+    {
+        DestructPairs();
+        size_ = 0;
+        used_ = 0;
+        freeSlots_.Clear();
+        indexed_ = 0;
+        if (index_)
+            memset(index_, 0, (indexMask_ + 1) * sizeof(IndexEntry));
+    }
+
+    /// Move the pairs to fill the slots of erased pairs not yet reused, restoring insertion order. Invalidates references and iterators. Not needed to bound memory use, as inserts reuse the slots of erased pairs.
+    void Compact()
+    {
+        if (used_ == size_)
+            return;
+
+        unsigned dest = 0;
+        for (unsigned i = 0; i < used_; ++i)
+        {
+            KeyValue* pair = GetPair(i);
+            if (!pair->alive_)
+                continue;
+
+            if (dest != i)
+            {
+                new(GetPair(dest)) KeyValue(*pair);
+                pair->~KeyValue();
+            }
+            ++dest;
+        }
+
+        used_ = dest;
+        freeSlots_.Clear();
+        if (index_)
+            RebuildIndex(indexMask_ + 1);
+    }
+
+    /// Sort pairs. After sorting the map can be iterated in order until new elements are inserted.
+    void Sort()
+    {
+        unsigned numKeys = Size();
+        if (!numKeys)
+            return;
+
+        PODVector<KeyValue*> pairs;
+        pairs.Reserve(numKeys);
+        for (unsigned i = 0; i < used_; ++i)
+        {
+            KeyValue* pair = GetPair(i);
+            if (pair->alive_)
+                pairs.Push(pair);
+        }
+
+        Atomic::Sort(pairs.Begin(), pairs.End(), ComparePairs);
+
+        FlatHashMap<T, U, N> sorted;
+        sorted.Reserve(numKeys);
+        for (unsigned i = 0; i < numKeys; ++i)
+            sorted.InsertPair(pairs[i]->first_, pairs[i]->second_);
+        *this = sorted;
+    }
+
+    /// Reserve space for a number of pairs.
+    void Reserve(unsigned numPairs)
+    {
+        while (capacity_ < numPairs)
+            AllocateChunk();
+    }
+
+    /// Rehash to a specific bucket count, which must be a power of two. Return true if successful.
+    bool Rehash(unsigned numBuckets)
+    {
+        if (numBuckets & (numBuckets - 1) || numBuckets < size_ * 2)
+            return false;
+
+        RebuildIndex(numBuckets);
+        return true;
+    }
+
+    /// Return iterator to the pair with key, or end iterator if not found.
+    Iterator Find(const T& key)
+    {
+        unsigned index;
+        KeyValue* pair = FindPair(key, index);
+        return pair ? Iterator(this, index, pair) : End();
+    }
+
+    /// Return const iterator to the pair with key, or end iterator if not found.
+    ConstIterator Find(const T& key) const
+    {
+        unsigned index;
+        KeyValue* pair = FindPair(key, index);
+        return pair ? ConstIterator(this, index, pair) : End();
+    }
+
+    /// Return whether contains a pair with key.
+    bool Contains(const T& key) const
+    {
+        unsigned index;
+        return FindPair(key, index) != 0;
+    }
+
+    /// Try to copy value to output. Return true if was found.
+    bool TryGetValue(const T& key, U& out) const
+    {
+        unsigned index;
+        KeyValue* pair = FindPair(key, index);
+        if (!pair)
+            return false;
+
+        out = pair->second_;
+        return true;
+    }
+
+    /// Return all the keys.
+    Vector<T> Keys() const
+    {
+        Vector<T> result;
+        result.Reserve(Size());
+        for (ConstIterator i = Begin(); i != End(); ++i)
+            result.Push(i->first_);
+        return result;
+    }
+
+    /// Return all the values.
+    Vector<U> Values() const
+    {
+        Vector<U> result;
+        result.Reserve(Size());
+        for (ConstIterator i = Begin(); i != End(); ++i)
+            result.Push(i->second_);
+        return result;
+    }
+
+    /// Return iterator to the beginning.
+    Iterator Begin() { return Iterator(this, FirstIndex()); }
+
+    /// Return iterator to the beginning.
+    ConstIterator Begin() const { return ConstIterator(this, FirstIndex()); }
+
+    /// Return iterator to the end.
+    Iterator End() { return Iterator(this, used_, 0); }
+
+    /// Return iterator to the end.
+    ConstIterator End() const { return ConstIterator(this, used_, 0); }
+
+    /// Return first pair.
+    const KeyValue& Front() const { return *Begin(); }
+
+    /// Return last pair.
+    const KeyValue& Back() const { return *(--End()); }
+
+    /// Return number of pairs.
+    unsigned Size() const { return size_; }
+
+    /// Return whether the map is empty.
+    bool Empty() const { return size_ == 0; }
+
+    /// Return number of index buckets, or zero if the map is small enough to be searched linearly.
+    unsigned NumBuckets() const { return index_ ? indexMask_ + 1 : 0; }
+
+private:
+    /// Maximum number of pairs searched linearly, without building the index.
+    static const unsigned MAX_LINEAR_SEARCH = 8;
+    /// Minimum number of index buckets.
+    static const unsigned MIN_BUCKETS = 16;
+
+    /// Return pair by index. Heap chunk k holds N << k pairs starting from index N << k.
+    KeyValue* GetPair(unsigned index) const
+    {
+        if (index < N)
+            return reinterpret_cast<KeyValue*>(const_cast<unsigned char*>(inline_.data_)) + index;
+
+        unsigned chunk = FloorLog2(index / N);
+        return chunks_[chunk] + (index - (N << chunk));
+    }
+
+    /// Return index of the first pair not erased, or end index.
+    unsigned FirstIndex() const
+    {
+        unsigned index = 0;
+        while (index < used_ && !GetPair(index)->alive_)
+            ++index;
+        return index;
+    }
+
+    /// Advance pair index and pointer to the next pair not erased, or to the end index and a null pointer.
+    void Advance(unsigned& index, KeyValue*& pair) const
+    {
+        while (++index < used_)
+        {
+            pair = IsChunkStart(index) ? GetPair(index) : pair + 1;
+            if (pair->alive_)
+                return;
+        }
+        pair = 0;
+    }
+
+    /// Return index of the previous pair not erased.
+    unsigned PrevIndex(unsigned index) const
+    {
+        --index;
+        while (index > 0 && !GetPair(index)->alive_)
+            --index;
+        return index;
+    }
+
+    /// Find pair by key and return it along with its index, or null if not found.
+    KeyValue* FindPair(const T& key, unsigned& index) const
+    {
+        if (!index_)
+        {
+            KeyValue* pair = 0;
+            for (unsigned i = 0; i < used_; ++i)
+            {
+                pair = IsChunkStart(i) ? GetPair(i) : pair + 1;
+                if (pair->alive_ && pair->first_ == key)
+                {
+                    index = i;
+                    return pair;
+                }
+            }
+            return 0;
+        }
+
+        unsigned hash = MakeHash(key);
+        unsigned bucket = hash & indexMask_;
+        while (unsigned slot = index_[bucket].slot_)
+        {
+            if (index_[bucket].hash_ == hash)
+            {
+                KeyValue* pair = index_[bucket].pair_;
+                if (pair->alive_ && pair->first_ == key)
+                {
+                    index = slot - 1;
+                    return pair;
+                }
+            }
+            bucket = (bucket + 1) & indexMask_;
+        }
+        return 0;
+    }
+
+    /// Insert a new pair into the slot of the most recently erased pair, or append it. The key must not exist. Return its index.
+    unsigned InsertPair(const T& key, const U& value)
+    {
+        // Pairs are never moved here, as that would invalidate references
+        unsigned index;
+        if (freeSlots_.Size())
+        {
+            index = freeSlots_.Back();
+            freeSlots_.Pop();
+        }
+        else
+        {
+            if (used_ == capacity_)
+                AllocateChunk();
+            index = used_++;
+        }
+
+        new(GetPair(index)) KeyValue(key, value);
+        ++size_;
+
+        if (index_)
+        {
+            // The entries of erased pairs stay in the index until it is rebuilt, so count them toward the load. Grow only if the pairs alone would load it over a quarter, so that rebuilds to drop erased entries stay infrequent
+            if ((indexed_ + 1) * 2 > indexMask_ + 1)
+                RebuildIndex(size_ * 4 > indexMask_ + 1 ? (indexMask_ + 1) << 1 : indexMask_ + 1);
+            else
+                IndexPair(index);
+        }
+        else if (used_ > MAX_LINEAR_SEARCH)
+            RebuildIndex(MIN_BUCKETS);
+
+        return index;
+    }
+
+    /// Erase pair by index.
+    void ErasePair(unsigned index)
+    {
+        KeyValue* pair = GetPair(index);
+        pair->alive_ = 0;
+        pair->second_.~U();
+        const_cast<T&>(pair->first_).~T();
+        --size_;
+    }
+
+    /// Allocate the next chunk, which doubles the capacity.
+    void AllocateChunk()
+    {
+        chunks_.Push(reinterpret_cast<KeyValue*>(new unsigned char[capacity_ * sizeof(KeyValue)]));
+        capacity_ <<= 1;
+    }
+
+    /// Rebuild the index with a number of buckets, which must be a power of two.
+    void RebuildIndex(unsigned numBuckets)
+    {
+        if (numBuckets < MIN_BUCKETS)
+            numBuckets = MIN_BUCKETS;
+
+        if (!index_ || indexMask_ + 1 != numBuckets)
+        {
+            delete[] index_;
+            index_ = new IndexEntry[numBuckets];
+            indexMask_ = numBuckets - 1;
+        }
+        memset(index_, 0, numBuckets * sizeof(IndexEntry));
+        indexed_ = 0;
+
+        for (unsigned i = 0; i < used_; ++i)
+        {
+            if (GetPair(i)->alive_)
+                IndexPair(i);
+        }
+    }
+
+    /// Add pair to the index.
+    void IndexPair(unsigned index)
+    {
+        unsigned hash = MakeHash(GetPair(index)->first_);
+        unsigned bucket = hash & indexMask_;
+        while (index_[bucket].slot_)
+            bucket = (bucket + 1) & indexMask_;
+        index_[bucket].pair_ = GetPair(index);
+        index_[bucket].slot_ = index + 1;
+        index_[bucket].hash_ = hash;
+        ++indexed_;
+    }
+
+    /// Destruct all pairs not erased. Each pair is marked erased before its destructor runs, in case the destructor looks up the map.
+    void DestructPairs()
+    {
+        for (unsigned i = 0; i < used_; ++i)
+        {
+            if (GetPair(i)->alive_)
+                ErasePair(i);
+        }
+    }
+
+    /// Return whether a pair index is the first one of the inline storage or a chunk.
+    static bool IsChunkStart(unsigned index) { return index % N == 0 && !((index / N) & (index / N - 1)); }
+
+    /// Return the base two logarithm of a nonzero value, rounded down.
+    static unsigned FloorLog2(unsigned value)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return 31 - __builtin_clz(value);
+#else
+        unsigned ret = 0;
+        while (value >>= 1)
+            ++ret;
+        return ret;
+#endif
+    }
+
+    /// Compare two pairs by key.
+    static bool ComparePairs(KeyValue* const& lhs, KeyValue* const& rhs) { return lhs->first_ < rhs->first_; }
+
+    /// Open addressing index entry.
+    struct IndexEntry
+    {
+        /// Pair.
+        KeyValue* pair_;
+        /// Pair index plus one, or zero if the bucket is empty.
+        unsigned slot_;
+        /// Full hash of the pair's key, compared before the key itself.
+        unsigned hash_;
+    };
+
+    /// Inline storage for the first N pairs.
+    union InlineStorage
+    {
+        /// Pair data.
+        unsigned char data_[N * sizeof(KeyValue)];
+        /// Alignment.
+        double alignDouble_;
+        /// Alignment.
+        long long alignLong_;
+        /// Alignment.
+        void* alignPtr_;
+    };
+
+    /// Inline pair storage.
+    InlineStorage inline_;
+    /// Heap-allocated pair chunks.
+    PODVector<KeyValue*> chunks_;
+    /// Open addressing index, or null if the map is searched linearly.
+    IndexEntry* index_;
+    /// Slots of erased pairs available for reuse, the most recently erased last.
+    PODVector<unsigned> freeSlots_;
+    /// Index bucket count minus one.
+    unsigned indexMask_;
+    /// Number of index entries, including those of erased pairs.
+    unsigned indexed_;
+    /// Number of pairs.
+    unsigned size_;
+    /// Number of pair slots used, including erased pairs.
+    unsigned used_;
+    /// Number of pair slots allocated.
+    unsigned capacity_;
+};
+
+template <class T, class U, unsigned N> typename Atomic::FlatHashMap<T, U, N>::ConstIterator begin(const Atomic::FlatHashMap<T, U, N>& v) { return v.Begin(); }
+
+template <class T, class U, unsigned N> typename Atomic::FlatHashMap<T, U, N>::ConstIterator end(const Atomic::FlatHashMap<T, U, N>& v) { return v.End(); }
+
+template <class T, class U, unsigned N> typename Atomic::FlatHashMap<T, U, N>::Iterator begin(Atomic::FlatHashMap<T, U, N>& v) { return v.Begin(); }
+
+template <class T, class U, unsigned N> typename Atomic::FlatHashMap<T, U, N>::Iterator end(Atomic::FlatHashMap<T, U, N>& v) { return v.End(); }
+
+}
@@ -0,0 +1,307 @@
+//
+// Copyright (c) 2014-2017 THUNDERBEAST GAMES LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Container/FlatHashMap.h"
+
+namespace Atomic
+{
+
+/// Empty value of the hash map a FlatHashSet is built on.
+struct FlatHashSetValue
+{
+};
+
+/// Hash set template class using open addressing, with the API of HashSet. A FlatHashMap with an empty value, so it stores the first N keys inline, keeps references and iterators valid when inserting, and iterates in insertion order except that a new key fills the slot of the most recently erased key. N must be at least 1.
+template <class T, unsigned N = 4> class FlatHashSet
+{
+public:
+    /// Hash map holding the keys.
+    typedef FlatHashMap<T, FlatHashSetValue, N> MapType;
+
+    /// Hash set iterator.
+    struct Iterator
+    {
+        /// Construct.
+        Iterator()
+        {
+        }
+
+        /// Construct from a hash map iterator.
+        Iterator(const typename MapType::Iterator& it) :
+            it_(it)
+        {
+        }
+
+        /// Preincrement the pointer.
+        Iterator& operator ++()
+        {
+            ++it_;
+            return *this;
+        }
+
+        /// Postincrement the pointer.
+        Iterator operator ++(int)
+        {
+            Iterator it = *this;
+            ++it_;
+            return it;
+        }
+
+        /// Predecrement the pointer.
+        Iterator& operator --()
+        {
+            --it_;
+            return *this;
+        }
+
+        /// Postdecrement the pointer.
+        Iterator operator --(int)
+        {
+            Iterator it = *this;
+            --it_;
+            return it;
+        }
+
+        /// Test for equality with another iterator.
+        bool operator ==(const Iterator& rhs) const { return it_ == rhs.it_; }
+
+        /// Test for inequality with another iterator.
+        bool operator !=(const Iterator& rhs) const { return it_ != rhs.it_; }
+
+        /// Point to the key.
+        const T* operator ->() const { return &it_->first_; }
+
+        /// Dereference the key.
+        const T& operator *() const { return it_->first_; }
+
+        /// Hash map iterator.
+        typename MapType::Iterator it_;
+    };
+
+    /// Hash set const iterator.
+    struct ConstIterator
+    {
+        /// Construct.
+        ConstIterator()
+        {
+        }
+
+        /// Construct from a hash map iterator.
+        ConstIterator(const typename MapType::ConstIterator& it) :
+            it_(it)
+        {
+        }
+
+        /// Construct from a non-const iterator.
+        ConstIterator(const Iterator& rhs) :
+            it_(rhs.it_)
+        {
+        }
+
+        /// Assign from a non-const iterator.
+        ConstIterator& operator =(const Iterator& rhs)
+        {
+            it_ = rhs.it_;
+            return *this;
+        }
+
+        /// Preincrement the pointer.
+        ConstIterator& operator ++()
+        {
+            ++it_;
+            return *this;
+        }
+
+        /// Postincrement the pointer.
+        ConstIterator operator ++(int)
+        {
+            ConstIterator it = *this;
+            ++it_;
+            return it;
+        }
+
+        /// Predecrement the pointer.
+        ConstIterator& operator --()
+        {
+            --it_;
+            return *this;
+        }
+
+        /// Postdecrement the pointer.
+        ConstIterator operator --(int)
+        {
+            ConstIterator it = *this;
+            --it_;
+            return it;
+        }
+
+        /// Test for equality with another iterator.
+        bool operator ==(const ConstIterator& rhs) const { return it_ == rhs.it_; }
+
+        /// Test for inequality with another iterator.
+        bool operator !=(const ConstIterator& rhs) const { return it_ != rhs.it_; }
+
+        /// Point to the key.
+        const T* operator ->() const { return &it_->first_; }
+
+        /// Dereference the key.
+        const T& operator *() const { return it_->first_; }
+
+        /// Hash map iterator.
+        typename MapType::ConstIterator it_;
+    };
+
+    /// Construct empty.
+    FlatHashSet()
+    {
+    }
+
+#if ATOMIC_CXX11
+    /// Aggregate initialization constructor.
+    FlatHashSet(const std::initializer_list<T>& list)
+    {
+        for (typename std::initializer_list<T>::const_iterator it = list.begin(); it != list.end(); ++it)
+            Insert(*it);
+    }
+#endif
+
+    /// Add-assign a value.
+    FlatHashSet& operator +=(const T& rhs)
+    {
+        Insert(rhs);
+        return *this;
+    }
+
+    /// Add-assign a hash set.
+    FlatHashSet& operator +=(const FlatHashSet<T, N>& rhs)
+    {
+        Insert(rhs);
+        return *this;
+    }
+
+    /// Test for equality with another hash set.
+    bool operator ==(const FlatHashSet<T, N>& rhs) const
+    {
+        if (rhs.Size() != Size())
+            return false;
+
+        for (ConstIterator i = Begin(); i != End(); ++i)
+        {
+            if (!rhs.Contains(*i))
+                return false;
+        }
+
+        return true;
+    }
+
+    /// Test for inequality with another hash set.
+    bool operator !=(const FlatHashSet<T, N>& rhs) const { return !(*this == rhs); }
+
+    /// Insert a key. Return an iterator to it.
+    Iterator Insert(const T& key) { return Iterator(map_.InsertNew(key, FlatHashSetValue())); }
+
+    /// Insert a key. Return an iterator and set exists flag according to whether the key already existed.
+    Iterator Insert(const T& key, bool& exists) { return Iterator(map_.Insert(MakePair(key, FlatHashSetValue()), exists)); }
+
+    /// Insert a set.
+    void Insert(const FlatHashSet<T, N>& set)
+    {
+        for (ConstIterator i = set.Begin(); i != set.End(); ++i)
+            Insert(*i);
+    }
+
+    /// Insert a key by iterator. Return iterator to the value.
+    Iterator Insert(const ConstIterator& it) { return Insert(*it); }
+
+    /// Erase a key. Return true if was found.
+    bool Erase(const T& key) { return map_.Erase(key); }
+
+    /// Erase a key by iterator. Return iterator to the next key.
+    Iterator Erase(const Iterator& it) { return Iterator(map_.Erase(it.it_)); }
+
+    /// Clear the set. The allocated memory is kept for reuse.
+    void Clear() { map_.Clear(); }
+
+    /// Move the keys to fill the slots of erased keys not yet reused, restoring insertion order. Invalidates iterators.
+    void Compact() { map_.Compact(); }
+
+    /// Sort keys. After sorting the set can be iterated in order until new elements are inserted.
+    void Sort() { map_.Sort(); }
+
+    /// Reserve space for a number of keys.
+    void Reserve(unsigned numKeys) { map_.Reserve(numKeys); }
+
+    /// Rehash to a specific bucket count, which must be a power of two. Return true if successful.
+    bool Rehash(unsigned numBuckets) { return map_.Rehash(numBuckets); }
+
+    /// Return iterator to the key, or end iterator if not found.
+    Iterator Find(const T& key) { return Iterator(map_.Find(key)); }
+
+    /// Return const iterator to the key, or end iterator if not found.
+    ConstIterator Find(const T& key) const { return ConstIterator(map_.Find(key)); }
+
+    /// Return whether contains a key.
+    bool Contains(const T& key) const { return map_.Contains(key); }
+
+    /// Return iterator to the beginning.
+    Iterator Begin() { return Iterator(map_.Begin()); }
+
+    /// Return iterator to the beginning.
+    ConstIterator Begin() const { return ConstIterator(map_.Begin()); }
+
+    /// Return iterator to the end.
+    Iterator End() { return Iterator(map_.End()); }
+
+    /// Return iterator to the end.
+    ConstIterator End() const { return ConstIterator(map_.End()); }
+
+    /// Return first key.
+    const T& Front() const { return *Begin(); }
+
+    /// Return last key.
+    const T& Back() const { return *(--End()); }
+
+    /// Return number of keys.
+    unsigned Size() const { return map_.Size(); }
+
+    /// Return whether the set is empty.
+    bool Empty() const { return map_.Empty(); }
+
+    /// Return number of index buckets, or zero if the set is small enough to be searched linearly.
+    unsigned NumBuckets() const { return map_.NumBuckets(); }
+
+private:
+    /// Keys with empty values.
+    MapType map_;
+};
+
+template <class T, unsigned N> typename Atomic::FlatHashSet<T, N>::ConstIterator begin(const Atomic::FlatHashSet<T, N>& v) { return v.Begin(); }
+
+template <class T, unsigned N> typename Atomic::FlatHashSet<T, N>::ConstIterator end(const Atomic::FlatHashSet<T, N>& v) { return v.End(); }
+
+template <class T, unsigned N> typename Atomic::FlatHashSet<T, N>::Iterator begin(Atomic::FlatHashSet<T, N>& v) { return v.Begin(); }
+
+template <class T, unsigned N> typename Atomic::FlatHashSet<T, N>::Iterator end(Atomic::FlatHashSet<T, N>& v) { return v.End(); }
+
+}
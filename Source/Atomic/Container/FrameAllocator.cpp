@@ -0,0 +1,174 @@
+//
+// Copyright (c) 2014-2017 THUNDERBEAST GAMES LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../Precompiled.h"
+
+#include "../Container/FrameAllocator.h"
+
+#include <atomic>
+
+#include "../DebugNew.h"
+
+namespace Atomic
+{
+
+/// Frame number shared by all threads. Incremented at frame end.
+static std::atomic<unsigned> currentFrameNumber(0);
+/// Total heap allocations at the end of the last completed frame.
+static unsigned long long lastTotalHeapAllocations = 0;
+
+unsigned FrameAllocator::frameHeapAllocations_ = 0;
+
+/// Owner of the calling thread's frame allocator. Frees it on thread exit.
+struct ThreadFrameAllocator
+{
+    /// Construct.
+    ThreadFrameAllocator() :
+        allocator_(0)
+    {
+    }
+
+    /// Destruct.
+    ~ThreadFrameAllocator()
+    {
+        delete allocator_;
+    }
+
+    /// Frame allocator.
+    FrameAllocator* allocator_;
+};
+
+static thread_local ThreadFrameAllocator threadFrameAllocator;
+
+FrameAllocator::FrameAllocator(unsigned blockSize) :
+    block_(0),
+    offset_(0),
+    blockSize_(blockSize ? blockSize : DEFAULT_BLOCK_SIZE),
+    usedSize_(0),
+    peakSize_(0),
+    capacity_(0),
+    frameNumber_(currentFrameNumber.load(std::memory_order_relaxed))
+{
+}
+
+FrameAllocator::~FrameAllocator()
+{
+    FreeBlocks();
+}
+
+void* FrameAllocator::Allocate(unsigned size, unsigned alignment)
+{
+    assert(alignment && !(alignment & (alignment - 1)));
+
+    // Reset lazily if the frame has ended since the last allocation
+    unsigned frameNumber = currentFrameNumber.load(std::memory_order_relaxed);
+    if (frameNumber != frameNumber_)
+        Reset();
+
+    for (;;)
+    {
+        if (block_)
+        {
+            unsigned char* data = reinterpret_cast<unsigned char*>(block_ + 1);
+            size_t address = reinterpret_cast<size_t>(data + offset_);
+            unsigned padding = (unsigned)(((address + alignment - 1) & ~(size_t)(alignment - 1)) - address);
+            if (offset_ + padding + size <= block_->size_)
+            {
+                void* ptr = data + offset_ + padding;
+                offset_ += padding + size;
+                usedSize_ += padding + size;
+                if (usedSize_ > peakSize_)
+                    peakSize_ = usedSize_;
+                return ptr;
+            }
+        }
+
+        AllocateBlock(size + alignment);
+    }
+}
+
+void FrameAllocator::Reset()
+{
+    frameNumber_ = currentFrameNumber.load(std::memory_order_relaxed);
+    usedSize_ = 0;
+    offset_ = 0;
+
+    // Merge several blocks into one sized for the whole previous usage
+    if (block_ && block_->prev_)
+    {
+        unsigned capacity = capacity_;
+        FreeBlocks();
+        blockSize_ = capacity;
+        AllocateBlock(capacity);
+    }
+}
+
+FrameAllocator* FrameAllocator::GetThreadAllocator()
+{
+    if (!threadFrameAllocator.allocator_)
+        threadFrameAllocator.allocator_ = new FrameAllocator();
+    return threadFrameAllocator.allocator_;
+}
+
+void FrameAllocator::EndFrame()
+{
+    currentFrameNumber.fetch_add(1, std::memory_order_relaxed);
+    if (threadFrameAllocator.allocator_)
+        threadFrameAllocator.allocator_->Reset();
+
+    unsigned long long totalHeapAllocations = GetTotalHeapAllocations();
+    frameHeapAllocations_ = (unsigned)(totalHeapAllocations - lastTotalHeapAllocations);
+    lastTotalHeapAllocations = totalHeapAllocations;
+}
+
+void FrameAllocator::AllocateBlock(unsigned size)
+{
+    unsigned blockSize = blockSize_;
+    while (blockSize < size)
+        blockSize <<= 1;
+
+    Block* block = reinterpret_cast<Block*>(new unsigned char[sizeof(Block) + blockSize]);
+    block->prev_ = block_;
+    block->size_ = blockSize;
+    block_ = block;
+    offset_ = 0;
+    capacity_ += blockSize;
+
+    // Grow the following blocks geometrically
+    blockSize_ = blockSize << 1;
+}
+
+void FrameAllocator::FreeBlocks()
+{
+    while (block_)
+    {
+        Block* prev = block_->prev_;
+        delete[] reinterpret_cast<unsigned char*>(block_);
+        block_ = prev;
+    }
+
+    offset_ = 0;
+    capacity_ = 0;
+}
+
+}
@@ -0,0 +1,125 @@
+//
+// Copyright (c) 2014-2017 THUNDERBEAST GAMES LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "../Container/Allocator.h"
+
+namespace Atomic
+{
+
+/// Linear arena allocator for per-frame scratch memory. Each thread has its own instance, which is reset at the end of every frame; allocations are never freed individually.
+class ATOMIC_API FrameAllocator
+{
+public:
+    /// Default size of the first memory block.
+    static const unsigned DEFAULT_BLOCK_SIZE = 64 * 1024;
+    /// Default allocation alignment.
+    static const unsigned DEFAULT_ALIGNMENT = 16;
+
+    /// Construct with the size of the first memory block, which is allocated on first use.
+    FrameAllocator(unsigned blockSize = DEFAULT_BLOCK_SIZE);
+    /// Destruct. Free all memory blocks.
+    ~FrameAllocator();
+
+    /// Allocate memory that stays valid until the allocator is reset. Alignment must be a power of two.
+    void* Allocate(unsigned size, unsigned alignment = DEFAULT_ALIGNMENT);
+    /// Release all allocations. If the allocations of the previous frame spanned several memory blocks, they are merged into one so that a frame with similar usage does not touch the heap.
+    void Reset();
+
+    /// Return number of bytes allocated since the last reset, including alignment padding.
+    unsigned GetUsedSize() const { return usedSize_; }
+    /// Return the highest used size reached by any frame since the allocator was created. Not cleared by Reset(), as within a frame it would always equal the used size.
+    unsigned GetPeakSize() const { return peakSize_; }
+    /// Return total size of the memory blocks.
+    unsigned GetCapacity() const { return capacity_; }
+
+    /// Return the frame allocator of the calling thread. Created on first use.
+    static FrameAllocator* GetThreadAllocator();
+    /// Allocate from the frame allocator of the calling thread.
+    static void* AllocateFrame(unsigned size, unsigned alignment = DEFAULT_ALIGNMENT) { return GetThreadAllocator()->Allocate(size, alignment); }
+    /// End the frame: reset the calling thread's allocator now and the allocators of other threads on their next allocation, and update the heap allocation statistics. Called by Time::EndFrame() after E_ENDFRAME, when worker threads must no longer be using frame memory.
+    static void EndFrame();
+
+    /// Return number of heap allocations during the last completed frame. Counted only when built with ATOMIC_ALLOCATION_COUNTER, otherwise zero.
+    static unsigned GetFrameHeapAllocations() { return frameHeapAllocations_; }
+    /// Return total number of heap allocations since startup. Counted only when built with ATOMIC_ALLOCATION_COUNTER, otherwise zero.
+    static unsigned long long GetTotalHeapAllocations();
+
+private:
+    /// Prevent copy construction.
+    FrameAllocator(const FrameAllocator& rhs);
+    /// Prevent assignment.
+    FrameAllocator& operator =(const FrameAllocator& rhs);
+
+    /// Allocate a new memory block that can hold at least the given size.
+    void AllocateBlock(unsigned size);
+    /// Free all memory blocks.
+    void FreeBlocks();
+
+    /// Memory block header. Data follows.
+    struct Block
+    {
+        /// Previous block.
+        Block* prev_;
+        /// Data size.
+        unsigned size_;
+    };
+
+    /// Current memory block.
+    Block* block_;
+    /// Offset into the current block.
+    unsigned offset_;
+    /// Size of the next memory block.
+    unsigned blockSize_;
+    /// Number of bytes allocated since the last reset.
+    unsigned usedSize_;
+    /// Highest used size of any frame since construction.
+    unsigned peakSize_;
+    /// Total size of the memory blocks.
+    unsigned capacity_;
+    /// Frame number of the last reset.
+    unsigned frameNumber_;
+
+    /// Heap allocations during the last completed frame.
+    static unsigned frameHeapAllocations_;
+};
+
+/// Container allocation policy using the frame allocator of the calling thread. Freeing is a no-op. A container using it must not outlive the frame in which it allocated; only a PODVector may be destructed later, as that does not access the elements.
+struct FrameAllocatorPolicy
+{
+    /// Allocate a buffer.
+    static unsigned char* AllocateBuffer(unsigned size) { return static_cast<unsigned char*>(FrameAllocator::AllocateFrame(size)); }
+    /// Free a buffer. Does nothing.
+    static void FreeBuffer(unsigned char* buffer) { }
+    /// Initialize the node pool of a hash container. Nodes are not pooled.
+    static AllocatorBlock* InitializeNodes(unsigned nodeSize, unsigned initialCapacity = 1) { return 0; }
+    /// Uninitialize the node pool of a hash container. Does nothing.
+    static void UninitializeNodes(AllocatorBlock* allocator) { }
+    /// Allocate a node.
+    static void* ReserveNode(AllocatorBlock* allocator, unsigned nodeSize) { return FrameAllocator::AllocateFrame(nodeSize); }
+    /// Free a node. Does nothing.
+    static void FreeNode(AllocatorBlock* allocator, void* node) { }
+};
+
+}
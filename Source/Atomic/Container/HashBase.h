@@ -132,6 +132,25 @@ protected:
     /// Allocate bucket head pointers + room for size and bucket count variables.
     void AllocateBuckets(unsigned size, unsigned numBuckets);
 
+    // ATOMIC BEGIN
+
+    /// Allocate bucket head pointers + room for size and bucket count variables from a container allocation policy.
+    template <class A> void AllocateBuckets(unsigned size, unsigned numBuckets)
+    {
+        if (ptrs_)
+            A::FreeBuffer(reinterpret_cast<unsigned char*>(ptrs_));
+
+        HashNodeBase** ptrs = reinterpret_cast<HashNodeBase**>(A::AllocateBuffer((numBuckets + 2) * (unsigned)sizeof(HashNodeBase*)));
+        unsigned* data = reinterpret_cast<unsigned*>(ptrs);
+        data[0] = size;
+        data[1] = numBuckets;
+        ptrs_ = ptrs;
+
+        ResetPtrs();
+    }
+
+    // ATOMIC END
+
     /// Reset bucket head pointers.
     void ResetPtrs();
 
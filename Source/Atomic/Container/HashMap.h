@@ -35,8 +35,8 @@
 namespace Atomic
 {
 
-/// Hash map template class.
-template <class T, class U> class HashMap : public HashBase
+/// Hash map template class. The allocation policy A provides the node and bucket storage.
+template <class T, class U, class A = HeapAllocatorPolicy> class HashMap : public HashBase
 {
 public:
     typedef T KeyType;
@@ -228,15 +228,15 @@ public:
     HashMap()
     {
         // Reserve the tail node
-        allocator_ = AllocatorInitialize((unsigned)sizeof(Node));
+        allocator_ = A::InitializeNodes((unsigned)sizeof(Node));
         head_ = tail_ = ReserveNode();
     }
 
     /// Construct from another hash map.
-    HashMap(const HashMap<T, U>& map)
+    HashMap(const HashMap<T, U, A>& map)
     {
         // Reserve the tail node + initial capacity according to the map's size
-        allocator_ = AllocatorInitialize((unsigned)sizeof(Node), map.Size() + 1);
+        allocator_ = A::InitializeNodes((unsigned)sizeof(Node), map.Size() + 1);
         head_ = tail_ = ReserveNode();
         *this = map;
     }
@@ -255,12 +255,12 @@ public:
     {
         Clear();
         FreeNode(Tail());
-        AllocatorUninitialize(allocator_);
-        delete[] ptrs_;
+        A::UninitializeNodes(allocator_);
+        A::FreeBuffer(reinterpret_cast<unsigned char*>(ptrs_));
     }
 
     /// Assign a hash map.
-    HashMap& operator =(const HashMap<T, U>& rhs)
+    HashMap& operator =(const HashMap<T, U, A>& rhs)
     {
         // In case of self-assignment do nothing
         if (&rhs != this)
@@ -279,14 +279,14 @@ public:
     }
 
     /// Add-assign a hash map.
-    HashMap& operator +=(const HashMap<T, U>& rhs)
+    HashMap& operator +=(const HashMap<T, U, A>& rhs)
     {
         Insert(rhs);
         return *this;
     }
 
     /// Test for equality with another hash map.
-    bool operator ==(const HashMap<T, U>& rhs) const
+    bool operator ==(const HashMap<T, U, A>& rhs) const
     {
         if (rhs.Size() != Size())
             return false;
@@ -304,7 +304,7 @@ public:
     }
 
     /// Test for inequality with another hash map.
-    bool operator !=(const HashMap<T, U>& rhs) const
+    bool operator !=(const HashMap<T, U, A>& rhs) const
     {
         if (rhs.Size() != Size())
             return true;
@@ -376,7 +376,7 @@ public:
     }
 
     /// Insert a map.
-    void Insert(const HashMap<T, U>& map)
+    void Insert(const HashMap<T, U, A>& map)
     {
         ConstIterator it = map.Begin();
         ConstIterator end = map.End();
@@ -515,7 +515,7 @@ public:
         if (check != 1)
             return false;
 
-        AllocateBuckets(Size(), numBuckets);
+        AllocateBuckets<A>(Size(), numBuckets);
         Rehash();
         return true;
     }
@@ -674,7 +674,7 @@ private:
         // If no pointers yet, allocate with minimum bucket count
         if (!ptrs_)
         {
-            AllocateBuckets(Size(), MIN_BUCKETS);
+            AllocateBuckets<A>(Size(), MIN_BUCKETS);
             Rehash();
         }
 
@@ -698,7 +698,7 @@ private:
         // Rehash if the maximum load factor has been exceeded
         if (Size() > NumBuckets() * MAX_LOAD_FACTOR)
         {
-            AllocateBuckets(Size(), NumBuckets() << 1);
+            AllocateBuckets<A>(Size(), NumBuckets() << 1);
             Rehash();
         }
 
@@ -754,7 +754,7 @@ private:
     /// Reserve a node.
     Node* ReserveNode()
     {
-        Node* newNode = static_cast<Node*>(AllocatorReserve(allocator_));
+        Node* newNode = static_cast<Node*>(A::ReserveNode(allocator_, (unsigned)sizeof(Node)));
         new(newNode) Node();
         return newNode;
     }
@@ -762,7 +762,7 @@ private:
     /// Reserve a node with specified key and value.
     Node* ReserveNode(const T& key, const U& value)
     {
-        Node* newNode = static_cast<Node*>(AllocatorReserve(allocator_));
+        Node* newNode = static_cast<Node*>(A::ReserveNode(allocator_, (unsigned)sizeof(Node)));
         new(newNode) Node(key, value);
         return newNode;
     }
@@ -771,7 +771,7 @@ private:
     void FreeNode(Node* node)
     {
         (node)->~Node();
-        AllocatorFree(allocator_, node);
+        A::FreeNode(allocator_, node);
     }
 
     /// Rehash the buckets.
@@ -793,12 +793,12 @@ private:
     unsigned Hash(const T& key) const { return MakeHash(key) & (NumBuckets() - 1); }
 };
 
-template <class T, class U> typename Atomic::HashMap<T, U>::ConstIterator begin(const Atomic::HashMap<T, U>& v) { return v.Begin(); }
+template <class T, class U, class A> typename Atomic::HashMap<T, U, A>::ConstIterator begin(const Atomic::HashMap<T, U, A>& v) { return v.Begin(); }
 
-template <class T, class U> typename Atomic::HashMap<T, U>::ConstIterator end(const Atomic::HashMap<T, U>& v) { return v.End(); }
+template <class T, class U, class A> typename Atomic::HashMap<T, U, A>::ConstIterator end(const Atomic::HashMap<T, U, A>& v) { return v.End(); }
 
-template <class T, class U> typename Atomic::HashMap<T, U>::Iterator begin(Atomic::HashMap<T, U>& v) { return v.Begin(); }
+template <class T, class U, class A> typename Atomic::HashMap<T, U, A>::Iterator begin(Atomic::HashMap<T, U, A>& v) { return v.Begin(); }
 
-template <class T, class U> typename Atomic::HashMap<T, U>::Iterator end(Atomic::HashMap<T, U>& v) { return v.End(); }
+template <class T, class U, class A> typename Atomic::HashMap<T, U, A>::Iterator end(Atomic::HashMap<T, U, A>& v) { return v.End(); }
 
 }
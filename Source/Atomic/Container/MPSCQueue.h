@@ -0,0 +1,121 @@
+//
+// Copyright (c) 2014-2017 THUNDERBEAST GAMES LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "../Container/Allocator.h"
+#include "../Container/Vector.h"
+
+#include <atomic>
+
+namespace Atomic
+{
+
+/// Lock-free multiple producer, single consumer queue. Items can be pushed from any thread; only one thread may pop them.
+template <class T> class MPSCQueue
+{
+public:
+    /// Construct.
+    MPSCQueue(unsigned initialCapacity = 64) :
+        head_(0),
+        allocator_(initialCapacity)
+    {
+    }
+
+    /// Destruct. No other thread may be using the queue.
+    ~MPSCQueue()
+    {
+        Node* node = head_.load(std::memory_order_acquire);
+        while (node)
+        {
+            Node* next = node->next_;
+            allocator_.Free(node);
+            node = next;
+        }
+    }
+
+    /// Push an item. Safe to call from any thread.
+    void Push(const T& item)
+    {
+        Node* node = allocator_.Reserve();
+        node->value_ = item;
+        node->next_ = head_.load(std::memory_order_relaxed);
+        while (!head_.compare_exchange_weak(node->next_, node, std::memory_order_release, std::memory_order_relaxed))
+            ;
+    }
+
+    /// Append all pushed items to dest in push order. Return number of items. Call only from the consumer thread.
+    unsigned PopAll(Vector<T>& dest)
+    {
+        Node* node = head_.exchange(0, std::memory_order_acquire);
+        if (!node)
+            return 0;
+
+        // The detached list is newest first: reverse it to push order
+        Node* reversed = 0;
+        unsigned count = 0;
+        while (node)
+        {
+            Node* next = node->next_;
+            node->next_ = reversed;
+            reversed = node;
+            node = next;
+            ++count;
+        }
+
+        while (reversed)
+        {
+            Node* next = reversed->next_;
+            dest.Push(reversed->value_);
+            allocator_.Free(reversed);
+            reversed = next;
+        }
+
+        return count;
+    }
+
+    /// Return whether the queue is empty. The result may be outdated immediately if other threads are pushing.
+    bool Empty() const { return head_.load(std::memory_order_relaxed) == 0; }
+
+private:
+    /// Queue node.
+    struct Node
+    {
+        /// Item.
+        T value_;
+        /// Next older node.
+        Node* next_;
+    };
+
+    /// Prevent copy construction.
+    MPSCQueue(const MPSCQueue<T>& rhs);
+    /// Prevent assignment.
+    MPSCQueue<T>& operator =(const MPSCQueue<T>& rhs);
+
+    /// Newest pushed node.
+    std::atomic<Node*> head_;
+    /// Thread-safe node allocator.
+    Allocator<Node, true> allocator_;
+};
+
+}
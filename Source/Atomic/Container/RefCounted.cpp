@@ -33,7 +33,8 @@ RefCounted::RefCounted() :
     refCount_(new RefCount()),
 // ATOMIC BEGIN
     instantiationType_(INSTANTIATION_NATIVE),
-    jsHeapPtr_(0)
+    jsHeapPtr_(0),
+    typeCounter_(0)
 // ATOMIC END
 {
     // Hold a weak ref to self to avoid possible double delete of the refcount
@@ -60,6 +61,9 @@ RefCounted::~RefCounted()
     refCount_ = 0;
 
 // ATOMIC BEGIN
+    if (typeCounter_)
+        typeCounter_->Add(instantiationType_, -1);
+
     for (unsigned i = 0; i < refCountedDeletedFunctions_.Size(); i++)
         refCountedDeletedFunctions_[i](this);
 // ATOMIC END
@@ -71,6 +75,9 @@ void RefCounted::AddRef()
     (refCount_->refs_)++;
 
 // ATOMIC BEGIN
+    if (instanceCounting_.load(std::memory_order_relaxed))
+        RegisterInstance();
+
     if (jsHeapPtr_ && refCount_->refs_ == 2)
     {
         for (unsigned i = 0; i < refCountChangedFunctions_.Size(); i++)
@@ -124,11 +131,66 @@ int RefCounted::WeakRefs() const
 PODVector<RefCountChangedFunction> RefCounted::refCountChangedFunctions_;
 PODVector<RefCountedCreatedFunction> RefCounted::refCountedCreatedFunctions_;
 PODVector<RefCountedDeletedFunction> RefCounted::refCountedDeletedFunctions_;
+std::atomic<bool> RefCounted::instanceCounting_(false);
+std::atomic<RefCountedRegisteredFunction> RefCounted::refCountedRegisteredFunction_(0);
+std::atomic<RefCountedTypeCounter*> RefCountedTypeCounter::first_(0);
+
+RefCountedTypeCounter::RefCountedTypeCounter(const String& typeName) :
+    typeName_(typeName)
+{
+    for (unsigned i = 0; i <= INSTANTIATION_NET; ++i)
+        counts_[i].store(0, std::memory_order_relaxed);
+
+    // Counters are never unlinked, so a lock-free push is enough for concurrent first use from several threads
+    next_ = first_.load(std::memory_order_relaxed);
+    while (!first_.compare_exchange_weak(next_, this, std::memory_order_release, std::memory_order_relaxed))
+        ;
+}
+
+int RefCountedTypeCounter::GetTotal() const
+{
+    int total = 0;
+    for (unsigned i = 0; i <= INSTANTIATION_NET; ++i)
+        total += counts_[i].load(std::memory_order_relaxed);
+    return total;
+}
 
 void RefCounted::AddRefSilent()
 {
     assert(refCount_->refs_ >= 0);
     (refCount_->refs_)++;
+
+    if (instanceCounting_.load(std::memory_order_relaxed))
+        RegisterInstance();
+}
+
+void RefCounted::SetInstantiationType(InstantiationType type)
+{
+    if (typeCounter_ && type != instantiationType_)
+    {
+        typeCounter_->Add(instantiationType_, -1);
+        typeCounter_->Add(type, 1);
+    }
+
+    instantiationType_ = type;
+}
+
+void RefCounted::RegisterInstance()
+{
+    // Deferred from the constructor, where the most derived type is not yet known. A reference taken inside a constructor
+    // still sees a base type, so check again on every reference and move the count once the most derived type is seen
+    RefCountedTypeCounter* counter = &GetTypeCounter();
+    if (counter == typeCounter_)
+        return;
+
+    if (typeCounter_)
+        typeCounter_->Add(instantiationType_, -1);
+    typeCounter_ = counter;
+    typeCounter_->Add(instantiationType_, 1);
+
+    RefCountedRegisteredFunction function = refCountedRegisteredFunction_.load(std::memory_order_relaxed);
+    if (function)
+        function(this);
 }
 
 void RefCounted::ReleaseRefSilent()
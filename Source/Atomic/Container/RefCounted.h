@@ -30,6 +30,8 @@
 #include "../Container/Str.h"
 #include "../Math/StringHash.h"
 
+#include <atomic>
+
 // ATOMIC END
 
 namespace Atomic
@@ -56,15 +58,54 @@ typedef void(*RefCountedCreatedFunction)(RefCounted*);
 // function callback for when a RefCounted is deleted
 typedef void(*RefCountedDeletedFunction)(RefCounted*);
 
+// function callback for when a RefCounted is registered with its type's instance counter
+typedef void(*RefCountedRegisteredFunction)(RefCounted*);
+
 typedef const void* ClassID;
 
+/// Live instance counts of a RefCounted derived type. Created once per type on first use and linked into a global list.
+class ATOMIC_API RefCountedTypeCounter
+{
+public:
+    /// Construct and link into the global counter list.
+    RefCountedTypeCounter(const String& typeName);
+
+    /// Adjust the live instance count of an instantiation type.
+    void Add(InstantiationType type, int delta) { counts_[type].fetch_add(delta, std::memory_order_relaxed); }
+
+    /// Return type name.
+    const String& GetTypeName() const { return typeName_; }
+    /// Return live instance count of an instantiation type.
+    int GetCount(InstantiationType type) const { return counts_[type].load(std::memory_order_relaxed); }
+    /// Return live instance count of all instantiation types.
+    int GetTotal() const;
+    /// Return next counter in the global list.
+    RefCountedTypeCounter* GetNext() const { return next_; }
+
+    /// Return first counter in the global list. Safe to walk from any thread while types keep registering.
+    static RefCountedTypeCounter* GetFirst() { return first_.load(std::memory_order_acquire); }
+
+private:
+    /// Type name.
+    const String& typeName_;
+    /// Live instance counts by instantiation type.
+    std::atomic<int> counts_[INSTANTIATION_NET + 1];
+    /// Next counter in the global list.
+    RefCountedTypeCounter* next_;
+
+    /// Head of the global list.
+    static std::atomic<RefCountedTypeCounter*> first_;
+};
+
 /// Macro to be included in RefCounted derived classes for efficient RTTI
 #define ATOMIC_REFCOUNTED(typeName) \
     public: \
         virtual Atomic::ClassID GetClassID() const { return GetClassIDStatic(); } \
         static Atomic::ClassID GetClassIDStatic() { static const int typeID = 0; return (Atomic::ClassID) &typeID; } \
         virtual const String& GetTypeName() const { return GetTypeNameStatic(); } \
-        static const String& GetTypeNameStatic() { static const String _typeName(#typeName); return _typeName; }
+        static const String& GetTypeNameStatic() { static const String _typeName(#typeName); return _typeName; } \
+        virtual Atomic::RefCountedTypeCounter& GetTypeCounter() const { return GetTypeCounterStatic(); } \
+        static Atomic::RefCountedTypeCounter& GetTypeCounterStatic() { static Atomic::RefCountedTypeCounter typeCounter(GetTypeNameStatic()); return typeCounter; }
 
 // ATOMIC END
 
@@ -128,12 +169,15 @@ public:
     virtual ClassID GetClassID() const  = 0;
     static ClassID GetClassIDStatic() { static const int typeID = 0; return (ClassID) &typeID; }
 
+    /// Return the live instance counter of the most derived type.
+    virtual RefCountedTypeCounter& GetTypeCounter() const = 0;
+
     /// JavaScript VM, heap object which can be pushed directly on stack without any lookups
     inline void* JSGetHeapPtr() const { return jsHeapPtr_; }
     inline void  JSSetHeapPtr(void* heapptr) { jsHeapPtr_ = heapptr; }
 
     inline InstantiationType GetInstantiationType()  const { return instantiationType_; }
-    inline void SetInstantiationType(InstantiationType type) { instantiationType_ = type; }
+    void SetInstantiationType(InstantiationType type);
 
     static void AddRefCountChangedFunction(RefCountChangedFunction function);
     static void RemoveRefCountChangedFunction(RefCountChangedFunction function);
@@ -144,6 +188,13 @@ public:
     static void AddRefCountedDeletedFunction(RefCountedDeletedFunction function);
     static void RemoveRefCountedDeletedFunction(RefCountedDeletedFunction function);
 
+    /// Enable or disable per-type instance counting. Live instances are registered with their type counter on their next reference, including ones created before enabling. An instance referenced inside a constructor is first counted under the constructing base type, and moved to its most derived type on its next reference after construction.
+    static void SetInstanceCounting(bool enable) { instanceCounting_.store(enable, std::memory_order_relaxed); }
+    /// Return whether per-type instance counting is enabled.
+    static bool GetInstanceCounting() { return instanceCounting_.load(std::memory_order_relaxed); }
+    /// Set function called on the registering thread whenever an instance is registered with a type counter, or null to disable. Called again if the instance moves from a base type counter to its most derived type.
+    static void SetRefCountedRegisteredFunction(RefCountedRegisteredFunction function) { refCountedRegisteredFunction_.store(function, std::memory_order_relaxed); }
+
 // ATOMIC END
 
 private:
@@ -157,8 +208,16 @@ private:
 
     // ATOMIC BEGIN
 
+    /// Register with the type counter of the most derived type, or move there from a base type counter.
+    void RegisterInstance();
+
     InstantiationType instantiationType_;
     void* jsHeapPtr_;
+    /// Type counter this instance is counted in, null if not registered.
+    RefCountedTypeCounter* typeCounter_;
+
+    static std::atomic<bool> instanceCounting_;
+    static std::atomic<RefCountedRegisteredFunction> refCountedRegisteredFunction_;
 
     static PODVector<RefCountChangedFunction> refCountChangedFunctions_;
     static PODVector<RefCountedCreatedFunction> refCountedCreatedFunctions_;
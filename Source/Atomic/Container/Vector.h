@@ -39,8 +39,8 @@
 namespace Atomic
 {
 
-/// %Vector template class.
-template <class T> class Vector : public VectorBase
+/// %Vector template class. The allocation policy A provides the element buffer storage.
+template <class T, class A = HeapAllocatorPolicy> class Vector : public VectorBase
 {
 public:
     typedef T ValueType;
@@ -73,7 +73,7 @@ public:
     }
 
     /// Construct from another vector.
-    Vector(const Vector<T>& vector)
+    Vector(const Vector<T, A>& vector)
     {
         *this = vector;
     }
@@ -91,11 +91,11 @@ public:
     ~Vector()
     {
         DestructElements(Buffer(), size_);
-        delete[] buffer_;
+        A::FreeBuffer(buffer_);
     }
 
     /// Assign from another vector.
-    Vector<T>& operator =(const Vector<T>& rhs)
+    Vector<T, A>& operator =(const Vector<T, A>& rhs)
     {
         // In case of self-assignment do nothing
         if (&rhs != this)
@@ -107,37 +107,37 @@ public:
     }
 
     /// Add-assign an element.
-    Vector<T>& operator +=(const T& rhs)
+    Vector<T, A>& operator +=(const T& rhs)
     {
         Push(rhs);
         return *this;
     }
 
     /// Add-assign another vector.
-    Vector<T>& operator +=(const Vector<T>& rhs)
+    Vector<T, A>& operator +=(const Vector<T, A>& rhs)
     {
         Push(rhs);
         return *this;
     }
 
     /// Add an element.
-    Vector<T> operator +(const T& rhs) const
+    Vector<T, A> operator +(const T& rhs) const
     {
-        Vector<T> ret(*this);
+        Vector<T, A> ret(*this);
         ret.Push(rhs);
         return ret;
     }
 
     /// Add another vector.
-    Vector<T> operator +(const Vector<T>& rhs) const
+    Vector<T, A> operator +(const Vector<T, A>& rhs) const
     {
-        Vector<T> ret(*this);
+        Vector<T, A> ret(*this);
         ret.Push(rhs);
         return ret;
     }
 
     /// Test for equality with another vector.
-    bool operator ==(const Vector<T>& rhs) const
+    bool operator ==(const Vector<T, A>& rhs) const
     {
         if (rhs.size_ != size_)
             return false;
@@ -154,7 +154,7 @@ public:
     }
 
     /// Test for inequality with another vector.
-    bool operator !=(const Vector<T>& rhs) const
+    bool operator !=(const Vector<T, A>& rhs) const
     {
         if (rhs.size_ != size_)
             return true;
@@ -215,7 +215,7 @@ public:
 #endif
 
     /// Add another vector at the end.
-    void Push(const Vector<T>& vector) { InsertElements(size_, vector.Begin(), vector.End()); }
+    void Push(const Vector<T, A>& vector) { InsertElements(size_, vector.Begin(), vector.End()); }
 
     /// Remove the last element.
     void Pop()
@@ -231,7 +231,7 @@ public:
     }
 
     /// Insert another vector at position.
-    void Insert(unsigned pos, const Vector<T>& vector)
+    void Insert(unsigned pos, const Vector<T, A>& vector)
     {
         InsertElements(pos, vector.Begin(), vector.End());
     }
@@ -244,7 +244,7 @@ public:
     }
 
     /// Insert a vector by iterator.
-    Iterator Insert(const Iterator& dest, const Vector<T>& vector)
+    Iterator Insert(const Iterator& dest, const Vector<T, A>& vector)
     {
         unsigned pos = (unsigned)(dest - Begin());
         return InsertElements(pos, vector.Begin(), vector.End());
@@ -351,13 +351,13 @@ public:
     void Clear() { Resize(0); }
 
     /// Resize the vector.
-    void Resize(unsigned newSize) { Vector<T> tempBuffer; Resize(newSize, 0, tempBuffer); }
+    void Resize(unsigned newSize) { Vector<T, A> tempBuffer; Resize(newSize, 0, tempBuffer); }
 
     /// Resize the vector and fill new elements with default value.
     void Resize(unsigned newSize, const T& value)
     {
         unsigned oldSize = Size();
-        Vector<T> tempBuffer;
+        Vector<T, A> tempBuffer;
         Resize(newSize, 0, tempBuffer);
         for (unsigned i = oldSize; i < newSize; ++i)
             At(i) = value;
@@ -376,14 +376,14 @@ public:
 
             if (capacity_)
             {
-                newBuffer = reinterpret_cast<T*>(AllocateBuffer((unsigned)(capacity_ * sizeof(T))));
+                newBuffer = reinterpret_cast<T*>(A::AllocateBuffer((unsigned)(capacity_ * sizeof(T))));
                 // Move the data into the new buffer
                 ConstructElements(newBuffer, Buffer(), size_);
             }
 
             // Delete the old buffer
             DestructElements(Buffer(), size_);
-            delete[] buffer_;
+            A::FreeBuffer(buffer_);
             buffer_ = reinterpret_cast<unsigned char*>(newBuffer);
         }
     }
@@ -472,7 +472,7 @@ public:
 
 private:
     /// Resize the vector and create/remove new elements as necessary. Current buffer will be stored in tempBuffer in case of reallocation.
-    void Resize(unsigned newSize, const T* src, Vector<T>& tempBuffer)
+    void Resize(unsigned newSize, const T* src, Vector<T, A>& tempBuffer)
     {
         // If size shrinks, destruct the removed elements
         if (newSize < size_)
@@ -494,7 +494,7 @@ private:
                         capacity_ += (capacity_ + 1) >> 1;
                 }
 
-                buffer_ = AllocateBuffer((unsigned)(capacity_ * sizeof(T)));
+                buffer_ = A::AllocateBuffer((unsigned)(capacity_ * sizeof(T)));
                 if (tempBuffer.Buffer())
                 {
                     ConstructElements(Buffer(), tempBuffer.Buffer(), size_);
@@ -517,7 +517,7 @@ private:
         if (pos > size_)
             pos = size_;
         unsigned length = (unsigned)(end - start);
-        Vector<T> tempBuffer;
+        Vector<T, A> tempBuffer;
         Resize(size_ + length, 0, tempBuffer);
         MoveRange(pos + length, pos, size_ - pos - length);
 
@@ -577,8 +577,8 @@ private:
     }
 };
 
-/// %Vector template class for POD types. Does not call constructors or destructors and uses block move. Is intentionally (for performance reasons) unsafe for self-insertion.
-template <class T> class PODVector : public VectorBase
+/// %Vector template class for POD types. Does not call constructors or destructors and uses block move. Is intentionally (for performance reasons) unsafe for self-insertion. The allocation policy A provides the element buffer storage.
+template <class T, class A = HeapAllocatorPolicy> class PODVector : public VectorBase
 {
 public:
     typedef T ValueType;
@@ -612,7 +612,7 @@ public:
     }
 
     /// Construct from another vector.
-    PODVector(const PODVector<T>& vector)
+    PODVector(const PODVector<T, A>& vector)
     {
         *this = vector;
     }
@@ -629,11 +629,11 @@ public:
     /// Destruct.
     ~PODVector()
     {
-        delete[] buffer_;
+        A::FreeBuffer(buffer_);
     }
 
     /// Assign from another vector.
-    PODVector<T>& operator =(const PODVector<T>& rhs)
+    PODVector<T, A>& operator =(const PODVector<T, A>& rhs)
     {
         // In case of self-assignment do nothing
         if (&rhs != this)
@@ -645,37 +645,37 @@ public:
     }
 
     /// Add-assign an element.
-    PODVector<T>& operator +=(const T& rhs)
+    PODVector<T, A>& operator +=(const T& rhs)
     {
         Push(rhs);
         return *this;
     }
 
     /// Add-assign another vector.
-    PODVector<T>& operator +=(const PODVector<T>& rhs)
+    PODVector<T, A>& operator +=(const PODVector<T, A>& rhs)
     {
         Push(rhs);
         return *this;
     }
 
     /// Add an element.
-    PODVector<T> operator +(const T& rhs) const
+    PODVector<T, A> operator +(const T& rhs) const
     {
-        PODVector<T> ret(*this);
+        PODVector<T, A> ret(*this);
         ret.Push(rhs);
         return ret;
     }
 
     /// Add another vector.
-    PODVector<T> operator +(const PODVector<T>& rhs) const
+    PODVector<T, A> operator +(const PODVector<T, A>& rhs) const
     {
-        PODVector<T> ret(*this);
+        PODVector<T, A> ret(*this);
         ret.Push(rhs);
         return ret;
     }
 
     /// Test for equality with another vector.
-    bool operator ==(const PODVector<T>& rhs) const
+    bool operator ==(const PODVector<T, A>& rhs) const
     {
         if (rhs.size_ != size_)
             return false;
@@ -692,7 +692,7 @@ public:
     }
 
     /// Test for inequality with another vector.
-    bool operator !=(const PODVector<T>& rhs) const
+    bool operator !=(const PODVector<T, A>& rhs) const
     {
         if (rhs.size_ != size_)
             return true;
@@ -747,7 +747,7 @@ public:
     }
 
     /// Add another vector at the end.
-    void Push(const PODVector<T>& vector)
+    void Push(const PODVector<T, A>& vector)
     {
         unsigned oldSize = size_;
         Resize(size_ + vector.size_);
@@ -774,7 +774,7 @@ public:
     }
 
     /// Insert another vector at position.
-    void Insert(unsigned pos, const PODVector<T>& vector)
+    void Insert(unsigned pos, const PODVector<T, A>& vector)
     {
         if (pos > size_)
             pos = size_;
@@ -797,7 +797,7 @@ public:
     }
 
     /// Insert a vector by iterator.
-    Iterator Insert(const Iterator& dest, const PODVector<T>& vector)
+    Iterator Insert(const Iterator& dest, const PODVector<T, A>& vector)
     {
         unsigned pos = (unsigned)(dest - Begin());
         if (pos > size_)
@@ -937,12 +937,12 @@ public:
                     capacity_ += (capacity_ + 1) >> 1;
             }
 
-            unsigned char* newBuffer = AllocateBuffer((unsigned)(capacity_ * sizeof(T)));
+            unsigned char* newBuffer = A::AllocateBuffer((unsigned)(capacity_ * sizeof(T)));
             // Move the data into the new buffer and delete the old
             if (buffer_)
             {
                 CopyElements(reinterpret_cast<T*>(newBuffer), Buffer(), size_);
-                delete[] buffer_;
+                A::FreeBuffer(buffer_);
             }
             buffer_ = newBuffer;
         }
@@ -963,13 +963,13 @@ public:
 
             if (capacity_)
             {
-                newBuffer = AllocateBuffer((unsigned)(capacity_ * sizeof(T)));
+                newBuffer = A::AllocateBuffer((unsigned)(capacity_ * sizeof(T)));
                 // Move the data into the new buffer
                 CopyElements(reinterpret_cast<T*>(newBuffer), Buffer(), size_);
             }
 
             // Delete the old buffer
-            delete[] buffer_;
+            A::FreeBuffer(buffer_);
             buffer_ = newBuffer;
         }
     }
@@ -1064,21 +1064,21 @@ private:
     }
 };
 
-template <class T> typename Atomic::Vector<T>::ConstIterator begin(const Atomic::Vector<T>& v) { return v.Begin(); }
+template <class T, class A> typename Atomic::Vector<T, A>::ConstIterator begin(const Atomic::Vector<T, A>& v) { return v.Begin(); }
 
-template <class T> typename Atomic::Vector<T>::ConstIterator end(const Atomic::Vector<T>& v) { return v.End(); }
+template <class T, class A> typename Atomic::Vector<T, A>::ConstIterator end(const Atomic::Vector<T, A>& v) { return v.End(); }
 
-template <class T> typename Atomic::Vector<T>::Iterator begin(Atomic::Vector<T>& v) { return v.Begin(); }
+template <class T, class A> typename Atomic::Vector<T, A>::Iterator begin(Atomic::Vector<T, A>& v) { return v.Begin(); }
 
-template <class T> typename Atomic::Vector<T>::Iterator end(Atomic::Vector<T>& v) { return v.End(); }
+template <class T, class A> typename Atomic::Vector<T, A>::Iterator end(Atomic::Vector<T, A>& v) { return v.End(); }
 
-template <class T> typename Atomic::PODVector<T>::ConstIterator begin(const Atomic::PODVector<T>& v) { return v.Begin(); }
+template <class T, class A> typename Atomic::PODVector<T, A>::ConstIterator begin(const Atomic::PODVector<T, A>& v) { return v.Begin(); }
 
-template <class T> typename Atomic::PODVector<T>::ConstIterator end(const Atomic::PODVector<T>& v) { return v.End(); }
+template <class T, class A> typename Atomic::PODVector<T, A>::ConstIterator end(const Atomic::PODVector<T, A>& v) { return v.End(); }
 
-template <class T> typename Atomic::PODVector<T>::Iterator begin(Atomic::PODVector<T>& v) { return v.Begin(); }
+template <class T, class A> typename Atomic::PODVector<T, A>::Iterator begin(Atomic::PODVector<T, A>& v) { return v.Begin(); }
 
-template <class T> typename Atomic::PODVector<T>::Iterator end(Atomic::PODVector<T>& v) { return v.End(); }
+template <class T, class A> typename Atomic::PODVector<T, A>::Iterator end(Atomic::PODVector<T, A>& v) { return v.End(); }
 
 }
 
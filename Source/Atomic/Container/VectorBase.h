@@ -24,6 +24,7 @@
 
 #include "Atomic/Atomic.h"
 
+#include "../Container/Allocator.h"
 #include "../Container/Swap.h"
 
 namespace Atomic
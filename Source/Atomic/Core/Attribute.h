@@ -51,6 +51,86 @@ static const unsigned AM_FILEREADONLY = 0x81;
 
 class Serializable;
 
+// ATOMIC BEGIN
+
+/// Network encoding of a replicated attribute value.
+enum AttributeNetEncodingMode
+{
+    /// Full precision variant data.
+    NET_ENCODING_DEFAULT = 0,
+    /// Each float component as a 16-bit half float. For float and Vector2 - Vector4 attributes.
+    NET_ENCODING_HALF,
+    /// Each float component as a fixed point value within a range. For float and Vector2 - Vector4 attributes.
+    NET_ENCODING_FIXED,
+    /// Unit quaternion as the index of the largest component and the three smallest components. For Quaternion attributes.
+    NET_ENCODING_SMALLEST_THREE
+};
+
+/// Network encoding hint of a replicated attribute. Encoded attributes are bit-packed together in delta and latest data updates.
+/// Server and clients must use the same hints.
+struct AttributeNetEncoding
+{
+    /// Construct as full precision.
+    AttributeNetEncoding() :
+        mode_(NET_ENCODING_DEFAULT),
+        bits_(0),
+        minValue_(0.0f),
+        maxValue_(0.0f)
+    {
+    }
+
+    /// Construct with mode, bits per component for fixed point modes, and value range for NET_ENCODING_FIXED.
+    AttributeNetEncoding(AttributeNetEncodingMode mode, unsigned bits = 0, float minValue = 0.0f, float maxValue = 0.0f) :
+        mode_(mode),
+        bits_(bits),
+        minValue_(minValue),
+        maxValue_(maxValue)
+    {
+    }
+
+    /// Return number of bits an attribute value of the given type is encoded in, or 0 if not bit-packed.
+    unsigned GetNumBits(VariantType type) const
+    {
+        unsigned numComponents = 0;
+        switch (type)
+        {
+        case VAR_FLOAT:
+            numComponents = 1;
+            break;
+        case VAR_VECTOR2:
+            numComponents = 2;
+            break;
+        case VAR_VECTOR3:
+            numComponents = 3;
+            break;
+        case VAR_VECTOR4:
+            numComponents = 4;
+            break;
+        case VAR_QUATERNION:
+            return mode_ == NET_ENCODING_SMALLEST_THREE && bits_ >= 1 && bits_ <= 32 ? 2 + 3 * bits_ : 0;
+        default:
+            return 0;
+        }
+
+        if (mode_ == NET_ENCODING_HALF)
+            return 16 * numComponents;
+        if (mode_ == NET_ENCODING_FIXED && bits_ >= 1 && bits_ <= 32 && maxValue_ > minValue_)
+            return bits_ * numComponents;
+        return 0;
+    }
+
+    /// Encoding mode.
+    AttributeNetEncodingMode mode_;
+    /// Bits per component for fixed point modes.
+    unsigned bits_;
+    /// Minimum value for NET_ENCODING_FIXED.
+    float minValue_;
+    /// Maximum value for NET_ENCODING_FIXED.
+    float maxValue_;
+};
+
+// ATOMIC END
+
 /// Abstract base class for invoking attribute accessors.
 class ATOMIC_API AttributeAccessor : public RefCounted
 {
@@ -164,6 +244,10 @@ struct AttributeInfo
     unsigned mode_;
     /// Attribute data pointer if elsewhere than in the Serializable.
     void* ptr_;
+    // ATOMIC BEGIN
+    /// Network encoding hint.
+    AttributeNetEncoding netEncoding_;
+    // ATOMIC END
 };
 
 }
@@ -24,6 +24,9 @@
 
 #include "../Core/Context.h"
 // ATOMIC BEGIN
+#include "../Core/EventQueue.h"
+// ATOMIC END
+// ATOMIC BEGIN
 #include "../Core/Profiler.h"
 // ATOMIC END
 #include "../IO/Log.h"
@@ -79,6 +82,56 @@ void EventReceiverGroup::EndSendEvent()
     }
 }
 
+// ATOMIC BEGIN
+
+EventChannel::EventChannel() :
+    sender_(0)
+{
+}
+
+EventChannel::EventChannel(Object* sender, StringHash eventType) :
+    sender_(0)
+{
+    Resolve(sender, eventType);
+}
+
+void EventChannel::Resolve(Object* sender, StringHash eventType)
+{
+    sender_ = sender;
+    eventType_ = eventType;
+
+    if (sender_)
+    {
+        Context* context = sender_->GetContext();
+        specificReceivers_ = context->GetOrCreateEventReceivers(sender_, eventType_);
+        receivers_ = context->GetOrCreateEventReceivers(eventType_);
+    }
+    else
+    {
+        specificReceivers_.Reset();
+        receivers_.Reset();
+    }
+}
+
+void EventChannel::Send(VariantMap& eventData)
+{
+    if (sender_)
+        sender_->DispatchEvent(eventType_, eventData, 0, this);
+}
+
+void EventChannel::Send(const EventPayload& payload)
+{
+    if (sender_)
+        sender_->DispatchEvent(eventType_, sender_->GetEventDataMap(), &payload, this);
+}
+
+bool EventChannel::HasReceivers() const
+{
+    return (specificReceivers_ && !specificReceivers_->receivers_.Empty()) || (receivers_ && !receivers_->receivers_.Empty());
+}
+
+// ATOMIC END
+
 void EventReceiverGroup::Add(Object* object)
 {
     if (object)
@@ -100,9 +153,9 @@ void EventReceiverGroup::Remove(Object* object)
         receivers_.Remove(object);
 }
 
-void RemoveNamedAttribute(HashMap<StringHash, Vector<AttributeInfo> >& attributes, StringHash objectType, const char* name)
+void RemoveNamedAttribute(FlatHashMap<StringHash, Vector<AttributeInfo> >& attributes, StringHash objectType, const char* name)
 {
-    HashMap<StringHash, Vector<AttributeInfo> >::Iterator i = attributes.Find(objectType);
+    FlatHashMap<StringHash, Vector<AttributeInfo> >::Iterator i = attributes.Find(objectType);
     if (i == attributes.End())
         return;
 
@@ -125,7 +178,8 @@ void RemoveNamedAttribute(HashMap<StringHash, Vector<AttributeInfo> >& attribute
 Context::Context() :
     eventHandler_(0),
 // ATOMIC BEGIN
-    editorContext_(false)
+    editorContext_(false),
+    eventQueue_(new EventQueue())
 // ATOMIC END
 {
 #ifdef __ANDROID__
@@ -159,7 +213,7 @@ Context::~Context()
 // ATOMIC BEGIN
 SharedPtr<Object> Context::CreateObject(StringHash objectType, const XMLElement& source)
 {
-    HashMap<StringHash, SharedPtr<ObjectFactory> >::ConstIterator i = factories_.Find(objectType);
+    FlatHashMap<StringHash, SharedPtr<ObjectFactory> >::ConstIterator i = factories_.Find(objectType);
     if (i != factories_.End())
         return i->second_->CreateObject(source);
     else
@@ -195,7 +249,7 @@ void Context::RegisterSubsystem(Object* object)
 
 void Context::RemoveSubsystem(StringHash objectType)
 {
-    HashMap<StringHash, SharedPtr<Object> >::Iterator i = subsystems_.Find(objectType);
+    FlatHashMap<StringHash, SharedPtr<Object> >::Iterator i = subsystems_.Find(objectType);
     if (i != subsystems_.End())
         subsystems_.Erase(i);
 }
@@ -229,6 +283,35 @@ void Context::UpdateAttributeDefaultValue(StringHash objectType, const char* nam
         info->defaultValue_ = defaultValue;
 }
 
+// ATOMIC BEGIN
+void Context::SetAttributeNetEncoding(StringHash objectType, const char* name, const AttributeNetEncoding& encoding)
+{
+    AttributeInfo* info = GetAttribute(objectType, name);
+    if (!info)
+        return;
+
+    if (encoding.mode_ != NET_ENCODING_DEFAULT && !encoding.GetNumBits(info->type_))
+    {
+        ATOMIC_LOGWARNING("Unsupported network encoding for attribute " + String(name) + " of type " +
+            Variant::GetTypeName(info->type_) + " in class " + GetTypeName(objectType));
+        return;
+    }
+
+    info->netEncoding_ = encoding;
+
+    // The network attributes are a separate copy, which the replication uses
+    FlatHashMap<StringHash, Vector<AttributeInfo> >::Iterator i = networkAttributes_.Find(objectType);
+    if (i == networkAttributes_.End())
+        return;
+
+    for (Vector<AttributeInfo>::Iterator j = i->second_.Begin(); j != i->second_.End(); ++j)
+    {
+        if (!j->name_.Compare(name, true))
+            j->netEncoding_ = encoding;
+    }
+}
+// ATOMIC END
+
 VariantMap& Context::GetEventDataMap()
 {
     unsigned nestingLevel = eventSenders_.Size();
@@ -344,7 +427,7 @@ void Context::CopyBaseAttributes(StringHash baseType, StringHash derivedType)
 
 Object* Context::GetSubsystem(StringHash type) const
 {
-    HashMap<StringHash, SharedPtr<Object> >::ConstIterator i = subsystems_.Find(type);
+    FlatHashMap<StringHash, SharedPtr<Object> >::ConstIterator i = subsystems_.Find(type);
     if (i != subsystems_.End())
         return i->second_;
     else
@@ -375,7 +458,7 @@ const String& Context::GetTypeName(StringHash objectType) const
     // ATOMIC BEGIN
 
     // Search factories to find the hash-to-name mapping
-    HashMap<StringHash, SharedPtr<ObjectFactory> >::ConstIterator i = factories_.Find(objectType);
+    FlatHashMap<StringHash, SharedPtr<ObjectFactory> >::ConstIterator i = factories_.Find(objectType);
     return i != factories_.End() ? i->second_->GetFactoryTypeName() : String::EMPTY;
     
     // ATOMIC END
@@ -383,7 +466,7 @@ const String& Context::GetTypeName(StringHash objectType) const
 
 AttributeInfo* Context::GetAttribute(StringHash objectType, const char* name)
 {
-    HashMap<StringHash, Vector<AttributeInfo> >::Iterator i = attributes_.Find(objectType);
+    FlatHashMap<StringHash, Vector<AttributeInfo> >::Iterator i = attributes_.Find(objectType);
     if (i == attributes_.End())
         return 0;
 
@@ -414,6 +497,26 @@ void Context::AddEventReceiver(Object* receiver, Object* sender, StringHash even
     group->Add(receiver);
 }
 
+// ATOMIC BEGIN
+
+EventReceiverGroup* Context::GetOrCreateEventReceivers(Object* sender, StringHash eventType)
+{
+    SharedPtr<EventReceiverGroup>& group = specificEventReceivers_[sender][eventType];
+    if (!group)
+        group = new EventReceiverGroup();
+    return group;
+}
+
+EventReceiverGroup* Context::GetOrCreateEventReceivers(StringHash eventType)
+{
+    SharedPtr<EventReceiverGroup>& group = eventReceivers_[eventType];
+    if (!group)
+        group = new EventReceiverGroup();
+    return group;
+}
+
+// ATOMIC END
+
 void Context::RemoveEventSender(Object* sender)
 {
     HashMap<Object*, HashMap<StringHash, SharedPtr<EventReceiverGroup> > >::Iterator i = specificEventReceivers_.Find(sender);
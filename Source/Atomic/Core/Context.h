@@ -22,6 +22,9 @@
 
 #pragma once
 
+// ATOMIC BEGIN
+#include "../Container/FlatHashMap.h"
+// ATOMIC END
 #include "../Container/HashSet.h"
 #include "../Core/Attribute.h"
 #include "../Core/Object.h"
@@ -31,6 +34,8 @@ namespace Atomic
 
 // ATOMIC BEGIN
 
+class EventQueue;
+
 class GlobalEventListener
 {
 public:
@@ -74,10 +79,53 @@ private:
     bool dirty_;
 };
 
+// ATOMIC BEGIN
+
+/// Pre-resolved channel for sending one event type from one sender. Holds the sender's receiver groups, so that sending skips the receiver lookups in Context. Must not outlive the sender.
+class ATOMIC_API EventChannel
+{
+    friend class Object;
+
+public:
+    /// Construct unresolved.
+    EventChannel();
+    /// Construct and resolve for a sender and event type.
+    EventChannel(Object* sender, StringHash eventType);
+
+    /// Resolve the receiver groups of a sender and event type. Creates empty groups in the context if necessary.
+    void Resolve(Object* sender, StringHash eventType);
+    /// Send the event with parameters.
+    void Send(VariantMap& eventData);
+    /// Send the event with a typed payload. The payload is converted to a VariantMap only for global listeners and receivers without a payload handler.
+    void Send(const EventPayload& payload);
+
+    /// Return sender, or null if not resolved.
+    Object* GetSender() const { return sender_; }
+    /// Return event type.
+    StringHash GetEventType() const { return eventType_; }
+    /// Return whether any receiver is subscribed. Global listeners are not included.
+    bool HasReceivers() const;
+
+private:
+    /// Sender.
+    Object* sender_;
+    /// Event type.
+    StringHash eventType_;
+    /// Receivers of the event from this sender.
+    SharedPtr<EventReceiverGroup> specificReceivers_;
+    /// Receivers of the event from any sender.
+    SharedPtr<EventReceiverGroup> receivers_;
+};
+
+// ATOMIC END
+
 /// Urho3D execution context. Provides access to subsystems, object factories and attributes, and event receivers.
 class ATOMIC_API Context : public RefCounted
 {
     friend class Object;
+    // ATOMIC BEGIN
+    friend class EventChannel;
+    // ATOMIC END
 
     ATOMIC_REFCOUNTED(Context)
 
@@ -113,6 +161,10 @@ public:
     void RemoveAttribute(StringHash objectType, const char* name);
     /// Update object attribute's default value.
     void UpdateAttributeDefaultValue(StringHash objectType, const char* name, const Variant& defaultValue);
+    // ATOMIC BEGIN
+    /// Set object attribute's network encoding hint.
+    void SetAttributeNetEncoding(StringHash objectType, const char* name, const AttributeNetEncoding& encoding);
+    // ATOMIC END
     /// Return a preallocated map for event data. Used for optimization to avoid constant re-allocation of event data maps.
     VariantMap& GetEventDataMap();
     /// Initialises the specified SDL systems, if not already. Returns true if successful. This call must be matched with ReleaseSDL() when SDL functions are no longer required, even if this call fails.
@@ -142,6 +194,10 @@ public:
     template <class T, class U> void CopyBaseAttributes();
     /// Template version of updating an object attribute's default value.
     template <class T> void UpdateAttributeDefaultValue(const char* name, const Variant& defaultValue);
+    // ATOMIC BEGIN
+    /// Template version of setting an object attribute's network encoding hint.
+    template <class T> void SetAttributeNetEncoding(const char* name, const AttributeNetEncoding& encoding);
+    // ATOMIC END
 
     /// Return subsystem by type.
     Object* GetSubsystem(StringHash type) const;
@@ -156,10 +212,10 @@ public:
     void SetGlobalVar(StringHash key, const Variant& value);
 
     /// Return all subsystems.
-    const HashMap<StringHash, SharedPtr<Object> >& GetSubsystems() const { return subsystems_; }
+    const FlatHashMap<StringHash, SharedPtr<Object> >& GetSubsystems() const { return subsystems_; }
 
     /// Return all object factories.
-    const HashMap<StringHash, SharedPtr<ObjectFactory> >& GetObjectFactories() const { return factories_; }
+    const FlatHashMap<StringHash, SharedPtr<ObjectFactory> >& GetObjectFactories() const { return factories_; }
 
     /// Return all object categories.
     const HashMap<String, Vector<StringHash> >& GetObjectCategories() const { return objectCategories_; }
@@ -182,19 +238,19 @@ public:
     /// Return attribute descriptions for an object type, or null if none defined.
     const Vector<AttributeInfo>* GetAttributes(StringHash type) const
     {
-        HashMap<StringHash, Vector<AttributeInfo> >::ConstIterator i = attributes_.Find(type);
+        FlatHashMap<StringHash, Vector<AttributeInfo> >::ConstIterator i = attributes_.Find(type);
         return i != attributes_.End() ? &i->second_ : 0;
     }
 
     /// Return network replication attribute descriptions for an object type, or null if none defined.
     const Vector<AttributeInfo>* GetNetworkAttributes(StringHash type) const
     {
-        HashMap<StringHash, Vector<AttributeInfo> >::ConstIterator i = networkAttributes_.Find(type);
+        FlatHashMap<StringHash, Vector<AttributeInfo> >::ConstIterator i = networkAttributes_.Find(type);
         return i != networkAttributes_.End() ? &i->second_ : 0;
     }
 
     /// Return all registered attributes.
-    const HashMap<StringHash, Vector<AttributeInfo> >& GetAllAttributes() const { return attributes_; }
+    const FlatHashMap<StringHash, Vector<AttributeInfo> >& GetAllAttributes() const { return attributes_; }
 
     /// Return event receivers for a sender and event type, or null if they do not exist.
     EventReceiverGroup* GetEventReceivers(Object* sender, StringHash eventType)
@@ -224,6 +280,9 @@ public:
     /// Get whether an Editor Context
     void SetEditorContext(bool editor) { editorContext_ = editor; }
 
+    /// Return the queue of events posted with Object::PostEvent().
+    EventQueue* GetEventQueue() const { return eventQueue_.Get(); }
+
     // hook for listening into events
     void AddGlobalEventListener(GlobalEventListener* listener) { globalEventListeners_.Push(listener); }
     void RemoveGlobalEventListener(GlobalEventListener* listener) { globalEventListeners_.Erase(globalEventListeners_.Find(listener)); }
@@ -270,14 +329,21 @@ private:
     /// Set current event handler. Called by Object.
     void SetEventHandler(EventHandler* handler) { eventHandler_ = handler; }
 
+    // ATOMIC BEGIN
+    /// Return event receivers for a sender and event type, creating an empty group if they do not exist.
+    EventReceiverGroup* GetOrCreateEventReceivers(Object* sender, StringHash eventType);
+    /// Return event receivers for an event type, creating an empty group if they do not exist.
+    EventReceiverGroup* GetOrCreateEventReceivers(StringHash eventType);
+    // ATOMIC END
+
     /// Object factories.
-    HashMap<StringHash, SharedPtr<ObjectFactory> > factories_;
+    FlatHashMap<StringHash, SharedPtr<ObjectFactory> > factories_;
     /// Subsystems.
-    HashMap<StringHash, SharedPtr<Object> > subsystems_;
+    FlatHashMap<StringHash, SharedPtr<Object> > subsystems_;
     /// Attribute descriptions per object type.
-    HashMap<StringHash, Vector<AttributeInfo> > attributes_;
+    FlatHashMap<StringHash, Vector<AttributeInfo> > attributes_;
     /// Network replication attribute descriptions per object type.
-    HashMap<StringHash, Vector<AttributeInfo> > networkAttributes_;
+    FlatHashMap<StringHash, Vector<AttributeInfo> > networkAttributes_;
     /// Event receivers for non-specific events.
     HashMap<StringHash, SharedPtr<EventReceiverGroup> > eventReceivers_;
     /// Event receivers for specific senders' events.
@@ -311,6 +377,8 @@ private:
 
     PODVector<GlobalEventListener*> globalEventListeners_;
     bool editorContext_;
+    /// Events posted from any thread for delivery on the main thread.
+    UniquePtr<EventQueue> eventQueue_;
 
     WeakPtr<Engine> engine_;
     WeakPtr<Time> time_;
@@ -363,4 +431,11 @@ template <class T> void Context::UpdateAttributeDefaultValue(const char* name, c
     UpdateAttributeDefaultValue(T::GetTypeStatic(), name, defaultValue);
 }
 
+// ATOMIC BEGIN
+template <class T> void Context::SetAttributeNetEncoding(const char* name, const AttributeNetEncoding& encoding)
+{
+    SetAttributeNetEncoding(T::GetTypeStatic(), name, encoding);
+}
+// ATOMIC END
+
 }
@@ -64,6 +64,28 @@ ATOMIC_EVENT(E_ENDFRAME, EndFrame)
 }
 
 // ATOMIC BEGIN
+/// Typed payload of the E_UPDATE, E_POSTUPDATE, E_RENDERUPDATE and E_POSTRENDERUPDATE events.
+struct ATOMIC_API UpdateEventPayload : public EventPayload
+{
+    /// Construct.
+    UpdateEventPayload(float timeStep = 0.0f) :
+        timeStep_(timeStep)
+    {
+    }
+
+    /// Write the parameters to an event data map.
+    virtual void ToVariantMap(VariantMap& eventData) const { eventData[Update::P_TIMESTEP] = timeStep_; }
+    /// Read the parameters from an event data map.
+    virtual void FromVariantMap(const VariantMap& eventData)
+    {
+        VariantMap::ConstIterator i = eventData.Find(Update::P_TIMESTEP);
+        timeStep_ = i != eventData.End() ? i->second_.GetFloat() : 0.0f;
+    }
+
+    /// Frame timestep.
+    float timeStep_;
+};
+
 /// Updating paused or resumed event.
 ATOMIC_EVENT(E_UPDATESPAUSEDRESUMED, UpdatesPaused)
 {
@@ -0,0 +1,188 @@
+//
+// Copyright (c) 2014-2017 THUNDERBEAST GAMES LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../Precompiled.h"
+
+#include "../Core/EventQueue.h"
+#include "../Core/Object.h"
+#include "../Core/Profiler.h"
+#include "../Core/Thread.h"
+#include "../IO/Log.h"
+
+#include "../DebugNew.h"
+
+namespace Atomic
+{
+
+/// Return whether variant holds a RefCounted pointer, directly or inside a nested vector or map.
+static bool HoldsRefCounted(const Variant& value)
+{
+    switch (value.GetType())
+    {
+    case VAR_PTR:
+        return true;
+
+    case VAR_VARIANTVECTOR:
+        {
+            const VariantVector& vector = value.GetVariantVector();
+            for (unsigned i = 0; i < vector.Size(); ++i)
+            {
+                if (HoldsRefCounted(vector[i]))
+                    return true;
+            }
+            return false;
+        }
+
+    case VAR_VARIANTMAP:
+        {
+            const VariantMap& map = value.GetVariantMap();
+            for (VariantMap::ConstIterator i = map.Begin(); i != map.End(); ++i)
+            {
+                if (HoldsRefCounted(i->second_))
+                    return true;
+            }
+            return false;
+        }
+
+    default:
+        return false;
+    }
+}
+
+EventQueue::EventQueue() :
+    numDelivered_(0),
+    numCoalesced_(0),
+    flushing_(false)
+{
+}
+
+EventQueue::~EventQueue()
+{
+}
+
+void EventQueue::Post(Object* sender, StringHash eventType, const VariantMap& eventData, bool coalesce)
+{
+    if (!Thread::IsMainThread())
+    {
+        for (VariantMap::ConstIterator i = eventData.Begin(); i != eventData.End(); ++i)
+        {
+            if (HoldsRefCounted(i->second_))
+            {
+                ATOMIC_LOGERROR("Events posted outside the main thread can not hold RefCounted pointers");
+                return;
+            }
+        }
+    }
+
+    PostedEvent event;
+    event.sender_ = sender;
+    event.eventType_ = eventType;
+    event.eventData_ = eventData;
+    event.coalesce_ = coalesce;
+    queue_.Push(event);
+}
+
+void EventQueue::Flush()
+{
+    if (!Thread::IsMainThread())
+    {
+        ATOMIC_LOGERROR("Posted events can only be flushed from the main thread");
+        return;
+    }
+
+    // Sending an event during the flush must not flush again
+    if (flushing_)
+        return;
+
+    queue_.PopAll(pending_);
+
+    numDelivered_ = 0;
+    numCoalesced_ = 0;
+
+    if (pending_.Empty())
+        return;
+
+    ATOMIC_PROFILE(FlushPostedEvents);
+
+    flushing_ = true;
+    delivering_.Swap(pending_);
+
+    // Walk newest first, so that the latest of coalesced events is the one kept
+    coalesced_.Clear();
+    for (unsigned i = delivering_.Size() - 1; i < delivering_.Size(); --i)
+    {
+        PostedEvent& event = delivering_[i];
+        if (!event.sender_ || !event.coalesce_)
+            continue;
+
+        Pair<Object*, StringHash> key(event.sender_, event.eventType_);
+        if (coalesced_.Contains(key))
+        {
+            event.sender_ = 0;
+            ++numCoalesced_;
+        }
+        else
+            coalesced_.Insert(key);
+    }
+
+    // Note: delivering_ is not resized while sending, as RemoveSender() only clears senders in it
+    for (unsigned i = 0; i < delivering_.Size(); ++i)
+    {
+        PostedEvent& event = delivering_[i];
+        if (!event.sender_)
+            continue;
+
+        event.sender_->SendEvent(event.eventType_, event.eventData_);
+        ++numDelivered_;
+    }
+
+    delivering_.Clear();
+    flushing_ = false;
+}
+
+void EventQueue::RemoveSender(Object* sender)
+{
+    // Senders destroyed in other threads must not have undelivered events
+    if (!Thread::IsMainThread() || (queue_.Empty() && pending_.Empty() && !flushing_))
+        return;
+
+    // Take the events posted so far off the lock-free queue, as it can not be modified in place
+    queue_.PopAll(pending_);
+
+    for (unsigned i = 0; i < pending_.Size(); ++i)
+    {
+        if (pending_[i].sender_ == sender)
+            pending_[i].sender_ = 0;
+    }
+
+    if (flushing_)
+    {
+        for (unsigned i = 0; i < delivering_.Size(); ++i)
+        {
+            if (delivering_[i].sender_ == sender)
+                delivering_[i].sender_ = 0;
+        }
+    }
+}
+
+}
@@ -0,0 +1,94 @@
+//
+// Copyright (c) 2014-2017 THUNDERBEAST GAMES LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "../Container/HashSet.h"
+#include "../Container/MPSCQueue.h"
+#include "../Container/Pair.h"
+#include "../Core/Variant.h"
+
+namespace Atomic
+{
+
+class Object;
+
+/// Event posted with Object::PostEvent(), waiting for delivery.
+struct PostedEvent
+{
+    /// Construct.
+    PostedEvent() :
+        sender_(0),
+        coalesce_(false)
+    {
+    }
+
+    /// Sender. Null if the sender was destroyed or the event was coalesced.
+    Object* sender_;
+    /// Event type.
+    StringHash eventType_;
+    /// Event parameters.
+    VariantMap eventData_;
+    /// Coalesce flag.
+    bool coalesce_;
+};
+
+/// Queue of events posted from any thread, delivered in one batch on the main thread by Engine::RunFrame().
+class ATOMIC_API EventQueue
+{
+public:
+    /// Construct.
+    EventQueue();
+    /// Destruct. Undelivered events are discarded.
+    ~EventQueue();
+
+    /// Post an event. Safe to call from any thread. If coalesce is true, of the events with the same sender and type posted with coalesce before the next flush, only the latest is delivered. Outside the main thread, events whose parameters hold RefCounted pointers are rejected, as copying them would touch non-atomic reference counts.
+    void Post(Object* sender, StringHash eventType, const VariantMap& eventData, bool coalesce);
+    /// Send the posted events in posting order. Must be called from the main thread. Events posted during the flush are delivered by the next flush.
+    void Flush();
+    /// Discard the undelivered events of a sender being destroyed. Called from the main thread.
+    void RemoveSender(Object* sender);
+
+    /// Return number of events sent by the last flush.
+    unsigned GetNumDelivered() const { return numDelivered_; }
+    /// Return number of events dropped by coalescing in the last flush.
+    unsigned GetNumCoalesced() const { return numCoalesced_; }
+
+private:
+    /// Events posted since the last flush.
+    MPSCQueue<PostedEvent> queue_;
+    /// Events taken from the queue during a flush, to be delivered by the next flush.
+    Vector<PostedEvent> pending_;
+    /// Events being delivered.
+    Vector<PostedEvent> delivering_;
+    /// Sender and event type pairs already seen while coalescing.
+    HashSet<Pair<Object*, StringHash> > coalesced_;
+    /// Number of events sent by the last flush.
+    unsigned numDelivered_;
+    /// Number of events dropped by coalescing in the last flush.
+    unsigned numCoalesced_;
+    /// Flush in progress flag.
+    bool flushing_;
+};
+
+}
@@ -26,6 +26,8 @@
 #include "../Core/Thread.h"
 #include "../IO/Log.h"
 // ATOMIC BEGIN
+#include "../Container/Sort.h"
+#include "../Core/EventQueue.h"
 #include "../Core/Profiler.h"
 // ATOMIC END
 
@@ -77,7 +79,8 @@ bool TypeInfo::IsTypeOf(const TypeInfo* typeInfo) const
 Object::Object(Context* context) :
     context_(context),
     // ATOMIC BEGIN
-    blockEvents_(false)
+    blockEvents_(false),
+    hasPostedEvents_(false)
     // ATOMIC END
 {
     assert(context_);
@@ -87,6 +90,10 @@ Object::~Object()
 {
     UnsubscribeFromAllEvents();
     context_->RemoveEventSender(this);
+    // ATOMIC BEGIN
+    if (hasPostedEvents_)
+        context_->GetEventQueue()->RemoveSender(this);
+    // ATOMIC END
 }
 
 void Object::OnEvent(Object* sender, StringHash eventType, VariantMap& eventData)
@@ -94,11 +101,47 @@ void Object::OnEvent(Object* sender, StringHash eventType, VariantMap& eventData
     // ATOMIC BEGIN
     if (blockEvents_)
         return;
-    // ATOMIC END
 
     // Make a copy of the context pointer in case the object is destroyed during event handler invocation
     Context* context = context_;
-    EventHandler* specific = 0;
+    EventHandler* handler = FindHandlerForEvent(sender, eventType);
+    if (handler)
+    {
+        context->SetEventHandler(handler);
+        handler->Invoke(eventData);
+        context->SetEventHandler(0);
+    }
+    // ATOMIC END
+}
+
+// ATOMIC BEGIN
+
+void Object::OnEventPayload(Object* sender, StringHash eventType, const EventPayload& payload, VariantMap& eventData, bool& eventDataValid)
+{
+    if (blockEvents_)
+        return;
+
+    Context* context = context_;
+    EventHandler* handler = FindHandlerForEvent(sender, eventType);
+    if (handler)
+    {
+        context->SetEventHandler(handler);
+        if (!handler->InvokePayload(payload))
+        {
+            // The handler takes a VariantMap, so fill it on first use. Later receivers see the same map, as with SendEvent()
+            if (!eventDataValid)
+            {
+                payload.ToVariantMap(eventData);
+                eventDataValid = true;
+            }
+            handler->Invoke(eventData);
+        }
+        context->SetEventHandler(0);
+    }
+}
+
+EventHandler* Object::FindHandlerForEvent(Object* sender, StringHash eventType) const
+{
     EventHandler* nonSpecific = 0;
 
     EventHandler* handler = eventHandlers_.First();
@@ -108,32 +151,18 @@ void Object::OnEvent(Object* sender, StringHash eventType, VariantMap& eventData
         {
             if (!handler->GetSender())
                 nonSpecific = handler;
+            // Specific event handlers have priority
             else if (handler->GetSender() == sender)
-            {
-                specific = handler;
-                break;
-            }
+                return handler;
         }
         handler = eventHandlers_.Next(handler);
     }
 
-    // Specific event handlers have priority, so if found, invoke first
-    if (specific)
-    {
-        context->SetEventHandler(specific);
-        specific->Invoke(eventData);
-        context->SetEventHandler(0);
-        return;
-    }
-
-    if (nonSpecific)
-    {
-        context->SetEventHandler(nonSpecific);
-        nonSpecific->Invoke(eventData);
-        context->SetEventHandler(0);
-    }
+    return nonSpecific;
 }
 
+// ATOMIC END
+
 bool Object::IsTypeOf(StringHash type)
 {
     return GetTypeInfoStatic()->IsTypeOf(type);
@@ -315,6 +344,22 @@ void Object::SendEvent(StringHash eventType)
 }
 // ATOMIC BEGIN
 void Object::SendEvent(StringHash eventType, VariantMap& eventData)
+{
+    DispatchEvent(eventType, eventData, 0, 0);
+}
+
+void Object::SendEventPayload(StringHash eventType, const EventPayload& payload)
+{
+    DispatchEvent(eventType, GetEventDataMap(), &payload, 0);
+}
+
+void Object::PostEvent(StringHash eventType, const VariantMap& eventData, bool coalesce)
+{
+    hasPostedEvents_ = true;
+    context_->GetEventQueue()->Post(this, eventType, eventData, coalesce);
+}
+
+void Object::DispatchEvent(StringHash eventType, VariantMap& eventData, const EventPayload* payload, EventChannel* channel)
 {
 #if ATOMIC_PROFILING
     bool eventProfilingEnabled = false;
@@ -322,13 +367,13 @@ void Object::SendEvent(StringHash eventType, VariantMap& eventData)
         eventProfilingEnabled = profiler->GetEventProfilingEnabled();
 
     if (eventProfilingEnabled)
-        SendEventProfiled(eventType, eventData);
+        SendEventProfiled(eventType, eventData, payload, channel);
     else
 #endif
-        SendEventNonProfiled(eventType, eventData);
+        SendEventNonProfiled(eventType, eventData, payload, channel);
 }
 
-void Object::SendEventProfiled(StringHash eventType, VariantMap& eventData)
+void Object::SendEventProfiled(StringHash eventType, VariantMap& eventData, const EventPayload* payload, EventChannel* channel)
 {
 #if ATOMIC_PROFILING
     String eventName;
@@ -336,10 +381,49 @@ void Object::SendEventProfiled(StringHash eventType, VariantMap& eventData)
         eventName = eventType.ToString();
     ATOMIC_PROFILE_SCOPED(eventName.CString(), PROFILER_COLOR_EVENTS);
 #endif
-    SendEventNonProfiled(eventType, eventData);
+    SendEventNonProfiled(eventType, eventData, payload, channel);
 }
 
-void Object::SendEventNonProfiled(StringHash eventType, VariantMap& eventData)
+bool Object::SendEventToGroup(EventReceiverGroup* group, StringHash eventType, VariantMap& eventData, const EventPayload* payload, bool& eventDataValid,
+    const WeakPtr<Object>& self, PODVector<Object*>* processed, const PODVector<Object*>* skip)
+{
+    group->BeginSendEvent();
+
+    const unsigned numReceivers = group->receivers_.Size();
+    for (unsigned i = 0; i < numReceivers; ++i)
+    {
+        Object* receiver = group->receivers_[i];
+        // Holes may exist if receivers removed during send
+        if (!receiver)
+            continue;
+        if (skip)
+        {
+            PODVector<Object*>::ConstIterator j = LowerBound(skip->Begin(), skip->End(), receiver);
+            if (j != skip->End() && *j == receiver)
+                continue;
+        }
+
+        if (payload)
+            receiver->OnEventPayload(this, eventType, *payload, eventData, eventDataValid);
+        else
+            receiver->OnEvent(this, eventType, eventData);
+
+        // If self has been destroyed as a result of event handling, exit
+        if (self.Expired())
+        {
+            group->EndSendEvent();
+            return false;
+        }
+
+        if (processed)
+            processed->Push(receiver);
+    }
+
+    group->EndSendEvent();
+    return true;
+}
+
+void Object::SendEventNonProfiled(StringHash eventType, VariantMap& eventData, const EventPayload* payload, EventChannel* channel)
 // ATOMIC END
 {
     if (!Thread::IsMainThread())
@@ -356,9 +440,18 @@ void Object::SendEventNonProfiled(StringHash eventType, VariantMap& eventData)
     // Make a weak pointer to self to check for destruction during event handling
     WeakPtr<Object> self(this);
     Context* context = context_;
-    HashSet<Object*> processed;
-
 // ATOMIC BEGIN
+    // Sorted for lookup, and unlike a HashSet does not allocate when no specific receivers are recorded
+    PODVector<Object*> processed;
+
+    // Global listeners (e.g. script event dispatch) always need the VariantMap
+    bool eventDataValid = !payload;
+    if (!eventDataValid && !context->globalEventListeners_.Empty())
+    {
+        payload->ToVariantMap(eventData);
+        eventDataValid = true;
+    }
+
     context->GlobalBeginSendEvent(this, eventType, eventData);
 // ATOMIC END
 
@@ -366,83 +459,34 @@ void Object::SendEventNonProfiled(StringHash eventType, VariantMap& eventData)
 
     // Check first the specific event receivers
     // Note: group is held alive with a shared ptr, as it may get destroyed along with the sender
-    SharedPtr<EventReceiverGroup> group(context->GetEventReceivers(this, eventType));
-    if (group)
+    // ATOMIC BEGIN
+    SharedPtr<EventReceiverGroup> group(channel ? channel->specificReceivers_.Get() : context->GetEventReceivers(this, eventType));
+    SharedPtr<EventReceiverGroup> nonSpecificGroup(channel ? channel->receivers_.Get() : context->GetEventReceivers(eventType));
+    if (group && !group->receivers_.Empty())
     {
-        group->BeginSendEvent();
-
-        const unsigned numReceivers = group->receivers_.Size();
-        for (unsigned i = 0; i < numReceivers; ++i)
+        // Only record the specific receivers if there may be non-specific receivers to check against
+        bool trackProcessed = !nonSpecificGroup || !nonSpecificGroup->receivers_.Empty();
+        if (!SendEventToGroup(group, eventType, eventData, payload, eventDataValid, self, trackProcessed ? &processed : 0, 0))
         {
-            Object* receiver = group->receivers_[i];
-            // Holes may exist if receivers removed during send
-            if (!receiver)
-                continue;
-
-            receiver->OnEvent(this, eventType, eventData);
-
-            // If self has been destroyed as a result of event handling, exit
-            if (self.Expired())
-            {
-                group->EndSendEvent();
-                context->EndSendEvent();
-                return;
-            }
-
-            processed.Insert(receiver);
+            context->EndSendEvent();
+            return;
         }
-
-        group->EndSendEvent();
+        Sort(processed.Begin(), processed.End());
     }
 
     // Then the non-specific receivers
-    group = context->GetEventReceivers(eventType);
-    if (group)
+    if (!nonSpecificGroup)
+        nonSpecificGroup = context->GetEventReceivers(eventType);
+    if (nonSpecificGroup && !nonSpecificGroup->receivers_.Empty())
     {
-        group->BeginSendEvent();
-
-        if (processed.Empty())
-        {
-            const unsigned numReceivers = group->receivers_.Size();
-            for (unsigned i = 0; i < numReceivers; ++i)
-            {
-                Object* receiver = group->receivers_[i];
-                if (!receiver)
-                    continue;
-
-                receiver->OnEvent(this, eventType, eventData);
-
-                if (self.Expired())
-                {
-                    group->EndSendEvent();
-                    context->EndSendEvent();
-                    return;
-                }
-            }
-        }
-        else
+        // If there were specific receivers, check that the event is not sent doubly to them
+        if (!SendEventToGroup(nonSpecificGroup, eventType, eventData, payload, eventDataValid, self, 0, processed.Empty() ? 0 : &processed))
         {
-            // If there were specific receivers, check that the event is not sent doubly to them
-            const unsigned numReceivers = group->receivers_.Size();
-            for (unsigned i = 0; i < numReceivers; ++i)
-            {
-                Object* receiver = group->receivers_[i];
-                if (!receiver || processed.Contains(receiver))
-                    continue;
-
-                receiver->OnEvent(this, eventType, eventData);
-
-                if (self.Expired())
-                {
-                    group->EndSendEvent();
-                    context->EndSendEvent();
-                    return;
-                }
-            }
+            context->EndSendEvent();
+            return;
         }
-
-        group->EndSendEvent();
     }
+    // ATOMIC END
 
     context->EndSendEvent();
 
@@ -591,10 +635,48 @@ void Object::RemoveEventSender(Object* sender)
 Atomic::StringHash EventNameRegistrar::RegisterEventName(const char* eventName)
 {
     StringHash id(eventName);
-    GetEventNameMap()[id] = eventName;
+    // ATOMIC BEGIN
+    RegisterEventName(eventName, id);
+    // ATOMIC END
     return id;
 }
 
+// ATOMIC BEGIN
+
+/// Return the event name hash collisions.
+static Vector<String>& GetEventNameCollisionsInternal()
+{
+    static Vector<String> collisions;
+    return collisions;
+}
+
+void EventNameRegistrar::RegisterEventName(const char* eventName, StringHash eventID)
+{
+    HashMap<StringHash, String>& eventNames = GetEventNameMap();
+    HashMap<StringHash, String>::Iterator i = eventNames.Find(eventID);
+    if (i == eventNames.End())
+    {
+        eventNames[eventID] = eventName;
+        return;
+    }
+
+#ifdef ATOMIC_DEBUG
+    // Names differing only by case hash the same and are the same event
+    if (i->second_.Compare(eventName, false))
+    {
+        GetEventNameCollisionsInternal().Push("Event name hash collision: " + i->second_ + " and " + String(eventName) +
+            " both hash to " + eventID.ToString());
+    }
+#endif
+}
+
+const Vector<String>& EventNameRegistrar::GetEventNameCollisions()
+{
+    return GetEventNameCollisionsInternal();
+}
+
+// ATOMIC END
+
 const String& EventNameRegistrar::GetEventName(StringHash eventID)
 {
     HashMap<StringHash, String>::ConstIterator it = GetEventNameMap().Find(eventID);
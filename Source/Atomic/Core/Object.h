@@ -40,6 +40,8 @@ class Context;
 class EventHandler;
 
 // ATOMIC BEGIN
+class EventChannel;
+class EventReceiverGroup;
 class Engine;
 class Time;
 class WorkQueue;
@@ -107,13 +109,34 @@ private:
         virtual Atomic::StringHash GetBaseType() const { return GetBaseTypeStatic(); } \
         virtual Atomic::ClassID GetClassID() const { return GetClassIDStatic(); } \
         static Atomic::ClassID GetClassIDStatic() { static const int typeID = 0; return (Atomic::ClassID) &typeID; } \
-        static Atomic::StringHash GetBaseTypeStatic() { static const Atomic::StringHash baseTypeStatic(#baseTypeName); return baseTypeStatic; }
+        static Atomic::StringHash GetBaseTypeStatic() { static const Atomic::StringHash baseTypeStatic(#baseTypeName); return baseTypeStatic; } \
+        virtual Atomic::RefCountedTypeCounter& GetTypeCounter() const { return GetTypeCounterStatic(); } \
+        static Atomic::RefCountedTypeCounter& GetTypeCounterStatic() { static Atomic::RefCountedTypeCounter typeCounter(GetTypeNameStatic()); return typeCounter; }
 
 
+// ATOMIC BEGIN
+
+/// Base class for typed event payloads, which can be sent without building a VariantMap. An event type must always be sent with the same payload class.
+struct ATOMIC_API EventPayload
+{
+    /// Destruct.
+    virtual ~EventPayload() { }
+
+    /// Write the parameters to an event data map, for global listeners and handlers that take a VariantMap.
+    virtual void ToVariantMap(VariantMap& eventData) const = 0;
+    /// Read the parameters from an event data map, for payload handlers receiving an event sent with a VariantMap.
+    virtual void FromVariantMap(const VariantMap& eventData) = 0;
+};
+
+// ATOMIC END
+
 /// Base class for objects with type identification, subsystem access and event sending/receiving capability.
 class ATOMIC_API Object : public RefCounted
 {
     friend class Context;
+    // ATOMIC BEGIN
+    friend class EventChannel;
+    // ATOMIC END
 
 public:
     /// Construct.
@@ -217,6 +240,10 @@ public:
     static const Atomic::String& GetTypeNameStatic() { static const Atomic::String typeNameStatic("Object"); return typeNameStatic; }
     /// Send event with parameters to all subscribers.
     void SendEvent(StringHash eventType, const VariantMap& eventData);
+    /// Send event with a typed payload to all subscribers. The payload is converted to a VariantMap only for global listeners and receivers without a payload handler.
+    void SendEventPayload(StringHash eventType, const EventPayload& payload);
+    /// Post event with parameters for delivery on the main thread at the start of the next frame. Safe to call from any thread. If coalesce is true, only the latest of the coalesced events with the same type from this object is delivered. The object must not be destroyed outside the main thread while it has undelivered events. Outside the main thread the parameters must not hold RefCounted pointers, as their reference counts are not atomic; such events are rejected.
+    void PostEvent(StringHash eventType, const VariantMap& eventData = Variant::emptyVariantMap, bool coalesce = false);
     /// Block object from sending and receiving events.
     void SetBlockEvents(bool block) { blockEvents_ = block; }
     /// Return sending and receiving events blocking status.
@@ -227,8 +254,8 @@ protected:
     /// Execution context.
     Context* context_;
 
-    void SendEventProfiled(StringHash eventType, VariantMap& eventData);
-    void SendEventNonProfiled(StringHash eventType, VariantMap& eventData);
+    void SendEventProfiled(StringHash eventType, VariantMap& eventData, const EventPayload* payload = 0, EventChannel* channel = 0);
+    void SendEventNonProfiled(StringHash eventType, VariantMap& eventData, const EventPayload* payload = 0, EventChannel* channel = 0);
 
 private:
     /// Find the first event handler with no specific sender.
@@ -240,11 +267,25 @@ private:
     /// Remove event handlers related to a specific sender.
     void RemoveEventSender(Object* sender);
 
+    // ATOMIC BEGIN
+    /// Send event with either a filled event data map or a payload, to the receivers resolved by a channel or looked up from the context if channel is null.
+    void DispatchEvent(StringHash eventType, VariantMap& eventData, const EventPayload* payload, EventChannel* channel);
+    /// Send event to the receivers of a group. Record the receivers to processed and skip those in the sorted skip vector, if non-null. Return false if self was destroyed.
+    bool SendEventToGroup(EventReceiverGroup* group, StringHash eventType, VariantMap& eventData, const EventPayload* payload, bool& eventDataValid,
+        const WeakPtr<Object>& self, PODVector<Object*>* processed, const PODVector<Object*>* skip);
+    /// Handle event sent with a payload. Fill the event data map from the payload only if the handler takes a VariantMap.
+    void OnEventPayload(Object* sender, StringHash eventType, const EventPayload& payload, VariantMap& eventData, bool& eventDataValid);
+    /// Return the handler for a sender's event: the specific handler if exists, otherwise the non-specific handler.
+    EventHandler* FindHandlerForEvent(Object* sender, StringHash eventType) const;
+    // ATOMIC END
+
     /// Event handlers. Sender is null for non-specific handlers.
     LinkedList<EventHandler> eventHandlers_;
 
     // ATOMIC BEGIN
     bool blockEvents_;
+    /// Whether the object has posted events, which must be discarded from the event queue on destruction.
+    bool hasPostedEvents_;
     // ATOMIC END
 };
 
@@ -336,6 +377,10 @@ public:
     virtual void Invoke(VariantMap& eventData) = 0;
     /// Return a unique copy of the event handler.
     virtual EventHandler* Clone() const = 0;
+    // ATOMIC BEGIN
+    /// Invoke event handler function with a typed payload. Return false if the handler takes a VariantMap instead.
+    virtual bool InvokePayload(const EventPayload& payload) { return false; }
+    // ATOMIC END
 
     /// Return event receiver.
     Object* GetReceiver() const { return receiver_; }
@@ -393,6 +438,53 @@ private:
     HandlerFunctionPtr function_;
 };
 
+// ATOMIC BEGIN
+
+/// Template implementation of the event handler invoke helper for typed payloads (stores a function pointer of specific class.)
+template <class T, class P> class EventHandlerPayloadImpl : public EventHandler
+{
+public:
+    typedef void (T::*HandlerFunctionPtr)(StringHash, const P&);
+
+    /// Construct with receiver and function pointers and userdata.
+    EventHandlerPayloadImpl(T* receiver, HandlerFunctionPtr function, void* userData = 0) :
+        EventHandler(receiver, userData),
+        function_(function)
+    {
+        assert(receiver_);
+        assert(function_);
+    }
+
+    /// Invoke event handler function for an event sent with a VariantMap.
+    virtual void Invoke(VariantMap& eventData)
+    {
+        P payload;
+        payload.FromVariantMap(eventData);
+        T* receiver = static_cast<T*>(receiver_);
+        (receiver->*function_)(eventType_, payload);
+    }
+
+    /// Invoke event handler function with a typed payload.
+    virtual bool InvokePayload(const EventPayload& payload)
+    {
+        T* receiver = static_cast<T*>(receiver_);
+        (receiver->*function_)(eventType_, static_cast<const P&>(payload));
+        return true;
+    }
+
+    /// Return a unique copy of the event handler.
+    virtual EventHandler* Clone() const
+    {
+        return new EventHandlerPayloadImpl(static_cast<T*>(receiver_), function_, userData_);
+    }
+
+private:
+    /// Class-specific pointer to handler function.
+    HandlerFunctionPtr function_;
+};
+
+// ATOMIC END
+
 #if ATOMIC_CXX11
 /// Template implementation of the event handler invoke helper (std::function instance).
 class EventHandler11Impl : public EventHandler
@@ -427,6 +519,14 @@ private:
 /// Register event names.
 struct ATOMIC_API EventNameRegistrar
 {
+    // ATOMIC BEGIN
+    /// Construct and register an event name with its hash.
+    EventNameRegistrar(const char* eventName, StringHash eventID) { RegisterEventName(eventName, eventID); }
+    /// Register an event name with its hash for reverse mapping. In debug builds a different name with the same hash is recorded as a collision.
+    static void RegisterEventName(const char* eventName, StringHash eventID);
+    /// Return descriptions of the event name hash collisions found so far. Only recorded in debug builds.
+    static const Vector<String>& GetEventNameCollisions();
+    // ATOMIC END
     /// Register an event name for hash reverse mapping.
     static StringHash RegisterEventName(const char* eventName);
     /// Return Event name or empty string if not found.
@@ -436,13 +536,19 @@ struct ATOMIC_API EventNameRegistrar
 };
 
 /// Describe an event's hash ID and begin a namespace in which to define its parameters.
-#define ATOMIC_EVENT(eventID, eventName) static const Atomic::StringHash eventID(Atomic::EventNameRegistrar::RegisterEventName(#eventName)); namespace eventName
+// ATOMIC BEGIN
+#define ATOMIC_EVENT(eventID, eventName) static const Atomic::StringHash eventID(#eventName); static const Atomic::EventNameRegistrar eventID##_NameRegistrar(#eventName, eventID); namespace eventName
+// ATOMIC END
 /// Describe an event's parameter hash ID. Should be used inside an event namespace.
 #define ATOMIC_PARAM(paramID, paramName) static const Atomic::StringHash paramID(#paramName)
 /// Convenience macro to construct an EventHandler that points to a receiver object and its member function.
 #define ATOMIC_HANDLER(className, function) (new Atomic::EventHandlerImpl<className>(this, &className::function))
 /// Convenience macro to construct an EventHandler that points to a receiver object and its member function, and also defines a userdata pointer.
 #define ATOMIC_HANDLER_USERDATA(className, function, userData) (new Atomic::EventHandlerImpl<className>(this, &className::function, userData))
+// ATOMIC BEGIN
+/// Convenience macro to construct an EventHandler that points to a receiver object and its member function taking a typed event payload.
+#define ATOMIC_PAYLOAD_HANDLER(className, payloadClassName, function) (new Atomic::EventHandlerPayloadImpl<className, payloadClassName>(this, &className::function))
+// ATOMIC END
 
 
 // ATOMIC BEGIN
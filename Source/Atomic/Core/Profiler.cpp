@@ -21,8 +21,11 @@
 //
 
 #include "../Precompiled.h"
+#include "../Core/CoreEvents.h"
 #include "../Core/Profiler.h"
 #include "../Core/StringUtils.h"
+#include "../IO/File.h"
+#include "../IO/Log.h"
 
 namespace Atomic
 {
@@ -147,6 +150,7 @@ void Profiler::BeginBlock(const char* name, const char* file, int line, unsigned
     else
         desc = it->second_;
     ::profiler::beginNonScopedBlock(desc, name);
+    ProfilerTrace::BeginBlock(name);
 #endif
 }
 
@@ -154,7 +158,74 @@ void Profiler::EndBlock()
 {
 #if ATOMIC_PROFILING
     ::profiler::endBlock();
+    ProfilerTrace::EndBlock();
 #endif
 }
 
+void Profiler::SetTraceCapture(float seconds, unsigned blocksPerThread)
+{
+    traceSeconds_ = Max(seconds, 0.0f);
+
+    if (traceSeconds_ > 0.0f)
+    {
+        ProfilerTrace::SetBufferSize(blocksPerThread);
+        ProfilerTrace::SetEnabled(true);
+        lastTriggerUSec_ = ProfilerTrace::GetTimeUSec();
+    }
+    else
+        ProfilerTrace::SetEnabled(false);
+}
+
+bool Profiler::SaveTraceData(const String& filePath)
+{
+    File file(context_);
+    if (!file.Open(filePath, FILE_WRITE))
+    {
+        ATOMIC_LOGERROR("Could not open trace file " + filePath);
+        return false;
+    }
+
+    return ProfilerTrace::Write(file, traceSeconds_);
+}
+
+void Profiler::SetTraceTrigger(float thresholdMs, const String& pathPrefix)
+{
+    traceThresholdMs_ = Max(thresholdMs, 0.0f);
+    tracePathPrefix_ = pathPrefix;
+
+    if (traceThresholdMs_ > 0.0f)
+    {
+        SubscribeToEvent(E_BEGINFRAME, ATOMIC_HANDLER(Profiler, HandleBeginFrame));
+        SubscribeToEvent(E_ENDFRAME, ATOMIC_HANDLER(Profiler, HandleEndFrame));
+    }
+    else
+    {
+        UnsubscribeFromEvent(E_BEGINFRAME);
+        UnsubscribeFromEvent(E_ENDFRAME);
+    }
+}
+
+void Profiler::HandleBeginFrame(StringHash eventType, VariantMap& eventData)
+{
+    frameTimer_.Reset();
+}
+
+void Profiler::HandleEndFrame(StringHash eventType, VariantMap& eventData)
+{
+    float frameMs = frameTimer_.GetUSec(false) / 1000.0f;
+    if (frameMs <= traceThresholdMs_ || !ProfilerTrace::IsEnabled())
+        return;
+
+    // Let a full capture window pass between saves so that consecutive slow frames do not each write a file
+    long long now = ProfilerTrace::GetTimeUSec();
+    if (now - lastTriggerUSec_ < (long long)(traceSeconds_ * 1000000.0f))
+        return;
+
+    lastTriggerUSec_ = now;
+
+    String filePath = tracePathPrefix_ + String(numTriggeredTraces_++) + ".json";
+    if (SaveTraceData(filePath))
+        ATOMIC_LOGINFOF("Frame took %.2f ms, saved trace to %s", frameMs, filePath.CString());
+}
+
 }
@@ -23,6 +23,7 @@
 #pragma once
 
 #include "../Container/Str.h"
+#include "../Core/ProfilerTrace.h"
 #include "../Core/Thread.h"
 #include "../Core/Timer.h"
 
@@ -93,19 +94,46 @@ public:
                     unsigned char status=ProfilerBlockStatus::ON);
     /// End block started with BeginBlock().
     void EndBlock();
+    /// Start recording profiled blocks for Chrome Trace Event export, keeping about the last seconds of data. Zero stops recording.
+    void SetTraceCapture(float seconds, unsigned blocksPerThread = 65536);
+    /// Returns length of the trace capture window in seconds, zero if not recording.
+    float GetTraceCapture() const { return traceSeconds_; }
+    /// Save recorded trace as Chrome Trace Event JSON, loadable in chrome://tracing and Perfetto.
+    bool SaveTraceData(const String& filePath);
+    /// Save the recorded trace to pathPrefix + index + ".json" when a frame takes longer than thresholdMs. Zero disables.
+    void SetTraceTrigger(float thresholdMs, const String& pathPrefix = "Trace");
+    /// Returns frame time threshold of the trace trigger in milliseconds.
+    float GetTraceTriggerThreshold() const { return traceThresholdMs_; }
 
 private:
+    /// Handle frame begin event.
+    void HandleBeginFrame(StringHash eventType, VariantMap& eventData);
+    /// Handle frame end event. Save the trace if the frame exceeded the trigger threshold.
+    void HandleEndFrame(StringHash eventType, VariantMap& eventData);
 
     bool enableEventProfiling_ = true;
     HashMap<unsigned, ::profiler::BaseBlockDescriptor*> blockDescriptorCache_;
+    /// Trace capture window in seconds.
+    float traceSeconds_ = 0.0f;
+    /// Trace trigger frame time threshold in milliseconds.
+    float traceThresholdMs_ = 0.0f;
+    /// Trace trigger file path prefix.
+    String tracePathPrefix_;
+    /// Number of traces saved by the trigger.
+    unsigned numTriggeredTraces_ = 0;
+    /// Trace clock time of the last triggered save.
+    long long lastTriggerUSec_ = 0;
+    /// Frame timer for the trace trigger.
+    HiresTimer frameTimer_;
 };
 
 #if ATOMIC_PROFILING
-#   define ATOMIC_PROFILE(name, ...) EASY_BLOCK(#name, __VA_ARGS__)
-#   define ATOMIC_PROFILE_SCOPED(name, ...) EASY_BLOCK(name, __VA_ARGS__)
-#   define ATOMIC_PROFILE_NONSCOPED(name, ...) EASY_NONSCOPED_BLOCK(name, __VA_ARGS__)
-#   define ATOMIC_PROFILE_END(...) EASY_END_BLOCK
-#   define ATOMIC_PROFILE_THREAD(name) EASY_THREAD(name)
+#   define ATOMIC_PROFILE_TRACE_SCOPE EASY_TOKEN_CONCATENATE(atomicTraceScope, __LINE__)
+#   define ATOMIC_PROFILE(name, ...) EASY_BLOCK(#name, __VA_ARGS__); Atomic::ProfilerTraceScope ATOMIC_PROFILE_TRACE_SCOPE(#name, true)
+#   define ATOMIC_PROFILE_SCOPED(name, ...) EASY_BLOCK(name, __VA_ARGS__); Atomic::ProfilerTraceScope ATOMIC_PROFILE_TRACE_SCOPE(name, false)
+#   define ATOMIC_PROFILE_NONSCOPED(name, ...) EASY_NONSCOPED_BLOCK(name, __VA_ARGS__); Atomic::ProfilerTrace::BeginBlock(name)
+#   define ATOMIC_PROFILE_END(...) EASY_END_BLOCK; Atomic::ProfilerTrace::EndBlock()
+#   define ATOMIC_PROFILE_THREAD(name) EASY_THREAD(name); Atomic::ProfilerTrace::SetThreadName(name)
 #else
 #   define ATOMIC_PROFILE(name, ...)
 #   define ATOMIC_PROFILE_NONSCOPED(name, ...)
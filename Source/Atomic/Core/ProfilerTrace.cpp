@@ -0,0 +1,289 @@
+//
+// Copyright (c) 2014-2017 THUNDERBEAST GAMES LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../Precompiled.h"
+
+#include "../Container/HashMap.h"
+#include "../Core/Mutex.h"
+#include "../Core/ProfilerTrace.h"
+#include "../Core/StringUtils.h"
+#include "../Core/Timer.h"
+#include "../IO/Serializer.h"
+#include "../Math/MathDefs.h"
+
+#include "../DebugNew.h"
+
+namespace Atomic
+{
+
+std::atomic<bool> ProfilerTrace::enabled_(false);
+std::atomic<unsigned> ProfilerTrace::generation_(0);
+unsigned ProfilerTrace::bufferSize_ = 65536;
+
+/// Open non-scoped block.
+struct ProfilerTraceOpenBlock
+{
+    /// Block name, null if recording was disabled when the block began.
+    const char* name_;
+    /// Start time.
+    long long startUSec_;
+};
+
+/// Block ring of one thread. Written only by the owning thread, read by the exporting thread.
+struct ProfilerTraceThread
+{
+    /// Construct.
+    ProfilerTraceThread(unsigned id) :
+        id_(id),
+        generation_(0),
+        head_(0)
+    {
+    }
+
+    /// Trace thread id.
+    unsigned id_;
+    /// Thread name.
+    String name_;
+    /// Recording generation the ring was last reset for.
+    unsigned generation_;
+    /// Ring storage, size is a power of two.
+    PODVector<ProfilerTraceEvent> events_;
+    /// Number of blocks ever written to the ring, published after each write.
+    std::atomic<unsigned> head_;
+    /// Open non-scoped blocks, only accessed by the owning thread.
+    PODVector<ProfilerTraceOpenBlock> openBlocks_;
+    /// Guards name_ and ring reallocation against a concurrent export.
+    Mutex mutex_;
+};
+
+static Mutex& GetTraceThreadsMutex()
+{
+    static Mutex mutex;
+    return mutex;
+}
+
+static PODVector<ProfilerTraceThread*>& GetTraceThreads()
+{
+    static PODVector<ProfilerTraceThread*> threads;
+    return threads;
+}
+
+/// Owns the ring of the current thread and unregisters it on thread exit.
+struct ProfilerTraceThreadOwner
+{
+    ProfilerTraceThreadOwner() :
+        thread_(0)
+    {
+    }
+
+    ~ProfilerTraceThreadOwner()
+    {
+        if (!thread_)
+            return;
+
+        MutexLock lock(GetTraceThreadsMutex());
+        GetTraceThreads().Remove(thread_);
+        delete thread_;
+    }
+
+    ProfilerTraceThread* Get()
+    {
+        if (!thread_)
+        {
+            static std::atomic<unsigned> nextId(1);
+            thread_ = new ProfilerTraceThread(nextId.fetch_add(1, std::memory_order_relaxed));
+            MutexLock lock(GetTraceThreadsMutex());
+            GetTraceThreads().Push(thread_);
+        }
+
+        return thread_;
+    }
+
+    ProfilerTraceThread* thread_;
+};
+
+static thread_local ProfilerTraceThreadOwner traceThread;
+
+static void AppendJSONString(String& dest, const char* str)
+{
+    dest += '"';
+    for (; *str; ++str)
+    {
+        char c = *str;
+        if (c == '"' || c == '\\')
+            dest += '\\';
+        if ((unsigned char)c < 0x20)
+            dest += ' ';
+        else
+            dest += c;
+    }
+    dest += '"';
+}
+
+void ProfilerTrace::SetEnabled(bool enable)
+{
+    if (enable)
+        generation_.fetch_add(1, std::memory_order_relaxed);
+
+    enabled_.store(enable, std::memory_order_release);
+}
+
+void ProfilerTrace::SetBufferSize(unsigned blocksPerThread)
+{
+    bufferSize_ = NextPowerOfTwo(Max(blocksPerThread, 256U));
+}
+
+long long ProfilerTrace::GetTimeUSec()
+{
+    static HiresTimer clock;
+    return clock.GetUSec(false);
+}
+
+void ProfilerTrace::SetThreadName(const char* name)
+{
+    ProfilerTraceThread* thread = traceThread.Get();
+    MutexLock lock(thread->mutex_);
+    thread->name_ = name;
+}
+
+const char* ProfilerTrace::InternName(const char* name)
+{
+    // Interned names are never freed; dynamic block names come from a small set such as event and resource names
+    static thread_local HashMap<StringHash, const char*> threadNames;
+
+    StringHash hash(name);
+    HashMap<StringHash, const char*>::ConstIterator i = threadNames.Find(hash);
+    if (i != threadNames.End())
+        return i->second_;
+
+    static Mutex mutex;
+    static HashMap<StringHash, String> names;
+
+    MutexLock lock(mutex);
+    String& interned = names[hash];
+    if (interned.Empty())
+        interned = name;
+    threadNames[hash] = interned.CString();
+    return interned.CString();
+}
+
+void ProfilerTrace::Record(const char* name, long long startUSec, long long endUSec)
+{
+    ProfilerTraceThread* thread = traceThread.Get();
+
+    unsigned generation = generation_.load(std::memory_order_relaxed);
+    if (thread->generation_ != generation || thread->events_.Empty())
+    {
+        MutexLock lock(thread->mutex_);
+        thread->generation_ = generation;
+        thread->events_.Resize(bufferSize_);
+        thread->head_.store(0, std::memory_order_release);
+    }
+
+    unsigned head = thread->head_.load(std::memory_order_relaxed);
+    ProfilerTraceEvent& event = thread->events_[head & (thread->events_.Size() - 1)];
+    event.name_ = name;
+    event.startUSec_ = startUSec;
+    event.durationUSec_ = endUSec - startUSec;
+    thread->head_.store(head + 1, std::memory_order_release);
+}
+
+void ProfilerTrace::BeginBlock(const char* name)
+{
+    ProfilerTraceOpenBlock block;
+    block.name_ = IsEnabled() ? InternName(name) : 0;
+    block.startUSec_ = block.name_ ? GetTimeUSec() : 0;
+    traceThread.Get()->openBlocks_.Push(block);
+}
+
+void ProfilerTrace::EndBlock()
+{
+    PODVector<ProfilerTraceOpenBlock>& openBlocks = traceThread.Get()->openBlocks_;
+    if (openBlocks.Empty())
+        return;
+
+    ProfilerTraceOpenBlock block = openBlocks.Back();
+    openBlocks.Pop();
+
+    if (block.name_ && IsEnabled())
+        Record(block.name_, block.startUSec_, GetTimeUSec());
+}
+
+bool ProfilerTrace::Write(Serializer& dest, float windowSeconds)
+{
+    long long cutoffUSec = windowSeconds > 0.0f ? GetTimeUSec() - (long long)(windowSeconds * 1000000.0f) : 0;
+
+    String json("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    json += "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"Atomic\"}}";
+
+    PODVector<ProfilerTraceEvent> events;
+
+    MutexLock lock(GetTraceThreadsMutex());
+    PODVector<ProfilerTraceThread*>& threads = GetTraceThreads();
+
+    for (unsigned i = 0; i < threads.Size(); ++i)
+    {
+        ProfilerTraceThread* thread = threads[i];
+        MutexLock threadLock(thread->mutex_);
+
+        String threadName = thread->name_.Empty() ? ToString("Thread %u", thread->id_) : thread->name_;
+        json.AppendWithFormat(",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":", thread->id_);
+        AppendJSONString(json, threadName.CString());
+        json += "}}";
+
+        unsigned size = thread->events_.Size();
+        if (!size)
+            continue;
+
+        // Copy the ring, then drop the entries the owning thread may have overwritten meanwhile
+        unsigned head = thread->head_.load(std::memory_order_acquire);
+        unsigned first = head > size ? head - size : 0;
+        events.Resize(head - first);
+        for (unsigned j = first; j < head; ++j)
+            events[j - first] = thread->events_[j & (size - 1)];
+
+        unsigned newHead = thread->head_.load(std::memory_order_acquire);
+        unsigned validFirst = newHead > size ? Max(first, newHead - size) : first;
+
+        for (unsigned j = validFirst - first; j < events.Size(); ++j)
+        {
+            const ProfilerTraceEvent& event = events[j];
+            if (event.startUSec_ + event.durationUSec_ < cutoffUSec)
+                continue;
+
+            json += ",\n{\"name\":";
+            AppendJSONString(json, event.name_);
+            json.AppendWithFormat(",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":", thread->id_);
+            json += String(event.startUSec_);
+            json += ",\"dur\":";
+            json += String(event.durationUSec_);
+            json += '}';
+        }
+    }
+
+    json += "\n]}\n";
+
+    return dest.Write(json.CString(), json.Length()) == json.Length();
+}
+
+}
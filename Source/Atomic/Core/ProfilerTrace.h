@@ -0,0 +1,114 @@
+//
+// Copyright (c) 2014-2017 THUNDERBEAST GAMES LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "../Container/Str.h"
+
+#include <atomic>
+
+namespace Atomic
+{
+
+class Serializer;
+
+/// Completed profiler block recorded for trace export.
+struct ProfilerTraceEvent
+{
+    /// Block name, a literal or an interned copy.
+    const char* name_;
+    /// Start time in microseconds since the trace clock started.
+    long long startUSec_;
+    /// Duration in microseconds.
+    long long durationUSec_;
+};
+
+/// Records profiler blocks into per-thread ring buffers for export as Chrome Trace Event JSON.
+class ATOMIC_API ProfilerTrace
+{
+public:
+    /// Enable or disable recording. Enabling discards previously recorded blocks.
+    static void SetEnabled(bool enable);
+    /// Return whether recording is enabled.
+    static bool IsEnabled() { return enabled_.load(std::memory_order_relaxed); }
+    /// Set ring buffer size in blocks per thread, rounded up to a power of two. Applies when recording is next enabled.
+    static void SetBufferSize(unsigned blocksPerThread);
+    /// Return ring buffer size in blocks per thread.
+    static unsigned GetBufferSize() { return bufferSize_; }
+    /// Return trace clock time in microseconds.
+    static long long GetTimeUSec();
+
+    /// Set name of the calling thread.
+    static void SetThreadName(const char* name);
+    /// Return a persistent copy of a block name.
+    static const char* InternName(const char* name);
+    /// Record a completed block on the calling thread.
+    static void Record(const char* name, long long startUSec, long long endUSec);
+    /// Begin a non-scoped block on the calling thread.
+    static void BeginBlock(const char* name);
+    /// End the innermost non-scoped block on the calling thread.
+    static void EndBlock();
+
+    /// Write blocks that ended within the last windowSeconds as Chrome Trace Event JSON. Zero writes everything still buffered.
+    static bool Write(Serializer& dest, float windowSeconds = 0.0f);
+
+private:
+    /// Recording flag.
+    static std::atomic<bool> enabled_;
+    /// Recording generation, bumped on enable so that threads reset their rings.
+    static std::atomic<unsigned> generation_;
+    /// Ring buffer size in blocks per thread.
+    static unsigned bufferSize_;
+};
+
+/// Scoped trace block. Records only while trace recording is enabled.
+class ProfilerTraceScope
+{
+public:
+    /// Construct and start timing. Non-literal names are interned.
+    ProfilerTraceScope(const char* name, bool literal) :
+        name_(0),
+        startUSec_(0)
+    {
+        if (ProfilerTrace::IsEnabled())
+        {
+            name_ = literal ? name : ProfilerTrace::InternName(name);
+            startUSec_ = ProfilerTrace::GetTimeUSec();
+        }
+    }
+
+    /// Destruct and record the block.
+    ~ProfilerTraceScope()
+    {
+        if (name_)
+            ProfilerTrace::Record(name_, startUSec_, ProfilerTrace::GetTimeUSec());
+    }
+
+private:
+    /// Block name, null when not recording.
+    const char* name_;
+    /// Start time.
+    long long startUSec_;
+};
+
+}
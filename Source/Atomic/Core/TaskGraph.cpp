@@ -0,0 +1,353 @@
+//
+// Copyright (c) 2014-2017 THUNDERBEAST GAMES LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../Precompiled.h"
+
+#include "../Core/TaskGraph.h"
+#include "../Core/Thread.h"
+#include "../IO/Log.h"
+
+#include "../DebugNew.h"
+
+namespace Atomic
+{
+
+/// Task graph node.
+struct TaskGraphTask
+{
+    /// Construct.
+    TaskGraphTask() :
+        parallel_(false),
+        begin_(0),
+        end_(0),
+        grainSize_(0),
+        numSlices_(1),
+        numDependencies_(0),
+        slicesRemaining_(0),
+        dependenciesRemaining_(0),
+        firstItem_(0),
+        graph_(0)
+    {
+    }
+
+    /// Single-execution function.
+    TaskFunction function_;
+    /// Parallel range function.
+    ParallelForFunction rangeFunction_;
+    /// Parallel range flag.
+    bool parallel_;
+    /// Range begin index.
+    unsigned begin_;
+    /// Range end index.
+    unsigned end_;
+    /// Minimum chunk size, 0 for automatic.
+    unsigned grainSize_;
+    /// Range shared between the slices while running.
+    ParallelRange range_;
+    /// Number of work items executing the task.
+    unsigned numSlices_;
+    /// Number of prerequisite tasks.
+    unsigned numDependencies_;
+    /// Slices not yet finished while running.
+    std::atomic<unsigned> slicesRemaining_;
+    /// Join counter: prerequisites not yet finished while running.
+    std::atomic<unsigned> dependenciesRemaining_;
+    /// Tasks depending on this task.
+    PODVector<TaskGraphTask*> continuations_;
+    /// Index of the first work item in the graph's item collection.
+    unsigned firstItem_;
+    /// Owner graph.
+    TaskGraph* graph_;
+};
+
+TaskGraph::TaskGraph(Context* context) :
+    Object(context),
+    workQueue_(0),
+    numTasks_(0),
+    running_(false)
+{
+}
+
+TaskGraph::~TaskGraph()
+{
+    Wait();
+
+    for (unsigned i = 0; i < tasks_.Size(); ++i)
+        delete tasks_[i];
+}
+
+unsigned TaskGraph::AddTask(const TaskFunction& function)
+{
+    TaskGraphTask* task = CreateTask();
+    task->function_ = function;
+    task->parallel_ = false;
+    return numTasks_ - 1;
+}
+
+unsigned TaskGraph::AddParallelTask(unsigned begin, unsigned end, unsigned grainSize, const ParallelForFunction& function)
+{
+    TaskGraphTask* task = CreateTask();
+    task->rangeFunction_ = function;
+    task->parallel_ = true;
+    task->begin_ = begin;
+    task->end_ = Max(begin, end);
+    task->grainSize_ = grainSize;
+    return numTasks_ - 1;
+}
+
+bool TaskGraph::AddDependency(unsigned task, unsigned prerequisite)
+{
+    if (running_)
+    {
+        ATOMIC_LOGERROR("Can not add task dependencies while the task graph is running");
+        return false;
+    }
+
+    if (task >= numTasks_ || prerequisite >= numTasks_ || task == prerequisite)
+    {
+        ATOMIC_LOGERROR("Illegal task graph dependency");
+        return false;
+    }
+
+    tasks_[prerequisite]->continuations_.Push(tasks_[task]);
+    ++tasks_[task]->numDependencies_;
+    return true;
+}
+
+void TaskGraph::Clear()
+{
+    if (running_)
+    {
+        ATOMIC_LOGERROR("Can not clear a running task graph");
+        return;
+    }
+
+    // Keep the task structures for reuse, but release captured function state
+    for (unsigned i = 0; i < numTasks_; ++i)
+    {
+        TaskGraphTask* task = tasks_[i];
+        task->function_ = TaskFunction();
+        task->rangeFunction_ = ParallelForFunction();
+        task->continuations_.Clear();
+        task->numDependencies_ = 0;
+    }
+
+    numTasks_ = 0;
+}
+
+bool TaskGraph::Start()
+{
+    if (running_)
+    {
+        ATOMIC_LOGERROR("Task graph is already running");
+        return false;
+    }
+
+    if (!Thread::IsMainThread())
+    {
+        ATOMIC_LOGERROR("TaskGraph::Start() can not be called from worker threads");
+        return false;
+    }
+
+    if (!numTasks_)
+        return true;
+
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
+
+    // Without worker threads execute everything immediately; Wait() will then have nothing to do
+    if (!queue || queue->deques_.Empty())
+    {
+        RunSerial();
+        return readyTasks_.Size() == numTasks_;
+    }
+
+    if (!CheckAcyclic())
+    {
+        ATOMIC_LOGERROR("Task graph contains a dependency cycle");
+        return false;
+    }
+
+    workQueue_ = queue;
+
+    // Create all work items up front, as worker threads can not take items from the pool
+    for (unsigned i = 0; i < numTasks_; ++i)
+    {
+        TaskGraphTask* task = tasks_[i];
+
+        unsigned grainSize = task->grainSize_;
+        task->numSlices_ = task->parallel_ ? queue->GetNumSlices(task->end_ - task->begin_, grainSize) : 1;
+        task->range_.Reset(task->begin_, task->end_, grainSize, task->numSlices_);
+        task->slicesRemaining_.store(task->numSlices_);
+        task->dependenciesRemaining_.store(task->numDependencies_);
+        task->firstItem_ = items_.Size();
+
+        for (unsigned j = 0; j < task->numSlices_; ++j)
+        {
+            SharedPtr<WorkItem> item = queue->GetFreeItem();
+            item->priority_ = M_MAX_UNSIGNED;
+            item->workFunction_ = TaskWork;
+            item->aux_ = task;
+            items_.Push(item);
+        }
+    }
+
+    running_ = true;
+    ++queue->numRunningTaskGraphs_;
+
+    for (unsigned i = 0; i < numTasks_; ++i)
+    {
+        TaskGraphTask* task = tasks_[i];
+        if (!task->numDependencies_)
+        {
+            for (unsigned j = 0; j < task->numSlices_; ++j)
+                queue->deques_[0]->Push(items_[task->firstItem_ + j]);
+        }
+    }
+
+    queue->Resume();
+    return true;
+}
+
+void TaskGraph::Wait()
+{
+    if (!running_)
+        return;
+
+    WorkQueue* queue = workQueue_;
+    unsigned idleCount = 0;
+
+    for (unsigned i = 0; i < items_.Size(); ++i)
+    {
+        while (!items_[i]->completed_)
+            queue->HelpOrBackOff(0, idleCount);
+    }
+
+    for (unsigned i = 0; i < items_.Size(); ++i)
+        queue->ReturnToPool(items_[i]);
+    items_.Clear();
+
+    running_ = false;
+    workQueue_ = 0;
+    --queue->numRunningTaskGraphs_;
+    queue->PauseIfIdle();
+}
+
+void TaskGraph::Run()
+{
+    if (Start())
+        Wait();
+}
+
+void TaskGraph::TaskWork(const WorkItem* item, unsigned threadIndex)
+{
+    TaskGraphTask* task = reinterpret_cast<TaskGraphTask*>(item->aux_);
+
+    if (!task->parallel_)
+    {
+        if (task->function_)
+            task->function_(threadIndex);
+    }
+    else if (task->rangeFunction_)
+    {
+        unsigned chunkBegin, chunkEnd;
+        while (task->range_.Claim(chunkBegin, chunkEnd))
+            task->rangeFunction_(chunkBegin, chunkEnd, threadIndex);
+    }
+
+    // The last slice to finish releases the continuations
+    if (task->slicesRemaining_.fetch_sub(1) == 1)
+        task->graph_->FinishTask(task, threadIndex);
+}
+
+TaskGraphTask* TaskGraph::CreateTask()
+{
+    if (numTasks_ == tasks_.Size())
+    {
+        TaskGraphTask* task = new TaskGraphTask();
+        task->graph_ = this;
+        tasks_.Push(task);
+    }
+
+    return tasks_[numTasks_++];
+}
+
+bool TaskGraph::CheckAcyclic()
+{
+    readyTasks_.Clear();
+
+    for (unsigned i = 0; i < numTasks_; ++i)
+    {
+        tasks_[i]->dependenciesRemaining_.store(tasks_[i]->numDependencies_, std::memory_order_relaxed);
+        if (!tasks_[i]->numDependencies_)
+            readyTasks_.Push(tasks_[i]);
+    }
+
+    for (unsigned i = 0; i < readyTasks_.Size(); ++i)
+    {
+        PODVector<TaskGraphTask*>& continuations = readyTasks_[i]->continuations_;
+        for (unsigned j = 0; j < continuations.Size(); ++j)
+        {
+            if (continuations[j]->dependenciesRemaining_.fetch_sub(1, std::memory_order_relaxed) == 1)
+                readyTasks_.Push(continuations[j]);
+        }
+    }
+
+    return readyTasks_.Size() == numTasks_;
+}
+
+void TaskGraph::RunSerial()
+{
+    // Dependency ordering also gives the execution order
+    if (!CheckAcyclic())
+        ATOMIC_LOGERROR("Task graph contains a dependency cycle, skipping tasks in the cycle");
+
+    for (unsigned i = 0; i < readyTasks_.Size(); ++i)
+    {
+        TaskGraphTask* task = readyTasks_[i];
+
+        if (!task->parallel_)
+        {
+            if (task->function_)
+                task->function_(0);
+        }
+        else if (task->rangeFunction_ && task->begin_ < task->end_)
+            task->rangeFunction_(task->begin_, task->end_, 0);
+    }
+}
+
+void TaskGraph::FinishTask(TaskGraphTask* task, unsigned threadIndex)
+{
+    WorkStealingDeque<WorkItem>* deque = workQueue_->deques_[threadIndex];
+
+    for (unsigned i = 0; i < task->continuations_.Size(); ++i)
+    {
+        TaskGraphTask* continuation = task->continuations_[i];
+        if (continuation->dependenciesRemaining_.fetch_sub(1) == 1)
+        {
+            for (unsigned j = 0; j < continuation->numSlices_; ++j)
+                deque->Push(items_[continuation->firstItem_ + j]);
+        }
+    }
+}
+
+}
@@ -0,0 +1,94 @@
+//
+// Copyright (c) 2014-2017 THUNDERBEAST GAMES LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "../Core/WorkQueue.h"
+
+namespace Atomic
+{
+
+/// Task function. Called with the thread index (0 = main thread) as parameter.
+typedef std::function<void(unsigned)> TaskFunction;
+
+struct TaskGraphTask;
+
+/// Dependency graph of tasks executed on the work queue. Each task keeps a join counter of unfinished prerequisites; when it reaches zero the task is pushed as a continuation to the work-stealing deque of the thread that finished the last prerequisite. Must be built, started and waited for from the main thread.
+class ATOMIC_API TaskGraph : public Object
+{
+    ATOMIC_OBJECT(TaskGraph, Object);
+
+public:
+    /// Construct.
+    TaskGraph(Context* context);
+    /// Destruct. Wait for the tasks to finish if running.
+    virtual ~TaskGraph();
+
+    /// Add a task that executes the function once. Return the task index.
+    unsigned AddTask(const TaskFunction& function);
+    /// Add a task that executes the function over the index range [begin, end) split between threads, see WorkQueue::ParallelFor(). Return the task index.
+    unsigned AddParallelTask(unsigned begin, unsigned end, unsigned grainSize, const ParallelForFunction& function);
+    /// Make a task wait for a prerequisite task to finish before starting. Return true if successful.
+    bool AddDependency(unsigned task, unsigned prerequisite);
+    /// Remove all tasks. The graph must not be running.
+    void Clear();
+
+    /// Start executing the tasks with no prerequisites. Return immediately so that the main thread can do other work meanwhile. Return false if the graph contains a dependency cycle.
+    bool Start();
+    /// Wait for all tasks to finish. The main thread executes tasks while waiting.
+    void Wait();
+    /// Start executing the tasks and wait for them to finish.
+    void Run();
+
+    /// Return number of tasks.
+    unsigned GetNumTasks() const { return numTasks_; }
+    /// Return whether started and not yet waited for.
+    bool IsRunning() const { return running_; }
+
+private:
+    /// Work function executing a slice of a task.
+    static void TaskWork(const WorkItem* item, unsigned threadIndex);
+    /// Allocate or reuse a task structure.
+    TaskGraphTask* CreateTask();
+    /// Return whether all tasks can be reached in dependency order.
+    bool CheckAcyclic();
+    /// Execute all tasks in dependency order in the main thread.
+    void RunSerial();
+    /// Make the continuations of a finished task runnable from the finishing thread.
+    void FinishTask(TaskGraphTask* task, unsigned threadIndex);
+
+    /// Work queue in use while running. Accessed also from the worker threads.
+    WorkQueue* workQueue_;
+    /// Task structures, reused between Clear() calls.
+    PODVector<TaskGraphTask*> tasks_;
+    /// Number of tasks in use.
+    unsigned numTasks_;
+    /// Work items of the tasks while running.
+    Vector<SharedPtr<WorkItem> > items_;
+    /// Ready tasks scratch buffer for dependency ordering.
+    PODVector<TaskGraphTask*> readyTasks_;
+    /// Running flag.
+    bool running_;
+};
+
+}
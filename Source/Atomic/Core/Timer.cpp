@@ -22,6 +22,7 @@
 
 #include "../Precompiled.h"
 
+#include "../Container/FrameAllocator.h"
 #include "../Core/CoreEvents.h"
 #include "../Core/Profiler.h"
 
@@ -126,6 +127,9 @@ void Time::EndFrame()
     ATOMIC_PROFILE(EndFrame);
     // Frame end event
     SendEvent(E_ENDFRAME);
+
+    // Release the per-frame scratch memory
+    FrameAllocator::EndFrame();
 }
 // ATOMIC END
 
@@ -22,6 +22,9 @@
 
 #include "../Precompiled.h"
 
+// ATOMIC BEGIN
+#include "../Container/Allocator.h"
+// ATOMIC END
 #include "../Core/StringUtils.h"
 #include "../IO/VectorBuffer.h"
 
@@ -38,6 +41,34 @@ const VariantMap Variant::emptyVariantMap;
 const VariantVector Variant::emptyVariantVector;
 const StringVector Variant::emptyStringVector;
 
+// ATOMIC BEGIN
+
+/// Return the pool for matrix values, which do not fit in VariantValue. Variants are used from worker threads, so the pool is thread-safe. It is never destroyed, as static variants may outlive it.
+static ConcurrentAllocatorPool* GetMatrixPool()
+{
+    static ConcurrentAllocatorPool* pool = ConcurrentAllocatorInitialize((unsigned)sizeof(Matrix4), 256);
+    return pool;
+}
+
+static void* AllocateMatrixStorage()
+{
+    return ConcurrentAllocatorReserve(GetMatrixPool());
+}
+
+static void FreeMatrixStorage(void* ptr)
+{
+    ConcurrentAllocatorFree(GetMatrixPool(), ptr);
+}
+
+/// Return the pool for nested variant map values. A VariantMap stores its first pairs, which hold variants, inline, so it can not be stored in VariantValue itself; the pool avoids a heap allocation per nested map instead. Never destroyed, like the matrix pool.
+static ConcurrentAllocatorPool* GetVariantMapPool()
+{
+    static ConcurrentAllocatorPool* pool = ConcurrentAllocatorInitialize((unsigned)sizeof(VariantMap), 64);
+    return pool;
+}
+
+// ATOMIC END
+
 static const char* typeNames[] =
 {
     "None",
@@ -101,7 +132,9 @@ Variant& Variant::operator =(const Variant& rhs)
         break;
 
     case VAR_VARIANTMAP:
-        *(reinterpret_cast<VariantMap*>(&value_)) = *(reinterpret_cast<const VariantMap*>(&rhs.value_));
+        // ATOMIC BEGIN
+        *(reinterpret_cast<VariantMap*>(value_.ptr_)) = *(reinterpret_cast<const VariantMap*>(rhs.value_.ptr_));
+        // ATOMIC END
         break;
 
     case VAR_PTR:
@@ -188,7 +221,9 @@ bool Variant::operator ==(const Variant& rhs) const
         return *(reinterpret_cast<const StringVector*>(&value_)) == *(reinterpret_cast<const StringVector*>(&rhs.value_));
 
     case VAR_VARIANTMAP:
-        return *(reinterpret_cast<const VariantMap*>(&value_)) == *(reinterpret_cast<const VariantMap*>(&rhs.value_));
+        // ATOMIC BEGIN
+        return *(reinterpret_cast<const VariantMap*>(value_.ptr_)) == *(reinterpret_cast<const VariantMap*>(rhs.value_.ptr_));
+        // ATOMIC END
 
     case VAR_INTRECT:
         return *(reinterpret_cast<const IntRect*>(&value_)) == *(reinterpret_cast<const IntRect*>(&rhs.value_));
@@ -541,7 +576,9 @@ bool Variant::IsZero() const
         return reinterpret_cast<const StringVector*>(&value_)->Empty();
 
     case VAR_VARIANTMAP:
-        return reinterpret_cast<const VariantMap*>(&value_)->Empty();
+        // ATOMIC BEGIN
+        return reinterpret_cast<const VariantMap*>(value_.ptr_)->Empty();
+        // ATOMIC END
 
     case VAR_INTRECT:
         return *reinterpret_cast<const IntRect*>(&value_) == IntRect::ZERO;
@@ -606,25 +643,25 @@ void Variant::SetType(VariantType newType)
         (reinterpret_cast<StringVector*>(&value_))->~StringVector();
         break;
 
+    // ATOMIC BEGIN
     case VAR_VARIANTMAP:
-        (reinterpret_cast<VariantMap*>(&value_))->~VariantMap();
+        reinterpret_cast<VariantMap*>(value_.ptr_)->~VariantMap();
+        ConcurrentAllocatorFree(GetVariantMapPool(), value_.ptr_);
         break;
+    // ATOMIC END
 
     case VAR_PTR:
         (reinterpret_cast<WeakPtr<RefCounted>*>(&value_))->~WeakPtr<RefCounted>();
         break;
 
+    // ATOMIC BEGIN
     case VAR_MATRIX3:
-        delete reinterpret_cast<Matrix3*>(value_.ptr_);
-        break;
-
     case VAR_MATRIX3X4:
-        delete reinterpret_cast<Matrix3x4*>(value_.ptr_);
-        break;
-
     case VAR_MATRIX4:
-        delete reinterpret_cast<Matrix4*>(value_.ptr_);
+        // Matrices have trivial destructors
+        FreeMatrixStorage(value_.ptr_);
         break;
+    // ATOMIC END
 
     default:
         break;
@@ -658,25 +695,29 @@ void Variant::SetType(VariantType newType)
         new(reinterpret_cast<StringVector*>(&value_)) StringVector();
         break;
 
+    // ATOMIC BEGIN
     case VAR_VARIANTMAP:
-        new(reinterpret_cast<VariantMap*>(&value_)) VariantMap();
+        value_.ptr_ = new(ConcurrentAllocatorReserve(GetVariantMapPool())) VariantMap();
         break;
+    // ATOMIC END
 
     case VAR_PTR:
         new(reinterpret_cast<WeakPtr<RefCounted>*>(&value_)) WeakPtr<RefCounted>();
         break;
 
+    // ATOMIC BEGIN
     case VAR_MATRIX3:
-        value_.ptr_ = new Matrix3();
+        value_.ptr_ = new(AllocateMatrixStorage()) Matrix3();
         break;
 
     case VAR_MATRIX3X4:
-        value_.ptr_ = new Matrix3x4();
+        value_.ptr_ = new(AllocateMatrixStorage()) Matrix3x4();
         break;
 
     case VAR_MATRIX4:
-        value_.ptr_ = new Matrix4();
+        value_.ptr_ = new(AllocateMatrixStorage()) Matrix4();
         break;
+    // ATOMIC END
 
     default:
         break;
@@ -23,6 +23,9 @@
 #pragma once
 
 #include "../Container/HashMap.h"
+// ATOMIC BEGIN
+#include "../Container/FlatHashMap.h"
+// ATOMIC END
 #include "../Container/Ptr.h"
 #include "../Math/Color.h"
 #include "../Math/Matrix3.h"
@@ -108,8 +111,10 @@ typedef Vector<Variant> VariantVector;
 /// Vector of strings.
 typedef Vector<String> StringVector;
 
-/// Map of variants.
-typedef HashMap<StringHash, Variant> VariantMap;
+// ATOMIC BEGIN
+/// Map of variants. Stores the first 4 pairs without heap allocation.
+typedef FlatHashMap<StringHash, Variant, 4> VariantMap;
+// ATOMIC END
 
 /// Typed resource reference.
 struct ATOMIC_API ResourceRef
@@ -650,7 +655,9 @@ public:
     Variant& operator =(const VariantMap& rhs)
     {
         SetType(VAR_VARIANTMAP);
-        *(reinterpret_cast<VariantMap*>(&value_)) = rhs;
+        // ATOMIC BEGIN
+        *(reinterpret_cast<VariantMap*>(value_.ptr_)) = rhs;
+        // ATOMIC END
         return *this;
     }
 
@@ -821,7 +828,9 @@ public:
     /// Test for equality with a variant map. To return true, both the type and value must match.
     bool operator ==(const VariantMap& rhs) const
     {
-        return type_ == VAR_VARIANTMAP ? *(reinterpret_cast<const VariantMap*>(&value_)) == rhs : false;
+        // ATOMIC BEGIN
+        return type_ == VAR_VARIANTMAP ? *(reinterpret_cast<const VariantMap*>(value_.ptr_)) == rhs : false;
+        // ATOMIC END
     }
 
     /// Test for equality with a rect. To return true, both the type and value must match.
@@ -1137,7 +1146,9 @@ public:
     /// Return a variant map or empty on type mismatch.
     const VariantMap& GetVariantMap() const
     {
-        return type_ == VAR_VARIANTMAP ? *reinterpret_cast<const VariantMap*>(&value_) : emptyVariantMap;
+        // ATOMIC BEGIN
+        return type_ == VAR_VARIANTMAP ? *reinterpret_cast<const VariantMap*>(value_.ptr_) : emptyVariantMap;
+        // ATOMIC END
     }
 
     /// Return a rect or empty on type mismatch.
@@ -1211,7 +1222,9 @@ public:
     StringVector* GetStringVectorPtr() { return type_ == VAR_STRINGVECTOR ? reinterpret_cast<StringVector*>(&value_) : 0; }
 
     /// Return a pointer to a modifiable variant map or null on type mismatch.
-    VariantMap* GetVariantMapPtr() { return type_ == VAR_VARIANTMAP ? reinterpret_cast<VariantMap*>(&value_) : 0; }
+    // ATOMIC BEGIN
+    VariantMap* GetVariantMapPtr() { return type_ == VAR_VARIANTMAP ? reinterpret_cast<VariantMap*>(value_.ptr_) : 0; }
+    // ATOMIC END
 
     /// Return name for variant type.
     static String GetTypeName(VariantType type);
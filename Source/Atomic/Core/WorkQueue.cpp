@@ -26,7 +26,13 @@
 #include "../Core/ProcessUtils.h"
 #include "../Core/Profiler.h"
 #include "../Core/WorkQueue.h"
+#include "../Core/Thread.h"
 #include "../IO/Log.h"
+// ATOMIC BEGIN
+#include "../Metrics/FrameStatistics.h"
+
+#include <thread>
+// ATOMIC END
 
 namespace Atomic
 {
@@ -49,6 +55,9 @@ public:
     {
         // Init FPU state first
         InitFPU();
+        // ATOMIC BEGIN
+        ATOMIC_PROFILE_THREAD(ToString("Worker %u", index_).CString());
+        // ATOMIC END
         owner_->ProcessItems(index_);
     }
 
@@ -62,8 +71,82 @@ private:
     unsigned index_;
 };
 
+// ATOMIC BEGIN
+
+/// Target number of chunks per thread when the grain size of a parallel loop is chosen automatically.
+static const unsigned PARALLELFOR_CHUNKS_PER_THREAD = 8;
+/// Number of unsuccessful attempts to find work before a waiting thread starts yielding its time slice.
+static const unsigned WAIT_SPIN_COUNT = 64;
+/// Number of unsuccessful attempts to find work before a waiting thread starts sleeping.
+static const unsigned WAIT_YIELD_COUNT = 1024;
+
+/// Parallel loop shared between its work items.
+struct ParallelForJob
+{
+    /// Index range.
+    ParallelRange range_;
+    /// Loop function.
+    const ParallelForFunction* function_;
+    /// Work-stealing deques of the work queue.
+    const PODVector<WorkStealingDeque<WorkItem>*>* deques_;
+};
+
+static void ParallelForWork(const WorkItem* item, unsigned threadIndex)
+{
+    ParallelForJob* job = reinterpret_cast<ParallelForJob*>(item->aux_);
+
+    // The slices form a binary tree through the start and end pointers. Fork the child slices to this thread's own deque,
+    // from where idle threads steal them, so that the loop spreads out from every thread that joins it
+    WorkStealingDeque<WorkItem>* deque = (*job->deques_)[threadIndex];
+    if (item->start_)
+        deque->Push(reinterpret_cast<WorkItem*>(item->start_));
+    if (item->end_)
+        deque->Push(reinterpret_cast<WorkItem*>(item->end_));
+
+    unsigned chunkBegin, chunkEnd;
+    while (job->range_.Claim(chunkBegin, chunkEnd))
+        (*job->function_)(chunkBegin, chunkEnd, threadIndex);
+}
+
+void ParallelRange::Reset(unsigned begin, unsigned end, unsigned grainSize, unsigned numSlices)
+{
+    next_.store(begin, std::memory_order_relaxed);
+    end_ = end;
+    grainSize_ = Max(grainSize, 1U);
+    numSlices_ = Max(numSlices, 1U);
+}
+
+bool ParallelRange::Claim(unsigned& chunkBegin, unsigned& chunkEnd)
+{
+    unsigned begin = next_.load(std::memory_order_relaxed);
+
+    for (;;)
+    {
+        if (begin >= end_)
+            return false;
+
+        unsigned remaining = end_ - begin;
+        unsigned count = numSlices_ > 1 ? Max(remaining / (numSlices_ * 2), grainSize_) : remaining;
+        count = Min(count, remaining);
+
+        // On failure begin is updated to the current value, retry
+        if (next_.compare_exchange_weak(begin, begin + count, std::memory_order_relaxed))
+        {
+            chunkBegin = begin;
+            chunkEnd = begin + count;
+            return true;
+        }
+    }
+}
+
+// ATOMIC END
+
 WorkQueue::WorkQueue(Context* context) :
     Object(context),
+// ATOMIC BEGIN
+    numRunningTaskGraphs_(0),
+    workStealing_(true),
+// ATOMIC END
     shutDown_(false),
     pausing_(false),
     paused_(false),
@@ -83,6 +166,11 @@ WorkQueue::~WorkQueue()
 
     for (unsigned i = 0; i < threads_.Size(); ++i)
         threads_[i]->Stop();
+
+    // ATOMIC BEGIN
+    for (unsigned i = 0; i < deques_.Size(); ++i)
+        delete deques_[i];
+    // ATOMIC END
 }
 
 void WorkQueue::CreateThreads(unsigned numThreads)
@@ -96,6 +184,12 @@ void WorkQueue::CreateThreads(unsigned numThreads)
     // Start threads in paused mode
     Pause();
 
+    // ATOMIC BEGIN
+    // One work-stealing deque per thread, including the main thread at index 0
+    for (unsigned i = 0; i < numThreads + 1; ++i)
+        deques_.Push(new WorkStealingDeque<WorkItem>());
+    // ATOMIC END
+
     for (unsigned i = 0; i < numThreads; ++i)
     {
         SharedPtr<WorkerThread> thread(new WorkerThread(this, i + 1));
@@ -111,8 +205,8 @@ SharedPtr<WorkItem> WorkQueue::GetFreeItem()
 {
     if (poolItems_.Size() > 0)
     {
-        SharedPtr<WorkItem> item = poolItems_.Front();
-        poolItems_.PopFront();
+        SharedPtr<WorkItem> item = poolItems_.Back();
+        poolItems_.Pop();
         return item;
     }
     else
@@ -140,6 +234,17 @@ void WorkQueue::AddWorkItem(SharedPtr<WorkItem> item)
     workItems_.Push(item);
     item->completed_ = false;
 
+    // ATOMIC BEGIN
+    // Maximum priority items are completed within the current frame; hand them to the main thread's lock-free
+    // deque from where the worker threads steal them without contending for the queue mutex
+    if (workStealing_ && threads_.Size() && item->priority_ == M_MAX_UNSIGNED)
+    {
+        deques_[0]->Push(item);
+        Resume();
+        return;
+    }
+    // ATOMIC END
+
     // Make sure worker threads' list is safe to modify
     if (threads_.Size() && !paused_)
         queueMutex_.Acquire();
@@ -183,7 +288,7 @@ bool WorkQueue::RemoveWorkItem(SharedPtr<WorkItem> item)
     List<WorkItem*>::Iterator i = queue_.Find(item.Get());
     if (i != queue_.End())
     {
-        List<SharedPtr<WorkItem> >::Iterator j = workItems_.Find(item);
+        Vector<SharedPtr<WorkItem> >::Iterator j = workItems_.Find(item);
         if (j != workItems_.End())
         {
             queue_.Erase(i);
@@ -206,7 +311,7 @@ unsigned WorkQueue::RemoveWorkItems(const Vector<SharedPtr<WorkItem> >& items)
         List<WorkItem*>::Iterator j = queue_.Find(i->Get());
         if (j != queue_.End())
         {
-            List<SharedPtr<WorkItem> >::Iterator k = workItems_.Find(*i);
+            Vector<SharedPtr<WorkItem> >::Iterator k = workItems_.Find(*i);
             if (k != workItems_.End())
             {
                 queue_.Erase(j);
@@ -251,6 +356,17 @@ void WorkQueue::Complete(unsigned priority)
     {
         Resume();
 
+        // ATOMIC BEGIN
+        // Help with stealable work first, as it is always of maximum priority
+        while (WorkItem* item = TakeStealableItem(0))
+        {
+            item->workFunction_(item, 0);
+            item->completed_ = true;
+        }
+
+        unsigned idleCount = 0;
+        // ATOMIC END
+
         // Take work items also in the main thread until queue empty or no high-priority items anymore
         while (!queue_.Empty())
         {
@@ -273,6 +389,10 @@ void WorkQueue::Complete(unsigned priority)
         // Wait for threaded work to complete
         while (!IsCompleted(priority))
         {
+            // ATOMIC BEGIN
+            // Steal work back from the worker threads' deques in case they have spawned more
+            HelpOrBackOff(0, idleCount);
+            // ATOMIC END
         }
 
         // If no work at all remaining, pause worker threads by leaving the mutex locked
@@ -295,9 +415,85 @@ void WorkQueue::Complete(unsigned priority)
     completing_ = false;
 }
 
+// ATOMIC BEGIN
+
+void WorkQueue::ParallelFor(unsigned begin, unsigned end, unsigned grainSize, const ParallelForFunction& function)
+{
+    if (begin >= end)
+        return;
+
+    if (!Thread::IsMainThread())
+    {
+        ATOMIC_LOGERROR("WorkQueue::ParallelFor() can not be called from worker threads");
+        return;
+    }
+
+    unsigned numSlices = GetNumSlices(end - begin, grainSize);
+
+    // Execute directly if there are no worker threads or the range is not worth splitting
+    if (numSlices <= 1)
+    {
+        function(begin, end, 0);
+        return;
+    }
+
+    ParallelForJob job;
+    job.range_.Reset(begin, end, grainSize, numSlices);
+    job.function_ = &function;
+    job.deques_ = &deques_;
+
+    // The main thread executes the root slice itself. The other slices are children in a binary tree, where each slice
+    // forks its children to the deque of the thread executing it
+    unsigned firstItem = parallelForItems_.Size();
+    for (unsigned i = 1; i < numSlices; ++i)
+    {
+        SharedPtr<WorkItem> item = GetFreeItem();
+        item->priority_ = M_MAX_UNSIGNED;
+        item->workFunction_ = ParallelForWork;
+        item->aux_ = &job;
+        parallelForItems_.Push(item);
+    }
+
+    for (unsigned i = 1; i < numSlices; ++i)
+    {
+        WorkItem* item = parallelForItems_[firstItem + i - 1];
+        unsigned left = i * 2 + 1;
+        unsigned right = i * 2 + 2;
+        item->start_ = left < numSlices ? parallelForItems_[firstItem + left - 1].Get() : 0;
+        item->end_ = right < numSlices ? parallelForItems_[firstItem + right - 1].Get() : 0;
+    }
+
+    deques_[0]->Push(parallelForItems_[firstItem]);
+    if (numSlices > 2)
+        deques_[0]->Push(parallelForItems_[firstItem + 1]);
+
+    Resume();
+
+    unsigned chunkBegin, chunkEnd;
+    while (job.range_.Claim(chunkBegin, chunkEnd))
+        function(chunkBegin, chunkEnd, 0);
+
+    // Wait for the slices taken by the worker threads, helping with other stealable work meanwhile. Slices still in the
+    // deques find the range exhausted and complete immediately
+    unsigned idleCount = 0;
+    for (unsigned i = firstItem; i < parallelForItems_.Size(); ++i)
+    {
+        while (!parallelForItems_[i]->completed_)
+            HelpOrBackOff(0, idleCount);
+    }
+
+    for (unsigned i = firstItem; i < parallelForItems_.Size(); ++i)
+        ReturnToPool(parallelForItems_[i]);
+    parallelForItems_.Resize(firstItem);
+
+    PauseIfIdle();
+}
+
+// ATOMIC END
+
 bool WorkQueue::IsCompleted(unsigned priority) const
 {
-    for (List<SharedPtr<WorkItem> >::ConstIterator i = workItems_.Begin(); i != workItems_.End(); ++i)
+    for (Vector<SharedPtr<WorkItem> >::ConstIterator i = workItems_.Begin(); i != workItems_.End(); ++i)
     {
         if ((*i)->priority_ >= priority && !(*i)->completed_)
             return false;
@@ -315,6 +511,21 @@ void WorkQueue::ProcessItems(unsigned threadIndex)
         if (shutDown_)
             return;
 
+        // ATOMIC BEGIN
+        // Stealable work does not need the queue mutex
+        if (WorkItem* item = TakeStealableItem(threadIndex))
+        {
+            wasActive = true;
+            {
+                ATOMIC_PROFILE(WorkItem);
+                ATOMIC_FRAMESTAT(STAT_WORKQUEUE);
+                item->workFunction_(item, threadIndex);
+            }
+            item->completed_ = true;
+            continue;
+        }
+        // ATOMIC END
+
         if (pausing_ && !wasActive)
             Time::Sleep(0);
         else
@@ -327,7 +538,13 @@ void WorkQueue::ProcessItems(unsigned threadIndex)
                 WorkItem* item = queue_.Front();
                 queue_.PopFront();
                 queueMutex_.Release();
-                item->workFunction_(item, threadIndex);
+                // ATOMIC BEGIN
+                {
+                    ATOMIC_PROFILE(WorkItem);
+                    ATOMIC_FRAMESTAT(STAT_WORKQUEUE);
+                    item->workFunction_(item, threadIndex);
+                }
+                // ATOMIC END
                 item->completed_ = true;
             }
             else
@@ -345,25 +562,40 @@ void WorkQueue::PurgeCompleted(unsigned priority)
 {
     // Purge completed work items and send completion events. Do not signal items lower than priority threshold,
     // as those may be user submitted and lead to eg. scene manipulation that could happen in the middle of the
-    // render update, which is not allowed
-    for (List<SharedPtr<WorkItem> >::Iterator i = workItems_.Begin(); i != workItems_.End();)
+    // render update, which is not allowed. Completed items are first compacted out of the collection, so that event
+    // handlers are free to add or remove work items
+    Vector<SharedPtr<WorkItem> > completedItems;
+    unsigned numRemaining = 0;
+
+    for (unsigned i = 0; i < workItems_.Size(); ++i)
     {
-        if ((*i)->completed_ && (*i)->priority_ >= priority)
+        if (workItems_[i]->completed_ && workItems_[i]->priority_ >= priority)
+            completedItems.Push(workItems_[i]);
+        else
         {
-            if ((*i)->sendEvent_)
-            {
-                using namespace WorkItemCompleted;
+            if (numRemaining != i)
+                workItems_[numRemaining] = workItems_[i];
+            ++numRemaining;
+        }
+    }
 
-                VariantMap& eventData = GetEventDataMap();
-                eventData[P_ITEM] = i->Get();
-                SendEvent(E_WORKITEMCOMPLETED, eventData);
-            }
+    if (completedItems.Empty())
+        return;
 
-            ReturnToPool(*i);
-            i = workItems_.Erase(i);
+    workItems_.Resize(numRemaining);
+
+    for (Vector<SharedPtr<WorkItem> >::Iterator i = completedItems.Begin(); i != completedItems.End(); ++i)
+    {
+        if ((*i)->sendEvent_)
+        {
+            using namespace WorkItemCompleted;
+
+            VariantMap& eventData = GetEventDataMap();
+            eventData[P_ITEM] = i->Get();
+            SendEvent(E_WORKITEMCOMPLETED, eventData);
         }
-        else
-            ++i;
+
+        ReturnToPool(*i);
     }
 }
 
@@ -372,9 +604,9 @@ void WorkQueue::PurgePool()
     unsigned currentSize = poolItems_.Size();
     int difference = lastSize_ - currentSize;
 
-    // Difference tolerance, should be fairly significant to reduce the pool size.
-    for (unsigned i = 0; poolItems_.Size() > 0 && difference > tolerance_ && i < (unsigned)difference; i++)
-        poolItems_.PopFront();
+    // Difference tolerance, should be fairly significant to reduce the pool size. Remove the least recently used items
+    if (poolItems_.Size() > 0 && difference > tolerance_)
+        poolItems_.Erase(0, Min((unsigned)difference, poolItems_.Size()));
 
     lastSize_ = currentSize;
 }
@@ -423,4 +655,65 @@ void WorkQueue::HandleBeginFrame(StringHash eventType, VariantMap& eventData)
     PurgePool();
 }
 
+// ATOMIC BEGIN
+
+WorkItem* WorkQueue::TakeStealableItem(unsigned threadIndex)
+{
+    unsigned numDeques = deques_.Size();
+    if (threadIndex >= numDeques)
+        return 0;
+
+    // Own work first, in LIFO order for cache locality
+    WorkItem* item = deques_[threadIndex]->Pop();
+    if (item)
+        return item;
+
+    // Then steal the oldest items from the other threads, starting from the next one to spread contention
+    for (unsigned i = 1; i < numDeques; ++i)
+    {
+        item = deques_[(threadIndex + i) % numDeques]->Steal();
+        if (item)
+            return item;
+    }
+
+    return 0;
+}
+
+void WorkQueue::HelpOrBackOff(unsigned threadIndex, unsigned& idleCount)
+{
+    if (WorkItem* item = TakeStealableItem(threadIndex))
+    {
+        item->workFunction_(item, threadIndex);
+        item->completed_ = true;
+        idleCount = 0;
+        return;
+    }
+
+    // Short waits are common at the end of a parallel phase, so spin first; long ones should not burn a core
+    ++idleCount;
+    if (idleCount >= WAIT_YIELD_COUNT)
+        Time::Sleep(0);
+    else if (idleCount >= WAIT_SPIN_COUNT)
+        std::this_thread::yield();
+}
+
+unsigned WorkQueue::GetNumSlices(unsigned count, unsigned& grainSize) const
+{
+    unsigned numThreads = deques_.Size() ? deques_.Size() - 1 : 0;
+
+    if (!grainSize)
+        grainSize = Max(count / ((numThreads + 1) * PARALLELFOR_CHUNKS_PER_THREAD), 1U);
+
+    unsigned numChunks = count / grainSize + (count % grainSize ? 1 : 0);
+    return Max(Min(numThreads + 1, numChunks), 1U);
+}
+
+void WorkQueue::PauseIfIdle()
+{
+    if (queue_.Empty() && parallelForItems_.Empty() && !numRunningTaskGraphs_ && IsCompleted(0))
+        Pause();
+}
+
+// ATOMIC END
+
 }
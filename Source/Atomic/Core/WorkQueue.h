@@ -25,6 +25,11 @@
 #include "../Container/List.h"
 #include "../Core/Mutex.h"
 #include "../Core/Object.h"
+// ATOMIC BEGIN
+#include "../Core/WorkStealingDeque.h"
+
+#include <functional>
+// ATOMIC END
 
 namespace Atomic
 {
@@ -37,6 +42,40 @@ ATOMIC_EVENT(E_WORKITEMCOMPLETED, WorkItemCompleted)
 
 class WorkerThread;
 
+// ATOMIC BEGIN
+
+/// Parallel for -loop function. Called with the chunk begin and end indices and thread index (0 = main thread) as parameters.
+typedef std::function<void(unsigned, unsigned, unsigned)> ParallelForFunction;
+
+/// Index range shared between the work items of a parallel loop. Chunks are claimed with guided self-scheduling: large at first, shrinking towards the grain size as the range is consumed, which balances uneven work without per-index overhead.
+struct ATOMIC_API ParallelRange
+{
+    /// Construct.
+    ParallelRange() :
+        next_(0),
+        end_(0),
+        grainSize_(1),
+        numSlices_(1)
+    {
+    }
+
+    /// Reset for a new loop over the range, to be executed by the specified number of work items.
+    void Reset(unsigned begin, unsigned end, unsigned grainSize, unsigned numSlices);
+    /// Claim the next chunk. Return false when the range is exhausted. Safe to call from any thread.
+    bool Claim(unsigned& chunkBegin, unsigned& chunkEnd);
+
+    /// Next unclaimed index.
+    std::atomic<unsigned> next_;
+    /// End index (exclusive.)
+    unsigned end_;
+    /// Minimum chunk size.
+    unsigned grainSize_;
+    /// Number of work items executing the loop.
+    unsigned numSlices_;
+};
+
+// ATOMIC END
+
 /// Work queue item.
 struct WorkItem : public RefCounted
 {
@@ -79,6 +118,9 @@ class ATOMIC_API WorkQueue : public Object
     ATOMIC_OBJECT(WorkQueue, Object);
 
     friend class WorkerThread;
+    // ATOMIC BEGIN
+    friend class TaskGraph;
+    // ATOMIC END
 
 public:
     /// Construct.
@@ -92,7 +134,7 @@ public:
     SharedPtr<WorkItem> GetFreeItem();
     /// Add a work item and resume worker threads.
     void AddWorkItem(SharedPtr<WorkItem> item);
-    /// Remove a work item before it has started executing. Return true if successfully removed.
+    /// Remove a work item before it has started executing. Return true if successfully removed. Items handed to the work-stealing deques can not be removed.
     bool RemoveWorkItem(SharedPtr<WorkItem> item);
     /// Remove a number of work items before they have started executing. Return the number of items successfully removed.
     unsigned RemoveWorkItems(const Vector<SharedPtr<WorkItem> >& items);
@@ -102,6 +144,10 @@ public:
     void Resume();
     /// Finish all queued work which has at least the specified priority. Main thread will also execute priority work. Pause worker threads if no more work remains.
     void Complete(unsigned priority);
+    // ATOMIC BEGIN
+    /// Execute a function over the index range [begin, end) split into chunks among the worker threads and the main thread, and wait for it to finish. Only waits for the loop's own work instead of all queued work. Grain size is the minimum chunk size; 0 chooses automatically. Can only be called from the main thread.
+    void ParallelFor(unsigned begin, unsigned end, unsigned grainSize, const ParallelForFunction& function);
+    // ATOMIC END
 
     /// Set the pool telerance before it starts deleting pool items.
     void SetTolerance(int tolerance) { tolerance_ = tolerance; }
@@ -109,6 +155,11 @@ public:
     /// Set how many milliseconds maximum per frame to spend on low-priority work, when there are no worker threads.
     void SetNonThreadedWorkMs(int ms) { maxNonThreadedWorkMs_ = Max(ms, 1); }
 
+    // ATOMIC BEGIN
+    /// Set whether maximum priority items are distributed through the lock-free work-stealing deques instead of the mutex-protected queue. Default true.
+    void SetWorkStealing(bool enable) { workStealing_ = enable; }
+    // ATOMIC END
+
     /// Return number of worker threads.
     unsigned GetNumThreads() const { return threads_.Size(); }
 
@@ -123,6 +174,11 @@ public:
     /// Return how many milliseconds maximum to spend on non-threaded low-priority work.
     int GetNonThreadedWorkMs() const { return maxNonThreadedWorkMs_; }
 
+    // ATOMIC BEGIN
+    /// Return whether maximum priority items use the work-stealing deques.
+    bool GetWorkStealing() const { return workStealing_; }
+    // ATOMIC END
+
 private:
     /// Process work items until shut down. Called by the worker threads.
     void ProcessItems(unsigned threadIndex);
@@ -134,15 +190,35 @@ private:
     void ReturnToPool(SharedPtr<WorkItem>& item);
     /// Handle frame start event. Purge completed work from the main thread queue, and perform work if no threads at all.
     void HandleBeginFrame(StringHash eventType, VariantMap& eventData);
+    // ATOMIC BEGIN
+    /// Take an item from the thread's own deque, or steal from the other threads' deques. Return null if none available.
+    WorkItem* TakeStealableItem(unsigned threadIndex);
+    /// Execute a stealable item while waiting for work to finish, or back off if none is available. The idle count is the number of consecutive calls that found no item; waiting escalates from spinning to yielding to sleeping as it grows.
+    void HelpOrBackOff(unsigned threadIndex, unsigned& idleCount);
+    /// Return the number of work items to split a range into and choose the grain size if not specified.
+    unsigned GetNumSlices(unsigned count, unsigned& grainSize) const;
+    /// Pause worker threads if no queued or unfinished work remains.
+    void PauseIfIdle();
+    // ATOMIC END
 
     /// Worker threads.
     Vector<SharedPtr<WorkerThread> > threads_;
-    /// Work item pool for reuse to cut down on allocation. The bool is a flag for item pooling and whether it is available or not.
-    List<SharedPtr<WorkItem> > poolItems_;
+    /// Work item pool for reuse to cut down on allocation.
+    Vector<SharedPtr<WorkItem> > poolItems_;
     /// Work item collection. Accessed only by the main thread.
-    List<SharedPtr<WorkItem> > workItems_;
+    Vector<SharedPtr<WorkItem> > workItems_;
     /// Work item prioritized queue for worker threads. Pointers are guaranteed to be valid (point to workItems.)
     List<WorkItem*> queue_;
+    // ATOMIC BEGIN
+    /// Work-stealing deques indexed by thread index (0 = main thread.) Each is pushed and popped only by its own thread.
+    PODVector<WorkStealingDeque<WorkItem>*> deques_;
+    /// Work items of the currently executing parallel loops. Nested loops append to and later remove from the end.
+    Vector<SharedPtr<WorkItem> > parallelForItems_;
+    /// Number of task graphs started but not yet waited for.
+    unsigned numRunningTaskGraphs_;
+    /// Work-stealing enabled flag.
+    bool workStealing_;
+    // ATOMIC END
     /// Worker queue mutex.
     Mutex queueMutex_;
     /// Shutting down flag.
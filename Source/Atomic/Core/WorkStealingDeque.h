@@ -0,0 +1,181 @@
+//
+// Copyright (c) 2014-2017 THUNDERBEAST GAMES LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "../Container/Vector.h"
+#include "../Math/MathDefs.h"
+
+#include <atomic>
+
+namespace Atomic
+{
+
+/// Lock-free work-stealing deque (Chase-Lev) of pointers. The owning thread pushes and pops at the bottom, other threads steal from the top.
+template <class T> class WorkStealingDeque
+{
+public:
+    /// Construct with initial capacity, rounded up to a power of two.
+    WorkStealingDeque(unsigned initialCapacity = 256) :
+        top_(0),
+        bottom_(0)
+    {
+        array_.store(new Buffer(NextPowerOfTwo(Max((int)initialCapacity, 2))), std::memory_order_relaxed);
+    }
+
+    /// Destruct. Free the storage, including buffers retired by growing.
+    ~WorkStealingDeque()
+    {
+        delete array_.load(std::memory_order_relaxed);
+        for (unsigned i = 0; i < retired_.Size(); ++i)
+            delete retired_[i];
+    }
+
+    /// Push an item to the bottom. Only to be called from the owning thread.
+    void Push(T* item)
+    {
+        long long bottom = bottom_.load(std::memory_order_relaxed);
+        long long top = top_.load(std::memory_order_acquire);
+        Buffer* buffer = array_.load(std::memory_order_relaxed);
+
+        if (bottom - top > (long long)buffer->mask_)
+            buffer = Grow(buffer, top, bottom);
+
+        buffer->Put(bottom, item);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom_.store(bottom + 1, std::memory_order_relaxed);
+    }
+
+    /// Pop an item from the bottom. Only to be called from the owning thread. Return null if empty or lost the race for the last item.
+    T* Pop()
+    {
+        long long bottom = bottom_.load(std::memory_order_relaxed) - 1;
+        Buffer* buffer = array_.load(std::memory_order_relaxed);
+        bottom_.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        long long top = top_.load(std::memory_order_relaxed);
+
+        T* item = 0;
+        if (top <= bottom)
+        {
+            item = buffer->Get(bottom);
+            if (top == bottom)
+            {
+                // Last item: race against thieves
+                if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                    item = 0;
+                bottom_.store(bottom + 1, std::memory_order_relaxed);
+            }
+        }
+        else
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+
+        return item;
+    }
+
+    /// Steal an item from the top. Can be called from any thread. Return null if empty or lost the race to another thread.
+    T* Steal()
+    {
+        long long top = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        long long bottom = bottom_.load(std::memory_order_acquire);
+
+        if (top < bottom)
+        {
+            Buffer* buffer = array_.load(std::memory_order_acquire);
+            T* item = buffer->Get(top);
+            if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                return 0;
+            return item;
+        }
+
+        return 0;
+    }
+
+    /// Return approximate number of items. Exact only when called from the owning thread while no thieves are active.
+    unsigned Size() const
+    {
+        long long bottom = bottom_.load(std::memory_order_relaxed);
+        long long top = top_.load(std::memory_order_relaxed);
+        return bottom > top ? (unsigned)(bottom - top) : 0;
+    }
+
+    /// Return whether the deque appears empty.
+    bool Empty() const { return Size() == 0; }
+
+private:
+    /// Circular item buffer.
+    struct Buffer
+    {
+        /// Construct with power of two capacity.
+        Buffer(unsigned capacity) :
+            mask_(capacity - 1),
+            items_(new std::atomic<T*>[capacity])
+        {
+        }
+
+        /// Destruct.
+        ~Buffer()
+        {
+            delete[] items_;
+        }
+
+        /// Store an item at a logical index.
+        void Put(long long index, T* item) { items_[index & mask_].store(item, std::memory_order_relaxed); }
+        /// Load an item from a logical index.
+        T* Get(long long index) const { return items_[index & mask_].load(std::memory_order_relaxed); }
+
+        /// Capacity minus one.
+        unsigned mask_;
+        /// Item storage.
+        std::atomic<T*>* items_;
+    };
+
+    /// Replace the buffer with one of double capacity. The old buffer is retired rather than freed, as thieves may still be reading it.
+    Buffer* Grow(Buffer* buffer, long long top, long long bottom)
+    {
+        Buffer* newBuffer = new Buffer((buffer->mask_ + 1) * 2);
+        for (long long i = top; i < bottom; ++i)
+            newBuffer->Put(i, buffer->Get(i));
+
+        retired_.Push(buffer);
+        array_.store(newBuffer, std::memory_order_release);
+        return newBuffer;
+    }
+
+    /// Prevent copy construction.
+    WorkStealingDeque(const WorkStealingDeque& rhs);
+    /// Prevent assignment.
+    WorkStealingDeque& operator =(const WorkStealingDeque& rhs);
+
+    /// Top index, advanced by thieves.
+    std::atomic<long long> top_;
+    /// Bottom index, modified by the owner.
+    std::atomic<long long> bottom_;
+    /// Current buffer.
+    std::atomic<Buffer*> array_;
+    /// Buffers replaced by growing. Accessed only by the owner.
+    PODVector<Buffer*> retired_;
+};
+
+}
@@ -26,6 +26,7 @@
 #include "../Core/Context.h"
 #include "../Core/CoreEvents.h"
 // ATOMIC BEGIN
+#include "../Core/EventQueue.h"
 #include "../Core/Profiler.h"
 #include "../Engine/EngineDefs.h"
 // ATOMIC END
@@ -73,6 +74,9 @@
 #include "../Scene/Scene.h"
 #include "../Scene/SceneEvents.h"
 #include "../UI/UI.h"
+// ATOMIC BEGIN
+#include "../Metrics/FrameStatistics.h"
+// ATOMIC END
 #ifdef ATOMIC_ATOMIC2D
 #include "../Atomic2D/Atomic2D.h"
 #endif
@@ -142,6 +146,13 @@ Engine::Engine(Context* context) :
     // Register self as a subsystem
     context_->RegisterSubsystem(this);
 
+    // ATOMIC BEGIN
+    updateChannel_.Resolve(this, E_UPDATE);
+    postUpdateChannel_.Resolve(this, E_POSTUPDATE);
+    renderUpdateChannel_.Resolve(this, E_RENDERUPDATE);
+    postRenderUpdateChannel_.Resolve(this, E_POSTRENDERUPDATE);
+    // ATOMIC END
+
     // Create subsystems which do not depend on engine initialization or startup parameters
     context_->RegisterSubsystem(new Time(context_));
     context_->RegisterSubsystem(new WorkQueue(context_));
@@ -168,6 +179,9 @@ Engine::Engine(Context* context) :
     context_->RegisterSubsystem(new Input(context_));
     context_->RegisterSubsystem(new Audio(context_));
     context_->RegisterSubsystem(new UI(context_));
+    // ATOMIC BEGIN
+    context_->RegisterSubsystem(new FrameStatistics(context_));
+    // ATOMIC END
 
     // Register object factories for libraries which are not automatically registered along with subsystem creation
     RegisterSceneLibrary(context_);
@@ -258,9 +272,30 @@ bool Engine::Initialize(const VariantMap& parameters)
         if (HasParameter(parameters, EP_LOG_LEVEL))
             log->SetLevel(GetParameter(parameters, EP_LOG_LEVEL).GetInt());
         log->SetQuiet(GetParameter(parameters, EP_LOG_QUIET, false).GetBool());
+        // ATOMIC BEGIN
+        if (GetParameter(parameters, EP_LOG_JSON, false).GetBool())
+            log->SetFormat(LOG_FORMAT_JSON);
+        // ATOMIC END
         log->Open(GetParameter(parameters, EP_LOG_NAME, "Atomic.log").GetString());
+        // ATOMIC BEGIN
+        log->SetAsync(GetParameter(parameters, EP_LOG_ASYNC, false).GetBool());
+        // ATOMIC END
     }
 
+    // ATOMIC BEGIN
+    if (HasParameter(parameters, EP_FRAME_STATS_PORT))
+        GetSubsystem<FrameStatistics>()->StartServer((unsigned short)GetParameter(parameters, EP_FRAME_STATS_PORT).GetInt());
+    // ATOMIC END
+
+    // ATOMIC BEGIN
+#ifdef ATOMIC_DEBUG
+    // Event names are registered during static initialization, before the log exists
+    const Vector<String>& eventNameCollisions = EventNameRegistrar::GetEventNameCollisions();
+    for (unsigned i = 0; i < eventNameCollisions.Size(); ++i)
+        ATOMIC_LOGERROR(eventNameCollisions[i]);
+#endif
+    // ATOMIC END
+
     // Set maximally accurate low res timer
     GetSubsystem<Time>()->SetTimerPeriod(1);
 
@@ -284,6 +319,9 @@ bool Engine::Initialize(const VariantMap& parameters)
     if (numThreads)
     {
         GetSubsystem<WorkQueue>()->CreateThreads(numThreads);
+        // ATOMIC BEGIN
+        GetSubsystem<WorkQueue>()->SetWorkStealing(GetParameter(parameters, EP_WORK_STEALING, true).GetBool());
+        // ATOMIC END
 
         ATOMIC_LOGINFOF("Created %u worker thread%s", numThreads, numThreads > 1 ? "s" : "");
     }
@@ -389,6 +427,10 @@ bool Engine::Initialize(const VariantMap& parameters)
         if (GetParameter(parameters, EP_PROFILER_LISTEN, false).GetBool())
             profiler->StartListen((unsigned short)GetParameter(parameters, EP_PROFILER_PORT, PROFILER_DEFAULT_PORT).GetInt());
         profiler->SetEventProfilingEnabled(GetParameter(parameters, EP_EVENT_PROFILER, true).GetBool());
+        if (HasParameter(parameters, EP_TRACE_CAPTURE))
+            profiler->SetTraceCapture(GetParameter(parameters, EP_TRACE_CAPTURE).GetFloat());
+        if (HasParameter(parameters, EP_TRACE_THRESHOLD))
+            profiler->SetTraceTrigger(GetParameter(parameters, EP_TRACE_THRESHOLD).GetFloat());
     }
     // ATOMIC END
 #endif
@@ -594,6 +636,9 @@ void Engine::RunFrame()
     if ( exiting_ ) // needed to prevent scripts running the
         return;     // current frame update with null objects
 
+    // Deliver events posted from other threads since the last frame
+    context_->GetEventQueue()->Flush();
+
     // If paused, or pause when minimized -mode is in use, stop updates and audio as necessary
     if ((paused_ && !runNextPausedFrame_) ||
         (pauseMinimized_ && input->IsMinimized()))
@@ -705,16 +750,16 @@ void Engine::DumpResources(bool dumpFileName)
         return;
 
     ResourceCache* cache = GetSubsystem<ResourceCache>();
-    const HashMap<StringHash, ResourceGroup>& resourceGroups = cache->GetAllResources();
+    const FlatHashMap<StringHash, ResourceGroup>& resourceGroups = cache->GetAllResources();
     if (dumpFileName)
     {
         ATOMIC_LOGRAW("Used resources:\n");
-        for (HashMap<StringHash, ResourceGroup>::ConstIterator i = resourceGroups.Begin(); i != resourceGroups.End(); ++i)
+        for (FlatHashMap<StringHash, ResourceGroup>::ConstIterator i = resourceGroups.Begin(); i != resourceGroups.End(); ++i)
         {
-            const HashMap<StringHash, SharedPtr<Resource> >& resources = i->second_.resources_;
+            const FlatHashMap<StringHash, SharedPtr<Resource> >& resources = i->second_.resources_;
             if (dumpFileName)
             {
-                for (HashMap<StringHash, SharedPtr<Resource> >::ConstIterator j = resources.Begin(); j != resources.End(); ++j)
+                for (FlatHashMap<StringHash, SharedPtr<Resource> >::ConstIterator j = resources.Begin(); j != resources.End(); ++j)
                     ATOMIC_LOGRAW(j->second_->GetName() + "\n");
             }
         }
@@ -768,21 +813,34 @@ void Engine::Update()
 {
     ATOMIC_PROFILE(Update);
 
-    // Logic update event
-    using namespace Update;
+    // ATOMIC BEGIN
+    // The payload is converted to a VariantMap only for script listeners and handlers that take one
+    UpdateEventPayload payload(timeStep_);
 
-    VariantMap& eventData = GetEventDataMap();
-    eventData[P_TIMESTEP] = timeStep_;
-    SendEvent(E_UPDATE, eventData);
+    // Logic update event
+    {
+        ATOMIC_FRAMESTAT(STAT_UPDATE);
+        updateChannel_.Send(payload);
+    }
 
     // Logic post-update event
-    SendEvent(E_POSTUPDATE, eventData);
+    {
+        ATOMIC_FRAMESTAT(STAT_POSTUPDATE);
+        postUpdateChannel_.Send(payload);
+    }
 
     // Rendering update event
-    SendEvent(E_RENDERUPDATE, eventData);
+    {
+        ATOMIC_FRAMESTAT(STAT_RENDERUPDATE);
+        renderUpdateChannel_.Send(payload);
+    }
 
     // Post-render update event
-    SendEvent(E_POSTRENDERUPDATE, eventData);
+    {
+        ATOMIC_FRAMESTAT(STAT_POSTRENDERUPDATE);
+        postRenderUpdateChannel_.Send(payload);
+    }
+    // ATOMIC END
 }
 
 void Engine::Render()
@@ -791,6 +849,9 @@ void Engine::Render()
         return;
 
     ATOMIC_PROFILE(Render);
+    // ATOMIC BEGIN
+    ATOMIC_FRAMESTAT(STAT_RENDER);
+    // ATOMIC END
 
     // If device is lost, BeginFrame will fail and we skip rendering
     Graphics* graphics = GetSubsystem<Graphics>();
@@ -1051,6 +1112,25 @@ VariantMap Engine::ParseParameters(const Vector<String>& arguments)
             {
                 ret[EP_AUTO_METRICS] = true;
             }
+            else if (argument == "-logasync") // --logasync
+                ret[EP_LOG_ASYNC] = true;
+            else if (argument == "-logjson") // --logjson
+                ret[EP_LOG_JSON] = true;
+            else if (argument == "-framestatsport" && !value.Empty()) // --framestatsport
+            {
+                ret[EP_FRAME_STATS_PORT] = ToInt(value);
+                ++i;
+            }
+            else if (argument == "-tracecapture" && !value.Empty()) // --tracecapture <seconds>
+            {
+                ret[EP_TRACE_CAPTURE] = ToFloat(value);
+                ++i;
+            }
+            else if (argument == "-tracethreshold" && !value.Empty()) // --tracethreshold <ms>
+            {
+                ret[EP_TRACE_THRESHOLD] = ToFloat(value);
+                ++i;
+            }
             // ATOMIC END
 #ifdef ATOMIC_TESTING
             else if (argument == "timeout" && !value.Empty())
@@ -23,6 +23,9 @@
 #pragma once
 
 #include "../Core/Object.h"
+// ATOMIC BEGIN
+#include "../Core/Context.h"
+// ATOMIC END
 #include "../Core/Timer.h"
 
 namespace Atomic
@@ -193,6 +196,15 @@ private:
     /// Calculated fps
     unsigned fps_;
 
+    /// Channel for the logic update event
+    EventChannel updateChannel_;
+    /// Channel for the logic post-update event
+    EventChannel postUpdateChannel_;
+    /// Channel for the rendering update event
+    EventChannel renderUpdateChannel_;
+    /// Channel for the post-render update event
+    EventChannel postRenderUpdateChannel_;
+
     // ATOMIC END
    
 };
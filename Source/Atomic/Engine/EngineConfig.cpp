@@ -45,6 +45,8 @@ bool EngineConfig::LoadEngineConfig(const JSONValue& jengine)
 
         if (key == "workerthreads")
             valueMap_["WorkerThreads"] = GetBoolValue(jvalue, true);
+        else if (key == "workstealing")
+            valueMap_["WorkStealing"] = GetBoolValue(jvalue, true);
         else if (key == "logquiet")
             valueMap_["LogQuiet"] = GetBoolValue(jvalue, false);
         else if (key == "loglevel")
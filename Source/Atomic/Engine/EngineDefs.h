@@ -78,5 +78,11 @@ static const String EP_WINDOW_MAXIMIZED = "WindowMaximized";
 static const String EP_AUTO_METRICS = "AutoMetrics";
 static const String EP_PROFILER_LISTEN = "ProfilerListen";
 static const String EP_PROFILER_PORT = "ProfilerPort";
+static const String EP_WORK_STEALING = "WorkStealing";
+static const String EP_LOG_ASYNC = "LogAsync";
+static const String EP_LOG_JSON = "LogJSON";
+static const String EP_FRAME_STATS_PORT = "FrameStatsPort";
+static const String EP_TRACE_CAPTURE = "TraceCapture";
+static const String EP_TRACE_THRESHOLD = "TraceThreshold";
 // ATOMIC END
 }
@@ -136,6 +136,19 @@ bool AnimatedModel::Load(Deserializer& source, bool setInstanceDefault)
     return success;
 }
 
+// ATOMIC BEGIN
+
+bool AnimatedModel::LoadValues(const VariantVector& values, bool setInstanceDefault)
+{
+    loading_ = true;
+    bool success = Component::LoadValues(values, setInstanceDefault);
+    loading_ = false;
+
+    return success;
+}
+
+// ATOMIC END
+
 bool AnimatedModel::LoadXML(const XMLElement& source, bool setInstanceDefault)
 {
     loading_ = true;
@@ -49,6 +49,10 @@ public:
 
     /// Load from binary data. Return true if successful.
     virtual bool Load(Deserializer& source, bool setInstanceDefault = false);
+    // ATOMIC BEGIN
+    /// Load from attribute values decoded in advance. Return true if successful.
+    virtual bool LoadValues(const VariantVector& values, bool setInstanceDefault = false);
+    // ATOMIC END
     /// Load from XML data. Return true if successful.
     virtual bool LoadXML(const XMLElement& source, bool setInstanceDefault = false);
     /// Load from JSON data. Return true if successful.
@@ -725,6 +725,18 @@ void BatchQueue::Clear(int maxSortedInstances)
     maxSortedInstances_ = (unsigned)maxSortedInstances;
 }
 
+// ATOMIC BEGIN
+void BatchQueue::ReleaseFrameStorage()
+{
+    // The group instances are allocated from the frame allocator as well. Swapping with empty vectors forgets the
+    // storage without touching the elements
+    batchGroups_.Clear();
+    PODVector<Batch, FrameAllocatorPolicy>().Swap(batches_);
+    PODVector<Batch*, FrameAllocatorPolicy>().Swap(sortedBatches_);
+    PODVector<BatchGroup*, FrameAllocatorPolicy>().Swap(sortedBatchGroups_);
+}
+// ATOMIC END
+
 void BatchQueue::SortBackToFront()
 {
     sortedBatches_.Resize(batches_.Size());
@@ -776,10 +788,12 @@ void BatchQueue::SortFrontToBack()
     for (HashMap<BatchGroupKey, BatchGroup>::Iterator i = batchGroups_.Begin(); i != batchGroups_.End(); ++i)
         sortedBatchGroups_[index++] = &i->second_;
 
-    SortFrontToBack2Pass(reinterpret_cast<PODVector<Batch*>& >(sortedBatchGroups_));
+    // ATOMIC BEGIN
+    SortFrontToBack2Pass(reinterpret_cast<PODVector<Batch*, FrameAllocatorPolicy>& >(sortedBatchGroups_));
 }
 
-void BatchQueue::SortFrontToBack2Pass(PODVector<Batch*>& batches)
+void BatchQueue::SortFrontToBack2Pass(PODVector<Batch*, FrameAllocatorPolicy>& batches)
+// ATOMIC END
 {
     // Mobile devices likely use a tiled deferred approach, with which front-to-back sorting is irrelevant. The 2-pass
     // method is also time consuming, so just sort with state having priority
@@ -22,6 +22,7 @@
 
 #pragma once
 
+#include "../Container/FrameAllocator.h"
 #include "../Container/Ptr.h"
 #include "../Graphics/Drawable.h"
 #include "../Graphics/Material.h"
@@ -176,8 +177,10 @@ struct BatchGroup : public Batch
     /// Prepare and draw.
     void Draw(View* view, Camera* camera, bool allowDepthWrite) const;
 
-    /// Instance data.
-    PODVector<InstanceData> instances_;
+    // ATOMIC BEGIN
+    /// Instance data. Rebuilt every frame, so it is allocated from the frame allocator.
+    PODVector<InstanceData, FrameAllocatorPolicy> instances_;
+    // ATOMIC END
     /// Instance stream start index, or M_MAX_UNSIGNED if transforms not pre-set.
     unsigned startIndex_;
 };
@@ -238,12 +241,18 @@ struct BatchQueue
 public:
     /// Clear for new frame by clearing all groups and batches.
     void Clear(int maxSortedInstances);
+    // ATOMIC BEGIN
+    /// Release the groups and batches allocated from the frame allocator. Called at the end of the frame, before the frame allocators are reset.
+    void ReleaseFrameStorage();
+    // ATOMIC END
     /// Sort non-instanced draw calls back to front.
     void SortBackToFront();
     /// Sort instanced and non-instanced draw calls front to back.
     void SortFrontToBack();
     /// Sort batches front to back while also maintaining state sorting.
-    void SortFrontToBack2Pass(PODVector<Batch*>& batches);
+    // ATOMIC BEGIN
+    void SortFrontToBack2Pass(PODVector<Batch*, FrameAllocatorPolicy>& batches);
+    // ATOMIC END
     /// Pre-set instance data of all groups. The vertex buffer must be big enough to hold all data.
     void SetInstancingData(void* lockedData, unsigned stride, unsigned& freeIndex);
     /// Draw.
@@ -263,12 +272,14 @@ public:
     /// Geometry remapping table for 2-pass state and distance sort.
     HashMap<unsigned short, unsigned short> geometryRemapping_;
 
-    /// Unsorted non-instanced draw calls.
-    PODVector<Batch> batches_;
-    /// Sorted non-instanced draw calls.
-    PODVector<Batch*> sortedBatches_;
-    /// Sorted instanced draw calls.
-    PODVector<BatchGroup*> sortedBatchGroups_;
+    // ATOMIC BEGIN
+    /// Unsorted non-instanced draw calls. Rebuilt every frame, so it is allocated from the frame allocator.
+    PODVector<Batch, FrameAllocatorPolicy> batches_;
+    /// Sorted non-instanced draw calls. Allocated from the frame allocator.
+    PODVector<Batch*, FrameAllocatorPolicy> sortedBatches_;
+    /// Sorted instanced draw calls. Allocated from the frame allocator.
+    PODVector<BatchGroup*, FrameAllocatorPolicy> sortedBatchGroups_;
+    // ATOMIC END
     /// Maximum sorted instances.
     unsigned maxSortedInstances_;
     /// Whether the pass command contains extra shader defines.
@@ -315,8 +326,10 @@ struct LightBatchQueue
     Vector<ShadowBatchQueue> shadowSplits_;
     /// Per-vertex lights.
     PODVector<Light*> vertexLights_;
-    /// Light volume draw calls.
-    PODVector<Batch> volumeBatches_;
+    // ATOMIC BEGIN
+    /// Light volume draw calls. Allocated from the frame allocator.
+    PODVector<Batch, FrameAllocatorPolicy> volumeBatches_;
+    // ATOMIC END
 };
 
 }
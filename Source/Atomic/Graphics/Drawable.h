@@ -113,7 +113,6 @@ class ATOMIC_API Drawable : public Component
 
     friend class Octant;
     friend class Octree;
-    friend void UpdateDrawablesWork(const WorkItem* item, unsigned threadIndex);
 
 public:
     /// Construct.
@@ -48,21 +48,6 @@ static const int DEFAULT_OCTREE_LEVELS = 8;
 
 extern const char* SUBSYSTEM_CATEGORY;
 
-void UpdateDrawablesWork(const WorkItem* item, unsigned threadIndex)
-{
-    const FrameInfo& frame = *(reinterpret_cast<FrameInfo*>(item->aux_));
-    Drawable** start = reinterpret_cast<Drawable**>(item->start_);
-    Drawable** end = reinterpret_cast<Drawable**>(item->end_);
-
-    while (start != end)
-    {
-        Drawable* drawable = *start;
-        if (drawable)
-            drawable->Update(frame);
-        ++start;
-    }
-}
-
 inline bool CompareRayQueryResults(const RayQueryResult& lhs, const RayQueryResult& rhs)
 {
     return lhs.distance_ < rhs.distance_;
@@ -391,30 +376,18 @@ void Octree::Update(const FrameInfo& frame)
         WorkQueue* queue = GetSubsystem<WorkQueue>();
         scene->BeginThreadedUpdate();
 
-        int numWorkItems = queue->GetNumThreads() + 1; // Worker threads + main thread
-        int drawablesPerItem = Max((int)(drawableUpdates_.Size() / numWorkItems), 1);
-
-        PODVector<Drawable*>::Iterator start = drawableUpdates_.Begin();
-        // Create a work item for each thread
-        for (int i = 0; i < numWorkItems; ++i)
+        // ATOMIC BEGIN
+        queue->ParallelFor(0, drawableUpdates_.Size(), 0, [this, &frame](unsigned begin, unsigned end, unsigned threadIndex)
         {
-            SharedPtr<WorkItem> item = queue->GetFreeItem();
-            item->priority_ = M_MAX_UNSIGNED;
-            item->workFunction_ = UpdateDrawablesWork;
-            item->aux_ = const_cast<FrameInfo*>(&frame);
-
-            PODVector<Drawable*>::Iterator end = drawableUpdates_.End();
-            if (i < numWorkItems - 1 && end - start > drawablesPerItem)
-                end = start + drawablesPerItem;
-
-            item->start_ = &(*start);
-            item->end_ = &(*end);
-            queue->AddWorkItem(item);
-
-            start = end;
-        }
+            for (unsigned i = begin; i < end; ++i)
+            {
+                Drawable* drawable = drawableUpdates_[i];
+                if (drawable)
+                    drawable->Update(frame);
+            }
+        });
+        // ATOMIC END
 
-        queue->Complete(M_MAX_UNSIGNED);
         scene->EndThreadedUpdate();
     }
 
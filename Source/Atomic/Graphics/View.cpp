@@ -22,7 +22,11 @@
 
 #include "../Precompiled.h"
 
+// ATOMIC BEGIN
+#include "../Core/CoreEvents.h"
+// ATOMIC END
 #include "../Core/Profiler.h"
+#include "../Core/TaskGraph.h"
 #include "../Core/WorkQueue.h"
 #include "../Graphics/Camera.h"
 #include "../Graphics/DebugRenderer.h"
@@ -167,11 +171,10 @@ public:
     OcclusionBuffer* buffer_;
 };
 
-void CheckVisibilityWork(const WorkItem* item, unsigned threadIndex)
+// ATOMIC BEGIN
+void CheckVisibilityWork(View* view, Drawable** start, Drawable** end, unsigned threadIndex)
 {
-    View* view = reinterpret_cast<View*>(item->aux_);
-    Drawable** start = reinterpret_cast<Drawable**>(item->start_);
-    Drawable** end = reinterpret_cast<Drawable**>(item->end_);
+// ATOMIC END
     OcclusionBuffer* buffer = view->occlusionBuffer_;
     const Matrix3x4& viewMatrix = view->cullCamera_->GetView();
     Vector3 viewZ = Vector3(viewMatrix.m20_, viewMatrix.m21_, viewMatrix.m22_);
@@ -236,57 +239,6 @@ void CheckVisibilityWork(const WorkItem* item, unsigned threadIndex)
     }
 }
 
-void ProcessLightWork(const WorkItem* item, unsigned threadIndex)
-{
-    View* view = reinterpret_cast<View*>(item->aux_);
-    LightQueryResult* query = reinterpret_cast<LightQueryResult*>(item->start_);
-
-    view->ProcessLight(*query, threadIndex);
-}
-
-void UpdateDrawableGeometriesWork(const WorkItem* item, unsigned threadIndex)
-{
-    const FrameInfo& frame = *(reinterpret_cast<FrameInfo*>(item->aux_));
-    Drawable** start = reinterpret_cast<Drawable**>(item->start_);
-    Drawable** end = reinterpret_cast<Drawable**>(item->end_);
-
-    while (start != end)
-    {
-        Drawable* drawable = *start++;
-        // We may leave null pointer holes in the queue if a drawable is found out to require a main thread update
-        if (drawable)
-            drawable->UpdateGeometry(frame);
-    }
-}
-
-void SortBatchQueueFrontToBackWork(const WorkItem* item, unsigned threadIndex)
-{
-    BatchQueue* queue = reinterpret_cast<BatchQueue*>(item->start_);
-
-    queue->SortFrontToBack();
-}
-
-void SortBatchQueueBackToFrontWork(const WorkItem* item, unsigned threadIndex)
-{
-    BatchQueue* queue = reinterpret_cast<BatchQueue*>(item->start_);
-
-    queue->SortBackToFront();
-}
-
-void SortLightQueueWork(const WorkItem* item, unsigned threadIndex)
-{
-    LightBatchQueue* start = reinterpret_cast<LightBatchQueue*>(item->start_);
-    start->litBaseBatches_.SortFrontToBack();
-    start->litBatches_.SortFrontToBack();
-}
-
-void SortShadowQueueWork(const WorkItem* item, unsigned threadIndex)
-{
-    LightBatchQueue* start = reinterpret_cast<LightBatchQueue*>(item->start_);
-    for (unsigned i = 0; i < start->shadowSplits_.Size(); ++i)
-        start->shadowSplits_[i].shadowBatches_.SortFrontToBack();
-}
-
 StringHash ParseTextureTypeXml(ResourceCache* cache, String filename);
 
 View::View(Context* context) :
@@ -309,6 +261,11 @@ View::View(Context* context) :
     tempDrawables_.Resize(numThreads);
     sceneResults_.Resize(numThreads);
     frame_.camera_ = 0;
+    // ATOMIC BEGIN
+    updateGeometriesTasks_ = new TaskGraph(context);
+
+    SubscribeToEvent(E_ENDFRAME, ATOMIC_HANDLER(View, HandleEndFrame));
+    // ATOMIC END
 }
 
 View::~View()
@@ -911,30 +868,12 @@ void View::GetDrawables()
             result.maxZ_ = 0.0f;
         }
 
-        int numWorkItems = queue->GetNumThreads() + 1; // Worker threads + main thread
-        int drawablesPerItem = tempDrawables.Size() / numWorkItems;
-
-        PODVector<Drawable*>::Iterator start = tempDrawables.Begin();
-        // Create a work item for each thread
-        for (int i = 0; i < numWorkItems; ++i)
+        // ATOMIC BEGIN
+        queue->ParallelFor(0, tempDrawables.Size(), 0, [this, &tempDrawables](unsigned begin, unsigned end, unsigned threadIndex)
         {
-            SharedPtr<WorkItem> item = queue->GetFreeItem();
-            item->priority_ = M_MAX_UNSIGNED;
-            item->workFunction_ = CheckVisibilityWork;
-            item->aux_ = this;
-
-            PODVector<Drawable*>::Iterator end = tempDrawables.End();
-            if (i < numWorkItems - 1 && end - start > drawablesPerItem)
-                end = start + drawablesPerItem;
-
-            item->start_ = &(*start);
-            item->end_ = &(*end);
-            queue->AddWorkItem(item);
-
-            start = end;
-        }
-
-        queue->Complete(M_MAX_UNSIGNED);
+            CheckVisibilityWork(this, tempDrawables.Buffer() + begin, tempDrawables.Buffer() + end, threadIndex);
+        });
+        // ATOMIC END
     }
 
     // Combine lights, geometries & scene Z range from the threads
@@ -1000,21 +939,16 @@ void View::ProcessLights()
     lightQueryResults_.Resize(lights_.Size());
 
     for (unsigned i = 0; i < lightQueryResults_.Size(); ++i)
-    {
-        SharedPtr<WorkItem> item = queue->GetFreeItem();
-        item->priority_ = M_MAX_UNSIGNED;
-        item->workFunction_ = ProcessLightWork;
-        item->aux_ = this;
-
-        LightQueryResult& query = lightQueryResults_[i];
-        query.light_ = lights_[i];
-
-        item->start_ = &query;
-        queue->AddWorkItem(item);
-    }
+        lightQueryResults_[i].light_ = lights_[i];
 
-    // Ensure all lights have been processed before proceeding
-    queue->Complete(M_MAX_UNSIGNED);
+    // ATOMIC BEGIN
+    // Lights vary greatly in cost, so distribute them one at a time. Returns once all lights have been processed
+    queue->ParallelFor(0, lightQueryResults_.Size(), 1, [this](unsigned begin, unsigned end, unsigned threadIndex)
+    {
+        for (unsigned i = begin; i < end; ++i)
+            ProcessLight(lightQueryResults_[i], threadIndex);
+    });
+    // ATOMIC END
 }
 
 void View::GetLightBatches()
@@ -1305,7 +1239,11 @@ void View::UpdateGeometries()
 
     ATOMIC_PROFILE(SortAndUpdateGeometry);
 
-    WorkQueue* queue = GetSubsystem<WorkQueue>();
+    // ATOMIC BEGIN
+    // Batch sorting and threaded geometry updates are independent tasks of one graph. The main thread updates the
+    // non-threaded geometries while they run, and then waits only for this view's own work
+    TaskGraph* tasks = updateGeometriesTasks_;
+    tasks->Clear();
 
     // Sort batches
     {
@@ -1317,33 +1255,35 @@ void View::UpdateGeometries()
 
             if (command.type_ == CMD_SCENEPASS)
             {
-                SharedPtr<WorkItem> item = queue->GetFreeItem();
-                item->priority_ = M_MAX_UNSIGNED;
-                item->workFunction_ =
-                    command.sortMode_ == SORT_FRONTTOBACK ? SortBatchQueueFrontToBackWork : SortBatchQueueBackToFrontWork;
-                item->start_ = &batchQueues_[command.passIndex_];
-                queue->AddWorkItem(item);
+                BatchQueue* batchQueue = &batchQueues_[command.passIndex_];
+                if (command.sortMode_ == SORT_FRONTTOBACK)
+                    tasks->AddTask([batchQueue](unsigned) { batchQueue->SortFrontToBack(); });
+                else
+                    tasks->AddTask([batchQueue](unsigned) { batchQueue->SortBackToFront(); });
             }
         }
 
         for (Vector<LightBatchQueue>::Iterator i = lightQueues_.Begin(); i != lightQueues_.End(); ++i)
         {
-            SharedPtr<WorkItem> lightItem = queue->GetFreeItem();
-            lightItem->priority_ = M_MAX_UNSIGNED;
-            lightItem->workFunction_ = SortLightQueueWork;
-            lightItem->start_ = &(*i);
-            queue->AddWorkItem(lightItem);
+            LightBatchQueue* lightQueue = &(*i);
 
-            if (i->shadowSplits_.Size())
+            tasks->AddTask([lightQueue](unsigned)
             {
-                SharedPtr<WorkItem> shadowItem = queue->GetFreeItem();
-                shadowItem->priority_ = M_MAX_UNSIGNED;
-                shadowItem->workFunction_ = SortShadowQueueWork;
-                shadowItem->start_ = &(*i);
-                queue->AddWorkItem(shadowItem);
+                lightQueue->litBaseBatches_.SortFrontToBack();
+                lightQueue->litBatches_.SortFrontToBack();
+            });
+
+            if (lightQueue->shadowSplits_.Size())
+            {
+                tasks->AddTask([lightQueue](unsigned)
+                {
+                    for (unsigned j = 0; j < lightQueue->shadowSplits_.Size(); ++j)
+                        lightQueue->shadowSplits_[j].shadowBatches_.SortFrontToBack();
+                });
             }
         }
     }
+    // ATOMIC END
 
     // Update geometries. Split into threaded and non-threaded updates.
     {
@@ -1361,35 +1301,33 @@ void View::UpdateGeometries()
                 }
             }
 
-            int numWorkItems = queue->GetNumThreads() + 1; // Worker threads + main thread
-            int drawablesPerItem = threadedGeometries_.Size() / numWorkItems;
-
-            PODVector<Drawable*>::Iterator start = threadedGeometries_.Begin();
-            for (int i = 0; i < numWorkItems; ++i)
+            // ATOMIC BEGIN
+            tasks->AddParallelTask(0, threadedGeometries_.Size(), 0, [this](unsigned begin, unsigned end, unsigned threadIndex)
             {
-                PODVector<Drawable*>::Iterator end = threadedGeometries_.End();
-                if (i < numWorkItems - 1 && end - start > drawablesPerItem)
-                    end = start + drawablesPerItem;
-
-                SharedPtr<WorkItem> item = queue->GetFreeItem();
-                item->priority_ = M_MAX_UNSIGNED;
-                item->workFunction_ = UpdateDrawableGeometriesWork;
-                item->aux_ = const_cast<FrameInfo*>(&frame_);
-                item->start_ = &(*start);
-                item->end_ = &(*end);
-                queue->AddWorkItem(item);
-
-                start = end;
-            }
+                for (unsigned i = begin; i < end; ++i)
+                {
+                    Drawable* drawable = threadedGeometries_[i];
+                    // We may leave null pointer holes in the queue if a drawable is found out to require a main thread update
+                    if (drawable)
+                        drawable->UpdateGeometry(frame_);
+                }
+            });
+            // ATOMIC END
         }
 
+        // ATOMIC BEGIN
+        tasks->Start();
+        // ATOMIC END
+
         // While the work queue is processed, update non-threaded geometries
         for (PODVector<Drawable*>::ConstIterator i = nonThreadedGeometries_.Begin(); i != nonThreadedGeometries_.End(); ++i)
             (*i)->UpdateGeometry(frame_);
     }
 
     // Finally ensure all threaded work has completed
-    queue->Complete(M_MAX_UNSIGNED);
+    // ATOMIC BEGIN
+    tasks->Wait();
+    // ATOMIC END
     geometriesUpdated_ = true;
 }
 
@@ -3200,6 +3138,25 @@ void View::SendViewEvent(StringHash eventType)
     renderer_->SendEvent(eventType, eventData);
 }
 
+// ATOMIC BEGIN
+void View::HandleEndFrame(StringHash eventType, VariantMap& eventData)
+{
+    for (HashMap<unsigned, BatchQueue>::Iterator i = batchQueues_.Begin(); i != batchQueues_.End(); ++i)
+        i->second_.ReleaseFrameStorage();
+
+    for (Vector<LightBatchQueue>::Iterator i = lightQueues_.Begin(); i != lightQueues_.End(); ++i)
+    {
+        i->litBaseBatches_.ReleaseFrameStorage();
+        i->litBatches_.ReleaseFrameStorage();
+        for (Vector<ShadowBatchQueue>::Iterator j = i->shadowSplits_.Begin(); j != i->shadowSplits_.End(); ++j)
+            j->shadowBatches_.ReleaseFrameStorage();
+        PODVector<Batch, FrameAllocatorPolicy>().Swap(i->volumeBatches_);
+    }
+
+    vertexLightQueues_.Clear();
+}
+// ATOMIC END
+
 Texture* View::FindNamedTexture(const String& name, bool isRenderTarget, bool isVolumeMap)
 {
     // Check rendertargets first
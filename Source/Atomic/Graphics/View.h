@@ -43,6 +43,9 @@ class Octree;
 class Renderer;
 class RenderPath;
 class RenderSurface;
+// ATOMIC BEGIN
+class TaskGraph;
+// ATOMIC END
 class Technique;
 class Texture;
 class Texture2D;
@@ -109,8 +112,9 @@ static const unsigned MAX_VIEWPORT_TEXTURES = 2;
 /// Internal structure for 3D rendering work. Created for each backbuffer and texture viewport, but not for shadow cameras.
 class ATOMIC_API View : public Object
 {
-    friend void CheckVisibilityWork(const WorkItem* item, unsigned threadIndex);
-    friend void ProcessLightWork(const WorkItem* item, unsigned threadIndex);
+    // ATOMIC BEGIN
+    friend void CheckVisibilityWork(View* view, Drawable** start, Drawable** end, unsigned threadIndex);
+    // ATOMIC END
 
     ATOMIC_OBJECT(View, Object);
 
@@ -277,6 +281,10 @@ private:
     RenderSurface* GetRenderSurfaceFromTexture(Texture* texture, CubeMapFace face = FACE_POSITIVE_X);
     /// Send a view update or render related event through the Renderer subsystem. The parameters are the same for all of them.
     void SendViewEvent(StringHash eventType);
+    // ATOMIC BEGIN
+    /// Handle frame end. Release the batches allocated from the frame allocators before they are reset.
+    void HandleEndFrame(StringHash eventType, VariantMap& eventData);
+    // ATOMIC END
 
     /// Return the drawable's zone, or camera zone if it has override mode enabled.
     Zone* GetZone(Drawable* drawable)
@@ -409,6 +417,10 @@ private:
     HashMap<StringHash, Texture*> renderTargets_;
     /// Intermediate light processing results.
     Vector<LightQueryResult> lightQueryResults_;
+    // ATOMIC BEGIN
+    /// Batch sorting and threaded geometry update tasks.
+    SharedPtr<TaskGraph> updateGeometriesTasks_;
+    // ATOMIC END
     /// Info for scene render passes defined by the renderpath.
     PODVector<ScenePassInfo> scenePasses_;
     /// Per-pixel light queues.
@@ -0,0 +1,396 @@
+//
+// Copyright (c) 2014-2017 THUNDERBEAST GAMES LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../Precompiled.h"
+
+#include "../Core/ProcessUtils.h"
+#include "../Core/Timer.h"
+#include "../IO/AsyncLogWriter.h"
+#include "../IO/File.h"
+#include "../IO/Log.h"
+
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+
+#include "../DebugNew.h"
+
+namespace Atomic
+{
+
+extern const char* logLevelPrefixes[];
+
+/// Default size of each thread's log buffer in bytes.
+static const unsigned DEFAULT_BUFFER_SIZE = 64 * 1024;
+/// Default idle sleep time of the writer thread in milliseconds.
+static const unsigned DEFAULT_INTERVAL = 5;
+
+/// Calling thread's log buffer and the writer it belongs to. Releases the buffer when the thread exits, so that the writer can free it once drained.
+struct ThreadLogBuffer
+{
+    /// Destruct.
+    ~ThreadLogBuffer()
+    {
+        if (buffer_)
+            buffer_->Release();
+    }
+
+    /// Id of the writer that owns the buffer.
+    unsigned writerId_;
+    /// Buffer.
+    AsyncLogBuffer* buffer_;
+};
+
+static thread_local ThreadLogBuffer threadLogBuffer = { 0, 0 };
+static std::atomic<unsigned> nextWriterId(1);
+
+AsyncLogBuffer::AsyncLogBuffer(unsigned size, unsigned threadIndex, bool mainThread) :
+    size_(NextPowerOfTwo(Max((int)size, 1024))),
+    threadIndex_(threadIndex),
+    mainThread_(mainThread),
+    head_(0),
+    tail_(0),
+    dropped_(0),
+    refs_(2)
+{
+    data_ = new unsigned char[size_];
+}
+
+AsyncLogBuffer::~AsyncLogBuffer()
+{
+    delete[] data_;
+}
+
+void AsyncLogBuffer::Release()
+{
+    if (refs_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        delete this;
+}
+
+bool AsyncLogBuffer::Push(const AsyncLogRecord& record, const char* message)
+{
+    // Truncate messages that could never fit
+    AsyncLogRecord header = record;
+    header.length_ = Min(header.length_, size_ / 2 - (unsigned)sizeof(AsyncLogRecord));
+    unsigned total = (unsigned)sizeof(AsyncLogRecord) + header.length_;
+
+    unsigned head = head_.load(std::memory_order_relaxed);
+    unsigned tail = tail_.load(std::memory_order_acquire);
+    if (size_ - (head - tail) < total)
+    {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    CopyIn(head, &header, sizeof(AsyncLogRecord));
+    CopyIn(head + (unsigned)sizeof(AsyncLogRecord), message, header.length_);
+    head_.store(head + total, std::memory_order_release);
+    return true;
+}
+
+bool AsyncLogBuffer::Pop(AsyncLogRecord& record, String& dest)
+{
+    unsigned tail = tail_.load(std::memory_order_relaxed);
+    unsigned head = head_.load(std::memory_order_acquire);
+    if (head == tail)
+        return false;
+
+    CopyOut(tail, &record, sizeof(AsyncLogRecord));
+    dest.Resize(record.length_);
+    if (record.length_)
+        CopyOut(tail + (unsigned)sizeof(AsyncLogRecord), &dest[0], record.length_);
+    tail_.store(tail + (unsigned)sizeof(AsyncLogRecord) + record.length_, std::memory_order_release);
+    return true;
+}
+
+void AsyncLogBuffer::CopyIn(unsigned position, const void* src, unsigned length)
+{
+    unsigned offset = position & (size_ - 1);
+    unsigned first = Min(length, size_ - offset);
+    memcpy(data_ + offset, src, first);
+    if (first < length)
+        memcpy(data_, (const unsigned char*)src + first, length - first);
+}
+
+void AsyncLogBuffer::CopyOut(unsigned position, void* dest, unsigned length) const
+{
+    unsigned offset = position & (size_ - 1);
+    unsigned first = Min(length, size_ - offset);
+    memcpy(dest, data_ + offset, first);
+    if (first < length)
+        memcpy((unsigned char*)dest + first, data_, length - first);
+}
+
+AsyncLogWriter::AsyncLogWriter(Log* log) :
+    log_(log),
+    id_(nextWriterId.fetch_add(1)),
+    timeStampSecond_(-1),
+    nextThreadIndex_(1),
+    retiredDropped_(0),
+    reportedDropped_(0),
+    bufferSize_(DEFAULT_BUFFER_SIZE),
+    interval_(DEFAULT_INTERVAL)
+{
+}
+
+AsyncLogWriter::~AsyncLogWriter()
+{
+    Stop();
+    Drain();
+
+    // Buffers of threads that are still running are freed when they exit
+    for (unsigned i = 0; i < buffers_.Size(); ++i)
+        buffers_[i]->Release();
+}
+
+void AsyncLogWriter::Push(int level, bool error, const String& message)
+{
+    AsyncLogRecord record;
+    record.timeUSec_ = log_->GetTimeUSec();
+    record.length_ = message.Length();
+    record.level_ = level;
+    record.error_ = error;
+
+    GetThreadBuffer()->Push(record, message.CString());
+}
+
+void AsyncLogWriter::ThreadFunction()
+{
+    while (shouldRun_)
+    {
+        if (!Drain())
+            Time::Sleep(interval_);
+    }
+
+    // Write out what was queued before stopping
+    Drain();
+}
+
+unsigned AsyncLogWriter::GetNumDropped() const
+{
+    MutexLock lock(const_cast<Mutex&>(buffersMutex_));
+
+    unsigned dropped = retiredDropped_;
+    for (unsigned i = 0; i < buffers_.Size(); ++i)
+        dropped += buffers_[i]->GetNumDropped();
+    return dropped;
+}
+
+AsyncLogBuffer* AsyncLogWriter::GetThreadBuffer()
+{
+    if (threadLogBuffer.writerId_ == id_)
+        return threadLogBuffer.buffer_;
+
+    MutexLock lock(buffersMutex_);
+
+    // The main thread is always thread 0, other threads are numbered in order of their first message, reusing the numbers of exited threads
+    bool mainThread = Thread::IsMainThread();
+    unsigned threadIndex = 0;
+    if (!mainThread)
+    {
+        if (freeThreadIndices_.Size())
+        {
+            threadIndex = freeThreadIndices_.Back();
+            freeThreadIndices_.Pop();
+        }
+        else
+            threadIndex = nextThreadIndex_++;
+    }
+    AsyncLogBuffer* buffer = new AsyncLogBuffer(bufferSize_, threadIndex, mainThread);
+    buffers_.Push(buffer);
+
+    // Release the buffer of a previous writer, which that writer frees once drained
+    if (threadLogBuffer.buffer_)
+        threadLogBuffer.buffer_->Release();
+    threadLogBuffer.writerId_ = id_;
+    threadLogBuffer.buffer_ = buffer;
+    return buffer;
+}
+
+bool AsyncLogWriter::Drain()
+{
+    bool written = false;
+
+    {
+        MutexLock lock(buffersMutex_);
+
+        AsyncLogRecord record;
+        for (unsigned i = 0; i < buffers_.Size();)
+        {
+            // Check before draining, so that everything the thread pushed before exiting is drained
+            AsyncLogBuffer* buffer = buffers_[i];
+            bool retired = buffer->IsRetired();
+            while (buffer->Pop(record, message_))
+            {
+                FormatRecord(record, buffer->GetThreadIndex(), buffer->IsMainThread(), message_);
+                written = true;
+            }
+
+            if (retired)
+                RetireBuffer(i);
+            else
+                ++i;
+        }
+
+        unsigned dropped = GetNumDropped();
+        if (dropped != reportedDropped_)
+        {
+            record.timeUSec_ = log_->GetTimeUSec();
+            record.level_ = LOG_WARNING;
+            record.error_ = false;
+            message_ = "Dropped " + String(dropped - reportedDropped_) + " log messages, log buffer full";
+            record.length_ = message_.Length();
+
+            // Attribute to the main thread, which does not forward events from here
+            FormatRecord(record, 0, true, message_);
+
+            reportedDropped_ = dropped;
+            written = true;
+        }
+    }
+
+    if (written)
+        FlushBatches();
+
+    return written;
+}
+
+void AsyncLogWriter::RetireBuffer(unsigned index)
+{
+    AsyncLogBuffer* buffer = buffers_[index];
+    retiredDropped_ += buffer->GetNumDropped();
+    if (!buffer->IsMainThread())
+        freeThreadIndices_.Push(buffer->GetThreadIndex());
+    buffers_.Erase(index);
+    buffer->Release();
+}
+
+void AsyncLogWriter::FormatRecord(const AsyncLogRecord& record, unsigned threadIndex, bool mainThread, const String& message)
+{
+    bool raw = record.level_ == LOG_RAW;
+    bool error = raw ? record.error_ : record.level_ == LOG_ERROR;
+
+    if (raw)
+        line_ = message;
+    else
+    {
+        line_.Clear();
+        if (log_->timeStamp_)
+        {
+            line_ += '[';
+            line_ += GetTimeStamp(record.timeUSec_);
+            line_ += "] ";
+        }
+        line_ += logLevelPrefixes[record.level_];
+        line_ += ": ";
+        line_ += message;
+    }
+
+    if (!log_->quiet_ || error)
+    {
+        if (error)
+        {
+            // Keep ordering with the standard output stream
+            FlushConsole();
+            if (raw)
+                PrintUnicode(line_, true);
+            else
+                PrintUnicodeLine(line_, true);
+        }
+        else
+        {
+            consoleBatch_ += line_;
+            if (!raw)
+                consoleBatch_ += '\n';
+        }
+    }
+
+    if (log_->format_ == LOG_FORMAT_JSON)
+        log_->AppendJSONLine(fileBatch_, record.timeUSec_, threadIndex, record.level_, record.error_, message.CString(),
+            message.Length());
+    else
+    {
+        fileBatch_ += line_;
+        if (!raw)
+            fileBatch_ += "\r\n";
+    }
+
+    // Handed to the log by FlushBatches(), as the log mutex must not be taken while holding the buffer mutex
+    if (!mainThread && log_->forwardThreadEvents_)
+        eventMessages_.Push(StoredLogMessage(message, record.level_, record.error_));
+}
+
+const String& AsyncLogWriter::GetTimeStamp(long long timeUSec)
+{
+    long long second = log_->startTime_ + timeUSec / 1000000;
+    if (second != timeStampSecond_)
+    {
+        // Same format as Time::GetTimeStamp(), but without the shared static buffer of ctime()
+        time_t sysTime = (time_t)second;
+        tm localTime;
+#ifdef _WIN32
+        localtime_s(&localTime, &sysTime);
+#else
+        localtime_r(&sysTime, &localTime);
+#endif
+        char dateTime[64];
+        strftime(dateTime, sizeof dateTime, "%a %b %e %H:%M:%S %Y", &localTime);
+        timeStamp_ = dateTime;
+        timeStampSecond_ = second;
+    }
+
+    return timeStamp_;
+}
+
+void AsyncLogWriter::FlushConsole()
+{
+    if (!consoleBatch_.Empty())
+    {
+        PrintUnicode(consoleBatch_);
+        consoleBatch_.Clear();
+    }
+}
+
+void AsyncLogWriter::FlushBatches()
+{
+    FlushConsole();
+
+    if (!fileBatch_.Empty() || !eventMessages_.Empty())
+    {
+        MutexLock lock(log_->logMutex_);
+        if (log_->logFile_ && !fileBatch_.Empty())
+        {
+            log_->logFile_->Write(fileBatch_.CString(), fileBatch_.Length());
+            log_->logFile_->Flush();
+        }
+        fileBatch_.Clear();
+
+        while (!eventMessages_.Empty())
+        {
+            log_->asyncEventMessages_.Push(eventMessages_.Front());
+            eventMessages_.PopFront();
+        }
+    }
+}
+
+}
@@ -0,0 +1,178 @@
+//
+// Copyright (c) 2014-2017 THUNDERBEAST GAMES LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "../Container/Str.h"
+#include "../Container/Vector.h"
+#include "../Core/Mutex.h"
+#include "../Core/Thread.h"
+#include "../IO/Log.h"
+
+#include <atomic>
+
+namespace Atomic
+{
+
+/// Header of a log record in an asynchronous log buffer. Followed by the message bytes.
+struct AsyncLogRecord
+{
+    /// Time in microseconds since the log was created.
+    long long timeUSec_;
+    /// Message length in bytes.
+    unsigned length_;
+    /// Message level. LOG_RAW for raw messages.
+    int level_;
+    /// Error flag for raw messages.
+    bool error_;
+};
+
+/// Single producer, single consumer ring buffer holding the log records of one thread. Shared by the owning thread and the writer, and deleted when both have released it.
+class ATOMIC_API AsyncLogBuffer
+{
+public:
+    /// Construct with buffer size in bytes, rounded up to a power of two. Holds a reference for the owning thread and one for the writer.
+    AsyncLogBuffer(unsigned size, unsigned threadIndex, bool mainThread);
+    /// Destruct.
+    ~AsyncLogBuffer();
+
+    /// Release the reference of the owning thread or the writer. Delete the buffer if it was the last.
+    void Release();
+
+    /// Append a record. Called only from the owning thread. Return false and count a dropped message if the buffer is full.
+    bool Push(const AsyncLogRecord& record, const char* message);
+    /// Remove the oldest record and copy its message to dest. Called only from the writer thread. Return false if empty.
+    bool Pop(AsyncLogRecord& record, String& dest);
+
+    /// Return index of the owning thread, in order of registration.
+    unsigned GetThreadIndex() const { return threadIndex_; }
+    /// Return whether the owning thread is the main thread.
+    bool IsMainThread() const { return mainThread_; }
+    /// Return number of messages dropped because the buffer was full.
+    unsigned GetNumDropped() const { return dropped_.load(std::memory_order_relaxed); }
+    /// Return whether the owning thread has released the buffer, so that nothing more will be pushed. Called from the writer.
+    bool IsRetired() const { return refs_.load(std::memory_order_acquire) == 1; }
+
+private:
+    /// Copy bytes into the ring starting at a free-running position.
+    void CopyIn(unsigned position, const void* src, unsigned length);
+    /// Copy bytes out of the ring starting at a free-running position.
+    void CopyOut(unsigned position, void* dest, unsigned length) const;
+
+    /// Ring storage.
+    unsigned char* data_;
+    /// Ring size in bytes, a power of two.
+    unsigned size_;
+    /// Owning thread index.
+    unsigned threadIndex_;
+    /// Main thread flag.
+    bool mainThread_;
+    /// Write position. Only advanced by the producer.
+    std::atomic<unsigned> head_;
+    /// Read position. Only advanced by the consumer.
+    std::atomic<unsigned> tail_;
+    /// Dropped message count.
+    std::atomic<unsigned> dropped_;
+    /// Number of holders: the owning thread and the writer.
+    std::atomic<unsigned> refs_;
+};
+
+/// Background thread that drains the per-thread log buffers and writes them to the console and log file in batches. The buffer of an exited thread is freed once drained. The buffer mutex and the log mutex are never held together.
+class ATOMIC_API AsyncLogWriter : public Thread
+{
+public:
+    /// Construct for a log.
+    AsyncLogWriter(Log* log);
+    /// Destruct. Stop the thread and write out remaining messages.
+    virtual ~AsyncLogWriter();
+
+    /// Queue a message from the calling thread. Lock-free except for the first message of each thread.
+    void Push(int level, bool error, const String& message);
+    /// Drain the buffers and write out the messages. Called repeatedly by the writer thread.
+    virtual void ThreadFunction();
+
+    /// Set size of each thread's buffer in bytes. Affects only threads that have not logged yet.
+    void SetBufferSize(unsigned size) { bufferSize_ = size; }
+    /// Set sleep time in milliseconds when there is nothing to write.
+    void SetInterval(unsigned ms) { interval_ = ms; }
+
+    /// Return number of messages dropped because a thread's buffer was full.
+    unsigned GetNumDropped() const;
+    /// Return size of each thread's buffer in bytes.
+    unsigned GetBufferSize() const { return bufferSize_; }
+    /// Return sleep time in milliseconds when there is nothing to write.
+    unsigned GetInterval() const { return interval_; }
+
+private:
+    /// Return the calling thread's buffer, registering it on first use.
+    AsyncLogBuffer* GetThreadBuffer();
+    /// Write out all queued messages. Return true if anything was written.
+    bool Drain();
+    /// Remove the buffer at index after its thread has exited and it has been drained.
+    void RetireBuffer(unsigned index);
+    /// Format a record into the console and file batches, and queue it for the log message event if from another thread than main.
+    void FormatRecord(const AsyncLogRecord& record, unsigned threadIndex, bool mainThread, const String& message);
+    /// Return the console timestamp of a record.
+    const String& GetTimeStamp(long long timeUSec);
+    /// Write out and clear the console batch.
+    void FlushConsole();
+    /// Write out and clear the console and file batches, and hand the queued event messages to the log.
+    void FlushBatches();
+
+    /// Owning log.
+    Log* log_;
+    /// Unique id, used to invalidate thread-local buffer pointers of previous writers.
+    unsigned id_;
+    /// Buffers of all threads that have logged.
+    Vector<AsyncLogBuffer*> buffers_;
+    /// Mutex for registering buffers.
+    Mutex buffersMutex_;
+    /// Pending console output.
+    String consoleBatch_;
+    /// Pending log file output.
+    String fileBatch_;
+    /// Pending messages from other threads for the log message event.
+    List<StoredLogMessage> eventMessages_;
+    /// Scratch message of the record being formatted.
+    String message_;
+    /// Scratch formatted line.
+    String line_;
+    /// Cached formatted timestamp.
+    String timeStamp_;
+    /// Second of the cached timestamp.
+    long long timeStampSecond_;
+    /// Thread index for the next registered non-main thread.
+    unsigned nextThreadIndex_;
+    /// Thread indices of retired buffers, reused for new threads.
+    PODVector<unsigned> freeThreadIndices_;
+    /// Dropped messages of retired buffers.
+    unsigned retiredDropped_;
+    /// Dropped messages already reported.
+    unsigned reportedDropped_;
+    /// Buffer size for new threads.
+    unsigned bufferSize_;
+    /// Idle sleep time in milliseconds.
+    unsigned interval_;
+};
+
+}
@@ -0,0 +1,182 @@
+//
+// Copyright (c) 2014-2017 THUNDERBEAST GAMES LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../Precompiled.h"
+
+#include "../IO/BitStream.h"
+#include "../IO/Deserializer.h"
+#include "../IO/Serializer.h"
+
+#include "../DebugNew.h"
+
+namespace Atomic
+{
+
+/// Largest absolute value of the three smallest components of a unit quaternion.
+static const float SMALLEST_THREE_RANGE = 0.70710678f;
+
+static unsigned GetMaxFixedValue(unsigned numBits)
+{
+    return numBits >= 32 ? M_MAX_UNSIGNED : (1u << numBits) - 1;
+}
+
+BitWriter::BitWriter(Serializer& dest) :
+    dest_(dest),
+    buffer_(0),
+    bufferBits_(0),
+    numBits_(0)
+{
+}
+
+BitWriter::~BitWriter()
+{
+    Flush();
+}
+
+void BitWriter::WriteBits(unsigned value, unsigned numBits)
+{
+    if (!numBits)
+        return;
+
+    buffer_ |= (unsigned long long)(value & GetMaxFixedValue(numBits)) << bufferBits_;
+    bufferBits_ += numBits;
+    numBits_ += numBits;
+
+    while (bufferBits_ >= 8)
+    {
+        dest_.WriteUByte((unsigned char)buffer_);
+        buffer_ >>= 8;
+        bufferBits_ -= 8;
+    }
+}
+
+void BitWriter::WriteBool(bool value)
+{
+    WriteBits(value ? 1 : 0, 1);
+}
+
+void BitWriter::WriteHalf(float value)
+{
+    WriteBits(FloatToHalf(value), 16);
+}
+
+void BitWriter::WriteFixed(float value, float minValue, float maxValue, unsigned numBits)
+{
+    unsigned maxFixed = GetMaxFixedValue(numBits);
+    float range = maxValue - minValue;
+    double normalized = range > 0.0f ? (Clamp(value, minValue, maxValue) - minValue) / range : 0.0;
+    WriteBits((unsigned)(normalized * maxFixed + 0.5), numBits);
+}
+
+void BitWriter::WriteSmallestThree(const Quaternion& value, unsigned numBits)
+{
+    Quaternion norm = value.Normalized();
+    float components[4] = { norm.w_, norm.x_, norm.y_, norm.z_ };
+
+    unsigned largest = 0;
+    for (unsigned i = 1; i < 4; ++i)
+    {
+        if (Abs(components[i]) > Abs(components[largest]))
+            largest = i;
+    }
+
+    // The quaternion and its negation are the same rotation, so the largest component can be kept positive
+    float sign = components[largest] < 0.0f ? -1.0f : 1.0f;
+    WriteBits(largest, 2);
+    for (unsigned i = 0; i < 4; ++i)
+    {
+        if (i != largest)
+            WriteFixed(components[i] * sign, -SMALLEST_THREE_RANGE, SMALLEST_THREE_RANGE, numBits);
+    }
+}
+
+void BitWriter::Flush()
+{
+    if (bufferBits_)
+    {
+        dest_.WriteUByte((unsigned char)buffer_);
+        numBits_ += 8 - bufferBits_;
+        buffer_ = 0;
+        bufferBits_ = 0;
+    }
+}
+
+BitReader::BitReader(Deserializer& source) :
+    source_(source),
+    buffer_(0),
+    bufferBits_(0)
+{
+}
+
+unsigned BitReader::ReadBits(unsigned numBits)
+{
+    if (!numBits)
+        return 0;
+
+    while (bufferBits_ < numBits)
+    {
+        buffer_ |= (unsigned long long)source_.ReadUByte() << bufferBits_;
+        bufferBits_ += 8;
+    }
+
+    unsigned value = (unsigned)(buffer_ & GetMaxFixedValue(numBits));
+    buffer_ >>= numBits;
+    bufferBits_ -= numBits;
+    return value;
+}
+
+bool BitReader::ReadBool()
+{
+    return ReadBits(1) != 0;
+}
+
+float BitReader::ReadHalf()
+{
+    return HalfToFloat((unsigned short)ReadBits(16));
+}
+
+float BitReader::ReadFixed(float minValue, float maxValue, unsigned numBits)
+{
+    double normalized = (double)ReadBits(numBits) / GetMaxFixedValue(numBits);
+    return (float)(minValue + normalized * (maxValue - minValue));
+}
+
+Quaternion BitReader::ReadSmallestThree(unsigned numBits)
+{
+    unsigned largest = ReadBits(2);
+    float components[4];
+    float sumSquares = 0.0f;
+    for (unsigned i = 0; i < 4; ++i)
+    {
+        if (i != largest)
+        {
+            components[i] = ReadFixed(-SMALLEST_THREE_RANGE, SMALLEST_THREE_RANGE, numBits);
+            sumSquares += components[i] * components[i];
+        }
+    }
+    components[largest] = sqrtf(Max(1.0f - sumSquares, 0.0f));
+
+    return Quaternion(components[0], components[1], components[2], components[3]).Normalized();
+}
+
+}
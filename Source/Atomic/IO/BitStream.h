@@ -0,0 +1,109 @@
+//
+// Copyright (c) 2014-2017 THUNDERBEAST GAMES LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "../Math/Quaternion.h"
+
+namespace Atomic
+{
+
+class Deserializer;
+class Serializer;
+
+/// Writes values of arbitrary bit lengths to a serializer. Bits are packed starting from the least significant bit of each
+/// byte; the last byte is padded with zero bits on Flush() or destruction.
+class ATOMIC_API BitWriter
+{
+public:
+    /// Construct with destination serializer.
+    BitWriter(Serializer& dest);
+    /// Destruct. Flushes the remaining bits.
+    ~BitWriter();
+
+    /// Write the low bits of an unsigned integer. Number of bits must be 32 or less.
+    void WriteBits(unsigned value, unsigned numBits);
+    /// Write a bool as one bit.
+    void WriteBool(bool value);
+    /// Write a float as a 16-bit half float.
+    void WriteHalf(float value);
+    /// Write a float as a fixed point value within a range. Values outside the range are clamped.
+    void WriteFixed(float value, float minValue, float maxValue, unsigned numBits);
+    /// Write a unit quaternion as the index of its largest component and the three others as fixed point values.
+    void WriteSmallestThree(const Quaternion& value, unsigned numBits);
+    /// Write the remaining bits padded to a whole byte.
+    void Flush();
+
+    /// Return number of bits written, including flushed bits.
+    unsigned GetNumBits() const { return numBits_; }
+
+private:
+    /// Prevent copy construction.
+    BitWriter(const BitWriter& rhs);
+    /// Prevent assignment.
+    BitWriter& operator =(const BitWriter& rhs);
+
+    /// Destination serializer.
+    Serializer& dest_;
+    /// Bits not yet written.
+    unsigned long long buffer_;
+    /// Number of bits not yet written.
+    unsigned bufferBits_;
+    /// Total number of bits written.
+    unsigned numBits_;
+};
+
+/// Reads values of arbitrary bit lengths written by BitWriter from a deserializer. Whole bytes are read as needed, so after
+/// reading all values the deserializer is positioned just after the padded last byte.
+class ATOMIC_API BitReader
+{
+public:
+    /// Construct with source deserializer.
+    BitReader(Deserializer& source);
+
+    /// Read an unsigned integer of up to 32 bits.
+    unsigned ReadBits(unsigned numBits);
+    /// Read a bool from one bit.
+    bool ReadBool();
+    /// Read a 16-bit half float.
+    float ReadHalf();
+    /// Read a fixed point value within a range.
+    float ReadFixed(float minValue, float maxValue, unsigned numBits);
+    /// Read a unit quaternion written with WriteSmallestThree().
+    Quaternion ReadSmallestThree(unsigned numBits);
+
+private:
+    /// Prevent copy construction.
+    BitReader(const BitReader& rhs);
+    /// Prevent assignment.
+    BitReader& operator =(const BitReader& rhs);
+
+    /// Source deserializer.
+    Deserializer& source_;
+    /// Bits read from the source but not yet returned.
+    unsigned long long buffer_;
+    /// Number of bits read from the source but not yet returned.
+    unsigned bufferBits_;
+};
+
+}
@@ -28,6 +28,9 @@
 #include "../Core/Thread.h"
 #include "../Core/Timer.h"
 #include "../IO/File.h"
+// ATOMIC BEGIN
+#include "../IO/AsyncLogWriter.h"
+// ATOMIC END
 #include "../IO/IOEvents.h"
 #include "../IO/Log.h"
 
@@ -66,7 +69,14 @@ Log::Log(Context* context) :
 #endif
     timeStamp_(true),
     inWrite_(false),
-    quiet_(false)
+    quiet_(false),
+    // ATOMIC BEGIN
+    startTime_(Time::GetTimeSinceEpoch()),
+    format_(LOG_FORMAT_TEXT),
+    async_(false),
+    asyncPushes_(0),
+    forwardThreadEvents_(false)
+    // ATOMIC END
 {
     logInstance = this;
 
@@ -76,6 +86,11 @@ Log::Log(Context* context) :
 Log::~Log()
 {
     logInstance = 0;
+
+    // ATOMIC BEGIN
+    // Write out the remaining queued messages while the log file is still open
+    asyncWriter_.Reset();
+    // ATOMIC END
 }
 
 void Log::Open(const String& fileName)
@@ -91,20 +106,30 @@ void Log::Open(const String& fileName)
             Close();
     }
 
-    logFile_ = new File(context_);
-    if (logFile_->Open(fileName, FILE_WRITE))
+    // ATOMIC BEGIN
+    // Open before publishing, as the asynchronous writer may access the log file at any time
+    SharedPtr<File> logFile(new File(context_));
+    if (logFile->Open(fileName, FILE_WRITE))
+    {
+        {
+            MutexLock lock(logMutex_);
+            logFile_ = logFile;
+        }
         Write(LOG_INFO, "Opened log file " + fileName);
+    }
     else
-    {
-        logFile_.Reset();
         Write(LOG_ERROR, "Failed to create log file " + fileName);
-    }
+    // ATOMIC END
 #endif
 }
 
 void Log::Close()
 {
 #if !defined(__ANDROID__) && !defined(IOS) && !defined(TVOS)
+    // ATOMIC BEGIN
+    MutexLock lock(logMutex_);
+    // ATOMIC END
+
     if (logFile_ && logFile_->IsOpen())
     {
         logFile_->Close();
@@ -147,6 +172,19 @@ void Log::Write(int level, const String& message)
     if (level < LOG_DEBUG || level >= LOG_NONE)
         return;
 
+    // ATOMIC BEGIN
+    // Queue for the background writer from any thread without locking
+    if (logInstance && logInstance->async_)
+    {
+        if (logInstance->level_ > level)
+            return;
+
+        // If asynchronous mode was disabled meanwhile, write synchronously instead
+        if (logInstance->PushAsync(level, false, message))
+            return;
+    }
+    // ATOMIC END
+
     // If not in the main thread, store message for later processing
     if (!Thread::IsMainThread())
     {
@@ -188,7 +226,16 @@ void Log::Write(int level, const String& message)
 
     if (logInstance->logFile_)
     {
-        logInstance->logFile_->WriteLine(formattedMessage);
+        // ATOMIC BEGIN
+        if (logInstance->format_ == LOG_FORMAT_JSON)
+        {
+            String line;
+            logInstance->AppendJSONLine(line, logInstance->GetTimeUSec(), 0, level, false, message.CString(), message.Length());
+            logInstance->logFile_->Write(line.CString(), line.Length());
+        }
+        else
+            logInstance->logFile_->WriteLine(formattedMessage);
+        // ATOMIC END
         logInstance->logFile_->Flush();
     }
 
@@ -206,6 +253,11 @@ void Log::Write(int level, const String& message)
 
 void Log::WriteRaw(const String& message, bool error)
 {
+    // ATOMIC BEGIN
+    if (logInstance && logInstance->async_ && logInstance->PushAsync(LOG_RAW, error, message))
+        return;
+    // ATOMIC END
+
     // If not in the main thread, store message for later processing
     if (!Thread::IsMainThread())
     {
@@ -247,7 +299,16 @@ void Log::WriteRaw(const String& message, bool error)
 
     if (logInstance->logFile_)
     {
-        logInstance->logFile_->Write(message.CString(), message.Length());
+        // ATOMIC BEGIN
+        if (logInstance->format_ == LOG_FORMAT_JSON)
+        {
+            String line;
+            logInstance->AppendJSONLine(line, logInstance->GetTimeUSec(), 0, LOG_RAW, error, message.CString(), message.Length());
+            logInstance->logFile_->Write(line.CString(), line.Length());
+        }
+        else
+            logInstance->logFile_->Write(message.CString(), message.Length());
+        // ATOMIC END
         logInstance->logFile_->Flush();
     }
 
@@ -276,20 +337,187 @@ void Log::HandleEndFrame(StringHash eventType, VariantMap& eventData)
         return;
     }
 
-    MutexLock lock(logMutex_);
+    // ATOMIC BEGIN
+    List<StoredLogMessage> asyncEventMessages;
 
-    // Process messages accumulated from other threads (if any)
-    while (!threadMessages_.Empty())
     {
-        const StoredLogMessage& stored = threadMessages_.Front();
+        MutexLock lock(logMutex_);
 
-        if (stored.level_ != LOG_RAW)
-            Write(stored.level_, stored.message_);
-        else
-            WriteRaw(stored.message_, stored.error_);
+        // Process messages accumulated from other threads (if any)
+        while (!threadMessages_.Empty())
+        {
+            const StoredLogMessage& stored = threadMessages_.Front();
+
+            if (stored.level_ != LOG_RAW)
+                Write(stored.level_, stored.message_);
+            else
+                WriteRaw(stored.message_, stored.error_);
+
+            threadMessages_.PopFront();
+        }
+
+        // Take the messages the background writer has already written, but send their events without holding the mutex, as receivers may log
+        asyncEventMessages.Swap(asyncEventMessages_);
+    }
 
-        threadMessages_.PopFront();
+    // Send events for messages the background writer has already written, so that e.g. consoles still see them
+    while (!asyncEventMessages.Empty())
+    {
+        const StoredLogMessage& stored = asyncEventMessages.Front();
+        SendAsyncMessageEvent(stored.level_, stored.error_, stored.message_);
+        asyncEventMessages.PopFront();
     }
+
+    forwardThreadEvents_ = async_ && HasMessageReceivers();
+    // ATOMIC END
 }
 
+// ATOMIC BEGIN
+
+void Log::SetAsync(bool enable)
+{
+#if defined(ATOMIC_THREADING) && !defined(__ANDROID__) && !defined(IOS) && !defined(TVOS)
+    if (enable == async_)
+        return;
+
+    if (enable)
+    {
+        // The writer and its thread buffers are kept until the log is destroyed, as other threads may still hold them
+        if (!asyncWriter_)
+            asyncWriter_ = new AsyncLogWriter(this);
+        if (!asyncWriter_->Run())
+        {
+            ATOMIC_LOGERROR("Failed to start asynchronous log writer");
+            return;
+        }
+
+        forwardThreadEvents_ = HasMessageReceivers();
+        async_ = true;
+    }
+    else
+    {
+        async_ = false;
+        // Wait for the pushes of threads that still saw asynchronous mode enabled, so that the writer's final drain writes them out
+        while (asyncPushes_.load())
+            Time::Sleep(0);
+        asyncWriter_->Stop();
+    }
+#endif
+}
+
+bool Log::PushAsync(int level, bool error, const String& message)
+{
+    // Count the push before checking the flag, so that SetAsync(false) either sees the push in progress or the push sees the flag cleared
+    ++asyncPushes_;
+    bool pushed = async_;
+    if (pushed)
+        asyncWriter_->Push(level, error, message);
+    --asyncPushes_;
+
+    if (pushed && Thread::IsMainThread())
+        SendAsyncMessageEvent(level, error, message);
+    return pushed;
+}
+
+void Log::SetFormat(LogFormat format)
+{
+    format_ = format;
+}
+
+unsigned Log::GetNumDroppedMessages() const
+{
+    return asyncWriter_ ? asyncWriter_->GetNumDropped() : 0;
+}
+
+void Log::AppendJSONLine(String& dest, long long timeUSec, unsigned threadIndex, int level, bool error, const char* message,
+    unsigned length) const
+{
+    char header[128];
+    sprintf(header, "{\"time\":%u.%06u,\"thread\":%u,\"level\":\"%s\",\"message\":\"",
+        startTime_ + (unsigned)(timeUSec / 1000000), (unsigned)(timeUSec % 1000000), threadIndex,
+        level == LOG_RAW ? (error ? "RAW_ERROR" : "RAW") : logLevelPrefixes[level]);
+    dest.Append(header);
+
+    for (unsigned i = 0; i < length; ++i)
+    {
+        unsigned char c = (unsigned char)message[i];
+        switch (c)
+        {
+        case '"':
+            dest += "\\\"";
+            break;
+
+        case '\\':
+            dest += "\\\\";
+            break;
+
+        case '\n':
+            dest += "\\n";
+            break;
+
+        case '\r':
+            dest += "\\r";
+            break;
+
+        case '\t':
+            dest += "\\t";
+            break;
+
+        default:
+            if (c < 0x20)
+            {
+                char escaped[8];
+                sprintf(escaped, "\\u%04x", c);
+                dest.Append(escaped);
+            }
+            else
+                dest += (char)c;
+            break;
+        }
+    }
+
+    dest += "\"}\n";
+}
+
+void Log::SendAsyncMessageEvent(int level, bool error, const String& message)
+{
+    // Prevent recursion during log event
+    if (inWrite_)
+        return;
+
+    lastMessage_ = message;
+
+    if (!HasMessageReceivers())
+        return;
+
+    String formattedMessage;
+    if (level == LOG_RAW)
+        formattedMessage = message;
+    else
+    {
+        formattedMessage = logLevelPrefixes[level];
+        formattedMessage += ": " + message;
+        if (timeStamp_)
+            formattedMessage = "[" + Time::GetTimeStamp() + "] " + formattedMessage;
+    }
+
+    inWrite_ = true;
+
+    using namespace LogMessage;
+
+    VariantMap& eventData = GetEventDataMap();
+    eventData[P_MESSAGE] = formattedMessage;
+    eventData[P_LEVEL] = level == LOG_RAW ? (error ? LOG_ERROR : LOG_INFO) : level;
+    SendEvent(E_LOGMESSAGE, eventData);
+
+    inWrite_ = false;
+}
+
+bool Log::HasMessageReceivers() const
+{
+    return context_->GetEventReceivers(const_cast<Log*>(this), E_LOGMESSAGE) || context_->GetEventReceivers(E_LOGMESSAGE);
+}
+
+// ATOMIC END
+
 }
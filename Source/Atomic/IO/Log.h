@@ -26,6 +26,11 @@
 #include "../Core/Mutex.h"
 #include "../Core/Object.h"
 #include "../Core/StringUtils.h"
+// ATOMIC BEGIN
+#include "../Core/Timer.h"
+
+#include <atomic>
+// ATOMIC END
 
 namespace Atomic
 {
@@ -45,6 +50,21 @@ static const int LOG_NONE = 4;
 
 class File;
 
+// ATOMIC BEGIN
+
+class AsyncLogWriter;
+
+/// Log file line format.
+enum LogFormat
+{
+    /// Timestamped text lines, same as the console.
+    LOG_FORMAT_TEXT = 0,
+    /// One JSON object per line with time, thread, level and message.
+    LOG_FORMAT_JSON
+};
+
+// ATOMIC END
+
 /// Stored log message from another thread.
 struct StoredLogMessage
 {
@@ -112,9 +132,39 @@ public:
 
     const File* GetLogFile() const { return logFile_; }
 
+    /// Set whether to queue messages from all threads to a background writer thread instead of writing them immediately.
+    void SetAsync(bool enable);
+    /// Set log file line format.
+    void SetFormat(LogFormat format);
+
+    /// Return whether messages are written from a background thread.
+    bool IsAsync() const { return async_; }
+    /// Return log file line format.
+    LogFormat GetFormat() const { return format_; }
+    /// Return number of asynchronous messages dropped because a thread's buffer was full.
+    unsigned GetNumDroppedMessages() const;
+    /// Return the asynchronous writer, or null if asynchronous logging has never been enabled.
+    AsyncLogWriter* GetAsyncWriter() const { return asyncWriter_.Get(); }
+
+    /// Return time in microseconds since the log was created.
+    long long GetTimeUSec() const { return timer_.GetUSec(false); }
+    /// Append a JSON line for a message to a string.
+    void AppendJSONLine(String& dest, long long timeUSec, unsigned threadIndex, int level, bool error, const char* message, unsigned length) const;
+
     // ATOMIC END
 
 private:
+    // ATOMIC BEGIN
+    friend class AsyncLogWriter;
+
+    /// Queue a message for the background writer if asynchronous mode is enabled. Return false if not queued.
+    bool PushAsync(int level, bool error, const String& message);
+    /// Update the last message and send the log message event for a main thread message that was queued asynchronously.
+    void SendAsyncMessageEvent(int level, bool error, const String& message);
+    /// Return whether anyone is subscribed to the log message event.
+    bool HasMessageReceivers() const;
+    // ATOMIC END
+
     /// Handle end of frame. Process the threaded log messages.
     void HandleEndFrame(StringHash eventType, VariantMap& eventData);
 
@@ -134,6 +184,24 @@ private:
     bool inWrite_;
     /// Quiet mode flag.
     bool quiet_;
+    // ATOMIC BEGIN
+    /// Asynchronous writer.
+    UniquePtr<AsyncLogWriter> asyncWriter_;
+    /// Messages written asynchronously from other threads, waiting for the log message event on the main thread.
+    List<StoredLogMessage> asyncEventMessages_;
+    /// Timer for message times.
+    mutable HiresTimer timer_;
+    /// Wall clock time of log creation in seconds since epoch.
+    unsigned startTime_;
+    /// Log file line format.
+    LogFormat format_;
+    /// Asynchronous mode flag.
+    std::atomic<bool> async_;
+    /// Number of threads queuing a message to the background writer, which disabling asynchronous mode waits for.
+    std::atomic<unsigned> asyncPushes_;
+    /// Whether the asynchronous writer should queue other threads' messages for the log message event.
+    std::atomic<bool> forwardThreadEvents_;
+    // ATOMIC END
 };
 
 #ifdef ATOMIC_LOGGING
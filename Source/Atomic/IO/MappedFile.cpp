@@ -0,0 +1,171 @@
+//
+// Copyright (c) 2014-2017 THUNDERBEAST GAMES LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../Precompiled.h"
+
+#include "../IO/File.h"
+#include "../IO/FileSystem.h"
+#include "../IO/Log.h"
+#include "../IO/MappedFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "../DebugNew.h"
+
+namespace Atomic
+{
+
+MappedFile::MappedFile() :
+    data_(0),
+    size_(0),
+    mappingHandle_(0),
+    mapped_(false)
+{
+}
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+bool MappedFile::Open(File* file)
+{
+    Close();
+
+    if (!file || !file->IsOpen())
+    {
+        ATOMIC_LOGERROR("Could not map file, file not open");
+        return false;
+    }
+
+#ifndef __ANDROID__
+    if (!file->IsPackaged() && !file->GetFullPath().Empty() && Map(file->GetFullPath()))
+        return true;
+#endif
+
+    return Open(*file);
+}
+
+bool MappedFile::Open(Deserializer& source)
+{
+    Close();
+
+    unsigned size = source.GetSize();
+    buffer_.Resize(size);
+    source.Seek(0);
+    if (size && source.Read(&buffer_[0], size) != size)
+    {
+        ATOMIC_LOGERROR("Could not read " + source.GetName());
+        buffer_.Clear();
+        return false;
+    }
+
+    data_ = buffer_.Size() ? &buffer_[0] : 0;
+    size_ = size;
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (mapped_)
+    {
+#ifdef _WIN32
+        UnmapViewOfFile(data_);
+        CloseHandle((HANDLE)mappingHandle_);
+        mappingHandle_ = 0;
+#else
+        munmap((void*)data_, size_);
+#endif
+        mapped_ = false;
+    }
+
+    buffer_.Clear();
+    data_ = 0;
+    size_ = 0;
+}
+
+bool MappedFile::Map(const String& fileName)
+{
+#ifdef _WIN32
+    HANDLE fileHandle = CreateFileW(GetWideNativePath(fileName).CString(), GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL, 0);
+    if (fileHandle == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(fileHandle, &fileSize) || !fileSize.QuadPart || fileSize.QuadPart > M_MAX_UNSIGNED)
+    {
+        CloseHandle(fileHandle);
+        return false;
+    }
+
+    HANDLE mappingHandle = CreateFileMappingW(fileHandle, 0, PAGE_READONLY, 0, 0, 0);
+    // The mapping keeps the file open by itself
+    CloseHandle(fileHandle);
+    if (!mappingHandle)
+        return false;
+
+    void* data = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+    if (!data)
+    {
+        CloseHandle(mappingHandle);
+        return false;
+    }
+
+    mappingHandle_ = mappingHandle;
+    data_ = (const unsigned char*)data;
+    size_ = (unsigned)fileSize.QuadPart;
+#else
+    int fd = open(GetNativePath(fileName).CString(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) || !st.st_size || (unsigned long long)st.st_size > M_MAX_UNSIGNED)
+    {
+        close(fd);
+        return false;
+    }
+
+    void* data = mmap(0, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping keeps the file open by itself
+    close(fd);
+    if (data == MAP_FAILED)
+        return false;
+
+    data_ = (const unsigned char*)data;
+    size_ = (unsigned)st.st_size;
+#endif
+
+    mapped_ = true;
+    return true;
+}
+
+}
@@ -0,0 +1,76 @@
+//
+// Copyright (c) 2014-2017 THUNDERBEAST GAMES LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "../Container/RefCounted.h"
+#include "../Container/Vector.h"
+
+namespace Atomic
+{
+
+class Deserializer;
+class File;
+
+/// Read-only view of a whole file, memory-mapped when possible.
+class ATOMIC_API MappedFile : public RefCounted
+{
+    ATOMIC_REFCOUNTED(MappedFile)
+
+public:
+    /// Construct.
+    MappedFile();
+    /// Destruct. Unmap the file.
+    virtual ~MappedFile();
+
+    /// Map a file from its beginning. Read it into memory instead if it can not be mapped, for example when it is packaged or an Android asset. Return true if successful.
+    bool Open(File* file);
+    /// Read a stream into memory from its beginning. Return true if successful.
+    bool Open(Deserializer& source);
+    /// Unmap or free the file data.
+    void Close();
+
+    /// Return file data.
+    const unsigned char* GetData() const { return data_; }
+    /// Return file data size.
+    unsigned GetSize() const { return size_; }
+    /// Return whether the data is memory-mapped rather than read into memory.
+    bool IsMapped() const { return mapped_; }
+
+private:
+    /// Map a regular file by path. Return true if successful.
+    bool Map(const String& fileName);
+
+    /// File data.
+    const unsigned char* data_;
+    /// File data size.
+    unsigned size_;
+    /// Mapping handle on Windows.
+    void* mappingHandle_;
+    /// Memory-mapped flag.
+    bool mapped_;
+    /// File data when not mapped.
+    PODVector<unsigned char> buffer_;
+};
+
+}
@@ -234,9 +234,10 @@ void IPC::HandleBeginFrame(StringHash eventType, VariantMap& eventData)
         brokers_.Remove(SharedPtr<IPCBroker>(remove[i]));
     }
 
-    eventMutex_.Acquire();
+    Vector<QueuedEvent> queuedEvents;
+    queuedEvents_.PopAll(queuedEvents);
 
-    for (List<QueuedEvent>::Iterator itr = queuedEvents_.Begin(); itr != queuedEvents_.End(); itr++)
+    for (Vector<QueuedEvent>::Iterator itr = queuedEvents.Begin(); itr != queuedEvents.End(); itr++)
     {
         unsigned channelID = (*itr).channelID_;
         StringHash qeventType =  (*itr).eventType_;
@@ -260,23 +261,15 @@ void IPC::HandleBeginFrame(StringHash eventType, VariantMap& eventData)
 
 
     }
-
-    queuedEvents_.Clear();
-
-    eventMutex_.Release();
 }
 
 void IPC::QueueEvent(unsigned id, StringHash eventType, VariantMap& eventData)
 {
-    eventMutex_.Acquire();
-
     QueuedEvent event;
     event.channelID_ = id;
     event.eventType_ = eventType;
     event.eventData_ = eventData;
     queuedEvents_.Push(event);
-
-    eventMutex_.Release();
 }
 
 void IPC::Shutdown()
@@ -23,8 +23,7 @@
 #pragma once
 
 #include "../Core/Object.h"
-#include "../Core/Mutex.h"
-#include "../Container/List.h"
+#include "../Container/MPSCQueue.h"
 
 #include "IPCTypes.h"
 
@@ -83,9 +82,8 @@ private:
     // processes queued events
     void HandleBeginFrame(StringHash eventType, VariantMap& eventData);
 
-    mutable Mutex eventMutex_;
-
-    List<QueuedEvent> queuedEvents_;
+    // events received on the broker and worker threads
+    MPSCQueue<QueuedEvent> queuedEvents_;
 
     Vector<SharedPtr<IPCBroker> > brokers_;
 
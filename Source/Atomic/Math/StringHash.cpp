@@ -40,13 +40,15 @@ namespace Atomic
 
 const StringHash StringHash::ZERO;
 
+// ATOMIC BEGIN
+#if ATOMIC_PROFILING
 StringHash::StringHash(const char* str) :
     value_(Calculate(str))
 {
-#if ATOMIC_PROFILING
     RegisterSignificantString(str, *this);
-#endif
 }
+#endif
+// ATOMIC END
 
 StringHash::StringHash(const String& str) :
     value_(Calculate(str.CString()))
@@ -58,14 +60,17 @@ StringHash::StringHash(const String& str) :
 // ATOMIC BEGIN
 unsigned StringHash::Calculate(const char* str, unsigned hash)
 {
-    if (!str)
+    if (!str || !*str)
         return hash;
+
+    hash = InitialHash(hash);
 // ATOMIC END
     while (*str)
     {
         // Perform the actual hashing as case-insensitive
-        char c = *str;
-        hash = SDBMHash(hash, (unsigned char)tolower(c));
+        // ATOMIC BEGIN
+        hash = HashCharacter(hash, *str);
+        // ATOMIC END
         ++str;
     }
 
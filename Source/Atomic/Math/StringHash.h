@@ -23,34 +23,76 @@
 #pragma once
 
 #include "../Container/Str.h"
+// ATOMIC BEGIN
+#include "../Math/MathDefs.h"
+
+#include <type_traits>
+// ATOMIC END
 
 namespace Atomic
 {
 
+// ATOMIC BEGIN
+/// Undefined type that only a null pointer constant converts to a pointer of.
+struct StringHashNull;
+// ATOMIC END
+
 /// 32-bit hash value for a string.
 class ATOMIC_API StringHash
 {
 public:
+    // ATOMIC BEGIN
+
     /// Construct with zero value.
-    StringHash() :
+    constexpr StringHash() :
         value_(0)
     {
     }
 
     /// Copy-construct from another hash.
-    StringHash(const StringHash& rhs) :
+    constexpr StringHash(const StringHash& rhs) :
         value_(rhs.value_)
     {
     }
 
     /// Construct with an initial value.
-    explicit StringHash(unsigned value) :
+    explicit constexpr StringHash(unsigned value) :
         value_(value)
     {
     }
 
-    /// Construct from a C string case-insensitively.
+#if ATOMIC_PROFILING
+    /// Construct from a C string case-insensitively. Registers the string so that profiler output can show it.
     StringHash(const char* str);
+#else
+    /// Construct from a string literal or another constant char array case-insensitively. Evaluated at compile time, such as for event and parameter IDs.
+    template <unsigned L> constexpr StringHash(const char (&str)[L]) :
+        value_(CalculateConstexpr(str, L - 1))
+    {
+    }
+
+    /// Construct from a modifiable char array, such as a stack buffer, case-insensitively. Hashed at runtime, as the contents are not known at compile time.
+    template <unsigned L> StringHash(char (&str)[L]) :
+        value_(Calculate(str))
+    {
+    }
+
+    /// Construct from a C string only known at runtime case-insensitively. A template so that string literals prefer the compile time constructor.
+    template <class T> StringHash(const T& str, typename std::enable_if<std::is_same<T, const char*>::value ||
+        std::is_same<T, char*>::value>::type* = 0) :
+        value_(Calculate(str))
+    {
+    }
+
+    /// Construct from a null pointer constant, such as a literal zero, with zero value.
+    constexpr StringHash(const StringHashNull* null) :
+        value_(0)
+    {
+    }
+#endif
+
+    // ATOMIC END
+
     /// Construct from a string case-insensitively.
     StringHash(const String& str);
 
@@ -107,6 +149,53 @@ public:
 
     /// Calculate hash value case-insensitively from a C string.
     static unsigned Calculate(const char* str, unsigned hash = 0);
+    /// Calculate hash value case-insensitively from at most length characters of a C string at compile time. Gives the same result as Calculate(), which is faster for strings only known at runtime. The recursion depth grows with the logarithm of the length, so long literals stay within the compiler's constexpr depth limit.
+    static constexpr unsigned CalculateConstexpr(const char* str, unsigned length, unsigned hash = 0)
+    {
+        return HashLength(str, str ? FindNull(str, 0, length) : 0, hash);
+    }
+    /// Return the hash value to start a nonempty string from. A zero hash is replaced by the FNV-1a offset basis if ATOMIC_STRINGHASH_FNV1A is defined, so that the empty string still hashes to zero.
+    static constexpr unsigned InitialHash(unsigned hash)
+    {
+#if ATOMIC_STRINGHASH_FNV1A
+        return hash ? hash : 2166136261u;
+#else
+        return hash;
+#endif
+    }
+    /// Update a hash value with one character case-insensitively. Uses FNV-1a if ATOMIC_STRINGHASH_FNV1A is defined, otherwise SDBM.
+    static constexpr unsigned HashCharacter(unsigned hash, char c)
+    {
+#if ATOMIC_STRINGHASH_FNV1A
+        return (hash ^ ToLowerASCII(c)) * 16777619u;
+#else
+        return SDBMHash(hash, ToLowerASCII(c));
+#endif
+    }
+    /// Return the hash value of the first length characters of a C string at compile time, or the unchanged hash value if length is zero.
+    static constexpr unsigned HashLength(const char* str, unsigned length, unsigned hash)
+    {
+        return length ? HashRange(str, 0, length, InitialHash(hash)) : hash;
+    }
+    /// Update a hash value with the characters in a nonempty index range at compile time. Hashes the first half, then the second half with the result.
+    static constexpr unsigned HashRange(const char* str, unsigned begin, unsigned end, unsigned hash)
+    {
+        return end - begin == 1 ? HashCharacter(hash, str[begin]) :
+            HashRange(str, begin + (end - begin) / 2, end, HashRange(str, begin, begin + (end - begin) / 2, hash));
+    }
+    /// Return the index of the first null character in an index range at compile time, or the end index if none.
+    static constexpr unsigned FindNull(const char* str, unsigned begin, unsigned end)
+    {
+        return end - begin <= 1 ? (begin != end && !str[begin] ? begin : end) :
+            FindNullAfter(str, FindNull(str, begin, begin + (end - begin) / 2), begin + (end - begin) / 2, end);
+    }
+    /// Return the null character index found in the first half of an index range, or search the second half if none.
+    static constexpr unsigned FindNullAfter(const char* str, unsigned first, unsigned mid, unsigned end)
+    {
+        return first < mid ? first : FindNull(str, mid, end);
+    }
+    /// Return a character converted to lowercase if it is an ASCII uppercase letter. Matches tolower() in the C locale without a function call.
+    static constexpr unsigned char ToLowerASCII(char c) { return (unsigned char)(c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c); }
     /// Register significant string, which can be looked up via hash, note that the lookup is case insensitive
     static StringHash RegisterSignificantString(const String& str);
     /// Register significant string, which can be looked up via hash, note that the lookup is case insensitive
@@ -0,0 +1,347 @@
+//
+// Copyright (c) 2014-2017 THUNDERBEAST GAMES LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../Precompiled.h"
+
+#include "../Container/FrameAllocator.h"
+#include "../Container/Sort.h"
+#include "../Core/CoreEvents.h"
+#include "../Core/StringUtils.h"
+#include "../Core/WorkQueue.h"
+#include "../IO/Log.h"
+#include "../Metrics/FrameStatistics.h"
+#include "../Resource/ResourceCache.h"
+
+#ifdef ATOMIC_NETWORK
+#include <Civetweb/include/civetweb.h>
+#endif
+
+#include <atomic>
+
+#include "../DebugNew.h"
+
+namespace Atomic
+{
+
+static const char* frameStatNames[] =
+{
+    "Frame",
+    "Update",
+    "PostUpdate",
+    "RenderUpdate",
+    "PostRenderUpdate",
+    "Render",
+    "Physics",
+    "Network",
+    "AudioMix",
+    "WorkQueue",
+    "Allocations",
+    "ResourceMemory",
+    "WorkQueueUtilization",
+    0
+};
+
+/// Time counters of one thread. Written only by the owning thread, read at frame end by the main thread.
+struct ThreadFrameStats
+{
+    /// Construct.
+    ThreadFrameStats()
+    {
+        for (unsigned i = 0; i < MAX_FRAME_STATS; ++i)
+            usec_[i].store(0, std::memory_order_relaxed);
+    }
+
+    /// Accumulated microseconds of each timed statistic.
+    std::atomic<unsigned long long> usec_[MAX_FRAME_STATS];
+};
+
+/// Mutex for registering and retiring thread counters.
+static Mutex& GetThreadStatsMutex()
+{
+    static Mutex mutex;
+    return mutex;
+}
+
+/// Counters of all live threads that have recorded time.
+static PODVector<ThreadFrameStats*>& GetThreadStats()
+{
+    static PODVector<ThreadFrameStats*> threadStats;
+    return threadStats;
+}
+
+/// Totals of exited threads, so that the sums never go backwards.
+static unsigned long long retiredUSec[MAX_FRAME_STATS] = { 0 };
+
+/// Owner of the calling thread's counters. Retires them on thread exit.
+struct ThreadFrameStatsOwner
+{
+    /// Construct.
+    ThreadFrameStatsOwner() :
+        stats_(0)
+    {
+    }
+
+    /// Destruct.
+    ~ThreadFrameStatsOwner()
+    {
+        if (!stats_)
+            return;
+
+        MutexLock lock(GetThreadStatsMutex());
+        for (unsigned i = 0; i < MAX_FRAME_STATS; ++i)
+            retiredUSec[i] += stats_->usec_[i].load(std::memory_order_relaxed);
+        GetThreadStats().Remove(stats_);
+        delete stats_;
+    }
+
+    /// Counters.
+    ThreadFrameStats* stats_;
+};
+
+static thread_local ThreadFrameStatsOwner threadFrameStats;
+
+/// Sum the counters of all threads, live and exited.
+static void GetTotals(unsigned long long* totals)
+{
+    MutexLock lock(GetThreadStatsMutex());
+
+    const PODVector<ThreadFrameStats*>& threadStats = GetThreadStats();
+    for (unsigned i = 0; i < MAX_FRAME_STATS; ++i)
+    {
+        totals[i] = retiredUSec[i];
+        for (unsigned j = 0; j < threadStats.Size(); ++j)
+            totals[i] += threadStats[j]->usec_[i].load(std::memory_order_relaxed);
+    }
+}
+
+#ifdef ATOMIC_NETWORK
+static int HandleFrameStatisticsRequest(mg_connection* connection, void* data)
+{
+    String json = static_cast<FrameStatistics*>(data)->GetJSON();
+    mg_printf(connection, "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: %u\r\nConnection: close\r\n\r\n",
+        json.Length());
+    mg_write(connection, json.CString(), json.Length());
+    return 1;
+}
+#endif
+
+FrameStatistics::FrameStatistics(Context* context) :
+    Object(context),
+    historyIndex_(0),
+    numFrames_(0),
+    lastAllocations_(FrameAllocator::GetTotalHeapAllocations()),
+    server_(0)
+{
+    memset(history_, 0, sizeof history_);
+    GetTotals(lastTotals_);
+
+    SubscribeToEvent(E_ENDFRAME, ATOMIC_HANDLER(FrameStatistics, HandleEndFrame));
+}
+
+FrameStatistics::~FrameStatistics()
+{
+    StopServer();
+}
+
+bool FrameStatistics::StartServer(unsigned short port)
+{
+#ifdef ATOMIC_NETWORK
+    StopServer();
+
+    // Only listen on the loopback interface, the statistics are for local tools
+    String listeningPort = "127.0.0.1:" + String((unsigned)port);
+    const char* options[] =
+    {
+        "listening_ports", listeningPort.CString(),
+        "num_threads", "1",
+        0
+    };
+
+    server_ = mg_start(0, 0, options);
+    if (!server_)
+    {
+        ATOMIC_LOGERRORF("Failed to start frame statistics server on port %d", port);
+        return false;
+    }
+
+    mg_set_request_handler(server_, "/", HandleFrameStatisticsRequest, this);
+    ATOMIC_LOGINFOF("Serving frame statistics on 127.0.0.1:%d", port);
+    return true;
+#else
+    ATOMIC_LOGERROR("Frame statistics server is not supported without networking");
+    return false;
+#endif
+}
+
+void FrameStatistics::StopServer()
+{
+#ifdef ATOMIC_NETWORK
+    if (server_)
+    {
+        mg_stop(server_);
+        server_ = 0;
+    }
+#endif
+}
+
+float FrameStatistics::GetLast(FrameStat stat) const
+{
+    MutexLock lock(historyMutex_);
+    return numFrames_ ? history_[stat][(historyIndex_ + HISTORY_SIZE - 1) % HISTORY_SIZE] : 0.0f;
+}
+
+float FrameStatistics::GetAverage(FrameStat stat) const
+{
+    MutexLock lock(historyMutex_);
+    if (!numFrames_)
+        return 0.0f;
+
+    float total = 0.0f;
+    for (unsigned i = 0; i < numFrames_; ++i)
+        total += history_[stat][i];
+    return total / numFrames_;
+}
+
+float FrameStatistics::GetPercentile(FrameStat stat, float percentile) const
+{
+    PODVector<float> samples;
+    {
+        MutexLock lock(historyMutex_);
+        GetHistory(stat, samples);
+    }
+
+    if (samples.Empty())
+        return 0.0f;
+
+    Sort(samples.Begin(), samples.End());
+    unsigned index = (unsigned)(Clamp(percentile, 0.0f, 1.0f) * (samples.Size() - 1) + 0.5f);
+    return samples[index];
+}
+
+float FrameStatistics::GetMax(FrameStat stat) const
+{
+    MutexLock lock(historyMutex_);
+
+    float max = 0.0f;
+    for (unsigned i = 0; i < numFrames_; ++i)
+        max = Max(max, history_[stat][i]);
+    return max;
+}
+
+unsigned FrameStatistics::GetNumFrames() const
+{
+    MutexLock lock(historyMutex_);
+    return numFrames_;
+}
+
+String FrameStatistics::GetJSON() const
+{
+    String json = "{\"frames\":" + String(GetNumFrames());
+
+    for (unsigned i = 0; i < MAX_FRAME_STATS; ++i)
+    {
+        FrameStat stat = (FrameStat)i;
+        if (!IsStatAvailable(stat))
+            continue;
+
+        json += ToString(",\"%s\":{\"last\":%f,\"mean\":%f,\"p50\":%f,\"p90\":%f,\"p99\":%f,\"max\":%f}", frameStatNames[i],
+            GetLast(stat), GetAverage(stat), GetPercentile(stat, 0.5f), GetPercentile(stat, 0.9f), GetPercentile(stat, 0.99f),
+            GetMax(stat));
+    }
+
+    json += "}";
+    return json;
+}
+
+const char* FrameStatistics::GetStatName(FrameStat stat)
+{
+    return stat < MAX_FRAME_STATS ? frameStatNames[stat] : "";
+}
+
+bool FrameStatistics::IsStatAvailable(FrameStat stat)
+{
+#ifdef ATOMIC_ALLOCATION_COUNTER
+    return stat < MAX_FRAME_STATS;
+#else
+    return stat < MAX_FRAME_STATS && stat != STAT_ALLOCATIONS;
+#endif
+}
+
+void FrameStatistics::AddTime(FrameStat stat, long long usec)
+{
+    ThreadFrameStats* stats = threadFrameStats.stats_;
+    if (!stats)
+    {
+        stats = threadFrameStats.stats_ = new ThreadFrameStats();
+        MutexLock lock(GetThreadStatsMutex());
+        GetThreadStats().Push(stats);
+    }
+
+    // Only this thread writes its counters, so a relaxed load and store is enough and avoids a locked add
+    std::atomic<unsigned long long>& counter = stats->usec_[stat];
+    counter.store(counter.load(std::memory_order_relaxed) + (unsigned long long)usec, std::memory_order_relaxed);
+}
+
+void FrameStatistics::HandleEndFrame(StringHash eventType, VariantMap& eventData)
+{
+    float values[MAX_FRAME_STATS];
+
+    unsigned long long totals[MAX_FRAME_STATS];
+    GetTotals(totals);
+    for (unsigned i = 0; i < MAX_FRAME_STATS; ++i)
+    {
+        values[i] = (totals[i] - lastTotals_[i]) / 1000.0f;
+        lastTotals_[i] = totals[i];
+    }
+
+    values[STAT_FRAME] = frameTimer_.GetUSec(true) / 1000.0f;
+
+#ifdef ATOMIC_ALLOCATION_COUNTER
+    unsigned long long allocations = FrameAllocator::GetTotalHeapAllocations();
+    values[STAT_ALLOCATIONS] = (float)(allocations - lastAllocations_);
+    lastAllocations_ = allocations;
+#endif
+
+    ResourceCache* cache = GetSubsystem<ResourceCache>();
+    values[STAT_RESOURCEMEMORY] = cache ? cache->GetTotalMemoryUse() / (1024.0f * 1024.0f) : 0.0f;
+
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
+    unsigned numThreads = queue ? queue->GetNumThreads() : 0;
+    values[STAT_WORKQUEUEUTILIZATION] = numThreads && values[STAT_FRAME] > 0.0f ?
+        Min(values[STAT_WORKQUEUE] / (values[STAT_FRAME] * numThreads), 1.0f) : 0.0f;
+
+    MutexLock lock(historyMutex_);
+    for (unsigned i = 0; i < MAX_FRAME_STATS; ++i)
+        history_[i][historyIndex_] = values[i];
+    historyIndex_ = (historyIndex_ + 1) % HISTORY_SIZE;
+    numFrames_ = Min(numFrames_ + 1, HISTORY_SIZE);
+}
+
+void FrameStatistics::GetHistory(FrameStat stat, PODVector<float>& dest) const
+{
+    dest.Resize(numFrames_);
+    for (unsigned i = 0; i < numFrames_; ++i)
+        dest[i] = history_[stat][i];
+}
+
+}
@@ -0,0 +1,159 @@
+//
+// Copyright (c) 2014-2017 THUNDERBEAST GAMES LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "../Core/Mutex.h"
+#include "../Core/Object.h"
+#include "../Core/Timer.h"
+
+struct mg_context;
+
+namespace Atomic
+{
+
+/// Statistics tracked for every frame by FrameStatistics.
+enum FrameStat
+{
+    /// Wall clock frame time in milliseconds.
+    STAT_FRAME = 0,
+    /// Update event handling in milliseconds.
+    STAT_UPDATE,
+    /// PostUpdate event handling in milliseconds.
+    STAT_POSTUPDATE,
+    /// RenderUpdate event handling in milliseconds.
+    STAT_RENDERUPDATE,
+    /// PostRenderUpdate event handling in milliseconds.
+    STAT_POSTRENDERUPDATE,
+    /// Rendering in milliseconds.
+    STAT_RENDER,
+    /// Physics simulation in milliseconds.
+    STAT_PHYSICS,
+    /// Network message processing and replication in milliseconds.
+    STAT_NETWORK,
+    /// Audio mixing in milliseconds, on the audio thread.
+    STAT_AUDIOMIX,
+    /// Work item execution in milliseconds, summed over the worker threads.
+    STAT_WORKQUEUE,
+    /// Heap allocations. Available only when built with ATOMIC_ALLOCATION_COUNTER, otherwise left out of the JSON report.
+    STAT_ALLOCATIONS,
+    /// Resource cache memory use in megabytes.
+    STAT_RESOURCEMEMORY,
+    /// Fraction of worker thread time spent executing work items.
+    STAT_WORKQUEUEUTILIZATION,
+    /// Number of statistics.
+    MAX_FRAME_STATS
+};
+
+/// Always-on frame statistics. Any thread adds time to its own counters without locking; the counters are collected into
+/// a history of recent frames at the end of each frame.
+class ATOMIC_API FrameStatistics : public Object
+{
+    ATOMIC_OBJECT(FrameStatistics, Object)
+
+public:
+    /// Number of frames kept in the history.
+    static const unsigned HISTORY_SIZE = 256;
+
+    /// Construct.
+    FrameStatistics(Context* context);
+    /// Destruct.
+    virtual ~FrameStatistics();
+
+    /// Start serving the statistics as JSON over HTTP on a localhost port. Return true if successful.
+    bool StartServer(unsigned short port);
+    /// Stop serving the statistics.
+    void StopServer();
+
+    /// Return the value of a statistic in the last frame.
+    float GetLast(FrameStat stat) const;
+    /// Return the average of a statistic over the history.
+    float GetAverage(FrameStat stat) const;
+    /// Return a percentile between 0 and 1 of a statistic over the history.
+    float GetPercentile(FrameStat stat, float percentile) const;
+    /// Return the maximum of a statistic over the history.
+    float GetMax(FrameStat stat) const;
+    /// Return number of frames in the history.
+    unsigned GetNumFrames() const;
+    /// Return all statistics as a JSON object with last, mean, p50, p90, p99 and max of each.
+    String GetJSON() const;
+    /// Return whether the statistics are being served.
+    bool IsServerRunning() const { return server_ != 0; }
+
+    /// Return name of a statistic.
+    static const char* GetStatName(FrameStat stat);
+    /// Return whether a statistic is measured in this build. Heap allocations are counted only with ATOMIC_ALLOCATION_COUNTER.
+    static bool IsStatAvailable(FrameStat stat);
+    /// Add time in microseconds to a timed statistic of the calling thread.
+    static void AddTime(FrameStat stat, long long usec);
+
+private:
+    /// Handle end of frame. Collect the thread counters into the history.
+    void HandleEndFrame(StringHash eventType, VariantMap& eventData);
+    /// Copy the history of a statistic. Called with the mutex held.
+    void GetHistory(FrameStat stat, PODVector<float>& dest) const;
+
+    /// History of all statistics, oldest overwritten first.
+    float history_[MAX_FRAME_STATS][HISTORY_SIZE];
+    /// Next history index to write.
+    unsigned historyIndex_;
+    /// Number of valid frames in the history.
+    unsigned numFrames_;
+    /// Totals of the timed statistics in microseconds at the end of the last frame.
+    unsigned long long lastTotals_[MAX_FRAME_STATS];
+    /// Total heap allocations at the end of the last frame.
+    unsigned long long lastAllocations_;
+    /// Wall clock frame timer.
+    HiresTimer frameTimer_;
+    /// Mutex for the history, which the server reads from its own threads.
+    mutable Mutex historyMutex_;
+    /// HTTP server.
+    mg_context* server_;
+};
+
+/// Adds the time from construction to destruction to a frame statistic of the calling thread.
+class ATOMIC_API FrameStatScope
+{
+public:
+    /// Construct and start timing.
+    FrameStatScope(FrameStat stat) :
+        stat_(stat)
+    {
+    }
+
+    /// Destruct and add the elapsed time.
+    ~FrameStatScope()
+    {
+        FrameStatistics::AddTime(stat_, timer_.GetUSec(false));
+    }
+
+private:
+    /// Statistic to add to.
+    FrameStat stat_;
+    /// Timer.
+    HiresTimer timer_;
+};
+
+}
+
+#define ATOMIC_FRAMESTAT(stat) Atomic::FrameStatScope frameStatScope_##stat(Atomic::stat)
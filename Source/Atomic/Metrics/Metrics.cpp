@@ -20,6 +20,7 @@
 // THE SOFTWARE.
 //
 
+#include "../Core/Mutex.h"
 #include "../IO/Log.h"
 
 #include "../Scene/Node.h"
@@ -35,8 +36,74 @@
 namespace Atomic
 {
 
-Metrics* Metrics::metrics_ = 0;
 bool Metrics::everEnabled_ = false;
+std::atomic<unsigned> Metrics::sampleRate_(0);
+
+/// Node and script component samples taken on one thread.
+struct MetricsSampleBuffer
+{
+    MetricsSampleBuffer() :
+        nodeCounter_(0),
+        scriptCounter_(0)
+    {
+    }
+
+    /// Sampled instances, expired entries are compacted on capture.
+    Vector<WeakPtr<RefCounted> > samples_;
+    /// Node registrations since the last node sample.
+    unsigned nodeCounter_;
+    /// Script component registrations since the last script component sample.
+    unsigned scriptCounter_;
+    /// Guards samples_ against a concurrent capture.
+    Mutex mutex_;
+};
+
+static Mutex& GetSampleBuffersMutex()
+{
+    static Mutex mutex;
+    return mutex;
+}
+
+static PODVector<MetricsSampleBuffer*>& GetSampleBuffers()
+{
+    static PODVector<MetricsSampleBuffer*> buffers;
+    return buffers;
+}
+
+/// Owns the sample buffer of the current thread and unregisters it on thread exit.
+struct ThreadSampleBufferOwner
+{
+    ThreadSampleBufferOwner() :
+        buffer_(0)
+    {
+    }
+
+    ~ThreadSampleBufferOwner()
+    {
+        if (!buffer_)
+            return;
+
+        MutexLock lock(GetSampleBuffersMutex());
+        GetSampleBuffers().Remove(buffer_);
+        delete buffer_;
+    }
+
+    MetricsSampleBuffer* Get()
+    {
+        if (!buffer_)
+        {
+            buffer_ = new MetricsSampleBuffer();
+            MutexLock lock(GetSampleBuffersMutex());
+            GetSampleBuffers().Push(buffer_);
+        }
+
+        return buffer_;
+    }
+
+    MetricsSampleBuffer* buffer_;
+};
+
+static thread_local ThreadSampleBufferOwner threadSampleBuffer;
 
 bool MetricsSnapshot::CompareInstanceMetrics(const MetricsSnapshot::InstanceMetric& lhs, const MetricsSnapshot::InstanceMetric& rhs)
 {
@@ -71,13 +138,13 @@ void MetricsSnapshot::RegisterInstance(const String& classname, InstantiationTyp
     switch (instantiationType)
     {
     case INSTANTIATION_NATIVE:
-        metric->nativeInstances++;
+        metric->nativeInstances += count;
         break;
     case INSTANTIATION_JAVASCRIPT:
-        metric->jsInstances++;
+        metric->jsInstances += count;
         break;
     case INSTANTIATION_NET:
-        metric->netInstances++;
+        metric->netInstances += count;
         break;
     }
 
@@ -156,139 +223,82 @@ Metrics::Metrics(Context* context) :
     Object(context),
     enabled_(false)
 {    
-    Metrics::metrics_ = this;
 }
 
 Metrics::~Metrics()
 {
     Disable();
-    Metrics::metrics_ = 0;
 }
 
-void Metrics::ProcessInstances()
-{
-    const static StringHash scriptComponentType("ScriptComponent");
-    const static StringHash jsComponentType("JSComponent");
-    const static StringHash csComponentType("CSComponent");
-
-    RefCountedInfo ninfo;
-    PODVector<RefCounted*>::ConstIterator itr = processInstances_.Begin();
-
-    while (itr != processInstances_.End())
+void Metrics::CaptureInstances(MetricsSnapshot* snapshot)
+{    
+    for (RefCountedTypeCounter* counter = RefCountedTypeCounter::GetFirst(); counter; counter = counter->GetNext())
     {
-        RefCounted* r = *itr;
-
-        Object* o = r->IsObject() ? (Object *)r : 0;
-
-        const String& typeName = r->GetTypeName();
-
-        ninfo.refCounted = r;
-        ninfo.instantiationType = r->GetInstantiationType();
-
-        ninfo.typeID = StringHash(typeName);
-
-        if (!names_.Contains(ninfo.typeID))
+        for (unsigned i = INSTANTIATION_NATIVE; i <= INSTANTIATION_NET; i++)
         {
-            names_[ninfo.typeID] = typeName;
-        }
-        
-        ninfo.typeNameOverride = StringHash::ZERO;
-       
-        // for script components, setup typeNameOverride
-        if (o && o->IsInstanceOf(scriptComponentType))
-        {
-            const String& classname = ((ScriptComponent*)o)->GetComponentClassName();
+            int count = counter->GetCount((InstantiationType) i);
 
-            if (classname.Length())
-            {
-                String name;
+            if (count > 0)
+                snapshot->RegisterInstance(counter->GetTypeName(), (InstantiationType) i, count);
+        }
+    }
+}
 
-                if (o->GetType() == jsComponentType)
-                {
-                    name = classname + " (JS)";
-                }                    
-                else
-                {
-                    name = classname + " (C#)";
-                }
+void Metrics::CaptureSamples(MetricsSnapshot* snapshot)
+{
+    const static StringHash jsComponentType("JSComponent");
 
-                ninfo.typeNameOverride = StringHash(name);
+    // each sample stands for sampleRate instances
+    int weight = (int) GetSampleRate();
 
-                if (!names_.Contains(ninfo.typeNameOverride))
-                {
-                    names_[ninfo.typeNameOverride] = name;
-                }
+    if (!weight)
+        return;
 
-            }
-        }
-        
-        PODVector<RefCountedInfo>& infos = instances_[ninfo.typeID];
+    MutexLock lock(GetSampleBuffersMutex());
 
-        RefCountedInfo* info = infos.Buffer();
-        int count = (int) infos.Size();
+    PODVector<MetricsSampleBuffer*>& buffers = GetSampleBuffers();
 
-        while (count > 0)
-        {
-            if (!info->refCounted)
-            {
-                *info = ninfo;
-                break;
-            }
+    for (unsigned i = 0; i < buffers.Size(); i++)
+    {
+        MetricsSampleBuffer* buffer = buffers[i];
+        MutexLock bufferLock(buffer->mutex_);
 
-            count--;
-            info++;
-        }
+        Vector<WeakPtr<RefCounted> >& samples = buffer->samples_;
 
-        if (!count)
+        for (unsigned j = 0; j < samples.Size();)
         {
-            if (infos.Capacity() <= (infos.Size() + 1))
+            Object* o = static_cast<Object*>(samples[j].Get());
+
+            if (!o)
             {
-                infos.Reserve(infos.Size() + 32768);
+                samples.EraseSwap(j);
+                continue;
             }
 
-            infos.Push(ninfo);
-        }
-
-        itr++;
-    }
-
-    processInstances_.Clear();
-}
-
-void Metrics::CaptureInstances(MetricsSnapshot* snapshot)
-{    
-    ProcessInstances();
+            j++;
 
-    HashMap<StringHash, PODVector<RefCountedInfo>>::ConstIterator itr = instances_.Begin();
+            if (o->IsInstanceOf<Node>())
+            {
+                const String& name = ((Node*)o)->GetName();
+                MetricsSnapshot::NodeMetric& metric = snapshot->nodeMetrics_[name];
 
-    while (itr != instances_.End())
-    {
-        StringHash typeID = itr->first_;
-        String* typeName = &names_[typeID];
+                if (!metric.name.Length())
+                    metric.name = name.Length() ? name : "Anonymous Node";
 
-        RefCountedInfo* info = itr->second_.Buffer();
-        int count = (int) itr->second_.Size();
+                metric.count += weight;
 
-        while (count > 0)
-        {
-            // free spot
-            if (!info->refCounted)
-            {
-                info++;
-                count--;
                 continue;
             }
 
-            if (info->typeNameOverride != StringHash::ZERO)
-                typeName = &names_[info->typeNameOverride];
+            // script components are broken down by script class, resolved now as the class is not yet known on registration
+            const String& classname = ((ScriptComponent*)o)->GetComponentClassName();
 
-            snapshot->RegisterInstance(*typeName, info->instantiationType);
+            if (!classname.Length())
+                continue;
 
-            info++;
-            count--;
+            String name = classname + (o->GetType() == jsComponentType ? " (JS)" : " (C#)");
+            snapshot->RegisterInstance(name, o->GetInstantiationType(), weight);
         }
-
-        itr++;
     }
 }
 
@@ -306,6 +316,7 @@ void Metrics::Capture(MetricsSnapshot* snapshot)
     snapshot->Clear();
 
     CaptureInstances(snapshot);
+    CaptureSamples(snapshot);
 
 }
 
@@ -322,11 +333,10 @@ bool Metrics::Enable()
 
     enabled_ = everEnabled_ = true;
 
-    ATOMIC_LOGINFO("Metrics subsystem enabled, performance will be degraded and there may be stutter while instrumenting");
-    ATOMIC_LOGINFO("IMPORTANT: Do not ship applications with performance metrics enabled");
+    ATOMIC_LOGINFO("Metrics subsystem enabled, live instances are counted per type from their next reference");
 
-    RefCounted::AddRefCountedCreatedFunction(Metrics::OnRefCountedCreated);
-    RefCounted::AddRefCountedDeletedFunction(Metrics::OnRefCountedDeleted);
+    RefCounted::SetRefCountedRegisteredFunction(Metrics::OnRefCountedRegistered);
+    RefCounted::SetInstanceCounting(true);
 
     return true;
 }
@@ -338,112 +348,86 @@ void Metrics::Disable()
 
     enabled_ = false;
 
-    instances_.Clear();
-
-    RefCounted::RemoveRefCountedCreatedFunction(Metrics::OnRefCountedCreated);
-    RefCounted::RemoveRefCountedDeletedFunction(Metrics::OnRefCountedDeleted);
+    // registered instances keep decrementing their type counters on destruction, so counts stay balanced
+    RefCounted::SetInstanceCounting(false);
+    RefCounted::SetRefCountedRegisteredFunction(0);
 }
 
+void Metrics::SetSampleRate(unsigned rate)
+{
+    sampleRate_.store(rate, std::memory_order_relaxed);
+
+    if (!rate)
+    {
+        MutexLock lock(GetSampleBuffersMutex());
+
+        PODVector<MetricsSampleBuffer*>& buffers = GetSampleBuffers();
+
+        for (unsigned i = 0; i < buffers.Size(); i++)
+        {
+            MutexLock bufferLock(buffers[i]->mutex_);
+            buffers[i]->samples_.Clear();
+        }
+    }
+}
 
 String Metrics::PrintNodeNames() const
 {
-    const static StringHash nodeType("Node");
-
     String output;
 
-    PODVector<RefCountedInfo>& infos = instances_[nodeType];
+    MutexLock lock(GetSampleBuffersMutex());
 
-    PODVector<RefCountedInfo>::Iterator itr = infos.Begin();
+    PODVector<MetricsSampleBuffer*>& buffers = GetSampleBuffers();
 
-    for (; itr != infos.End(); itr++)
+    for (unsigned i = 0; i < buffers.Size(); i++)
     {
-        RefCounted* r = itr->refCounted;
+        MutexLock bufferLock(buffers[i]->mutex_);
 
-        if (!r)
-            continue;
+        const Vector<WeakPtr<RefCounted> >& samples = buffers[i]->samples_;
 
-        Object* o = r->IsObject() ? (Object *)r : 0;
+        for (unsigned j = 0; j < samples.Size(); j++)
+        {
+            Object* o = static_cast<Object*>(samples[j].Get());
 
-        if (!o)
-            continue;
+            if (!o || !o->IsInstanceOf<Node>())
+                continue;
 
-        if (o->GetType() == nodeType)
-        {
             const String& name = ((Node*)o)->GetName();
             output.AppendWithFormat("Node: %s\n", name.Length() ? name.CString() : "Anonymous Node");
         }
-
     }
 
     return output;
 }
 
-void Metrics::AddRefCounted(RefCounted* refCounted)
+void Metrics::OnRefCountedRegistered(RefCounted* refCounted)
 {
-    // We're called from the RefCounted constructor, so we don't know whether we're an object, etc
-
-    if (processInstances_.Capacity() <= (processInstances_.Size() + 1))
-    {
-        processInstances_.Reserve(processInstances_.Size() + 32768);
-    }
+    // called on the registering thread, normally once the instance is fully constructed; an instance referenced inside its
+    // constructor is called for again when it moves to its most derived type, so it may be sampled twice
 
-    processInstances_.Push(refCounted);
-
-}
+    unsigned rate = sampleRate_.load(std::memory_order_relaxed);
 
-void Metrics::RemoveRefCounted(RefCounted* refCounted)
-{
-    processInstances_.Remove(refCounted);
-
-    // this is called from RefCounted destructor, so can't access refCounted though pointer address is still valid
-    // we also don't want to hash every RefCounted ptr due to possible collisions, so need to search:
+    if (!rate || !refCounted->IsObject())
+        return;
 
-    HashMap<StringHash, PODVector<RefCountedInfo>>::Iterator itr = instances_.Begin();
+    Object* o = (Object*)refCounted;
 
-    while (itr != instances_.End())
-    {
-        RefCountedInfo* info = itr->second_.Buffer();
-        int count = (int)itr->second_.Size();
+    bool node = o->IsInstanceOf<Node>();
 
-        while (count > 0)
-        {
-            if (info->refCounted == refCounted)
-            {
-                info->refCounted = 0;
-                break;
-            }
+    if (!node && !o->IsInstanceOf<ScriptComponent>())
+        return;
 
-            info++;
-            count--;
-        }
+    MetricsSampleBuffer* buffer = threadSampleBuffer.Get();
 
-        if (count)
-            break;
+    unsigned& counter = node ? buffer->nodeCounter_ : buffer->scriptCounter_;
 
-        itr++;
-    }
-}
-
-void Metrics::OnRefCountedCreated(RefCounted* refCounted)
-{
-    if (!metrics_)
-    {
-        ATOMIC_LOGERROR("Metrics::OnRefCountedCreated - null instance");
+    if (++counter < rate)
         return;
-    }
-
-    metrics_->AddRefCounted(refCounted);
-}
 
-void Metrics::OnRefCountedDeleted(RefCounted* refCounted)
-{
-    if (!metrics_)
-    {
-        ATOMIC_LOGERROR("Metrics::OnRefCountedDeleted - null instance");
-        return;
-    }
+    counter = 0;
 
-    metrics_->RemoveRefCounted(refCounted);    
+    MutexLock lock(buffer->mutex_);
+    buffer->samples_.Push(WeakPtr<RefCounted>(refCounted));
 }
 
 
@@ -112,60 +112,39 @@ public:
     /// Destruct.
     virtual ~Metrics();
 
-    /// Enable the Metrics subsystem and start capturing instance data, expensive on CPU and may cause stuttering while enabled
+    /// Enable the Metrics subsystem and start counting instances per type, cheap enough to leave enabled
     bool Enable();
 
     /// Get whether the Metrics subsystem is enabled or not
     bool GetEnabled() const { return enabled_; }    
 
-    // Captures a snapshot of metrics data
+    /// Set sampling of node and script component instances for name breakdowns, 1 samples every instance, N every Nth per thread, 0 disables
+    void SetSampleRate(unsigned rate);
+
+    /// Get node and script component sample rate
+    unsigned GetSampleRate() const { return sampleRate_.load(std::memory_order_relaxed); }
+
+    // Captures a snapshot of metrics data, cost is proportional to the number of types and sampled instances
     void Capture(MetricsSnapshot* snapshot);
 
-    /// Prints names of registered node instances output string
+    /// Prints names of sampled node instances output string
     String PrintNodeNames() const;
 
 private:
 
-    // A RefCountedInfo entry, necessary as we need to access instances in RefCounted constructor/destructor
-    // and info is not available (pure call access violations on abstract virtual functions)
-    struct RefCountedInfo
-    {
-        // pointer to corresponding RefCounted, null means a free entry
-        RefCounted *refCounted;
-        // the has of the typename
-        StringHash typeID;
-        // for some types, like ScriptComponent it is useful to override the name to the JSComponent/CSComponent
-        StringHash typeNameOverride;
-        // the instantiation type of the instance
-        InstantiationType instantiationType;
-    };
-
     void Disable();
 
     void CaptureInstances(MetricsSnapshot* snapshot);
-    void ProcessInstances();
-
-    static void OnRefCountedCreated(RefCounted* refCounted);
-    static void OnRefCountedDeleted(RefCounted* refCounted);
+    void CaptureSamples(MetricsSnapshot* snapshot);
 
-    void AddRefCounted(RefCounted* refCounted);
-    void RemoveRefCounted(RefCounted* refCounted);
-
-    // static instance
-    static Metrics* metrics_;
+    static void OnRefCountedRegistered(RefCounted* refCounted);
 
     static bool everEnabled_;
 
-    bool enabled_;
-
-    // typeid -> information for individual RefCounted
-    mutable HashMap<StringHash, PODVector<RefCountedInfo>> instances_;
+    // node and script component sample rate, read on the registering thread
+    static std::atomic<unsigned> sampleRate_;
 
-    // instances added since last capture, see note on RefCountedInfo as to why necessary
-    PODVector<RefCounted*> processInstances_;
-
-    // Lookup from string hashes to avoid String thrashing in the metrics subsystem with large numbers of instances
-    HashMap<StringHash, String> names_;
+    bool enabled_;
 
 };
 
@@ -625,6 +625,16 @@ void CrowdAgent::OnMarkedDirty(Node* node)
 {
     if (!ignoreTransformChanges_ && IsEnabledEffective())
     {
+        // ATOMIC BEGIN
+        // The crowd manager's agent data is not safe to modify from worker threads
+        Scene* scene = GetScene();
+        if (scene && scene->IsThreadedUpdate())
+        {
+            scene->DelayedMarkedDirty(this);
+            return;
+        }
+        // ATOMIC END
+
         dtCrowdAgent* agent = const_cast<dtCrowdAgent*>(GetDetourCrowdAgent());
         if (agent)
         {
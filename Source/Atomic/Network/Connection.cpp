@@ -22,6 +22,9 @@
 
 #include "../Precompiled.h"
 
+// ATOMIC BEGIN
+#include "../Core/Mutex.h"
+// ATOMIC END
 #include "../Core/Profiler.h"
 #include "../IO/File.h"
 #include "../IO/FileSystem.h"
@@ -34,6 +37,9 @@
 #include "../Network/NetworkPriority.h"
 #include "../Network/Protocol.h"
 #include "../Resource/ResourceCache.h"
+// ATOMIC BEGIN
+#include "../Scene/ReplicationFanout.h"
+// ATOMIC END
 #include "../Scene/Scene.h"
 #include "../Scene/SceneEvents.h"
 #include "../Scene/SmoothedTransform.h"
@@ -48,6 +54,22 @@ namespace Atomic
 {
 
 static const int STATS_INTERVAL_MSEC = 2000;
+// ATOMIC BEGIN
+/// Distance factor of the interest radius after which a relevant node leaves, so that nodes on the border do not flicker.
+static const float INTEREST_LEAVE_FACTOR = 1.1f;
+/// Number of earlier snapshot messages acknowledged along the newest one.
+static const unsigned SNAPSHOT_ACK_BITS = 32;
+/// Number of sent snapshot messages remembered for acknowledgement.
+static const unsigned SNAPSHOT_HISTORY_SIZE = 256;
+/// Number of queued outbound messages after which overdue snapshot data is not sent again, as it is more likely queued than lost.
+static const unsigned SNAPSHOT_MAX_QUEUED_MESSAGES = 4;
+/// Acknowledgement time factor after which unacknowledged snapshot data is sent again.
+static const float SNAPSHOT_RESEND_FACTOR = 1.5f;
+/// Minimum time in milliseconds after which unacknowledged snapshot data is sent again.
+static const unsigned SNAPSHOT_RESEND_MIN_MSEC = 20;
+/// Smoothing factor of the snapshot acknowledgement time.
+static const float SNAPSHOT_ACK_TIME_SMOOTHING = 0.125f;
+// ATOMIC END
 
 PackageDownload::PackageDownload() :
     totalFragments_(0),
@@ -62,13 +84,96 @@ PackageUpload::PackageUpload() :
 {
 }
 
+// ATOMIC BEGIN
+SnapshotState::SnapshotState() :
+    update_(0),
+    sendTime_(0),
+    sent_(false)
+{
+}
+
+SnapshotState::SnapshotState(unsigned update) :
+    update_(update),
+    sendTime_(0),
+    sent_(false)
+{
+}
+
+SnapshotMessage::SnapshotMessage() :
+    sequence_(0),
+    sendTime_(0)
+{
+}
+// ATOMIC END
+
+// ATOMIC BEGIN
+/// Mutex for adding and removing replication states, which also touches the nodes and components shared between connections.
+static Mutex& GetReplicationStateMutex()
+{
+    static Mutex mutex;
+    return mutex;
+}
+
+/// Return world position of a node without updating its cached world transform, as the scene must stay read-only while connections are updated in parallel.
+static Vector3 GetWorldPositionReadOnly(Node* node)
+{
+    if (!node->IsDirty())
+        return node->GetWorldPosition();
+
+    Matrix3x4 transform = node->GetTransform();
+    Scene* scene = node->GetScene();
+    for (Node* parent = node->GetParent(); parent && parent != scene; parent = parent->GetParent())
+    {
+        if (!parent->IsDirty())
+            return (parent->GetWorldTransform() * transform).Translation();
+        transform = parent->GetTransform() * transform;
+    }
+
+    return transform.Translation();
+}
+
+/// Mark the latest data attributes of a node or component dirty.
+static void SetLatestDataBits(Serializable* object, DirtyBits& bits)
+{
+    const Vector<AttributeInfo>* attributes = object->GetNetworkAttributes();
+    if (!attributes)
+        return;
+
+    for (unsigned i = 0; i < attributes->Size(); ++i)
+    {
+        if (attributes->At(i).mode_ & AM_LATESTDATA)
+            bits.Set(i);
+    }
+}
+
+/// Store latest data of a not yet received node or component in the same format as a latest data message.
+static void StorePendingLatestData(PODVector<unsigned char>& dest, unsigned id, const unsigned char* data, unsigned size)
+{
+    VectorBuffer buffer;
+    buffer.WriteNetID(id);
+    buffer.Write(data, size);
+    dest.Resize(buffer.GetSize());
+    memcpy(&dest[0], buffer.GetData(), buffer.GetSize());
+}
+// ATOMIC END
+
 // ATOMIC BEGIN
 Connection::Connection(Context* context) : Object(context),
     timeStamp_(0),
     sendMode_(OPSM_NONE),
     connectPending_(false),
     sceneLoaded_(false),
-    logStatistics_(false)
+    logStatistics_(false),
+    fanout_(0),
+    interest_(0),
+    interestUpdate_(0),
+    interestManaged_(false),
+    snapshotUpdate_(0),
+    snapshotSequence_(0),
+    snapshotAckBits_(0),
+    snapshotAckTime_(0.0f),
+    snapshotReplication_(false),
+    snapshotAckPending_(false)
 {
 
 }
@@ -82,7 +187,19 @@ Connection::Connection(Context* context, bool isClient, kNet::SharedPtr<kNet::Me
     isClient_(isClient),
     connectPending_(false),
     sceneLoaded_(false),
-    logStatistics_(false)
+    logStatistics_(false),
+// ATOMIC BEGIN
+    fanout_(0),
+    interest_(0),
+    interestUpdate_(0),
+    interestManaged_(false),
+    snapshotUpdate_(0),
+    snapshotSequence_(0),
+    snapshotAckBits_(0),
+    snapshotAckTime_(0.0f),
+    snapshotReplication_(false),
+    snapshotAckPending_(false)
+// ATOMIC END
 {
     sceneState_.connection_ = this;
 
@@ -185,6 +302,11 @@ void Connection::SetScene(Scene* newScene)
     scene_ = newScene;
     sceneLoaded_ = false;
     UnsubscribeFromEvent(E_ASYNCLOADFINISHED);
+    // ATOMIC BEGIN
+    relevantNodes_.Clear();
+    snapshotNodes_.Clear();
+    snapshotComponents_.Clear();
+    // ATOMIC END
 
     if (!scene_)
         return;
@@ -259,11 +381,27 @@ void Connection::Disconnect(int waitMSec)
     connection_->Disconnect(waitMSec);
 }
 
-void Connection::SendServerUpdate()
+// ATOMIC BEGIN
+void Connection::SendServerUpdate(ReplicationFanout* fanout, InterestGrid* interest)
+// ATOMIC END
 {
     if (!scene_ || !sceneLoaded_)
         return;
 
+    // ATOMIC BEGIN
+    fanout_ = fanout;
+    interest_ = interest;
+    if (interest_)
+        UpdateInterest();
+    else if (interestManaged_)
+        MarkAllNodesDirty();
+    interestManaged_ = interest_ != 0;
+    if (snapshotReplication_)
+        ++snapshotUpdate_;
+    else if (!snapshotNodes_.Empty() || !snapshotComponents_.Empty())
+        MarkSnapshotDataDirty();
+    // ATOMIC END
+
     // Always check the root node (scene) first so that the scene-wide components get sent first,
     // and all other replicated nodes get added to the dirty set for sending the initial state
     unsigned sceneID = scene_->GetID();
@@ -279,6 +417,14 @@ void Connection::SendServerUpdate()
         unsigned nodeID = nodesToProcess_.Front();
         ProcessNode(nodeID);
     }
+
+    // ATOMIC BEGIN
+    if (snapshotReplication_)
+        SendSnapshots();
+
+    fanout_ = 0;
+    interest_ = 0;
+    // ATOMIC END
 }
 
 void Connection::SendClientUpdate()
@@ -298,6 +444,17 @@ void Connection::SendClientUpdate()
         msg_.WritePackedQuaternion(rotation_);
     SendMessage(MSG_CONTROLS, false, false, msg_, CONTROLS_CONTENT_ID);
 
+    // ATOMIC BEGIN
+    if (snapshotAckPending_)
+    {
+        msg_.Clear();
+        msg_.WriteUInt(snapshotSequence_);
+        msg_.WriteUInt(snapshotAckBits_);
+        SendMessage(MSG_SNAPSHOTACK, false, false, msg_, SNAPSHOTACK_CONTENT_ID);
+        snapshotAckPending_ = false;
+    }
+    // ATOMIC END
+
     ++timeStamp_;
 }
 
@@ -460,6 +617,14 @@ bool Connection::ProcessMessage(int msgID, MemoryBuffer& msg)
     case MSG_STRING:
         ProcessStringMessage(msgID, msg);
         break;
+
+    case MSG_SNAPSHOT:
+        ProcessSnapshot(msgID, msg);
+        break;
+
+    case MSG_SNAPSHOTACK:
+        ProcessSnapshotAck(msgID, msg);
+        break;
     // ATOMIC END
 
     default:
@@ -491,6 +656,10 @@ void Connection::ProcessLoadScene(int msgID, MemoryBuffer& msg)
     nodeLatestData_.Clear();
     componentLatestData_.Clear();
     downloads_.Clear();
+    // ATOMIC BEGIN
+    snapshotNodeUpdates_.Clear();
+    snapshotComponentUpdates_.Clear();
+    // ATOMIC END
 
     // In case we have joined other scenes in this session, remove first all downloaded package files from the resource system
     // to prevent resource conflicts
@@ -654,6 +823,9 @@ void Connection::ProcessSceneUpdate(int msgID, MemoryBuffer& msg)
             if (node)
                 node->Remove();
             nodeLatestData_.Erase(nodeID);
+            // ATOMIC BEGIN
+            snapshotNodeUpdates_.Erase(nodeID);
+            // ATOMIC END
         }
         break;
 
@@ -731,6 +903,9 @@ void Connection::ProcessSceneUpdate(int msgID, MemoryBuffer& msg)
             if (component)
                 component->Remove();
             componentLatestData_.Erase(componentID);
+            // ATOMIC BEGIN
+            snapshotComponentUpdates_.Erase(componentID);
+            // ATOMIC END
         }
         break;
 
@@ -1169,8 +1344,16 @@ void Connection::ProcessNode(unsigned nodeID)
             // would be enough. However, this may be better due to the client not possibly having updated parenting
             // information at the time of receiving this message
             SendMessage(MSG_REMOVENODE, true, true, msg_);
+            // ATOMIC BEGIN
+            snapshotNodes_.Erase(nodeID);
+            MutexLock lock(GetReplicationStateMutex());
+            // ATOMIC END
             sceneState_.nodeStates_.Erase(nodeID);
         }
+        // ATOMIC BEGIN
+        else if (interest_ && !IsRelevant(node))
+            LeaveNode(node);
+        // ATOMIC END
         else
             ProcessExistingNode(node, i->second_);
     }
@@ -1178,7 +1361,14 @@ void Connection::ProcessNode(unsigned nodeID)
     {
         // Replication state not found: this is a new node
         Node* node = scene_->GetNode(nodeID);
-        if (node)
+        // ATOMIC BEGIN
+        if (node && interest_ && !IsRelevant(node))
+        {
+            // Not of interest to the client yet: sent when its top-level node enters the interest radius
+            sceneState_.dirtyNodes_.Erase(nodeID);
+        }
+        else if (node)
+        // ATOMIC END
             ProcessNewNode(node);
         else
         {
@@ -1205,8 +1395,13 @@ void Connection::ProcessNewNode(Node* node)
     NodeReplicationState& nodeState = sceneState_.nodeStates_[node->GetID()];
     nodeState.connection_ = this;
     nodeState.sceneState_ = &sceneState_;
-    nodeState.node_ = node;
-    node->AddReplicationState(&nodeState);
+    // ATOMIC BEGIN
+    {
+        MutexLock lock(GetReplicationStateMutex());
+        nodeState.node_ = node;
+        node->AddReplicationState(&nodeState);
+    }
+    // ATOMIC END
 
     // Write node's attributes
     node->WriteInitialDeltaUpdate(msg_, timeStamp_);
@@ -1233,8 +1428,13 @@ void Connection::ProcessNewNode(Node* node)
         ComponentReplicationState& componentState = nodeState.componentStates_[component->GetID()];
         componentState.connection_ = this;
         componentState.nodeState_ = &nodeState;
-        componentState.component_ = component;
-        component->AddReplicationState(&componentState);
+        // ATOMIC BEGIN
+        {
+            MutexLock lock(GetReplicationStateMutex());
+            componentState.component_ = component;
+            component->AddReplicationState(&componentState);
+        }
+        // ATOMIC END
 
         msg_.WriteStringHash(component->GetType());
         msg_.WriteNetID(component->GetID());
@@ -1263,7 +1463,9 @@ void Connection::ProcessExistingNode(Node* node, NodeReplicationState& nodeState
     NetworkPriority* priority = node->GetComponent<NetworkPriority>();
     if (priority && (!priority->GetAlwaysUpdateOwner() || node->GetOwner() != this))
     {
-        float distance = (node->GetWorldPosition() - position_).Length();
+        // ATOMIC BEGIN
+        float distance = (GetWorldPositionReadOnly(node) - position_).Length();
+        // ATOMIC END
         if (!priority->CheckUpdate(distance, nodeState.priorityAcc_))
             return;
     }
@@ -1285,11 +1487,20 @@ void Connection::ProcessExistingNode(Node* node, NodeReplicationState& nodeState
         }
 
         // Send latestdata message if necessary
-        if (hasLatestData)
+        // ATOMIC BEGIN
+        if (hasLatestData && snapshotReplication_)
+            snapshotNodes_[node->GetID()] = SnapshotState(snapshotUpdate_);
+        else if (hasLatestData)
+        // ATOMIC END
         {
             msg_.Clear();
             msg_.WriteNetID(node->GetID());
-            node->WriteLatestDataUpdate(msg_, timeStamp_);
+            // ATOMIC BEGIN
+            if (fanout_)
+                fanout_->WriteLatestDataUpdate(node, msg_, timeStamp_);
+            else
+                node->WriteLatestDataUpdate(msg_, timeStamp_);
+            // ATOMIC END
 
             SendMessage(MSG_NODELATESTDATA, true, false, msg_, node->GetID());
         }
@@ -1299,7 +1510,12 @@ void Connection::ProcessExistingNode(Node* node, NodeReplicationState& nodeState
         {
             msg_.Clear();
             msg_.WriteNetID(node->GetID());
-            node->WriteDeltaUpdate(msg_, nodeState.dirtyAttributes_, timeStamp_);
+            // ATOMIC BEGIN
+            if (fanout_)
+                fanout_->WriteDeltaUpdate(node, msg_, nodeState.dirtyAttributes_, timeStamp_);
+            else
+                node->WriteDeltaUpdate(msg_, nodeState.dirtyAttributes_, timeStamp_);
+            // ATOMIC END
 
             // Write changed variables
             msg_.WriteVLE(nodeState.dirtyVars_.Size());
@@ -1342,6 +1558,10 @@ void Connection::ProcessExistingNode(Node* node, NodeReplicationState& nodeState
             msg_.WriteNetID(current->first_);
 
             SendMessage(MSG_REMOVECOMPONENT, true, true, msg_);
+            // ATOMIC BEGIN
+            snapshotComponents_.Erase(current->first_);
+            MutexLock lock(GetReplicationStateMutex());
+            // ATOMIC END
             nodeState.componentStates_.Erase(current);
         }
         else
@@ -1363,11 +1583,20 @@ void Connection::ProcessExistingNode(Node* node, NodeReplicationState& nodeState
                 }
 
                 // Send latestdata message if necessary
-                if (hasLatestData)
+                // ATOMIC BEGIN
+                if (hasLatestData && snapshotReplication_)
+                    snapshotComponents_[component->GetID()] = SnapshotState(snapshotUpdate_);
+                else if (hasLatestData)
+                // ATOMIC END
                 {
                     msg_.Clear();
                     msg_.WriteNetID(component->GetID());
-                    component->WriteLatestDataUpdate(msg_, timeStamp_);
+                    // ATOMIC BEGIN
+                    if (fanout_)
+                        fanout_->WriteLatestDataUpdate(component, msg_, timeStamp_);
+                    else
+                        component->WriteLatestDataUpdate(msg_, timeStamp_);
+                    // ATOMIC END
 
                     SendMessage(MSG_COMPONENTLATESTDATA, true, false, msg_, component->GetID());
                 }
@@ -1377,7 +1606,12 @@ void Connection::ProcessExistingNode(Node* node, NodeReplicationState& nodeState
                 {
                     msg_.Clear();
                     msg_.WriteNetID(component->GetID());
-                    component->WriteDeltaUpdate(msg_, componentState.dirtyAttributes_, timeStamp_);
+                    // ATOMIC BEGIN
+                    if (fanout_)
+                        fanout_->WriteDeltaUpdate(component, msg_, componentState.dirtyAttributes_, timeStamp_);
+                    else
+                        component->WriteDeltaUpdate(msg_, componentState.dirtyAttributes_, timeStamp_);
+                    // ATOMIC END
 
                     SendMessage(MSG_COMPONENTDELTAUPDATE, true, true, msg_);
 
@@ -1405,8 +1639,13 @@ void Connection::ProcessExistingNode(Node* node, NodeReplicationState& nodeState
                 ComponentReplicationState& componentState = nodeState.componentStates_[component->GetID()];
                 componentState.connection_ = this;
                 componentState.nodeState_ = &nodeState;
-                componentState.component_ = component;
-                component->AddReplicationState(&componentState);
+                // ATOMIC BEGIN
+                {
+                    MutexLock lock(GetReplicationStateMutex());
+                    componentState.component_ = component;
+                    component->AddReplicationState(&componentState);
+                }
+                // ATOMIC END
 
                 msg_.Clear();
                 msg_.WriteNetID(node->GetID());
@@ -1423,6 +1662,420 @@ void Connection::ProcessExistingNode(Node* node, NodeReplicationState& nodeState
     sceneState_.dirtyNodes_.Erase(node->GetID());
 }
 
+// ATOMIC BEGIN
+void Connection::UpdateInterest()
+{
+    ++interestUpdate_;
+
+    // Nodes enter within the interest radius and stay until a little further away
+    float radius = interest_->GetCellSize();
+    interest_->GetNodes(interestNodes_, position_, radius * INTEREST_LEAVE_FACTOR);
+    for (PODVector<InterestGridNode>::ConstIterator i = interestNodes_.Begin(); i != interestNodes_.End(); ++i)
+    {
+        FlatHashMap<unsigned, unsigned>::Iterator j = relevantNodes_.Find(i->id_);
+        if (j != relevantNodes_.End())
+        {
+            j->second_ = interestUpdate_;
+            continue;
+        }
+
+        if ((i->position_ - position_).LengthSquared() > radius * radius)
+            continue;
+
+        relevantNodes_.Insert(MakePair(i->id_, interestUpdate_));
+        Node* node = scene_->GetNode(i->id_);
+        if (node)
+        {
+            // Entering node: its hierarchy is sent on this update
+            sceneState_.dirtyNodes_.Insert(i->id_);
+            node->GetChildren(interestChildren_, true);
+            for (PODVector<Node*>::ConstIterator k = interestChildren_.Begin(); k != interestChildren_.End(); ++k)
+            {
+                if ((*k)->GetID() < FIRST_LOCAL_ID)
+                    sceneState_.dirtyNodes_.Insert((*k)->GetID());
+            }
+        }
+    }
+
+    // Nodes moved under a relevant node are not dirty for this connection yet, as they had no replication state
+    const PODVector<unsigned>& reparentedNodes = interest_->GetReparentedNodes();
+    for (PODVector<unsigned>::ConstIterator i = reparentedNodes.Begin(); i != reparentedNodes.End(); ++i)
+    {
+        Node* node = scene_->GetNode(*i);
+        if (!node || sceneState_.nodeStates_.Contains(*i) || !IsRelevant(node))
+            continue;
+
+        sceneState_.dirtyNodes_.Insert(*i);
+        node->GetChildren(interestChildren_, true);
+        for (PODVector<Node*>::ConstIterator k = interestChildren_.Begin(); k != interestChildren_.End(); ++k)
+        {
+            if ((*k)->GetID() < FIRST_LOCAL_ID)
+                sceneState_.dirtyNodes_.Insert((*k)->GetID());
+        }
+    }
+
+    // Nodes not found by the query have left, unless owned by this connection
+    for (FlatHashMap<unsigned, unsigned>::Iterator i = relevantNodes_.Begin(); i != relevantNodes_.End();)
+    {
+        if (i->second_ == interestUpdate_)
+        {
+            ++i;
+            continue;
+        }
+
+        Node* node = scene_->GetNode(i->first_);
+        if (node && node->GetOwner() == this)
+        {
+            ++i;
+            continue;
+        }
+
+        i = relevantNodes_.Erase(i);
+        // Removed nodes are removed from the client by the regular update, and reparented nodes follow their new parent
+        if (node && node->GetParent() == scene_)
+            LeaveNode(node);
+    }
+}
+
+bool Connection::IsRelevant(Node* node) const
+{
+    // Child nodes share the relevance of their top-level node
+    Node* root = node;
+    while (root->GetParent() && root->GetParent() != scene_)
+        root = root->GetParent();
+
+    if (root == scene_ || !root->GetParent() || root->GetID() >= FIRST_LOCAL_ID || root->GetOwner() == this)
+        return true;
+
+    return relevantNodes_.Contains(root->GetID());
+}
+
+void Connection::LeaveNode(Node* node)
+{
+    // Removing the node on the client also removes its children
+    if (sceneState_.nodeStates_.Contains(node->GetID()))
+    {
+        msg_.Clear();
+        msg_.WriteNetID(node->GetID());
+        SendMessage(MSG_REMOVENODE, true, true, msg_);
+    }
+
+    node->GetChildren(interestChildren_, true);
+    interestChildren_.Push(node);
+
+    MutexLock lock(GetReplicationStateMutex());
+    for (PODVector<Node*>::ConstIterator i = interestChildren_.Begin(); i != interestChildren_.End(); ++i)
+    {
+        Node* leavingNode = *i;
+        unsigned nodeID = leavingNode->GetID();
+        sceneState_.dirtyNodes_.Erase(nodeID);
+        nodesToProcess_.Erase(nodeID);
+        snapshotNodes_.Erase(nodeID);
+
+        HashMap<unsigned, NodeReplicationState>::Iterator j = sceneState_.nodeStates_.Find(nodeID);
+        if (j == sceneState_.nodeStates_.End())
+            continue;
+
+        NodeReplicationState& nodeState = j->second_;
+        for (HashMap<unsigned, ComponentReplicationState>::Iterator k = nodeState.componentStates_.Begin();
+             k != nodeState.componentStates_.End(); ++k)
+        {
+            Component* component = k->second_.component_;
+            if (component)
+                component->RemoveReplicationState(&k->second_);
+            snapshotComponents_.Erase(k->first_);
+        }
+        leavingNode->RemoveReplicationState(&nodeState);
+        sceneState_.nodeStates_.Erase(j);
+    }
+}
+
+void Connection::MarkAllNodesDirty()
+{
+    relevantNodes_.Clear();
+
+    scene_->GetChildren(interestChildren_, true);
+    for (PODVector<Node*>::ConstIterator i = interestChildren_.Begin(); i != interestChildren_.End(); ++i)
+    {
+        if ((*i)->GetID() < FIRST_LOCAL_ID)
+            sceneState_.dirtyNodes_.Insert((*i)->GetID());
+    }
+}
+
+void Connection::SendSnapshots()
+{
+    if (snapshotNodes_.Empty() && snapshotComponents_.Empty())
+        return;
+
+    if (snapshotHistory_.Empty())
+        snapshotHistory_.Resize(SNAPSHOT_HISTORY_SIZE);
+
+    // Changes are sent right away. Unacknowledged data is sent again once its acknowledgement is overdue, with the current
+    // values, so a lost message never holds back newer data like a reliable resend would. The acknowledgement time includes
+    // the client's update interval, so fall back to the round trip time only until it has been measured
+    unsigned now = snapshotTimer_.GetMSec(false);
+    float ackTime = snapshotAckTime_ > 0.0f ? snapshotAckTime_ : GetRoundTripTime();
+    unsigned resendMSec = Max((unsigned)(ackTime * SNAPSHOT_RESEND_FACTOR), SNAPSHOT_RESEND_MIN_MSEC);
+    bool resend = connection_->NumOutboundMessagesPending() <= SNAPSHOT_MAX_QUEUED_MESSAGES;
+    msg_.Clear();
+
+    for (FlatHashMap<unsigned, SnapshotState>::Iterator i = snapshotNodes_.Begin(); i != snapshotNodes_.End();)
+    {
+        SnapshotState& state = i->second_;
+        if (state.sent_ && (!resend || now - state.sendTime_ < resendMSec))
+        {
+            ++i;
+            continue;
+        }
+
+        Node* node = scene_->GetNode(i->first_);
+        if (!node || !sceneState_.nodeStates_.Contains(i->first_))
+        {
+            i = snapshotNodes_.Erase(i);
+            continue;
+        }
+
+        snapshotData_.Clear();
+        if (fanout_)
+            fanout_->WriteLatestDataUpdate(node, snapshotData_, timeStamp_);
+        else
+            node->WriteLatestDataUpdate(snapshotData_, timeStamp_);
+        WriteSnapshotEntry(i->first_, state.update_, false);
+        state.sendTime_ = now;
+        state.sent_ = true;
+        ++i;
+    }
+
+    for (FlatHashMap<unsigned, SnapshotState>::Iterator i = snapshotComponents_.Begin(); i != snapshotComponents_.End();)
+    {
+        SnapshotState& state = i->second_;
+        if (state.sent_ && (!resend || now - state.sendTime_ < resendMSec))
+        {
+            ++i;
+            continue;
+        }
+
+        Component* component = scene_->GetComponent(i->first_);
+        Node* node = component ? component->GetNode() : 0;
+        HashMap<unsigned, NodeReplicationState>::ConstIterator j = node ? sceneState_.nodeStates_.Find(node->GetID()) :
+            sceneState_.nodeStates_.End();
+        if (j == sceneState_.nodeStates_.End() || !j->second_.componentStates_.Contains(i->first_))
+        {
+            i = snapshotComponents_.Erase(i);
+            continue;
+        }
+
+        snapshotData_.Clear();
+        if (fanout_)
+            fanout_->WriteLatestDataUpdate(component, snapshotData_, timeStamp_);
+        else
+            component->WriteLatestDataUpdate(snapshotData_, timeStamp_);
+        WriteSnapshotEntry(i->first_, state.update_, true);
+        state.sendTime_ = now;
+        state.sent_ = true;
+        ++i;
+    }
+
+    if (msg_.GetSize())
+        SendMessage(MSG_SNAPSHOT, false, false, msg_);
+}
+
+void Connection::BeginSnapshotMessage()
+{
+    // Sequence number zero marks a free history slot
+    if (!++snapshotSequence_)
+        ++snapshotSequence_;
+
+    SnapshotMessage& message = snapshotHistory_[snapshotSequence_ % SNAPSHOT_HISTORY_SIZE];
+    message.sequence_ = snapshotSequence_;
+    message.sendTime_ = snapshotTimer_.GetMSec(false);
+    message.entries_.Clear();
+
+    msg_.Clear();
+    msg_.WriteUInt(snapshotSequence_);
+    msg_.WriteUInt(snapshotUpdate_);
+}
+
+void Connection::WriteSnapshotEntry(unsigned id, unsigned update, bool component)
+{
+    // Reserve room for the ID and size in front of the data
+    if (!msg_.GetSize())
+        BeginSnapshotMessage();
+    else if (msg_.GetSize() + snapshotData_.GetSize() + 8 > SNAPSHOT_MESSAGE_SIZE)
+    {
+        SendMessage(MSG_SNAPSHOT, false, false, msg_);
+        BeginSnapshotMessage();
+    }
+
+    // The lowest bit of the size tells components from nodes, as their IDs overlap
+    msg_.WriteNetID(id);
+    msg_.WriteVLE(snapshotData_.GetSize() << 1 | (component ? 1 : 0));
+    msg_.Write(snapshotData_.GetData(), snapshotData_.GetSize());
+
+    SnapshotEntry entry;
+    entry.id_ = id;
+    entry.update_ = update;
+    entry.component_ = component;
+    snapshotHistory_[snapshotSequence_ % SNAPSHOT_HISTORY_SIZE].entries_.Push(entry);
+}
+
+void Connection::MarkSnapshotDataDirty()
+{
+    for (FlatHashMap<unsigned, SnapshotState>::ConstIterator i = snapshotNodes_.Begin(); i != snapshotNodes_.End(); ++i)
+    {
+        HashMap<unsigned, NodeReplicationState>::Iterator j = sceneState_.nodeStates_.Find(i->first_);
+        if (j == sceneState_.nodeStates_.End() || !j->second_.node_)
+            continue;
+
+        SetLatestDataBits(j->second_.node_, j->second_.dirtyAttributes_);
+        sceneState_.dirtyNodes_.Insert(i->first_);
+    }
+
+    for (FlatHashMap<unsigned, SnapshotState>::ConstIterator i = snapshotComponents_.Begin(); i != snapshotComponents_.End(); ++i)
+    {
+        Component* component = scene_->GetComponent(i->first_);
+        Node* node = component ? component->GetNode() : 0;
+        if (!node)
+            continue;
+
+        HashMap<unsigned, NodeReplicationState>::Iterator j = sceneState_.nodeStates_.Find(node->GetID());
+        if (j == sceneState_.nodeStates_.End())
+            continue;
+
+        HashMap<unsigned, ComponentReplicationState>::Iterator k = j->second_.componentStates_.Find(i->first_);
+        if (k == j->second_.componentStates_.End())
+            continue;
+
+        SetLatestDataBits(component, k->second_.dirtyAttributes_);
+        sceneState_.dirtyNodes_.Insert(node->GetID());
+    }
+
+    snapshotNodes_.Clear();
+    snapshotComponents_.Clear();
+}
+
+void Connection::ProcessSnapshot(int msgID, MemoryBuffer& msg)
+{
+    if (IsClient())
+    {
+        ATOMIC_LOGWARNING("Received unexpected Snapshot message from client " + ToString());
+        return;
+    }
+
+    if (!scene_)
+        return;
+
+    unsigned sequence = msg.ReadUInt();
+    unsigned update = msg.ReadUInt();
+
+    // Remember the newest sequence number and which of the earlier ones were received, to acknowledge on the next client update
+    if (sequence > snapshotSequence_)
+    {
+        unsigned shift = sequence - snapshotSequence_;
+        if (shift < SNAPSHOT_ACK_BITS)
+            snapshotAckBits_ = snapshotAckBits_ << shift | 1u << (shift - 1);
+        else
+            snapshotAckBits_ = shift == SNAPSHOT_ACK_BITS ? 1u << (SNAPSHOT_ACK_BITS - 1) : 0;
+        snapshotSequence_ = sequence;
+    }
+    else if (sequence < snapshotSequence_ && snapshotSequence_ - sequence <= SNAPSHOT_ACK_BITS)
+        snapshotAckBits_ |= 1u << (snapshotSequence_ - sequence - 1);
+    snapshotAckPending_ = true;
+
+    while (!msg.IsEof())
+    {
+        unsigned id = msg.ReadNetID();
+        unsigned sizeAndType = msg.ReadVLE();
+        unsigned size = sizeAndType >> 1;
+        bool component = (sizeAndType & 1) != 0;
+        unsigned position = msg.GetPosition();
+        if (position + size > msg.GetSize())
+        {
+            ATOMIC_LOGERROR("Snapshot message parsing aborted due to truncated data");
+            return;
+        }
+
+        const unsigned char* data = msg.GetData() + position;
+        msg.Seek(position + size);
+
+        // Messages may arrive out of order: skip data older than already applied
+        FlatHashMap<unsigned, unsigned>& updates = component ? snapshotComponentUpdates_ : snapshotNodeUpdates_;
+        FlatHashMap<unsigned, unsigned>::Iterator i = updates.Find(id);
+        if (i == updates.End())
+            updates.Insert(MakePair(id, update));
+        else if (i->second_ < update)
+            i->second_ = update;
+        else
+            continue;
+
+        MemoryBuffer entry(data, size);
+        if (!component)
+        {
+            Node* node = scene_->GetNode(id);
+            if (node)
+                node->ReadLatestDataUpdate(entry);
+            else
+                StorePendingLatestData(nodeLatestData_[id], id, data, size);
+        }
+        else
+        {
+            Component* comp = scene_->GetComponent(id);
+            if (comp)
+            {
+                if (comp->ReadLatestDataUpdate(entry))
+                    comp->ApplyAttributes();
+            }
+            else
+                StorePendingLatestData(componentLatestData_[id], id, data, size);
+        }
+    }
+}
+
+void Connection::ProcessSnapshotAck(int msgID, MemoryBuffer& msg)
+{
+    if (!IsClient())
+    {
+        ATOMIC_LOGWARNING("Received unexpected SnapshotAck message from server");
+        return;
+    }
+
+    unsigned sequence = msg.ReadUInt();
+    unsigned ackBits = msg.ReadUInt();
+
+    AckSnapshotMessage(sequence);
+    for (unsigned i = 0; i < SNAPSHOT_ACK_BITS; ++i)
+    {
+        if (ackBits & (1u << i))
+            AckSnapshotMessage(sequence - i - 1);
+    }
+}
+
+void Connection::AckSnapshotMessage(unsigned sequence)
+{
+    if (!sequence || snapshotHistory_.Empty())
+        return;
+
+    SnapshotMessage& message = snapshotHistory_[sequence % SNAPSHOT_HISTORY_SIZE];
+    if (message.sequence_ != sequence)
+        return;
+
+    float ackTime = (float)(snapshotTimer_.GetMSec(false) - message.sendTime_);
+    snapshotAckTime_ = snapshotAckTime_ > 0.0f ? Lerp(snapshotAckTime_, ackTime, SNAPSHOT_ACK_TIME_SMOOTHING) : ackTime;
+
+    // The client is up to date on everything in the message that has not changed since
+    for (PODVector<SnapshotEntry>::ConstIterator i = message.entries_.Begin(); i != message.entries_.End(); ++i)
+    {
+        FlatHashMap<unsigned, SnapshotState>& states = i->component_ ? snapshotComponents_ : snapshotNodes_;
+        FlatHashMap<unsigned, SnapshotState>::Iterator j = states.Find(i->id_);
+        if (j != states.End() && j->second_.update_ == i->update_)
+            states.Erase(j);
+    }
+
+    message.sequence_ = 0;
+    message.entries_.Clear();
+}
+// ATOMIC END
+
 bool Connection::RequestNeededPackages(unsigned numPackages, MemoryBuffer& msg)
 {
     ResourceCache* cache = GetSubsystem<ResourceCache>();
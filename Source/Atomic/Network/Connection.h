@@ -27,6 +27,9 @@
 #include "../Core/Timer.h"
 #include "../Input/Controls.h"
 #include "../IO/VectorBuffer.h"
+// ATOMIC BEGIN
+#include "../Network/InterestGrid.h"
+// ATOMIC END
 #include "../Scene/ReplicationState.h"
 
 // ATOMIC BEGIN
@@ -47,6 +50,9 @@ class Node;
 class Scene;
 class Serializable;
 class PackageFile;
+// ATOMIC BEGIN
+class ReplicationFanout;
+// ATOMIC END
 
 /// Queued remote event.
 struct RemoteEvent
@@ -95,6 +101,49 @@ struct PackageUpload
     unsigned totalFragments_;
 };
 
+// ATOMIC BEGIN
+/// Latest data of a node or component sent in a snapshot message.
+struct SnapshotEntry
+{
+    /// Node or component ID.
+    unsigned id_;
+    /// Server update number of the sent data.
+    unsigned update_;
+    /// Component flag.
+    bool component_;
+};
+
+/// Latest data of a node or component not yet acknowledged by the client.
+struct SnapshotState
+{
+    /// Construct with defaults.
+    SnapshotState();
+    /// Construct with the server update number of a change.
+    explicit SnapshotState(unsigned update);
+
+    /// Server update number of the last change.
+    unsigned update_;
+    /// Time of the last send in milliseconds.
+    unsigned sendTime_;
+    /// Sent since the last change flag.
+    bool sent_;
+};
+
+/// Sent snapshot message waiting for acknowledgement.
+struct SnapshotMessage
+{
+    /// Construct with defaults.
+    SnapshotMessage();
+
+    /// Sequence number, zero if free.
+    unsigned sequence_;
+    /// Time of sending in milliseconds.
+    unsigned sendTime_;
+    /// Nodes and components in the message.
+    PODVector<SnapshotEntry> entries_;
+};
+// ATOMIC END
+
 /// Send modes for observer position/rotation. Activated by the client setting either position or rotation.
 enum ObserverPositionSendMode
 {
@@ -141,8 +190,14 @@ public:
     void SetLogStatistics(bool enable);
     /// Disconnect. If wait time is non-zero, will block while waiting for disconnect to finish.
     void Disconnect(int waitMSec = 0);
-    /// Send scene update messages. Called by Network.
-    void SendServerUpdate();
+    // ATOMIC BEGIN
+    /// Send scene update messages. Called by Network. Attribute updates are copied from the fan-out when given. Only the nodes near the observer position are sent when an interest grid is given.
+    void SendServerUpdate(ReplicationFanout* fanout = 0, InterestGrid* interest = 0);
+    /// Set whether latest data is sent as unreliable snapshots of the changes since the last acknowledged ones, instead of reliable messages. Called by Network.
+    void SetSnapshotReplication(bool enable) { snapshotReplication_ = enable; }
+    /// Return whether latest data is sent as unreliable snapshots.
+    bool GetSnapshotReplication() const { return snapshotReplication_; }
+    // ATOMIC END
     /// Send latest controls from the client. Called by Network.
     void SendClientUpdate();
     /// Send queued remote events. Called by Network.
@@ -298,6 +353,29 @@ private:
 
     void HandleComponentRemoved(StringHash eventType, VariantMap& eventData);
 
+    /// Update the set of relevant top-level nodes from the interest grid. Nodes that enter are marked dirty and nodes that leave are removed from the client.
+    void UpdateInterest();
+    /// Return whether a node should be replicated to the client under interest management.
+    bool IsRelevant(Node* node) const;
+    /// Remove a node and its children from the client and drop their replication states, so that their changes no longer dirty this connection.
+    void LeaveNode(Node* node);
+    /// Mark all replicated nodes of the scene dirty after interest management was turned off.
+    void MarkAllNodesDirty();
+    /// Send the latest data not yet acknowledged by the client as snapshot messages.
+    void SendSnapshots();
+    /// Begin a new snapshot message.
+    void BeginSnapshotMessage();
+    /// Add the latest data in the scratch buffer to the current snapshot message. Begins the message if none, or sends it first if full.
+    void WriteSnapshotEntry(unsigned id, unsigned update, bool component);
+    /// Mark the latest data not yet acknowledged dirty after snapshots were turned off, so that it is sent reliably.
+    void MarkSnapshotDataDirty();
+    /// Process a Snapshot message from the server.
+    void ProcessSnapshot(int msgID, MemoryBuffer& msg);
+    /// Process a SnapshotAck message from the client.
+    void ProcessSnapshotAck(int msgID, MemoryBuffer& msg);
+    /// Remove the acknowledged entries of a sent snapshot message.
+    void AckSnapshotMessage(unsigned sequence);
+
 // ATOMIC END
 
     /// kNet message connection.
@@ -342,6 +420,48 @@ private:
     bool sceneLoaded_;
     /// Show statistics flag.
     bool logStatistics_;
+    // ATOMIC BEGIN
+    /// Shared attribute updates during the server update.
+    ReplicationFanout* fanout_;
+    /// Interest grid during the server update.
+    InterestGrid* interest_;
+    /// Relevant top-level node IDs with the interest update number they were last found in.
+    FlatHashMap<unsigned, unsigned> relevantNodes_;
+    /// Scratch buffer for interest grid queries.
+    PODVector<InterestGridNode> interestNodes_;
+    /// Scratch buffer for node hierarchies.
+    PODVector<Node*> interestChildren_;
+    /// Interest update number.
+    unsigned interestUpdate_;
+    /// Interest management active flag of the previous server update.
+    bool interestManaged_;
+    /// Nodes with latest data not yet acknowledged by the client.
+    FlatHashMap<unsigned, SnapshotState> snapshotNodes_;
+    /// Components with latest data not yet acknowledged by the client.
+    FlatHashMap<unsigned, SnapshotState> snapshotComponents_;
+    /// Recently sent snapshot messages indexed by sequence number.
+    Vector<SnapshotMessage> snapshotHistory_;
+    /// Newest applied server update number by node ID on the client.
+    FlatHashMap<unsigned, unsigned> snapshotNodeUpdates_;
+    /// Newest applied server update number by component ID on the client.
+    FlatHashMap<unsigned, unsigned> snapshotComponentUpdates_;
+    /// Scratch buffer for snapshot entry data.
+    VectorBuffer snapshotData_;
+    /// Timer for resending unacknowledged snapshot data.
+    Timer snapshotTimer_;
+    /// Server update number.
+    unsigned snapshotUpdate_;
+    /// Sequence number of the last sent snapshot message on the server, or of the newest received one on the client.
+    unsigned snapshotSequence_;
+    /// Received snapshot messages before the newest one on the client, one bit per sequence number.
+    unsigned snapshotAckBits_;
+    /// Smoothed time in milliseconds from sending a snapshot message to receiving its acknowledgement, zero if not measured yet.
+    float snapshotAckTime_;
+    /// Snapshot replication flag.
+    bool snapshotReplication_;
+    /// Snapshot received since the last acknowledgement flag.
+    bool snapshotAckPending_;
+    // ATOMIC END
 };
 
 }
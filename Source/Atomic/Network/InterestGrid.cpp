@@ -0,0 +1,243 @@
+//
+// Copyright (c) 2014-2017 THUNDERBEAST GAMES LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../Precompiled.h"
+
+#include "../Network/InterestGrid.h"
+#include "../Scene/Scene.h"
+#include "../Scene/SceneEvents.h"
+
+#include "../DebugNew.h"
+
+namespace Atomic
+{
+
+static const int CELL_COORDINATE_BITS = 21;
+static const int CELL_COORDINATE_OFFSET = 1 << (CELL_COORDINATE_BITS - 1);
+static const unsigned long long CELL_COORDINATE_MASK = (1ULL << CELL_COORDINATE_BITS) - 1;
+
+InterestGrid::InterestGrid(Context* context, Scene* scene, float cellSize) :
+    Object(context),
+    scene_(scene),
+    cellSize_(Max(cellSize, M_EPSILON)),
+    built_(false)
+{
+    if (scene)
+        SubscribeToEvent(scene, E_NODEREMOVED, ATOMIC_HANDLER(InterestGrid, HandleNodeRemoved));
+}
+
+InterestGrid::~InterestGrid()
+{
+}
+
+void InterestGrid::Update()
+{
+    reparentedNodes_ = pendingReparentedNodes_;
+    pendingReparentedNodes_.Clear();
+
+    if (!scene_)
+    {
+        cells_.Clear();
+        entries_.Clear();
+        return;
+    }
+
+    if (!built_)
+    {
+        Build();
+        return;
+    }
+
+    // Only the nodes marked for network update can have moved, been added or removed
+    const FlatHashSet<unsigned>& updateNodes = scene_->GetNetworkUpdateNodes();
+    for (FlatHashSet<unsigned>::ConstIterator i = updateNodes.Begin(); i != updateNodes.End(); ++i)
+        UpdateNode(*i);
+    for (PODVector<unsigned>::ConstIterator i = reparentedNodes_.Begin(); i != reparentedNodes_.End(); ++i)
+        UpdateNode(*i);
+}
+
+void InterestGrid::GetNodes(PODVector<InterestGridNode>& dest, const Vector3& position, float radius) const
+{
+    dest.Clear();
+
+    float radiusSquared = radius * radius;
+    int minX = GetCellCoordinate(position.x_ - radius);
+    int minY = GetCellCoordinate(position.y_ - radius);
+    int minZ = GetCellCoordinate(position.z_ - radius);
+    int maxX = GetCellCoordinate(position.x_ + radius);
+    int maxY = GetCellCoordinate(position.y_ + radius);
+    int maxZ = GetCellCoordinate(position.z_ + radius);
+
+    unsigned long long numCells = (unsigned long long)(maxX - minX + 1) * (maxY - minY + 1) * (maxZ - minZ + 1);
+    if (numCells > cells_.Size())
+    {
+        // The query covers more cells than are occupied: check the occupied cells directly
+        for (FlatHashMap<unsigned long long, PODVector<InterestGridNode> >::ConstIterator i = cells_.Begin(); i != cells_.End(); ++i)
+        {
+            const PODVector<InterestGridNode>& cell = i->second_;
+            for (PODVector<InterestGridNode>::ConstIterator j = cell.Begin(); j != cell.End(); ++j)
+            {
+                if ((j->position_ - position).LengthSquared() <= radiusSquared)
+                    dest.Push(*j);
+            }
+        }
+        return;
+    }
+
+    for (int z = minZ; z <= maxZ; ++z)
+    {
+        for (int y = minY; y <= maxY; ++y)
+        {
+            for (int x = minX; x <= maxX; ++x)
+            {
+                FlatHashMap<unsigned long long, PODVector<InterestGridNode> >::ConstIterator i = cells_.Find(GetCellKey(x, y, z));
+                if (i == cells_.End())
+                    continue;
+
+                const PODVector<InterestGridNode>& cell = i->second_;
+                for (PODVector<InterestGridNode>::ConstIterator j = cell.Begin(); j != cell.End(); ++j)
+                {
+                    if ((j->position_ - position).LengthSquared() <= radiusSquared)
+                        dest.Push(*j);
+                }
+            }
+        }
+    }
+}
+
+Scene* InterestGrid::GetScene() const
+{
+    return scene_;
+}
+
+void InterestGrid::Build()
+{
+    cells_.Clear();
+    entries_.Clear();
+
+    const Vector<SharedPtr<Node> >& children = scene_->GetChildren();
+    for (Vector<SharedPtr<Node> >::ConstIterator i = children.Begin(); i != children.End(); ++i)
+    {
+        Node* node = *i;
+        if (node->GetID() < FIRST_LOCAL_ID)
+            SetNode(node->GetID(), node->GetPosition());
+    }
+
+    built_ = true;
+}
+
+void InterestGrid::UpdateNode(unsigned nodeID)
+{
+    if (nodeID >= FIRST_LOCAL_ID)
+        return;
+
+    // The scene's transform is identity, so the position of a top-level node is its world position
+    Node* node = scene_->GetNode(nodeID);
+    if (node && node != scene_ && node->GetParent() == scene_)
+        SetNode(nodeID, node->GetPosition());
+    else
+        RemoveNode(nodeID);
+}
+
+void InterestGrid::SetNode(unsigned nodeID, const Vector3& position)
+{
+    unsigned long long cellKey = GetCellKey(GetCellCoordinate(position.x_), GetCellCoordinate(position.y_),
+        GetCellCoordinate(position.z_));
+
+    FlatHashMap<unsigned, InterestGridEntry>::Iterator i = entries_.Find(nodeID);
+    if (i != entries_.End())
+    {
+        InterestGridEntry& entry = i->second_;
+        if (entry.cellKey_ == cellKey)
+        {
+            // Still in the same cell: only update the position
+            cells_[cellKey][entry.index_].position_ = position;
+            return;
+        }
+
+        RemoveNode(nodeID);
+    }
+
+    PODVector<InterestGridNode>& cell = cells_[cellKey];
+    InterestGridNode gridNode;
+    gridNode.id_ = nodeID;
+    gridNode.position_ = position;
+    InterestGridEntry entry;
+    entry.cellKey_ = cellKey;
+    entry.index_ = cell.Size();
+    cell.Push(gridNode);
+    entries_[nodeID] = entry;
+}
+
+void InterestGrid::RemoveNode(unsigned nodeID)
+{
+    FlatHashMap<unsigned, InterestGridEntry>::Iterator i = entries_.Find(nodeID);
+    if (i == entries_.End())
+        return;
+
+    FlatHashMap<unsigned long long, PODVector<InterestGridNode> >::Iterator j = cells_.Find(i->second_.cellKey_);
+    unsigned index = i->second_.index_;
+    entries_.Erase(i);
+    if (j == cells_.End())
+        return;
+
+    // Fill the hole with the last node of the cell
+    PODVector<InterestGridNode>& cell = j->second_;
+    if (index + 1 < cell.Size())
+    {
+        cell[index] = cell.Back();
+        entries_[cell[index].id_].index_ = index;
+    }
+    cell.Pop();
+
+    if (cell.Empty())
+        cells_.Erase(j);
+}
+
+int InterestGrid::GetCellCoordinate(float value) const
+{
+    return FloorToInt(Clamp(value / cellSize_, (float)-CELL_COORDINATE_OFFSET, (float)(CELL_COORDINATE_OFFSET - 1)));
+}
+
+unsigned long long InterestGrid::GetCellKey(int x, int y, int z)
+{
+    return ((unsigned long long)(x + CELL_COORDINATE_OFFSET) & CELL_COORDINATE_MASK) |
+        (((unsigned long long)(y + CELL_COORDINATE_OFFSET) & CELL_COORDINATE_MASK) << CELL_COORDINATE_BITS) |
+        (((unsigned long long)(z + CELL_COORDINATE_OFFSET) & CELL_COORDINATE_MASK) << (2 * CELL_COORDINATE_BITS));
+}
+
+void InterestGrid::HandleNodeRemoved(StringHash eventType, VariantMap& eventData)
+{
+    using namespace NodeRemoved;
+
+    // Also sent when a node is moved to another parent in the same scene. The new parent is known on the next update
+    Node* node = static_cast<Node*>(eventData[P_NODE].GetPtr());
+    if (node && node->GetID() < FIRST_LOCAL_ID)
+    {
+        if (eventData[P_PARENT].GetPtr() == scene_)
+            RemoveNode(node->GetID());
+        pendingReparentedNodes_.Push(node->GetID());
+    }
+}
+
+}
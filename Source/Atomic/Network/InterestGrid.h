@@ -0,0 +1,112 @@
+//
+// Copyright (c) 2014-2017 THUNDERBEAST GAMES LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "../Container/FlatHashMap.h"
+#include "../Core/Object.h"
+#include "../Math/Vector3.h"
+
+namespace Atomic
+{
+
+class Scene;
+
+/// Replicated top-level node stored in an interest grid.
+struct InterestGridNode
+{
+    /// Node ID.
+    unsigned id_;
+    /// Position in the scene.
+    Vector3 position_;
+};
+
+/// Location of a node in the interest grid cells.
+struct InterestGridEntry
+{
+    /// Cell key.
+    unsigned long long cellKey_;
+    /// Index in the cell.
+    unsigned index_;
+};
+
+/// %Network interest management spatial grid. Tracks the replicated direct children of a scene in uniform cells so that
+/// connections can find the nodes near their observer position without visiting every node. Child nodes share the
+/// relevance of their top-level ancestor. Updated on the main thread by Network; queries are safe from several threads.
+class ATOMIC_API InterestGrid : public Object
+{
+    ATOMIC_OBJECT(InterestGrid, Object);
+
+public:
+    /// Construct with scene and cell size.
+    InterestGrid(Context* context, Scene* scene, float cellSize);
+    /// Destruct.
+    virtual ~InterestGrid();
+
+    /// Update the positions of the nodes that have changed since the last prepared network update. Builds the grid on first call.
+    void Update();
+    /// Return the nodes within a distance of a position.
+    void GetNodes(PODVector<InterestGridNode>& dest, const Vector3& position, float radius) const;
+
+    /// Return scene.
+    Scene* GetScene() const;
+    /// Return cell size.
+    float GetCellSize() const { return cellSize_; }
+    /// Return number of nodes in the grid.
+    unsigned GetNumNodes() const { return entries_.Size(); }
+    /// Return IDs of nodes that were moved to another parent since the previous update.
+    const PODVector<unsigned>& GetReparentedNodes() const { return reparentedNodes_; }
+
+private:
+    /// Insert all replicated top-level nodes of the scene.
+    void Build();
+    /// Insert, move or remove a node according to its current position and parent.
+    void UpdateNode(unsigned nodeID);
+    /// Insert or move a node.
+    void SetNode(unsigned nodeID, const Vector3& position);
+    /// Remove a node.
+    void RemoveNode(unsigned nodeID);
+    /// Return cell coordinate of a position on one axis.
+    int GetCellCoordinate(float value) const;
+    /// Return cell key from cell coordinates.
+    static unsigned long long GetCellKey(int x, int y, int z);
+    /// Handle node being removed from its parent.
+    void HandleNodeRemoved(StringHash eventType, VariantMap& eventData);
+
+    /// Scene.
+    WeakPtr<Scene> scene_;
+    /// Nodes by cell.
+    FlatHashMap<unsigned long long, PODVector<InterestGridNode> > cells_;
+    /// Cell locations by node ID.
+    FlatHashMap<unsigned, InterestGridEntry> entries_;
+    /// Nodes reparented since the previous update.
+    PODVector<unsigned> pendingReparentedNodes_;
+    /// Nodes reparented before the current update.
+    PODVector<unsigned> reparentedNodes_;
+    /// Cell size.
+    float cellSize_;
+    /// Grid built flag.
+    bool built_;
+};
+
+}
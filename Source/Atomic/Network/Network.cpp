@@ -25,12 +25,18 @@
 #include "../Core/Context.h"
 #include "../Core/CoreEvents.h"
 #include "../Core/Profiler.h"
+// ATOMIC BEGIN
+#include "../Core/WorkQueue.h"
+// ATOMIC END
 #include "../Engine/EngineEvents.h"
 #include "../IO/FileSystem.h"
 #include "../Input/InputEvents.h"
 #include "../IO/IOEvents.h"
 #include "../IO/Log.h"
 #include "../IO/MemoryBuffer.h"
+// ATOMIC BEGIN
+#include "../Metrics/FrameStatistics.h"
+// ATOMIC END
 #include "../Network/HttpRequest.h"
 #include "../Network/Network.h"
 #include "../Network/NetworkEvents.h"
@@ -58,7 +64,11 @@ Network::Network(Context* context) :
     updateInterval_(1.0f / (float)DEFAULT_UPDATE_FPS),
     updateAcc_(0.0f),
 // ATOMIC BEGIN
-    serverPort_(0xFFFF)
+    serverPort_(0xFFFF),
+    sharedReplication_(true),
+    serverUpdateThreaded_(true),
+    interestRadius_(0.0f),
+    snapshotReplication_(false)
 // ATOMIC END
 {
     network_ = new kNet::Network();
@@ -154,6 +164,12 @@ u32 Network::ComputeContentID(kNet::message_id_t msgId, const char* data, size_t
         // Return fixed content ID for controls
         return CONTROLS_CONTENT_ID;
 
+    // ATOMIC BEGIN
+    case MSG_SNAPSHOTACK:
+        // Only the newest acknowledgement matters, as it also covers the earlier ones
+        return SNAPSHOTACK_CONTENT_ID;
+    // ATOMIC END
+
     case MSG_NODELATESTDATA:
     case MSG_COMPONENTLATESTDATA:
         {
@@ -175,6 +191,9 @@ void Network::NewConnectionEstablished(kNet::MessageConnection* connection)
     // Create a new client connection corresponding to this MessageConnection
     SharedPtr<Connection> newConnection(new Connection(context_, true, kNet::SharedPtr<kNet::MessageConnection>(connection)));
     newConnection->ConfigureNetworkSimulator(simulatedLatency_, simulatedPacketLoss_);
+    // ATOMIC BEGIN
+    newConnection->SetSnapshotReplication(snapshotReplication_);
+    // ATOMIC END
     clientConnections_[connection] = newConnection;
     ATOMIC_LOGINFO("Client " + newConnection->ToString() + " connected");
 
@@ -460,6 +479,9 @@ bool Network::CheckRemoteEvent(StringHash eventType) const
 void Network::Update(float timeStep)
 {
     ATOMIC_PROFILE(UpdateNetwork);
+    // ATOMIC BEGIN
+    ATOMIC_FRAMESTAT(STAT_NETWORK);
+    // ATOMIC END
 
     // Process server connection if it exists
     if (serverConnection_)
@@ -491,6 +513,9 @@ void Network::Update(float timeStep)
 void Network::PostUpdate(float timeStep)
 {
     ATOMIC_PROFILE(PostUpdateNetwork);
+    // ATOMIC BEGIN
+    ATOMIC_FRAMESTAT(STAT_NETWORK);
+    // ATOMIC END
 
     // Check if periodic update should happen now
     updateAcc_ += timeStep;
@@ -517,21 +542,59 @@ void Network::PostUpdate(float timeStep)
                         networkScenes_.Insert(scene);
                 }
 
+                // ATOMIC BEGIN
+                // Update the interest grids before preparing the scenes, as the prepare clears the moved node set
+                UpdateInterestGrids();
+
+                ReplicationFanout* fanout = GetReplicationFanout();
+                if (fanout)
+                    fanout->BeginTick();
+
                 for (HashSet<Scene*>::ConstIterator i = networkScenes_.Begin(); i != networkScenes_.End(); ++i)
-                    (*i)->PrepareNetworkUpdate();
+                    (*i)->PrepareNetworkUpdate(fanout);
+                // ATOMIC END
             }
 
             {
                 ATOMIC_PROFILE(SendServerUpdate);
 
-                // Then send server updates for each client connection
+                // ATOMIC BEGIN
+                // Then send server updates for each client connection. The updates only write to the connections' own
+                // replication states and leave the scene untouched, so they can run in worker threads
+                updateConnections_.Clear();
                 for (HashMap<kNet::MessageConnection*, SharedPtr<Connection> >::Iterator i = clientConnections_.Begin();
                      i != clientConnections_.End(); ++i)
+                    updateConnections_.Push(i->second_);
+
+                ReplicationFanout* fanout = GetReplicationFanout();
+                WorkQueue* queue = GetSubsystem<WorkQueue>();
+                if (serverUpdateThreaded_ && queue && queue->GetNumThreads() && updateConnections_.Size() > 1)
+                {
+                    queue->ParallelFor(0, updateConnections_.Size(), 1, [this, fanout](unsigned begin, unsigned end, unsigned threadIndex)
+                    {
+                        for (unsigned i = begin; i < end; ++i)
+                        {
+                            Connection* connection = updateConnections_[i];
+                            connection->SendServerUpdate(fanout, GetInterestGrid(connection->GetScene()));
+                        }
+                    });
+                }
+                else
                 {
-                    i->second_->SendServerUpdate();
-                    i->second_->SendRemoteEvents();
-                    i->second_->SendPackages();
+                    for (unsigned i = 0; i < updateConnections_.Size(); ++i)
+                    {
+                        Connection* connection = updateConnections_[i];
+                        connection->SendServerUpdate(fanout, GetInterestGrid(connection->GetScene()));
+                    }
                 }
+
+                // Remote events and package uploads use the event system and file system, so send them on the main thread
+                for (unsigned i = 0; i < updateConnections_.Size(); ++i)
+                {
+                    updateConnections_[i]->SendRemoteEvents();
+                    updateConnections_[i]->SendPackages();
+                }
+                // ATOMIC END
             }
         }
 
@@ -656,6 +719,51 @@ bool Network::IsEndPointConnected(const kNet::EndPoint& endPoint) const
     return false;
 }
 
+void Network::SetInterestRadius(float radius)
+{
+    interestRadius_ = Max(radius, 0.0f);
+}
+
+void Network::SetSnapshotReplication(bool enable)
+{
+    snapshotReplication_ = enable;
+
+    for (HashMap<kNet::MessageConnection*, SharedPtr<Connection> >::Iterator i = clientConnections_.Begin();
+         i != clientConnections_.End(); ++i)
+        i->second_->SetSnapshotReplication(enable);
+}
+
+InterestGrid* Network::GetInterestGrid(Scene* scene) const
+{
+    HashMap<Scene*, SharedPtr<InterestGrid> >::ConstIterator i = interestGrids_.Find(scene);
+    return i != interestGrids_.End() ? i->second_.Get() : 0;
+}
+
+void Network::UpdateInterestGrids()
+{
+    // Remove grids of scenes that are no longer networked or have been destroyed, and grids of a different radius
+    for (HashMap<Scene*, SharedPtr<InterestGrid> >::Iterator i = interestGrids_.Begin(); i != interestGrids_.End();)
+    {
+        InterestGrid* grid = i->second_;
+        if (interestRadius_ <= 0.0f || !networkScenes_.Contains(i->first_) || grid->GetScene() != i->first_ ||
+            grid->GetCellSize() != interestRadius_)
+            i = interestGrids_.Erase(i);
+        else
+            ++i;
+    }
+
+    if (interestRadius_ <= 0.0f)
+        return;
+
+    for (HashSet<Scene*>::ConstIterator i = networkScenes_.Begin(); i != networkScenes_.End(); ++i)
+    {
+        SharedPtr<InterestGrid>& grid = interestGrids_[*i];
+        if (!grid)
+            grid = new InterestGrid(context_, *i, interestRadius_);
+        grid->Update();
+    }
+}
+
 // ATOMIC END
 
 }
@@ -26,6 +26,9 @@
 #include "../Core/Object.h"
 #include "../IO/VectorBuffer.h"
 #include "../Network/Connection.h"
+// ATOMIC BEGIN
+#include "../Scene/ReplicationFanout.h"
+// ATOMIC END
 
 #include <kNet/IMessageHandler.h>
 #include <kNet/INetworkServerListener.h>
@@ -150,6 +153,27 @@ public:
     /// Connect to a server, reusing an existing Socket
     bool ConnectWithExistingSocket(kNet::Socket* existingSocket, Scene* scene);
 
+    /// Set whether changed attributes are serialized once per update and shared by all client connections. Default true.
+    void SetSharedReplication(bool enable) { sharedReplication_ = enable; }
+    /// Return whether changed attributes are serialized once per update for all client connections.
+    bool GetSharedReplication() const { return sharedReplication_; }
+    /// Return the shared replication updates of the current network update, or null if disabled.
+    ReplicationFanout* GetReplicationFanout() { return sharedReplication_ ? &fanout_ : 0; }
+    /// Set whether the server updates of client connections are sent in parallel on worker threads. Default true. Takes effect only with at least two connections and worker threads in the WorkQueue.
+    void SetServerUpdateThreaded(bool enable) { serverUpdateThreaded_ = enable; }
+    /// Return whether the server updates of client connections are sent in parallel on worker threads.
+    bool IsServerUpdateThreaded() const { return serverUpdateThreaded_; }
+    /// Set interest management radius. Client connections then only receive the replicated top-level nodes, with their children, that are within the radius of their observer position. Nodes owned by the connection are always sent. Zero (default) sends all nodes.
+    void SetInterestRadius(float radius);
+    /// Return interest management radius.
+    float GetInterestRadius() const { return interestRadius_; }
+    /// Return the interest management grid of a networked scene, or null if interest management is disabled.
+    InterestGrid* GetInterestGrid(Scene* scene) const;
+    /// Set whether client connections receive latest data as unreliable snapshots, each holding the changes since the ones the client acknowledged, instead of reliable messages. Avoids stalls on lossy links. Default false.
+    void SetSnapshotReplication(bool enable);
+    /// Return whether client connections receive latest data as unreliable snapshots.
+    bool GetSnapshotReplication() const { return snapshotReplication_; }
+
     // ATOMIC END
 
 private:
@@ -195,7 +219,25 @@ private:
 
     kNet::Network* GetKnetNetwork() { return network_.Get(); }
 
+    /// Create, update or remove the interest management grids of the networked scenes.
+    void UpdateInterestGrids();
+
     unsigned short serverPort_;
+
+    /// Attribute updates serialized once per network update.
+    ReplicationFanout fanout_;
+    /// Shared replication enabled flag.
+    bool sharedReplication_;
+    /// Client connections to send server updates to during the network update.
+    PODVector<Connection*> updateConnections_;
+    /// Threaded server update flag.
+    bool serverUpdateThreaded_;
+    /// Interest management grids of the networked scenes.
+    HashMap<Scene*, SharedPtr<InterestGrid> > interestGrids_;
+    /// Interest management radius.
+    float interestRadius_;
+    /// Snapshot replication flag.
+    bool snapshotReplication_;
     // ATOMIC END
 
 };
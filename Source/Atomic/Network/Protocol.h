@@ -68,6 +68,10 @@ static const int MSG_PACKAGEINFO = 0x16;
 
 // Server->client, Client->server: string message
 static const int MSG_STRING = 0x17;
+/// Server->client: unreliable snapshot of the latest data changed since the snapshots acknowledged by the client.
+static const int MSG_SNAPSHOT = 0x18;
+/// Client->server: acknowledge received snapshots by sequence number.
+static const int MSG_SNAPSHOTACK = 0x19;
 
 // ATOMIC END
 
@@ -75,5 +79,11 @@ static const int MSG_STRING = 0x17;
 static const unsigned CONTROLS_CONTENT_ID = 1;
 /// Package file fragment size.
 static const unsigned PACKAGE_FRAGMENT_SIZE = 1024;
+// ATOMIC BEGIN
+/// Fixed content ID for snapshot acknowledgements.
+static const unsigned SNAPSHOTACK_CONTENT_ID = 2;
+/// Snapshot message size after which no more entries are added, so that the unreliable messages are not fragmented.
+static const unsigned SNAPSHOT_MESSAGE_SIZE = 1200;
+// ATOMIC END
 
 }
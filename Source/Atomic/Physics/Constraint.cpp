@@ -477,6 +477,16 @@ void Constraint::OnSceneSet(Scene* scene)
 
 void Constraint::OnMarkedDirty(Node* node)
 {
+    // ATOMIC BEGIN
+    // Physics operations are not safe from worker threads
+    Scene* scene = GetScene();
+    if (scene && scene->IsThreadedUpdate())
+    {
+        scene->DelayedMarkedDirty(this);
+        return;
+    }
+    // ATOMIC END
+
     /// \todo This does not catch the connected body node's scale changing
     if (HasWorldScaleChanged(cachedWorldScale_, node->GetWorldScale()))
         ApplyFrames();
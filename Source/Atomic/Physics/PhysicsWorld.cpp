@@ -29,6 +29,9 @@
 #include "../Graphics/Model.h"
 #include "../IO/Log.h"
 #include "../Math/Ray.h"
+// ATOMIC BEGIN
+#include "../Metrics/FrameStatistics.h"
+// ATOMIC END
 #include "../Physics/CollisionShape.h"
 #include "../Physics/Constraint.h"
 #include "../Physics/PhysicsEvents.h"
@@ -240,6 +243,9 @@ void PhysicsWorld::draw3dText(const btVector3& location, const char* textString)
 void PhysicsWorld::Update(float timeStep)
 {
     ATOMIC_PROFILE(UpdatePhysics);
+    // ATOMIC BEGIN
+    ATOMIC_FRAMESTAT(STAT_PHYSICS);
+    // ATOMIC END
 
     float internalTimeStep = 1.0f / fps_;
     int maxSubSteps = (int)(timeStep * fps_) + 1;
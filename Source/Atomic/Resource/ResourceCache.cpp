@@ -267,13 +267,13 @@ void ResourceCache::ReleaseResources(StringHash type, bool force)
 {
     bool released = false;
 
-    HashMap<StringHash, ResourceGroup>::Iterator i = resourceGroups_.Find(type);
+    FlatHashMap<StringHash, ResourceGroup>::Iterator i = resourceGroups_.Find(type);
     if (i != resourceGroups_.End())
     {
-        for (HashMap<StringHash, SharedPtr<Resource> >::Iterator j = i->second_.resources_.Begin();
+        for (FlatHashMap<StringHash, SharedPtr<Resource> >::Iterator j = i->second_.resources_.Begin();
              j != i->second_.resources_.End();)
         {
-            HashMap<StringHash, SharedPtr<Resource> >::Iterator current = j++;
+            FlatHashMap<StringHash, SharedPtr<Resource> >::Iterator current = j++;
             // If other references exist, do not release, unless forced
             if ((current->second_.Refs() == 1 && current->second_.WeakRefs() == 0) || force)
             {
@@ -291,13 +291,13 @@ void ResourceCache::ReleaseResources(StringHash type, const String& partialName,
 {
     bool released = false;
 
-    HashMap<StringHash, ResourceGroup>::Iterator i = resourceGroups_.Find(type);
+    FlatHashMap<StringHash, ResourceGroup>::Iterator i = resourceGroups_.Find(type);
     if (i != resourceGroups_.End())
     {
-        for (HashMap<StringHash, SharedPtr<Resource> >::Iterator j = i->second_.resources_.Begin();
+        for (FlatHashMap<StringHash, SharedPtr<Resource> >::Iterator j = i->second_.resources_.Begin();
              j != i->second_.resources_.End();)
         {
-            HashMap<StringHash, SharedPtr<Resource> >::Iterator current = j++;
+            FlatHashMap<StringHash, SharedPtr<Resource> >::Iterator current = j++;
             if (current->second_->GetName().Contains(partialName))
             {
                 // If other references exist, do not release, unless forced
@@ -322,14 +322,14 @@ void ResourceCache::ReleaseResources(const String& partialName, bool force)
 
     while (repeat--)
     {
-        for (HashMap<StringHash, ResourceGroup>::Iterator i = resourceGroups_.Begin(); i != resourceGroups_.End(); ++i)
+        for (FlatHashMap<StringHash, ResourceGroup>::Iterator i = resourceGroups_.Begin(); i != resourceGroups_.End(); ++i)
         {
             bool released = false;
 
-            for (HashMap<StringHash, SharedPtr<Resource> >::Iterator j = i->second_.resources_.Begin();
+            for (FlatHashMap<StringHash, SharedPtr<Resource> >::Iterator j = i->second_.resources_.Begin();
                  j != i->second_.resources_.End();)
             {
-                HashMap<StringHash, SharedPtr<Resource> >::Iterator current = j++;
+                FlatHashMap<StringHash, SharedPtr<Resource> >::Iterator current = j++;
                 if (current->second_->GetName().Contains(partialName))
                 {
                     // If other references exist, do not release, unless forced
@@ -352,15 +352,15 @@ void ResourceCache::ReleaseAllResources(bool force)
 
     while (repeat--)
     {
-        for (HashMap<StringHash, ResourceGroup>::Iterator i = resourceGroups_.Begin();
+        for (FlatHashMap<StringHash, ResourceGroup>::Iterator i = resourceGroups_.Begin();
              i != resourceGroups_.End(); ++i)
         {
             bool released = false;
 
-            for (HashMap<StringHash, SharedPtr<Resource> >::Iterator j = i->second_.resources_.Begin();
+            for (FlatHashMap<StringHash, SharedPtr<Resource> >::Iterator j = i->second_.resources_.Begin();
                  j != i->second_.resources_.End();)
             {
-                HashMap<StringHash, SharedPtr<Resource> >::Iterator current = j++;
+                FlatHashMap<StringHash, SharedPtr<Resource> >::Iterator current = j++;
                 // If other references exist, do not release, unless forced
                 if ((current->second_.Refs() == 1 && current->second_.WeakRefs() == 0) || force)
                 {
@@ -776,10 +776,10 @@ unsigned ResourceCache::GetNumBackgroundLoadResources() const
 void ResourceCache::GetResources(PODVector<Resource*>& result, StringHash type) const
 {
     result.Clear();
-    HashMap<StringHash, ResourceGroup>::ConstIterator i = resourceGroups_.Find(type);
+    FlatHashMap<StringHash, ResourceGroup>::ConstIterator i = resourceGroups_.Find(type);
     if (i != resourceGroups_.End())
     {
-        for (HashMap<StringHash, SharedPtr<Resource> >::ConstIterator j = i->second_.resources_.Begin();
+        for (FlatHashMap<StringHash, SharedPtr<Resource> >::ConstIterator j = i->second_.resources_.Begin();
              j != i->second_.resources_.End(); ++j)
             result.Push(j->second_);
     }
@@ -822,20 +822,20 @@ bool ResourceCache::Exists(const String& nameIn) const
 
 unsigned long long ResourceCache::GetMemoryBudget(StringHash type) const
 {
-    HashMap<StringHash, ResourceGroup>::ConstIterator i = resourceGroups_.Find(type);
+    FlatHashMap<StringHash, ResourceGroup>::ConstIterator i = resourceGroups_.Find(type);
     return i != resourceGroups_.End() ? i->second_.memoryBudget_ : 0;
 }
 
 unsigned long long ResourceCache::GetMemoryUse(StringHash type) const
 {
-    HashMap<StringHash, ResourceGroup>::ConstIterator i = resourceGroups_.Find(type);
+    FlatHashMap<StringHash, ResourceGroup>::ConstIterator i = resourceGroups_.Find(type);
     return i != resourceGroups_.End() ? i->second_.memoryUse_ : 0;
 }
 
 unsigned long long ResourceCache::GetTotalMemoryUse() const
 {
     unsigned long long total = 0;
-    for (HashMap<StringHash, ResourceGroup>::ConstIterator i = resourceGroups_.Begin(); i != resourceGroups_.End(); ++i)
+    for (FlatHashMap<StringHash, ResourceGroup>::ConstIterator i = resourceGroups_.Begin(); i != resourceGroups_.End(); ++i)
         total += i->second_.memoryUse_;
     return total;
 }
@@ -980,7 +980,7 @@ String ResourceCache::PrintMemoryUsage() const
     unsigned long long totalAverage = 0;
     unsigned long long totalUse = GetTotalMemoryUse();
 
-    for (HashMap<StringHash, ResourceGroup>::ConstIterator cit = resourceGroups_.Begin(); cit != resourceGroups_.End(); ++cit)
+    for (FlatHashMap<StringHash, ResourceGroup>::ConstIterator cit = resourceGroups_.Begin(); cit != resourceGroups_.End(); ++cit)
     {
         const unsigned resourceCt = cit->second_.resources_.Size();
         unsigned long long average = 0;
@@ -989,7 +989,7 @@ String ResourceCache::PrintMemoryUsage() const
         else
             average = 0;
         unsigned long long largest = 0;
-        for (HashMap<StringHash, SharedPtr<Resource> >::ConstIterator resIt = cit->second_.resources_.Begin(); resIt != cit->second_.resources_.End(); ++resIt)
+        for (FlatHashMap<StringHash, SharedPtr<Resource> >::ConstIterator resIt = cit->second_.resources_.Begin(); resIt != cit->second_.resources_.End(); ++resIt)
         {
             if (resIt->second_->GetMemoryUse() > largest)
                 largest = resIt->second_->GetMemoryUse();
@@ -1033,10 +1033,10 @@ const SharedPtr<Resource>& ResourceCache::FindResource(StringHash type, StringHa
 {
     MutexLock lock(resourceMutex_);
 
-    HashMap<StringHash, ResourceGroup>::Iterator i = resourceGroups_.Find(type);
+    FlatHashMap<StringHash, ResourceGroup>::Iterator i = resourceGroups_.Find(type);
     if (i == resourceGroups_.End())
         return noResource;
-    HashMap<StringHash, SharedPtr<Resource> >::Iterator j = i->second_.resources_.Find(nameHash);
+    FlatHashMap<StringHash, SharedPtr<Resource> >::Iterator j = i->second_.resources_.Find(nameHash);
     if (j == i->second_.resources_.End())
         return noResource;
 
@@ -1047,9 +1047,9 @@ const SharedPtr<Resource>& ResourceCache::FindResource(StringHash nameHash)
 {
     MutexLock lock(resourceMutex_);
 
-    for (HashMap<StringHash, ResourceGroup>::Iterator i = resourceGroups_.Begin(); i != resourceGroups_.End(); ++i)
+    for (FlatHashMap<StringHash, ResourceGroup>::Iterator i = resourceGroups_.Begin(); i != resourceGroups_.End(); ++i)
     {
-        HashMap<StringHash, SharedPtr<Resource> >::Iterator j = i->second_.resources_.Find(nameHash);
+        FlatHashMap<StringHash, SharedPtr<Resource> >::Iterator j = i->second_.resources_.Find(nameHash);
         if (j != i->second_.resources_.End())
             return j->second_;
     }
@@ -1067,9 +1067,9 @@ void ResourceCache::ReleasePackageResources(PackageFile* package, bool force)
         StringHash nameHash(i->first_);
 
         // We do not know the actual resource type, so search all type containers
-        for (HashMap<StringHash, ResourceGroup>::Iterator j = resourceGroups_.Begin(); j != resourceGroups_.End(); ++j)
+        for (FlatHashMap<StringHash, ResourceGroup>::Iterator j = resourceGroups_.Begin(); j != resourceGroups_.End(); ++j)
         {
-            HashMap<StringHash, SharedPtr<Resource> >::Iterator k = j->second_.resources_.Find(nameHash);
+            FlatHashMap<StringHash, SharedPtr<Resource> >::Iterator k = j->second_.resources_.Find(nameHash);
             if (k != j->second_.resources_.End())
             {
                 // If other references exist, do not release, unless forced
@@ -1089,7 +1089,7 @@ void ResourceCache::ReleasePackageResources(PackageFile* package, bool force)
 
 void ResourceCache::UpdateResourceGroup(StringHash type)
 {
-    HashMap<StringHash, ResourceGroup>::Iterator i = resourceGroups_.Find(type);
+    FlatHashMap<StringHash, ResourceGroup>::Iterator i = resourceGroups_.Find(type);
     if (i == resourceGroups_.End())
         return;
 
@@ -1097,9 +1097,9 @@ void ResourceCache::UpdateResourceGroup(StringHash type)
     {
         unsigned totalSize = 0;
         unsigned oldestTimer = 0;
-        HashMap<StringHash, SharedPtr<Resource> >::Iterator oldestResource = i->second_.resources_.End();
+        FlatHashMap<StringHash, SharedPtr<Resource> >::Iterator oldestResource = i->second_.resources_.End();
 
-        for (HashMap<StringHash, SharedPtr<Resource> >::Iterator j = i->second_.resources_.Begin();
+        for (FlatHashMap<StringHash, SharedPtr<Resource> >::Iterator j = i->second_.resources_.Begin();
              j != i->second_.resources_.End(); ++j)
         {
             totalSize += j->second_->GetMemoryUse();
@@ -1252,9 +1252,9 @@ String ResourceCache::PrintResources(const String& typeName) const
 
     String output = "Resource Type         Refs   WeakRefs  Name\n\n";
 
-    for (HashMap<StringHash, ResourceGroup>::ConstIterator cit = resourceGroups_.Begin(); cit != resourceGroups_.End(); ++cit)
+    for (FlatHashMap<StringHash, ResourceGroup>::ConstIterator cit = resourceGroups_.Begin(); cit != resourceGroups_.End(); ++cit)
     {
-        for (HashMap<StringHash, SharedPtr<Resource> >::ConstIterator resIt = cit->second_.resources_.Begin(); resIt != cit->second_.resources_.End(); ++resIt)
+        for (FlatHashMap<StringHash, SharedPtr<Resource> >::ConstIterator resIt = cit->second_.resources_.Begin(); resIt != cit->second_.resources_.End(); ++resIt)
         {
             Resource* resource = resIt->second_;
 
@@ -22,6 +22,9 @@
 
 #pragma once
 
+// ATOMIC BEGIN
+#include "../Container/FlatHashMap.h"
+// ATOMIC END
 #include "../Container/HashSet.h"
 #include "../Container/List.h"
 #include "../Core/Mutex.h"
@@ -53,7 +56,7 @@ struct ResourceGroup
     /// Current memory use.
     unsigned long long memoryUse_;
     /// Resources.
-    HashMap<StringHash, SharedPtr<Resource> > resources_;
+    FlatHashMap<StringHash, SharedPtr<Resource> > resources_;
 };
 
 /// Resource request types.
@@ -173,7 +176,7 @@ public:
     Resource* GetExistingResource(StringHash type, const String& name);
 
     /// Return all loaded resources.
-    const HashMap<StringHash, ResourceGroup>& GetAllResources() const { return resourceGroups_; }
+    const FlatHashMap<StringHash, ResourceGroup>& GetAllResources() const { return resourceGroups_; }
 
     /// Return added resource load directories.
     const Vector<String>& GetResourceDirs() const { return resourceDirs_; }
@@ -269,7 +272,7 @@ private:
     /// Mutex for thread-safe access to the resource directories, resource packages and resource dependencies.
     mutable Mutex resourceMutex_;
     /// Resources by type.
-    HashMap<StringHash, ResourceGroup> resourceGroups_;
+    FlatHashMap<StringHash, ResourceGroup> resourceGroups_;
     /// Resource load directories.
     Vector<String> resourceDirs_;
     /// File watchers for resource directories, if automatic reloading enabled.
@@ -0,0 +1,385 @@
+//
+// Copyright (c) 2014-2017 THUNDERBEAST GAMES LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../Precompiled.h"
+
+#include "../Core/Context.h"
+#include "../Core/Timer.h"
+#include "../Core/WorkQueue.h"
+#include "../IO/File.h"
+#include "../IO/Log.h"
+#include "../IO/MemoryBuffer.h"
+#include "../IO/VectorBuffer.h"
+#include "../Scene/AsyncSceneLoader.h"
+#include "../Scene/Component.h"
+#include "../Scene/PackedScene.h"
+#include "../Scene/Scene.h"
+#include "../Scene/SceneResolver.h"
+
+#include "../DebugNew.h"
+
+namespace Atomic
+{
+
+/// Decode attribute values of a type from a stream. Registered attributes are only read here, so this is safe while the main thread runs. Return false if the type has no registered attributes.
+static bool DecodeValues(Context* context, StringHash type, Deserializer& source, VariantVector& values)
+{
+    const Vector<AttributeInfo>* attributes = context->GetAttributes(type);
+    if (!attributes)
+        return false;
+
+    for (unsigned i = 0; i < attributes->Size(); ++i)
+    {
+        const AttributeInfo& attr = attributes->At(i);
+        if (!(attr.mode_ & AM_FILE))
+            continue;
+
+        // A short stream is reported by LoadValues() in the main thread, like Load() would
+        if (source.IsEof())
+            break;
+
+        values.Push(source.ReadVariant(attr.type_));
+    }
+
+    return true;
+}
+
+bool PreparedSubtree::Decode(Context* context, Deserializer& source, unsigned parent, const std::atomic<bool>* cancelled)
+{
+    unsigned index = nodes_.Size();
+    nodes_.Resize(index + 1);
+
+    PreparedNode& prepared = nodes_[index];
+    prepared.id_ = source.ReadUInt();
+    prepared.parent_ = parent;
+    DecodeValues(context, Node::GetTypeStatic(), source, prepared.values_);
+
+    unsigned firstComponent = components_.Size();
+    unsigned numComponents = source.ReadVLE();
+    for (unsigned i = 0; i < numComponents; ++i)
+    {
+        if (source.IsEof())
+            return false;
+
+        VectorBuffer compBuffer(source, source.ReadVLE());
+        components_.Resize(components_.Size() + 1);
+        PreparedComponent& compPrepared = components_.Back();
+        compPrepared.type_ = compBuffer.ReadStringHash();
+        compPrepared.id_ = compBuffer.ReadUInt();
+        compPrepared.decoded_ = DecodeValues(context, compPrepared.type_, compBuffer, compPrepared.values_);
+        if (!compPrepared.decoded_)
+        {
+            // Keep the data of unknown types for the component's own Load()
+            compPrepared.data_.Resize(compBuffer.GetSize() - compBuffer.GetPosition());
+            if (compPrepared.data_.Size())
+                compBuffer.Read(&compPrepared.data_[0], compPrepared.data_.Size());
+        }
+    }
+
+    // The node may have moved if the vector grew
+    nodes_[index].firstComponent_ = firstComponent;
+    nodes_[index].numComponents_ = numComponents;
+
+    unsigned numChildren = source.ReadVLE();
+    for (unsigned i = 0; i < numChildren; ++i)
+    {
+        if ((cancelled && *cancelled) || source.IsEof() || !Decode(context, source, index, cancelled))
+            return false;
+    }
+
+    return true;
+}
+
+bool PreparedSubtree::Decode(Context* context, const PackedScene* packedScene, unsigned index, const std::atomic<bool>* cancelled)
+{
+    unsigned first = nodes_.Size();
+    unsigned end = packedScene->GetNode(index).end_;
+    nodes_.Resize(first + end - index);
+
+    for (unsigned i = index; i < end; ++i)
+    {
+        if (cancelled && *cancelled)
+            return false;
+
+        const PackedNodeEntry& entry = packedScene->GetNode(i);
+        PreparedNode& prepared = nodes_[first + i - index];
+        prepared.id_ = entry.id_;
+        prepared.parent_ = i == index ? M_MAX_UNSIGNED : first + entry.parent_ - index;
+        prepared.firstComponent_ = components_.Size();
+        prepared.numComponents_ = entry.numComponents_;
+
+        MemoryBuffer nodeData(packedScene->GetData(entry.dataOffset_), entry.dataSize_);
+        DecodeValues(context, Node::GetTypeStatic(), nodeData, prepared.values_);
+
+        for (unsigned j = entry.firstComponent_; j < entry.firstComponent_ + entry.numComponents_; ++j)
+        {
+            const PackedComponentEntry& compEntry = packedScene->GetComponent(j);
+            components_.Resize(components_.Size() + 1);
+            PreparedComponent& compPrepared = components_.Back();
+            compPrepared.type_ = StringHash(compEntry.type_);
+            compPrepared.typeName_ = packedScene->GetString(compEntry.typeName_);
+            compPrepared.id_ = compEntry.id_;
+
+            MemoryBuffer compData(packedScene->GetData(compEntry.dataOffset_), compEntry.dataSize_);
+            compPrepared.decoded_ = DecodeValues(context, compPrepared.type_, compData, compPrepared.values_);
+            if (!compPrepared.decoded_)
+            {
+                compPrepared.data_.Resize(compEntry.dataSize_);
+                if (compEntry.dataSize_)
+                    memcpy(&compPrepared.data_[0], packedScene->GetData(compEntry.dataOffset_), compEntry.dataSize_);
+            }
+        }
+    }
+
+    return true;
+}
+
+Node* PreparedSubtree::CreateNode(unsigned index, Node* parent, SceneResolver& resolver, CreateMode mode, bool rewriteIDs) const
+{
+    const PreparedNode& prepared = nodes_[index];
+    Node* newNode = parent->CreateChild(rewriteIDs ? 0 : prepared.id_, mode);
+    resolver.AddNode(prepared.id_, newNode);
+    newNode->LoadValues(prepared.values_);
+
+    for (unsigned i = prepared.firstComponent_; i < prepared.firstComponent_ + prepared.numComponents_; ++i)
+    {
+        const PreparedComponent& compPrepared = components_[i];
+        Component* newComponent = newNode->SafeCreateComponent(compPrepared.typeName_, compPrepared.type_,
+            (mode == REPLICATED && compPrepared.id_ < FIRST_LOCAL_ID) ? REPLICATED : LOCAL, rewriteIDs ? 0 : compPrepared.id_);
+        if (newComponent)
+        {
+            resolver.AddComponent(compPrepared.id_, newComponent);
+            // Do not abort if component fails to load, as each component is described separately
+            if (compPrepared.decoded_)
+                newComponent->LoadValues(compPrepared.values_);
+            else
+            {
+                MemoryBuffer compData(compPrepared.data_);
+                newComponent->Load(compData);
+            }
+        }
+    }
+
+    return newNode;
+}
+
+void PreparedSubtree::LoadNode(unsigned index, Node* node, SceneResolver& resolver) const
+{
+    const PreparedNode& prepared = nodes_[index];
+    resolver.AddNode(prepared.id_, node);
+    node->LoadValues(prepared.values_);
+
+    const Vector<SharedPtr<Component> >& components = node->GetComponents();
+    for (unsigned i = 0; i < prepared.numComponents_ && i < components.Size(); ++i)
+    {
+        const PreparedComponent& compPrepared = components_[prepared.firstComponent_ + i];
+        Component* component = components[i];
+        resolver.AddComponent(compPrepared.id_, component);
+        if (compPrepared.decoded_)
+            component->LoadValues(compPrepared.values_);
+        else
+        {
+            MemoryBuffer compData(compPrepared.data_);
+            component->Load(compData);
+        }
+    }
+}
+
+AsyncSceneLoader::AsyncSceneLoader(Context* context) :
+    context_(context),
+    workQueue_(context->GetSubsystem<WorkQueue>()),
+    nextSubtree_(0),
+    cancelled_(false),
+    attachIndex_(0),
+    attachNode_(0)
+{
+}
+
+AsyncSceneLoader::~AsyncSceneLoader()
+{
+    Stop();
+}
+
+void AsyncSceneLoader::Start(File* file, unsigned numSubtrees)
+{
+    Stop();
+
+    file_ = file;
+    subtrees_.Resize(numSubtrees);
+    ready_.Resize(numSubtrees);
+    for (unsigned i = 0; i < numSubtrees; ++i)
+        ready_[i] = false;
+
+    // The file is read sequentially, so one work item decodes all the subtrees in order
+    cancelled_ = false;
+    AddWorkItem(DecodeFileWork);
+}
+
+void AsyncSceneLoader::Start(PackedScene* packedScene)
+{
+    Stop();
+
+    packedScene_ = packedScene;
+    packedRoots_.Clear();
+    for (unsigned i = 1; i < packedScene->GetNumNodes(); i = packedScene->GetNode(i).end_)
+        packedRoots_.Push(i);
+
+    subtrees_.Resize(packedRoots_.Size());
+    ready_.Resize(packedRoots_.Size());
+    for (unsigned i = 0; i < ready_.Size(); ++i)
+        ready_[i] = false;
+
+    // Subtrees have random access, so let each worker thread claim the next undecoded one
+    cancelled_ = false;
+    nextSubtree_ = 0;
+    unsigned numItems = Min(workQueue_->GetNumThreads(), packedRoots_.Size());
+    for (unsigned i = 0; i < numItems; ++i)
+        AddWorkItem(DecodePackedWork);
+}
+
+void AsyncSceneLoader::Stop()
+{
+    cancelled_ = true;
+
+    // Items that were not taken yet can be removed, the rest see the cancel flag and finish soon
+    for (unsigned i = 0; i < workItems_.Size(); ++i)
+    {
+        WorkItem* item = workItems_[i];
+        if (!workQueue_->RemoveWorkItem(workItems_[i]))
+        {
+            while (!item->completed_)
+                Time::Sleep(0);
+        }
+    }
+
+    workItems_.Clear();
+    file_.Reset();
+    packedScene_.Reset();
+    packedRoots_.Clear();
+    subtrees_.Clear();
+    ready_.Clear();
+    attachIndex_ = 0;
+    attachNode_ = 0;
+    attachedNodes_.Clear();
+}
+
+bool AsyncSceneLoader::Attach(Scene* scene, SceneResolver& resolver, HiresTimer& timer, long long maxUSec)
+{
+    if (attachIndex_ >= subtrees_.Size())
+        return false;
+
+    {
+        MutexLock lock(readyMutex_);
+        if (!ready_[attachIndex_])
+            return false;
+    }
+
+    PreparedSubtree& subtree = subtrees_[attachIndex_];
+    if (subtree.valid_)
+    {
+        while (attachNode_ < subtree.nodes_.Size())
+        {
+            const PreparedNode& prepared = subtree.nodes_[attachNode_];
+
+            // Skip the node if its parent has been removed in the meanwhile
+            Node* parent = prepared.parent_ == M_MAX_UNSIGNED ? scene : attachedNodes_[prepared.parent_].Get();
+            Node* newNode = parent ? subtree.CreateNode(attachNode_, parent, resolver,
+                prepared.id_ < FIRST_LOCAL_ID ? REPLICATED : LOCAL, false) : 0;
+
+            attachedNodes_.Push(WeakPtr<Node>(newNode));
+            ++attachNode_;
+
+            // Continue on the next call if out of time, attaching at least one node per call
+            if (attachNode_ < subtree.nodes_.Size() && timer.GetUSec(false) >= maxUSec)
+                return false;
+        }
+    }
+
+    // Free the description, the worker threads never touch a decoded subtree again
+    subtrees_[attachIndex_] = PreparedSubtree();
+    attachedNodes_.Clear();
+    attachNode_ = 0;
+    ++attachIndex_;
+    return true;
+}
+
+void AsyncSceneLoader::DecodeFileWork(const WorkItem* item, unsigned threadIndex)
+{
+    AsyncSceneLoader* loader = reinterpret_cast<AsyncSceneLoader*>(item->aux_);
+    File* file = loader->file_;
+
+    for (unsigned i = 0; i < loader->subtrees_.Size(); ++i)
+    {
+        if (loader->cancelled_)
+            return;
+
+        PreparedSubtree& subtree = loader->subtrees_[i];
+        subtree.valid_ = !file->IsEof() && subtree.Decode(loader->context_, *file, M_MAX_UNSIGNED, &loader->cancelled_);
+        if (!subtree.valid_)
+        {
+            // The stream position is lost, so the remaining subtrees can not be decoded either
+            if (!loader->cancelled_)
+                ATOMIC_LOGERROR("Failed to decode scene content from " + file->GetName());
+            for (unsigned j = i; j < loader->subtrees_.Size(); ++j)
+                loader->SetReady(j);
+            return;
+        }
+
+        loader->SetReady(i);
+    }
+}
+
+void AsyncSceneLoader::DecodePackedWork(const WorkItem* item, unsigned threadIndex)
+{
+    AsyncSceneLoader* loader = reinterpret_cast<AsyncSceneLoader*>(item->aux_);
+
+    while (!loader->cancelled_)
+    {
+        unsigned index = loader->nextSubtree_++;
+        if (index >= loader->subtrees_.Size())
+            return;
+
+        PreparedSubtree& subtree = loader->subtrees_[index];
+        subtree.valid_ = subtree.Decode(loader->context_, loader->packedScene_, loader->packedRoots_[index], &loader->cancelled_);
+        loader->SetReady(index);
+    }
+}
+
+void AsyncSceneLoader::SetReady(unsigned index)
+{
+    MutexLock lock(readyMutex_);
+    ready_[index] = true;
+}
+
+void AsyncSceneLoader::AddWorkItem(void (*workFunction)(const WorkItem*, unsigned))
+{
+    // Use low priority so that the main thread never waits for scene decoding when completing frame work
+    SharedPtr<WorkItem> item(new WorkItem());
+    item->workFunction_ = workFunction;
+    item->aux_ = this;
+    item->priority_ = 0;
+    workItems_.Push(item);
+    workQueue_->AddWorkItem(item);
+}
+
+}
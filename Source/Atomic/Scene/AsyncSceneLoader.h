@@ -0,0 +1,171 @@
+//
+// Copyright (c) 2014-2017 THUNDERBEAST GAMES LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "../Container/Ptr.h"
+#include "../Core/Mutex.h"
+#include "../Core/Variant.h"
+#include "../Scene/Node.h"
+
+#include <atomic>
+
+namespace Atomic
+{
+
+class Context;
+class Deserializer;
+class File;
+class HiresTimer;
+class PackedScene;
+class Scene;
+class SceneResolver;
+class WorkQueue;
+struct WorkItem;
+
+/// Component description decoded by a worker thread.
+struct PreparedComponent
+{
+    /// Component type hash.
+    StringHash type_;
+    /// Component type name, may be empty.
+    String typeName_;
+    /// Component ID.
+    unsigned id_;
+    /// Attribute values in file order.
+    VariantVector values_;
+    /// Undecoded attribute data for types without registered attributes.
+    PODVector<unsigned char> data_;
+    /// Whether the attributes were decoded into values.
+    bool decoded_;
+};
+
+/// Node description decoded by a worker thread.
+struct PreparedNode
+{
+    /// Node ID.
+    unsigned id_;
+    /// Parent node index within the subtree, M_MAX_UNSIGNED for the subtree root.
+    unsigned parent_;
+    /// Attribute values in file order.
+    VariantVector values_;
+    /// Index of the first component within the subtree.
+    unsigned firstComponent_;
+    /// Number of components.
+    unsigned numComponents_;
+};
+
+/// Detached description of a node with its children, in depth-first order. Can be decoded in any thread.
+struct ATOMIC_API PreparedSubtree
+{
+    /// Construct.
+    PreparedSubtree() :
+        valid_(false)
+    {
+    }
+
+    /// Decode a binary node with its ID, components and children and append it, stopping early if the cancel flag gets set. Return true if successful.
+    bool Decode(Context* context, Deserializer& source, unsigned parent = M_MAX_UNSIGNED, const std::atomic<bool>* cancelled = 0);
+    /// Decode the subtree starting at a packed scene node entry, stopping early if the cancel flag gets set. Return true if successful.
+    bool Decode(Context* context, const PackedScene* packedScene, unsigned index, const std::atomic<bool>* cancelled = 0);
+    /// Create a node under a parent and load its attributes and components. When rewriteIDs is set, the scene assigns new IDs. Return the node.
+    Node* CreateNode(unsigned index, Node* parent, SceneResolver& resolver, CreateMode mode, bool rewriteIDs) const;
+    /// Reload the attributes of an existing node and its components, which must match the description in number and order.
+    void LoadNode(unsigned index, Node* node, SceneResolver& resolver) const;
+
+    /// Nodes.
+    Vector<PreparedNode> nodes_;
+    /// Components.
+    Vector<PreparedComponent> components_;
+    /// Whether the subtree decoded successfully.
+    bool valid_;
+};
+
+/// Threaded part of asynchronous scene loading. Worker threads decode the root-level subtrees of a binary or packed scene
+/// into detached node and component descriptions, which the main thread then attaches to the scene under a time budget.
+class ATOMIC_API AsyncSceneLoader : public RefCounted
+{
+    ATOMIC_REFCOUNTED(AsyncSceneLoader)
+
+public:
+    /// Construct.
+    AsyncSceneLoader(Context* context);
+    /// Destruct. Stop the work items.
+    virtual ~AsyncSceneLoader();
+
+    /// Start decoding the root-level subtrees of a binary scene file from its current position. The file must not be accessed until Stop().
+    void Start(File* file, unsigned numSubtrees);
+    /// Start decoding the root-level subtrees of a packed scene, several at a time.
+    void Start(PackedScene* packedScene);
+    /// Cancel decoding and wait for the work items to finish.
+    void Stop();
+
+    /// Attach prepared nodes to the scene until a subtree is complete, the next subtree is not decoded yet, or the time budget runs out. Return true if a subtree was completed.
+    bool Attach(Scene* scene, SceneResolver& resolver, HiresTimer& timer, long long maxUSec);
+
+    /// Return number of root-level subtrees.
+    unsigned GetNumSubtrees() const { return subtrees_.Size(); }
+    /// Return number of subtrees attached so far.
+    unsigned GetNumAttached() const { return attachIndex_; }
+
+private:
+    /// Work item function for binary scene files.
+    static void DecodeFileWork(const WorkItem* item, unsigned threadIndex);
+    /// Work item function for packed scenes.
+    static void DecodePackedWork(const WorkItem* item, unsigned threadIndex);
+    /// Mark a subtree decoded.
+    void SetReady(unsigned index);
+    /// Add a work item to the work queue.
+    void AddWorkItem(void (*workFunction)(const WorkItem*, unsigned));
+
+    /// Context.
+    Context* context_;
+    /// Work queue.
+    WorkQueue* workQueue_;
+    /// Binary scene file.
+    SharedPtr<File> file_;
+    /// Packed scene.
+    SharedPtr<PackedScene> packedScene_;
+    /// Packed scene node index of each root-level subtree.
+    PODVector<unsigned> packedRoots_;
+    /// Work items.
+    Vector<SharedPtr<WorkItem> > workItems_;
+    /// Decoded subtrees.
+    Vector<PreparedSubtree> subtrees_;
+    /// Decoded flags of the subtrees.
+    PODVector<bool> ready_;
+    /// Mutex for the decoded flags.
+    Mutex readyMutex_;
+    /// Next subtree to claim for decoding.
+    std::atomic<unsigned> nextSubtree_;
+    /// Cancel flag.
+    std::atomic<bool> cancelled_;
+    /// Subtree being attached.
+    unsigned attachIndex_;
+    /// Next node to attach within the subtree.
+    unsigned attachNode_;
+    /// Nodes created so far within the subtree.
+    Vector<WeakPtr<Node> > attachedNodes_;
+};
+
+}
@@ -25,6 +25,9 @@
 #include "../Core/Context.h"
 #include "../Resource/JSONValue.h"
 #include "../Scene/Component.h"
+// ATOMIC BEGIN
+#include "../Scene/ReplicationFanout.h"
+// ATOMIC END
 #include "../Scene/ReplicationState.h"
 #include "../Scene/Scene.h"
 #include "../Scene/SceneEvents.h"
@@ -56,7 +59,10 @@ Component::Component(Context* context) :
     node_(0),
     id_(0),
     networkUpdate_(false),
-    enabled_(true)
+    enabled_(true),
+// ATOMIC BEGIN
+    sceneIndex_(M_MAX_UNSIGNED)
+// ATOMIC END
 {
 }
 
@@ -162,7 +168,17 @@ void Component::AddReplicationState(ComponentReplicationState* state)
     networkState_->replicationStates_.Push(state);
 }
 
-void Component::PrepareNetworkUpdate()
+// ATOMIC BEGIN
+void Component::RemoveReplicationState(ComponentReplicationState* state)
+{
+    if (networkState_)
+        networkState_->replicationStates_.Remove(state);
+}
+// ATOMIC END
+
+// ATOMIC BEGIN
+void Component::PrepareNetworkUpdate(ReplicationFanout* fanout)
+// ATOMIC END
 {
     if (!networkState_)
         AllocateNetworkState();
@@ -172,6 +188,9 @@ void Component::PrepareNetworkUpdate()
         return;
 
     unsigned numAttributes = attributes->Size();
+    // ATOMIC BEGIN
+    DirtyBits changedAttributes;
+    // ATOMIC END
 
     // Check for attribute changes
     for (unsigned i = 0; i < numAttributes; ++i)
@@ -183,9 +202,14 @@ void Component::PrepareNetworkUpdate()
 
         OnGetAttribute(attr, networkState_->currentValues_[i]);
 
-        if (networkState_->currentValues_[i] != networkState_->previousValues_[i])
+        // ATOMIC BEGIN
+        if (IsNetworkAttributeChanged(attr, networkState_->currentValues_[i], networkState_->previousValues_[i]))
+        // ATOMIC END
         {
             networkState_->previousValues_[i] = networkState_->currentValues_[i];
+            // ATOMIC BEGIN
+            changedAttributes.Set(i);
+            // ATOMIC END
 
             // Mark the attribute dirty in all replication states that are tracking this component
             for (PODVector<ReplicationState*>::Iterator j = networkState_->replicationStates_.Begin();
@@ -205,6 +229,12 @@ void Component::PrepareNetworkUpdate()
         }
     }
 
+    // ATOMIC BEGIN
+    // Serialize the changes once if several connections are going to send them
+    if (fanout && changedAttributes.Count() && networkState_->replicationStates_.Size() > 1)
+        fanout->Encode(this, changedAttributes);
+    // ATOMIC END
+
     networkUpdate_ = false;
 }
 
@@ -248,6 +278,12 @@ void Component::OnNodeSetEnabled(Node* node)
 {
 }
 
+// ATOMIC BEGIN
+void Component::OnReuse()
+{
+}
+// ATOMIC END
+
 void Component::SetID(unsigned id)
 {
     id_ = id;
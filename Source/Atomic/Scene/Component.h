@@ -30,6 +30,9 @@ namespace Atomic
 class DebugRenderer;
 class Node;
 class Scene;
+// ATOMIC BEGIN
+class ReplicationFanout;
+// ATOMIC END
 
 struct ComponentReplicationState;
 
@@ -48,6 +51,9 @@ class ATOMIC_API Component : public Animatable
 
     friend class Node;
     friend class Scene;
+    // ATOMIC BEGIN
+    friend class PrefabCache;
+    // ATOMIC END
 
 public:
     /// Construct.
@@ -101,8 +107,14 @@ public:
 
     /// Add a replication state that is tracking this component.
     void AddReplicationState(ComponentReplicationState* state);
-    /// Prepare network update by comparing attributes and marking replication states dirty as necessary.
-    void PrepareNetworkUpdate();
+    // ATOMIC BEGIN
+    /// Remove a replication state that no longer tracks this component.
+    void RemoveReplicationState(ComponentReplicationState* state);
+    // ATOMIC END
+    // ATOMIC BEGIN
+    /// Prepare network update by comparing attributes and marking replication states dirty as necessary. When a fan-out is given, also serialize the changes once for all connections.
+    void PrepareNetworkUpdate(ReplicationFanout* fanout = 0);
+    // ATOMIC END
     /// Clean up all references to a network connection that is about to be removed.
     void CleanupConnection(Connection* connection);
 
@@ -119,6 +131,10 @@ protected:
     virtual void OnMarkedDirty(Node* node);
     /// Handle scene node enabled status changing.
     virtual void OnNodeSetEnabled(Node* node);
+    // ATOMIC BEGIN
+    /// Handle being reused from a prefab instance pool, after the attributes were reset to the prefab's values. Reset any other per-instance state and restart as if newly created.
+    virtual void OnReuse();
+    // ATOMIC END
     /// Set ID. Called by Scene.
     void SetID(unsigned id);
     /// Set scene node. Called by Node when creating the component.
@@ -138,6 +154,10 @@ protected:
     bool networkUpdate_;
     /// Enabled flag.
     bool enabled_;
+    // ATOMIC BEGIN
+    /// Position in the scene lookup index, M_MAX_UNSIGNED if not indexed.
+    unsigned sceneIndex_;
+    // ATOMIC END
 };
 
 template <class T> T* Component::GetComponent() const { return static_cast<T*>(GetComponent(T::GetTypeStatic())); }
@@ -37,7 +37,12 @@ LogicComponent::LogicComponent(Context* context) :
     Component(context),
     updateEventMask_(USE_UPDATE | USE_POSTUPDATE | USE_FIXEDUPDATE | USE_FIXEDPOSTUPDATE),
     currentEventMask_(0),
-    delayedStartCalled_(false)
+    delayedStartCalled_(false),
+// ATOMIC BEGIN
+    parallelUpdate_(false),
+    parallelUpdateScene_(0),
+    parallelUpdateIndex_(M_MAX_UNSIGNED)
+// ATOMIC END
 {
 }
 
@@ -75,6 +80,17 @@ void LogicComponent::SetUpdateEventMask(unsigned char mask)
     }
 }
 
+// ATOMIC BEGIN
+void LogicComponent::SetParallelUpdate(bool enable)
+{
+    if (parallelUpdate_ != enable)
+    {
+        parallelUpdate_ = enable;
+        UpdateEventSubscription();
+    }
+}
+// ATOMIC END
+
 void LogicComponent::OnNodeSet(Node* node)
 {
     if (node)
@@ -95,6 +111,10 @@ void LogicComponent::OnSceneSet(Scene* scene)
         UpdateEventSubscription();
     else
     {
+        // ATOMIC BEGIN
+        if (parallelUpdateScene_)
+            parallelUpdateScene_->RemoveParallelUpdate(this);
+        // ATOMIC END
         UnsubscribeFromEvent(E_SCENEUPDATE);
         UnsubscribeFromEvent(E_SCENEPOSTUPDATE);
 #if defined(ATOMIC_PHYSICS) || defined(ATOMIC_ATOMIC2D)
@@ -105,6 +125,15 @@ void LogicComponent::OnSceneSet(Scene* scene)
     }
 }
 
+// ATOMIC BEGIN
+void LogicComponent::OnReuse()
+{
+    delayedStartCalled_ = false;
+    Start();
+    UpdateEventSubscription();
+}
+// ATOMIC END
+
 void LogicComponent::UpdateEventSubscription()
 {
     Scene* scene = GetScene();
@@ -114,9 +143,19 @@ void LogicComponent::UpdateEventSubscription()
     bool enabled = IsEnabledEffective();
 
     bool needUpdate = enabled && ((updateEventMask_ & USE_UPDATE) || !delayedStartCalled_);
+
+    // ATOMIC BEGIN
+    // The parallel update phase takes over the update event, including the delayed start
+    bool needParallelUpdate = needUpdate && parallelUpdate_;
+    if (needParallelUpdate && !parallelUpdateScene_)
+        scene->AddParallelUpdate(this);
+    else if (!needParallelUpdate && parallelUpdateScene_)
+        parallelUpdateScene_->RemoveParallelUpdate(this);
+    needUpdate = needUpdate && !parallelUpdate_;
+    // ATOMIC END
     if (needUpdate && !(currentEventMask_ & USE_UPDATE))
     {
-        SubscribeToEvent(scene, E_SCENEUPDATE, ATOMIC_HANDLER(LogicComponent, HandleSceneUpdate));
+        SubscribeToEvent(scene, E_SCENEUPDATE, ATOMIC_PAYLOAD_HANDLER(LogicComponent, SceneUpdateEventPayload, HandleSceneUpdate));
         currentEventMask_ |= USE_UPDATE;
     }
     else if (!needUpdate && (currentEventMask_ & USE_UPDATE))
@@ -128,7 +167,7 @@ void LogicComponent::UpdateEventSubscription()
     bool needPostUpdate = enabled && (updateEventMask_ & USE_POSTUPDATE);
     if (needPostUpdate && !(currentEventMask_ & USE_POSTUPDATE))
     {
-        SubscribeToEvent(scene, E_SCENEPOSTUPDATE, ATOMIC_HANDLER(LogicComponent, HandleScenePostUpdate));
+        SubscribeToEvent(scene, E_SCENEPOSTUPDATE, ATOMIC_PAYLOAD_HANDLER(LogicComponent, SceneUpdateEventPayload, HandleScenePostUpdate));
         currentEventMask_ |= USE_POSTUPDATE;
     }
     else if (!needPostUpdate && (currentEventMask_ & USE_POSTUPDATE))
@@ -168,10 +207,9 @@ void LogicComponent::UpdateEventSubscription()
 #endif
 }
 
-void LogicComponent::HandleSceneUpdate(StringHash eventType, VariantMap& eventData)
+// ATOMIC BEGIN
+void LogicComponent::HandleSceneUpdate(StringHash eventType, const SceneUpdateEventPayload& payload)
 {
-    using namespace SceneUpdate;
-
     // Execute user-defined delayed start function before first update
     if (!delayedStartCalled_)
     {
@@ -188,16 +226,15 @@ void LogicComponent::HandleSceneUpdate(StringHash eventType, VariantMap& eventDa
     }
 
     // Then execute user-defined update function
-    Update(eventData[P_TIMESTEP].GetFloat());
+    Update(payload.timeStep_);
 }
 
-void LogicComponent::HandleScenePostUpdate(StringHash eventType, VariantMap& eventData)
+void LogicComponent::HandleScenePostUpdate(StringHash eventType, const SceneUpdateEventPayload& payload)
 {
-    using namespace ScenePostUpdate;
-
     // Execute user-defined post-update function
-    PostUpdate(eventData[P_TIMESTEP].GetFloat());
+    PostUpdate(payload.timeStep_);
 }
+// ATOMIC END
 
 #if defined(ATOMIC_PHYSICS) || defined(ATOMIC_ATOMIC2D)
 
@@ -23,6 +23,9 @@
 #pragma once
 
 #include "../Scene/Component.h"
+// ATOMIC BEGIN
+#include "../Scene/SceneEvents.h"
+// ATOMIC END
 
 namespace Atomic
 {
@@ -41,6 +44,10 @@ class ATOMIC_API LogicComponent : public Component
 {
     ATOMIC_OBJECT(LogicComponent, Component);
 
+    // ATOMIC BEGIN
+    friend class Scene;
+    // ATOMIC END
+
     /// Construct.
     LogicComponent(Context* context);
     /// Destruct.
@@ -76,19 +83,32 @@ class ATOMIC_API LogicComponent : public Component
     /// Return whether the DelayedStart() function has been called.
     bool IsDelayedStartCalled() const { return delayedStartCalled_; }
 
+    // ATOMIC BEGIN
+    /// Set whether Update() runs in worker threads, in parallel with other opted-in components, right after the scene update event. Update() must then only modify its own node and components, and defer anything else with Scene::DelayedCall(). Sending events is not possible. Listener components of the moved nodes are notified in the worker thread too, and must defer work that is not thread-safe with Scene::DelayedMarkedDirty() like the built-in ones do. DelayedStart() and the other update functions still run on the main thread. Like the update event mask, this is not an attribute.
+    void SetParallelUpdate(bool enable);
+    /// Return whether Update() runs in worker threads.
+    bool GetParallelUpdate() const { return parallelUpdate_; }
+    // ATOMIC END
+
 protected:
     /// Handle scene node being assigned at creation.
     virtual void OnNodeSet(Node* node);
     /// Handle scene being assigned.
     virtual void OnSceneSet(Scene* scene);
+    // ATOMIC BEGIN
+    /// Handle being reused from a prefab instance pool. Runs Start() again, and DelayedStart() before the next update.
+    virtual void OnReuse();
+    // ATOMIC END
 
 private:
     /// Subscribe/unsubscribe to update events based on current enabled state and update event mask.
     void UpdateEventSubscription();
+    // ATOMIC BEGIN
     /// Handle scene update event.
-    void HandleSceneUpdate(StringHash eventType, VariantMap& eventData);
+    void HandleSceneUpdate(StringHash eventType, const SceneUpdateEventPayload& payload);
     /// Handle scene post-update event.
-    void HandleScenePostUpdate(StringHash eventType, VariantMap& eventData);
+    void HandleScenePostUpdate(StringHash eventType, const SceneUpdateEventPayload& payload);
+    // ATOMIC END
 #if defined(ATOMIC_PHYSICS) || defined(ATOMIC_ATOMIC2D)
     /// Handle physics pre-step event.
     void HandlePhysicsPreStep(StringHash eventType, VariantMap& eventData);
@@ -101,6 +121,14 @@ private:
     unsigned char currentEventMask_;
     /// Flag for delayed start.
     bool delayedStartCalled_;
+    // ATOMIC BEGIN
+    /// Parallel update requested flag.
+    bool parallelUpdate_;
+    /// Scene whose parallel update phase the component is in, or null.
+    Scene* parallelUpdateScene_;
+    /// Position in the scene's parallel update phase.
+    unsigned parallelUpdateIndex_;
+    // ATOMIC END
 };
 
 }
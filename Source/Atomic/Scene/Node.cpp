@@ -30,9 +30,15 @@
 #include "../Resource/JSONFile.h"
 #include "../Scene/Component.h"
 #include "../Scene/ObjectAnimation.h"
+// ATOMIC BEGIN
+#include "../Scene/ReplicationFanout.h"
+// ATOMIC END
 #include "../Scene/ReplicationState.h"
 #include "../Scene/Scene.h"
 #include "../Scene/SceneEvents.h"
+// ATOMIC BEGIN
+#include "../Scene/SceneTransforms.h"
+// ATOMIC END
 #include "../Scene/SmoothedTransform.h"
 #include "../Scene/UnknownComponent.h"
 
@@ -45,6 +51,11 @@
 namespace Atomic
 {
 
+// ATOMIC BEGIN
+/// Bits per component of the replicated rotation, about the precision of a quaternion packed in 16-bit components.
+static const unsigned NET_ROTATION_BITS = 15;
+// ATOMIC END
+
 Node::Node(Context* context) :
     Animatable(context),
     worldTransform_(Matrix3x4::IDENTITY),
@@ -62,6 +73,11 @@ Node::Node(Context* context) :
 {
     impl_ = new NodeImpl();
     impl_->owner_ = 0;
+    // ATOMIC BEGIN
+    impl_->sceneIndex_ = M_MAX_UNSIGNED;
+    impl_->transformIndex_ = M_MAX_UNSIGNED;
+    impl_->transformLevel_ = 0;
+    // ATOMIC END
 }
 
 Node::~Node()
@@ -87,10 +103,15 @@ void Node::RegisterObject(Context* context)
     ATOMIC_ATTRIBUTE("Variables", VariantMap, vars_, Variant::emptyVariantMap, AM_FILE); // Network replication of vars uses custom data
     ATOMIC_ACCESSOR_ATTRIBUTE("Network Position", GetNetPositionAttr, SetNetPositionAttr, Vector3, Vector3::ZERO,
         AM_NET | AM_LATESTDATA | AM_NOEDIT);
-    ATOMIC_ACCESSOR_ATTRIBUTE("Network Rotation", GetNetRotationAttr, SetNetRotationAttr, PODVector<unsigned char>, Variant::emptyBuffer,
+    // ATOMIC BEGIN
+    ATOMIC_ACCESSOR_ATTRIBUTE("Network Rotation", GetNetRotationAttr, SetNetRotationAttr, Quaternion, Quaternion::IDENTITY,
         AM_NET | AM_LATESTDATA | AM_NOEDIT);
+    // ATOMIC END
     ATOMIC_ACCESSOR_ATTRIBUTE("Network Parent Node", GetNetParentAttr, SetNetParentAttr, PODVector<unsigned char>, Variant::emptyBuffer,
         AM_NET | AM_NOEDIT);
+    // ATOMIC BEGIN
+    ATOMIC_ATTRIBUTE_NET_ENCODING("Network Rotation", AttributeNetEncoding(NET_ENCODING_SMALLEST_THREE, NET_ROTATION_BITS));
+    // ATOMIC END
 }
 
 bool Node::Load(Deserializer& source, bool setInstanceDefault)
@@ -307,6 +328,14 @@ void Node::AddReplicationState(NodeReplicationState* state)
     networkState_->replicationStates_.Push(state);
 }
 
+// ATOMIC BEGIN
+void Node::RemoveReplicationState(NodeReplicationState* state)
+{
+    if (networkState_)
+        networkState_->replicationStates_.Remove(state);
+}
+// ATOMIC END
+
 bool Node::SaveXML(Serializer& dest, const String& indentation) const
 {
     SharedPtr<XMLFile> xml(new XMLFile(context_));
@@ -332,9 +361,18 @@ void Node::SetName(const String& name)
 {
     if (name != impl_->name_)
     {
+        // ATOMIC BEGIN
+        StringHash oldNameHash = impl_->nameHash_;
+        // ATOMIC END
+
         impl_->name_ = name;
         impl_->nameHash_ = name;
 
+        // ATOMIC BEGIN
+        if (scene_)
+            scene_->NodeNameChanged(this, oldNameHash);
+        // ATOMIC END
+
         MarkNetworkUpdate();
 
         // Send change event
@@ -747,6 +785,16 @@ void Node::MarkDirty()
     Node *cur = this;
     for (;;)
     {
+        // ATOMIC BEGIN
+        // With transform batching the scene propagates the flag through its depth level arrays instead
+        if (cur->impl_->transformIndex_ != M_MAX_UNSIGNED && cur->scene_ && cur->scene_->GetTransforms())
+        {
+            if (!cur->dirty_)
+                cur->scene_->GetTransforms()->MarkDirty(cur);
+            return;
+        }
+        // ATOMIC END
+
         // Precondition:
         // a) whenever a node is marked dirty, all its children are marked dirty as well.
         // b) whenever a node is cleared from being dirty, all its parents must have been
@@ -759,21 +807,9 @@ void Node::MarkDirty()
         cur->dirty_ = true;
 
         // Notify listener components first, then mark child nodes
-        for (Vector<WeakPtr<Component> >::Iterator i = cur->listeners_.Begin(); i != cur->listeners_.End();)
-        {
-            Component *c = *i;
-            if (c)
-            {
-                c->OnMarkedDirty(cur);
-                ++i;
-            }
-            // If listener has expired, erase from list (swap with the last element to avoid O(n^2) behavior)
-            else
-            {
-                *i = cur->listeners_.Back();
-                cur->listeners_.Pop();
-            }
-        }
+        // ATOMIC BEGIN
+        cur->NotifyListeners();
+        // ATOMIC END
 
         // Tail call optimization: Don't recurse to mark the first child dirty, but
         // instead process it in the context of the current function. If there are more
@@ -833,6 +869,11 @@ void Node::AddChild(Node* node, unsigned index)
                 eventData[P_NODE] = node;
 
                 scene_->SendEvent(E_NODEREMOVED, eventData);
+
+                // ATOMIC BEGIN
+                if (scene_->GetTransforms())
+                    scene_->GetTransforms()->RemoveNode(node);
+                // ATOMIC END
             }
 
             oldParent->children_.Remove(nodeShared);
@@ -845,6 +886,10 @@ void Node::AddChild(Node* node, unsigned index)
         scene_->NodeAdded(node);
 
     node->parent_ = this;
+    // ATOMIC BEGIN
+    if (scene_ && scene_->GetTransforms())
+        scene_->GetTransforms()->AddNode(node);
+    // ATOMIC END
     node->MarkDirty();
     node->MarkNetworkUpdate();
     // If the child node has components, also mark network update on them to ensure they have a valid NetworkState
@@ -1274,6 +1319,19 @@ void Node::GetChildrenWithComponent(PODVector<Node*>& dest, StringHash type, boo
                 dest.Push(*i);
         }
     }
+    // ATOMIC BEGIN
+    else if (this == scene_ && scene_->IsIndexingEnabled())
+    {
+        const PODVector<Component*>& components = scene_->GetComponentsOfType(type);
+        for (PODVector<Component*>::ConstIterator i = components.Begin(); i != components.End(); ++i)
+        {
+            Node* node = (*i)->GetNode();
+            // Only the first component of the type on a node adds it, so that each node is returned once
+            if (node && node != this && node->GetComponent(type) == *i)
+                dest.Push(node);
+        }
+    }
+    // ATOMIC END
     else
         GetChildrenWithComponentRecursive(dest, type);
 }
@@ -1325,6 +1383,20 @@ Node* Node::GetChild(const char* name, bool recursive) const
 
 Node* Node::GetChild(StringHash nameHash, bool recursive) const
 {
+    // ATOMIC BEGIN
+    if (recursive && this == scene_ && scene_->IsIndexingEnabled() && nameHash != StringHash::ZERO)
+    {
+        const PODVector<Node*>& nodes = scene_->GetNodesWithName(nameHash);
+        for (PODVector<Node*>::ConstIterator i = nodes.Begin(); i != nodes.End(); ++i)
+        {
+            if (*i != this)
+                return *i;
+        }
+
+        return 0;
+    }
+    // ATOMIC END
+
     for (Vector<SharedPtr<Node> >::ConstIterator i = children_.Begin(); i != children_.End(); ++i)
     {
         if ((*i)->GetNameHash() == nameHash)
@@ -1369,6 +1441,8 @@ void Node::GetComponents(PODVector<Component*>& dest, StringHash type, bool recu
                 dest.Push(*i);
         }
     }
+    else if (!all && this == scene_ && scene_->IsIndexingEnabled())
+        dest = scene_->GetComponentsOfType(type);
     else
         GetComponentsRecursive(dest, type);
 
@@ -1417,6 +1491,14 @@ Component* Node::GetComponent(StringHash type, bool recursive) const
             return *i;
     }
 
+    // ATOMIC BEGIN
+    if (recursive && this == scene_ && scene_->IsIndexingEnabled())
+    {
+        const PODVector<Component*>& components = scene_->GetComponentsOfType(type);
+        return components.Size() ? components[0] : 0;
+    }
+    // ATOMIC END
+
     if (recursive)
     {
         for (Vector<SharedPtr<Node> >::ConstIterator i = children_.Begin(); i != children_.End(); ++i)
@@ -1473,15 +1555,16 @@ void Node::SetNetPositionAttr(const Vector3& value)
         SetPosition(value);
 }
 
-void Node::SetNetRotationAttr(const PODVector<unsigned char>& value)
+// ATOMIC BEGIN
+void Node::SetNetRotationAttr(const Quaternion& value)
 {
-    MemoryBuffer buf(value);
     SmoothedTransform* transform = GetComponent<SmoothedTransform>();
     if (transform)
-        transform->SetTargetRotation(buf.ReadPackedQuaternion());
+        transform->SetTargetRotation(value);
     else
-        SetRotation(buf.ReadPackedQuaternion());
+        SetRotation(value);
 }
+// ATOMIC END
 
 void Node::SetNetParentAttr(const PODVector<unsigned char>& value)
 {
@@ -1525,12 +1608,12 @@ const Vector3& Node::GetNetPositionAttr() const
     return position_;
 }
 
-const PODVector<unsigned char>& Node::GetNetRotationAttr() const
+// ATOMIC BEGIN
+const Quaternion& Node::GetNetRotationAttr() const
 {
-    impl_->attrBuffer_.Clear();
-    impl_->attrBuffer_.WritePackedQuaternion(rotation_);
-    return impl_->attrBuffer_.GetBuffer();
+    return rotation_;
 }
+// ATOMIC END
 
 const PODVector<unsigned char>& Node::GetNetParentAttr() const
 {
@@ -1695,7 +1778,9 @@ bool Node::LoadJSON(const JSONValue& source, SceneResolver& resolver, bool readC
     return true;
 }
 
-void Node::PrepareNetworkUpdate()
+// ATOMIC BEGIN
+void Node::PrepareNetworkUpdate(ReplicationFanout* fanout)
+// ATOMIC END
 {
     // Update dependency nodes list first
     impl_->dependencyNodes_.Clear();
@@ -1724,6 +1809,9 @@ void Node::PrepareNetworkUpdate()
 
     const Vector<AttributeInfo>* attributes = networkState_->attributes_;
     unsigned numAttributes = attributes->Size();
+    // ATOMIC BEGIN
+    DirtyBits changedAttributes;
+    // ATOMIC END
 
     // Check for attribute changes
     for (unsigned i = 0; i < numAttributes; ++i)
@@ -1735,9 +1823,14 @@ void Node::PrepareNetworkUpdate()
 
         OnGetAttribute(attr, networkState_->currentValues_[i]);
 
-        if (networkState_->currentValues_[i] != networkState_->previousValues_[i])
+        // ATOMIC BEGIN
+        if (IsNetworkAttributeChanged(attr, networkState_->currentValues_[i], networkState_->previousValues_[i]))
+        // ATOMIC END
         {
             networkState_->previousValues_[i] = networkState_->currentValues_[i];
+            // ATOMIC BEGIN
+            changedAttributes.Set(i);
+            // ATOMIC END
 
             // Mark the attribute dirty in all replication states that are tracking this node
             for (PODVector<ReplicationState*>::Iterator j = networkState_->replicationStates_.Begin();
@@ -1756,6 +1849,12 @@ void Node::PrepareNetworkUpdate()
         }
     }
 
+    // ATOMIC BEGIN
+    // Serialize the changes once if several connections are going to send them
+    if (fanout && changedAttributes.Count() && networkState_->replicationStates_.Size() > 1)
+        fanout->Encode(this, changedAttributes);
+    // ATOMIC END
+
     // Finally check for user var changes
     for (VariantMap::ConstIterator i = vars_.Begin(); i != vars_.End(); ++i)
     {
@@ -2099,6 +2198,25 @@ Component* Node::SafeCreateComponent(const String& typeName, StringHash type, Cr
     }
 }
 
+void Node::NotifyListeners()
+{
+    for (Vector<WeakPtr<Component> >::Iterator i = listeners_.Begin(); i != listeners_.End();)
+    {
+        Component *c = *i;
+        if (c)
+        {
+            c->OnMarkedDirty(this);
+            ++i;
+        }
+        // If listener has expired, erase from list (swap with the last element to avoid O(n^2) behavior)
+        else
+        {
+            *i = listeners_.Back();
+            listeners_.Pop();
+        }
+    }
+}
+
 // ATOMIC END
 
 void Node::UpdateWorldTransform() const
@@ -2311,6 +2429,15 @@ void Node::GetChildrenWithName(PODVector<Node*>& dest, StringHash nameHash, bool
                 dest.Push(*i);
         }
     }
+    else if (this == scene_ && scene_->IsIndexingEnabled() && nameHash != StringHash::ZERO)
+    {
+        const PODVector<Node*>& nodes = scene_->GetNodesWithName(nameHash);
+        for (PODVector<Node*>::ConstIterator i = nodes.Begin(); i != nodes.End(); ++i)
+        {
+            if (*i != this)
+                dest.Push(*i);
+        }
+    }
     else
         GetChildrenWithNameRecursive(dest, nameHash);
 }
@@ -34,6 +34,9 @@ class Connection;
 class Node;
 class Scene;
 class SceneResolver;
+// ATOMIC BEGIN
+class ReplicationFanout;
+// ATOMIC END
 
 struct NodeReplicationState;
 
@@ -67,6 +70,14 @@ struct ATOMIC_API NodeImpl
     StringHash nameHash_;
     /// Attribute buffer for network updates.
     mutable VectorBuffer attrBuffer_;
+    // ATOMIC BEGIN
+    /// Position in the scene lookup index by name, M_MAX_UNSIGNED if not indexed.
+    unsigned sceneIndex_;
+    /// Position in the scene batched transform arrays, M_MAX_UNSIGNED if not assigned.
+    unsigned transformIndex_;
+    /// Depth level in the scene batched transform arrays, valid while assigned.
+    unsigned transformLevel_;
+    // ATOMIC END
 };
 
 /// %Scene node that may contain components and child nodes.
@@ -75,6 +86,12 @@ class ATOMIC_API Node : public Animatable
     ATOMIC_OBJECT(Node, Animatable);
 
     friend class Connection;
+    // ATOMIC BEGIN
+    friend class Scene;
+    friend class SceneTransforms;
+    friend class PackedScene;
+    friend struct PreparedSubtree;
+    // ATOMIC END
 
 public:
     /// Construct.
@@ -106,6 +123,10 @@ public:
     virtual void MarkNetworkUpdate();
     /// Add a replication state that is tracking this node.
     virtual void AddReplicationState(NodeReplicationState* state);
+    // ATOMIC BEGIN
+    /// Remove a replication state that no longer tracks this node.
+    void RemoveReplicationState(NodeReplicationState* state);
+    // ATOMIC END
 
     /// Save to an XML file. Return true if successful.
     bool SaveXML(Serializer& dest, const String& indentation = "\t") const;
@@ -578,14 +599,18 @@ public:
     void ResetScene();
     /// Set network position attribute.
     void SetNetPositionAttr(const Vector3& value);
+    // ATOMIC BEGIN
     /// Set network rotation attribute.
-    void SetNetRotationAttr(const PODVector<unsigned char>& value);
+    void SetNetRotationAttr(const Quaternion& value);
+    // ATOMIC END
     /// Set network parent attribute.
     void SetNetParentAttr(const PODVector<unsigned char>& value);
     /// Return network position attribute.
     const Vector3& GetNetPositionAttr() const;
+    // ATOMIC BEGIN
     /// Return network rotation attribute.
-    const PODVector<unsigned char>& GetNetRotationAttr() const;
+    const Quaternion& GetNetRotationAttr() const;
+    // ATOMIC END
     /// Return network parent attribute.
     const PODVector<unsigned char>& GetNetParentAttr() const;
     /// Load components and optionally load child nodes.
@@ -600,8 +625,10 @@ public:
     /// Return the depended on nodes to order network updates.
     const PODVector<Node*>& GetDependencyNodes() const { return impl_->dependencyNodes_; }
 
-    /// Prepare network update by comparing attributes and marking replication states dirty as necessary.
-    void PrepareNetworkUpdate();
+    // ATOMIC BEGIN
+    /// Prepare network update by comparing attributes and marking replication states dirty as necessary. When a fan-out is given, also serialize the changes once for all connections.
+    void PrepareNetworkUpdate(ReplicationFanout* fanout = 0);
+    // ATOMIC END
     /// Clean up all references to a network connection that is about to be removed.
     void CleanupConnection(Connection* connection);
     /// Mark node dirty in scene replication states.
@@ -685,6 +712,8 @@ private:
 // ATOMIC BEGIN
     /// Create component, allowing UnknownComponent if actual type is not supported. Leave typeName empty if not known.
     Component* SafeCreateComponent(const String& typeName, StringHash type, CreateMode mode, unsigned id, const XMLElement& source = XMLElement::EMPTY);
+    /// Notify listener components that the world transform is dirty, erasing expired listeners.
+    void NotifyListeners();
 // ATOMIC END
 
     /// Recalculate the world transform.
@@ -0,0 +1,327 @@
+//
+// Copyright (c) 2014-2017 THUNDERBEAST GAMES LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../Precompiled.h"
+
+#include "../Core/Profiler.h"
+#include "../IO/File.h"
+#include "../IO/Log.h"
+#include "../IO/MemoryBuffer.h"
+#include "../IO/VectorBuffer.h"
+#include "../Scene/Component.h"
+#include "../Scene/Scene.h"
+#include "../Scene/PackedScene.h"
+#include "../Scene/SceneResolver.h"
+
+#include "../DebugNew.h"
+
+namespace Atomic
+{
+
+const char* PACKED_SCENE_ID = "ASCN";
+
+/// Collect persistent nodes depth-first and write their attribute and component data.
+static bool CollectPackedNodes(const Node* node, unsigned parent, PODVector<PackedNodeEntry>& nodes,
+    PODVector<PackedComponentEntry>& components, Vector<String>& strings, HashMap<StringHash, unsigned>& stringIndices,
+    VectorBuffer& data)
+{
+    unsigned index = nodes.Size();
+
+    PackedNodeEntry entry;
+    entry.id_ = node->GetID();
+    entry.parent_ = parent;
+    entry.firstComponent_ = components.Size();
+    entry.numComponents_ = 0;
+    entry.dataOffset_ = data.GetPosition();
+    if (!node->Animatable::Save(data))
+        return false;
+    entry.dataSize_ = data.GetPosition() - entry.dataOffset_;
+
+    const Vector<SharedPtr<Component> >& nodeComponents = node->GetComponents();
+    for (unsigned i = 0; i < nodeComponents.Size(); ++i)
+    {
+        Component* component = nodeComponents[i];
+        if (component->IsTemporary())
+            continue;
+
+        // Component::Save() writes the type and ID before the attributes; keep only the attributes in the blob
+        VectorBuffer compBuffer;
+        if (!component->Save(compBuffer))
+            return false;
+        compBuffer.Seek(0);
+        compBuffer.ReadStringHash();
+        compBuffer.ReadUInt();
+        unsigned attrStart = compBuffer.GetPosition();
+
+        const String& typeName = component->GetTypeName();
+        StringHash typeNameHash(typeName);
+        HashMap<StringHash, unsigned>::ConstIterator stringIt = stringIndices.Find(typeNameHash);
+        if (stringIt == stringIndices.End())
+        {
+            stringIt = stringIndices.Insert(MakePair(typeNameHash, strings.Size()));
+            strings.Push(typeName);
+        }
+
+        PackedComponentEntry compEntry;
+        compEntry.type_ = component->GetType().Value();
+        compEntry.typeName_ = stringIt->second_;
+        compEntry.id_ = component->GetID();
+        compEntry.dataOffset_ = data.GetPosition();
+        compEntry.dataSize_ = compBuffer.GetSize() - attrStart;
+        data.Write(compBuffer.GetData() + attrStart, compEntry.dataSize_);
+
+        components.Push(compEntry);
+        ++entry.numComponents_;
+    }
+
+    nodes.Push(entry);
+
+    const Vector<SharedPtr<Node> >& children = node->GetChildren();
+    for (unsigned i = 0; i < children.Size(); ++i)
+    {
+        if (children[i]->IsTemporary())
+            continue;
+        if (!CollectPackedNodes(children[i], index, nodes, components, strings, stringIndices, data))
+            return false;
+    }
+
+    nodes[index].end_ = nodes.Size();
+    return true;
+}
+
+PackedScene::PackedScene() :
+    header_(0),
+    nodes_(0),
+    components_(0),
+    strings_(0)
+{
+}
+
+PackedScene::~PackedScene()
+{
+}
+
+bool PackedScene::Open(File* file)
+{
+    if (!file)
+        return false;
+
+    file_ = new MappedFile();
+    return file_->Open(file) && Validate(file->GetName());
+}
+
+bool PackedScene::Open(Deserializer& source)
+{
+    file_ = new MappedFile();
+    return file_->Open(source) && Validate(source.GetName());
+}
+
+bool PackedScene::Save(Serializer& dest, const Node* root)
+{
+    ATOMIC_PROFILE(SavePackedScene);
+
+    if (!root)
+        return false;
+
+    PODVector<PackedNodeEntry> nodes;
+    PODVector<PackedComponentEntry> components;
+    Vector<String> strings;
+    HashMap<StringHash, unsigned> stringIndices;
+    VectorBuffer data;
+
+    if (!CollectPackedNodes(root, M_MAX_UNSIGNED, nodes, components, strings, stringIndices, data))
+        return false;
+
+    // The string characters go to the end of the data area
+    PODVector<unsigned> stringOffsets;
+    for (unsigned i = 0; i < strings.Size(); ++i)
+    {
+        stringOffsets.Push(data.GetPosition());
+        data.Write(strings[i].CString(), strings[i].Length() + 1);
+    }
+
+    PackedSceneHeader header;
+    header.version_ = PACKED_SCENE_VERSION;
+    header.numNodes_ = nodes.Size();
+    header.numComponents_ = components.Size();
+    header.numStrings_ = strings.Size();
+    header.nodeOffset_ = 4 + sizeof(PackedSceneHeader);
+    header.componentOffset_ = header.nodeOffset_ + nodes.Size() * sizeof(PackedNodeEntry);
+    header.stringOffset_ = header.componentOffset_ + components.Size() * sizeof(PackedComponentEntry);
+    unsigned dataOffset = header.stringOffset_ + strings.Size() * sizeof(unsigned);
+
+    // Make the data offsets absolute
+    for (unsigned i = 0; i < nodes.Size(); ++i)
+        nodes[i].dataOffset_ += dataOffset;
+    for (unsigned i = 0; i < components.Size(); ++i)
+        components[i].dataOffset_ += dataOffset;
+    for (unsigned i = 0; i < stringOffsets.Size(); ++i)
+        stringOffsets[i] += dataOffset;
+
+    bool success = dest.WriteFileID(PACKED_SCENE_ID);
+    success &= dest.Write(&header, sizeof header) == sizeof header;
+    if (nodes.Size())
+        success &= dest.Write(&nodes[0], nodes.Size() * sizeof(PackedNodeEntry)) == nodes.Size() * sizeof(PackedNodeEntry);
+    if (components.Size())
+    {
+        success &= dest.Write(&components[0], components.Size() * sizeof(PackedComponentEntry)) ==
+            components.Size() * sizeof(PackedComponentEntry);
+    }
+    if (stringOffsets.Size())
+        success &= dest.Write(&stringOffsets[0], stringOffsets.Size() * sizeof(unsigned)) == stringOffsets.Size() * sizeof(unsigned);
+    success &= dest.Write(data.GetData(), data.GetSize()) == data.GetSize();
+
+    if (!success)
+        ATOMIC_LOGERROR("Could not save packed scene, writing to stream failed");
+    return success;
+}
+
+bool PackedScene::LoadNode(Node* node, unsigned index, SceneResolver& resolver, bool setInstanceDefault) const
+{
+    const PackedNodeEntry& entry = nodes_[index];
+
+    node->RemoveAllChildren();
+    node->RemoveAllComponents();
+
+    MemoryBuffer nodeData(GetData(entry.dataOffset_), entry.dataSize_);
+    if (!node->Animatable::Load(nodeData, setInstanceDefault))
+        return false;
+
+    for (unsigned i = entry.firstComponent_; i < entry.firstComponent_ + entry.numComponents_; ++i)
+    {
+        const PackedComponentEntry& compEntry = components_[i];
+        Component* newComponent = node->SafeCreateComponent(GetString(compEntry.typeName_), StringHash(compEntry.type_),
+            compEntry.id_ < FIRST_LOCAL_ID ? REPLICATED : LOCAL, compEntry.id_);
+        if (newComponent)
+        {
+            resolver.AddComponent(compEntry.id_, newComponent);
+            // Do not abort if component fails to load, as each component has its own blob
+            MemoryBuffer compData(GetData(compEntry.dataOffset_), compEntry.dataSize_);
+            newComponent->Load(compData);
+        }
+    }
+
+    return true;
+}
+
+bool PackedScene::LoadSubtree(Node* parent, unsigned index, SceneResolver& resolver) const
+{
+    if (!index || index >= GetNumNodes())
+        return false;
+
+    // The subtree is contiguous and every parent precedes its children, so nodes can be created in one linear pass
+    unsigned end = nodes_[index].end_;
+    PODVector<Node*> created(end - index);
+
+    for (unsigned i = index; i < end; ++i)
+    {
+        const PackedNodeEntry& entry = nodes_[i];
+        Node* nodeParent = i == index ? parent : created[entry.parent_ - index];
+        Node* newNode = nodeParent->CreateChild(entry.id_, entry.id_ < FIRST_LOCAL_ID ? REPLICATED : LOCAL);
+        resolver.AddNode(entry.id_, newNode);
+        created[i - index] = newNode;
+
+        if (!LoadNode(newNode, i, resolver))
+            return false;
+    }
+
+    return true;
+}
+
+bool PackedScene::Validate(const String& name)
+{
+    const unsigned char* data = file_->GetData();
+
+    if (!IsInside(0, 4 + sizeof(PackedSceneHeader)) || memcmp(data, PACKED_SCENE_ID, 4))
+    {
+        ATOMIC_LOGERROR(name + " is not a valid packed scene file");
+        return false;
+    }
+
+    header_ = reinterpret_cast<const PackedSceneHeader*>(data + 4);
+    if (header_->version_ != PACKED_SCENE_VERSION)
+    {
+        ATOMIC_LOGERROR(name + " has unsupported packed scene version " + String(header_->version_));
+        header_ = 0;
+        return false;
+    }
+
+    bool valid = header_->numNodes_ > 0 &&
+        header_->numNodes_ <= file_->GetSize() / sizeof(PackedNodeEntry) &&
+        header_->numComponents_ <= file_->GetSize() / sizeof(PackedComponentEntry) &&
+        header_->numStrings_ <= file_->GetSize() / sizeof(unsigned) &&
+        (header_->nodeOffset_ | header_->componentOffset_ | header_->stringOffset_) % 4 == 0 &&
+        IsInside(header_->nodeOffset_, header_->numNodes_ * sizeof(PackedNodeEntry)) &&
+        IsInside(header_->componentOffset_, header_->numComponents_ * sizeof(PackedComponentEntry)) &&
+        IsInside(header_->stringOffset_, header_->numStrings_ * sizeof(unsigned));
+
+    if (valid)
+    {
+        nodes_ = reinterpret_cast<const PackedNodeEntry*>(data + header_->nodeOffset_);
+        components_ = reinterpret_cast<const PackedComponentEntry*>(data + header_->componentOffset_);
+        strings_ = reinterpret_cast<const unsigned*>(data + header_->stringOffset_);
+
+        for (unsigned i = 0; valid && i < header_->numStrings_; ++i)
+            valid = strings_[i] < file_->GetSize() && memchr(data + strings_[i], 0, file_->GetSize() - strings_[i]);
+
+        for (unsigned i = 0; valid && i < header_->numComponents_; ++i)
+        {
+            const PackedComponentEntry& entry = components_[i];
+            valid = entry.typeName_ < header_->numStrings_ && IsInside(entry.dataOffset_, entry.dataSize_);
+        }
+
+        // The nodes must be in depth-first order with correct subtree ranges, so that LoadSubtree() always finds the
+        // parents it needs. Walk them keeping a stack of the subtrees still open
+        PODVector<unsigned> openNodes;
+        for (unsigned i = 0; valid && i < header_->numNodes_; ++i)
+        {
+            const PackedNodeEntry& entry = nodes_[i];
+            while (openNodes.Size() && nodes_[openNodes.Back()].end_ <= i)
+                openNodes.Pop();
+
+            if (i)
+                valid = openNodes.Size() && entry.parent_ == openNodes.Back() && entry.end_ > i && entry.end_ <= nodes_[entry.parent_].end_;
+            else
+                valid = entry.parent_ == M_MAX_UNSIGNED && entry.end_ == header_->numNodes_;
+            openNodes.Push(i);
+
+            valid = valid && entry.firstComponent_ <= header_->numComponents_ &&
+                entry.numComponents_ <= header_->numComponents_ - entry.firstComponent_ &&
+                IsInside(entry.dataOffset_, entry.dataSize_);
+        }
+    }
+
+    if (!valid)
+    {
+        ATOMIC_LOGERROR(name + " is a corrupt packed scene file");
+        header_ = 0;
+        nodes_ = 0;
+        components_ = 0;
+        strings_ = 0;
+        return false;
+    }
+
+    return true;
+}
+
+}
@@ -0,0 +1,152 @@
+//
+// Copyright (c) 2014-2017 THUNDERBEAST GAMES LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "../Container/Ptr.h"
+#include "../IO/MappedFile.h"
+
+namespace Atomic
+{
+
+class Deserializer;
+class File;
+class Node;
+class SceneResolver;
+class Serializer;
+
+/// Packed scene file identifier.
+extern ATOMIC_API const char* PACKED_SCENE_ID;
+/// Packed scene format version.
+static const unsigned PACKED_SCENE_VERSION = 1;
+
+/// Packed scene header, following the file identifier. All offsets are from the start of the file.
+struct PackedSceneHeader
+{
+    /// Format version.
+    unsigned version_;
+    /// Number of node entries.
+    unsigned numNodes_;
+    /// Number of component entries.
+    unsigned numComponents_;
+    /// Number of strings in the string pool.
+    unsigned numStrings_;
+    /// Offset of the node table.
+    unsigned nodeOffset_;
+    /// Offset of the component table.
+    unsigned componentOffset_;
+    /// Offset of the string pool offset table.
+    unsigned stringOffset_;
+};
+
+/// Packed scene node entry. Nodes are stored depth-first with the root first, so every subtree is a contiguous range.
+struct PackedNodeEntry
+{
+    /// Node ID.
+    unsigned id_;
+    /// Parent node index, M_MAX_UNSIGNED for the root.
+    unsigned parent_;
+    /// Index past the last node of the subtree.
+    unsigned end_;
+    /// Index of the first component.
+    unsigned firstComponent_;
+    /// Number of components.
+    unsigned numComponents_;
+    /// Offset of the attribute data.
+    unsigned dataOffset_;
+    /// Size of the attribute data.
+    unsigned dataSize_;
+};
+
+/// Packed scene component entry.
+struct PackedComponentEntry
+{
+    /// Component type hash.
+    unsigned type_;
+    /// Index of the type name in the string pool.
+    unsigned typeName_;
+    /// Component ID.
+    unsigned id_;
+    /// Offset of the attribute data.
+    unsigned dataOffset_;
+    /// Size of the attribute data.
+    unsigned dataSize_;
+};
+
+/// Versioned, chunked binary scene format: an offset table of nodes and components, a string pool and per-node and per-component attribute blobs. Reads the file through a memory mapping when possible, and loads attributes directly from it.
+class ATOMIC_API PackedScene : public RefCounted
+{
+    ATOMIC_REFCOUNTED(PackedScene)
+
+public:
+    /// Construct.
+    PackedScene();
+    /// Destruct.
+    virtual ~PackedScene();
+
+    /// Open a packed scene file, memory-mapping it when possible. Return true if the file is a valid packed scene.
+    bool Open(File* file);
+    /// Open a packed scene by reading a stream into memory. Return true if the stream is a valid packed scene.
+    bool Open(Deserializer& source);
+    /// Save a node hierarchy, skipping temporary nodes and components. Return true if successful.
+    static bool Save(Serializer& dest, const Node* root);
+
+    /// Load the attributes and components of a node entry into an existing node.
+    bool LoadNode(Node* node, unsigned index, SceneResolver& resolver, bool setInstanceDefault = false) const;
+    /// Create and load the nodes of the subtree starting at a node entry as children of a parent node.
+    bool LoadSubtree(Node* parent, unsigned index, SceneResolver& resolver) const;
+
+    /// Return number of node entries.
+    unsigned GetNumNodes() const { return header_ ? header_->numNodes_ : 0; }
+    /// Return number of component entries.
+    unsigned GetNumComponents() const { return header_ ? header_->numComponents_ : 0; }
+    /// Return node entry by index.
+    const PackedNodeEntry& GetNode(unsigned index) const { return nodes_[index]; }
+    /// Return component entry by index.
+    const PackedComponentEntry& GetComponent(unsigned index) const { return components_[index]; }
+    /// Return string from the pool by index.
+    const char* GetString(unsigned index) const { return (const char*)file_->GetData() + strings_[index]; }
+    /// Return attribute data of a node or component entry.
+    const unsigned char* GetData(unsigned offset) const { return file_->GetData() + offset; }
+    /// Return whether the data is memory-mapped.
+    bool IsMapped() const { return file_->IsMapped(); }
+
+private:
+    /// Validate the tables after opening. Return true if successful.
+    bool Validate(const String& name);
+    /// Return whether a byte range is inside the file.
+    bool IsInside(unsigned offset, unsigned size) const { return offset <= file_->GetSize() && size <= file_->GetSize() - offset; }
+
+    /// File data.
+    SharedPtr<MappedFile> file_;
+    /// Header.
+    const PackedSceneHeader* header_;
+    /// Node table.
+    const PackedNodeEntry* nodes_;
+    /// Component table.
+    const PackedComponentEntry* components_;
+    /// String pool offsets.
+    const unsigned* strings_;
+};
+
+}
@@ -0,0 +1,361 @@
+//
+// Copyright (c) 2014-2017 THUNDERBEAST GAMES LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../Precompiled.h"
+
+#include "../Core/Profiler.h"
+#include "../Core/Timer.h"
+#include "../IO/FileSystem.h"
+#include "../IO/Log.h"
+#include "../IO/MemoryBuffer.h"
+#include "../IO/VectorBuffer.h"
+#include "../Resource/JSONFile.h"
+#include "../Resource/ResourceCache.h"
+#include "../Resource/ResourceEvents.h"
+#include "../Resource/XMLFile.h"
+#include "../Scene/Component.h"
+#include "../Scene/PrefabCache.h"
+#include "../Scene/Scene.h"
+#include "../Scene/SceneResolver.h"
+
+#include "../DebugNew.h"
+
+namespace Atomic
+{
+
+/// Collect a node hierarchy depth-first, in the order of its description.
+static void CollectNodes(Node* node, PODVector<Node*>& dest)
+{
+    dest.Push(node);
+
+    const Vector<SharedPtr<Node> >& children = node->GetChildren();
+    for (unsigned i = 0; i < children.Size(); ++i)
+        CollectNodes(children[i], dest);
+}
+
+/// Return whether a collected node hierarchy has the structure and component types of a description.
+static bool MatchesPrefab(const PODVector<Node*>& nodes, const PreparedSubtree& prefab)
+{
+    if (nodes.Size() != prefab.nodes_.Size())
+        return false;
+
+    for (unsigned i = 0; i < nodes.Size(); ++i)
+    {
+        const PreparedNode& prepared = prefab.nodes_[i];
+        if (i && nodes[i]->GetParent() != nodes[prepared.parent_])
+            return false;
+
+        const Vector<SharedPtr<Component> >& components = nodes[i]->GetComponents();
+        if (components.Size() != prepared.numComponents_)
+            return false;
+        for (unsigned j = 0; j < components.Size(); ++j)
+        {
+            if (components[j]->GetType() != prefab.components_[prepared.firstComponent_ + j].type_)
+                return false;
+        }
+    }
+
+    return true;
+}
+
+/// Return create mode of a node in an instance, following the rules of Scene::Instantiate().
+static CreateMode GetInstanceMode(const PreparedSubtree& prefab, unsigned index, CreateMode mode)
+{
+    if (!index)
+        return mode;
+
+    return (mode == REPLICATED && prefab.nodes_[index].id_ < FIRST_LOCAL_ID) ? REPLICATED : LOCAL;
+}
+
+PrefabBatch::PrefabBatch(const String& name, CreateMode mode) :
+    name_(name),
+    mode_(mode),
+    cancelled_(false)
+{
+}
+
+PrefabCache::PrefabCache(Scene* scene) :
+    Object(scene->GetContext()),
+    scene_(scene),
+    maxPoolSize_(64),
+    budgetMs_(2)
+{
+}
+
+PrefabCache::~PrefabCache()
+{
+}
+
+Node* PrefabCache::Instantiate(const String& name, const Vector3& position, const Quaternion& rotation, CreateMode mode)
+{
+    ATOMIC_PROFILE(InstantiatePrefab);
+
+    PrefabEntry* entry = GetEntry(name);
+    if (!entry)
+        return 0;
+
+    const PreparedSubtree& prefab = entry->prefab_;
+    SceneResolver resolver;
+    PODVector<Node*> reusedNodes;
+    Node* root;
+
+    if (entry->pool_.Size())
+    {
+        SharedPtr<Node> pooled = entry->pool_.Back();
+        entry->pool_.Pop();
+
+        CollectNodes(pooled, reusedNodes);
+
+        // Assign IDs before the hierarchy reenters the scene, which would otherwise make them all replicated
+        for (unsigned i = 0; i < reusedNodes.Size(); ++i)
+        {
+            CreateMode nodeMode = GetInstanceMode(prefab, i, mode);
+            reusedNodes[i]->SetID(scene_->GetFreeNodeID(nodeMode));
+
+            const PreparedNode& prepared = prefab.nodes_[i];
+            const Vector<SharedPtr<Component> >& components = reusedNodes[i]->GetComponents();
+            for (unsigned j = 0; j < components.Size(); ++j)
+            {
+                bool replicated = nodeMode == REPLICATED && prefab.components_[prepared.firstComponent_ + j].id_ < FIRST_LOCAL_ID;
+                components[j]->SetID(scene_->GetFreeComponentID(replicated ? REPLICATED : LOCAL));
+            }
+        }
+
+        scene_->AddChild(pooled);
+
+        // Reset all attributes to the prefab's values
+        for (unsigned i = 0; i < reusedNodes.Size(); ++i)
+            prefab.LoadNode(i, reusedNodes[i], resolver);
+
+        root = pooled;
+    }
+    else
+    {
+        PODVector<Node*> nodes(prefab.nodes_.Size());
+        for (unsigned i = 0; i < nodes.Size(); ++i)
+        {
+            Node* parent = i ? nodes[prefab.nodes_[i].parent_] : scene_;
+            nodes[i] = prefab.CreateNode(i, parent, resolver, GetInstanceMode(prefab, i, mode), true);
+        }
+
+        root = nodes[0];
+    }
+
+    resolver.Resolve();
+    root->SetTransform(position, rotation);
+    root->ApplyAttributes();
+
+    // Restart the components of a reused instance, as those of a new one start when created
+    for (unsigned i = 0; i < reusedNodes.Size(); ++i)
+    {
+        const Vector<SharedPtr<Component> >& components = reusedNodes[i]->GetComponents();
+        for (unsigned j = 0; j < components.Size(); ++j)
+            components[j]->OnReuse();
+    }
+
+    return root;
+}
+
+SharedPtr<PrefabBatch> PrefabCache::InstantiateBatch(const String& name, const PODVector<Vector3>& positions,
+    const PODVector<Quaternion>& rotations, CreateMode mode)
+{
+    SharedPtr<PrefabBatch> batch(new PrefabBatch(name, mode));
+    batch->positions_ = positions;
+    batch->rotations_ = rotations;
+    batch->nodes_.Reserve(positions.Size());
+
+    // Parse the prefab now rather than during the time-limited updates
+    if (!GetEntry(name))
+        batch->Cancel();
+    else
+        batches_.Push(batch);
+
+    return batch;
+}
+
+bool PrefabCache::Release(Node* node, const String& name)
+{
+    if (!node || node->GetScene() != scene_ || node == scene_)
+        return false;
+
+    SharedPtr<Node> keepAlive(node);
+    bool pooled = false;
+
+    PrefabEntry* entry = GetEntry(name);
+    if (entry && entry->pool_.Size() < maxPoolSize_)
+    {
+        PODVector<Node*> nodes;
+        CollectNodes(node, nodes);
+        pooled = MatchesPrefab(nodes, entry->prefab_);
+    }
+
+    node->Remove();
+    if (pooled)
+        entry->pool_.Push(keepAlive);
+
+    return pooled;
+}
+
+void PrefabCache::Update()
+{
+    if (batches_.Empty())
+        return;
+
+    ATOMIC_PROFILE(UpdatePrefabBatches);
+
+    HiresTimer timer;
+
+    while (batches_.Size())
+    {
+        PrefabBatch* batch = batches_.Front();
+        if (batch->IsFinished())
+        {
+            batches_.Erase(0);
+            continue;
+        }
+
+        unsigned index = batch->nodes_.Size();
+        Quaternion rotation = index < batch->rotations_.Size() ? batch->rotations_[index] : Quaternion::IDENTITY;
+        Node* node = Instantiate(batch->name_, batch->positions_[index], rotation, batch->mode_);
+        if (!node)
+        {
+            batch->Cancel();
+            continue;
+        }
+
+        batch->nodes_.Push(WeakPtr<Node>(node));
+
+        // Continue on the next frame if out of time, creating at least one instance per frame
+        if (timer.GetUSec(false) >= budgetMs_ * 1000)
+            break;
+    }
+}
+
+void PrefabCache::SetMaxPoolSize(unsigned size)
+{
+    maxPoolSize_ = size;
+
+    for (HashMap<StringHash, PrefabEntry>::Iterator i = prefabs_.Begin(); i != prefabs_.End(); ++i)
+    {
+        if (i->second_.pool_.Size() > size)
+            i->second_.pool_.Resize(size);
+    }
+}
+
+void PrefabCache::SetBudgetMs(int ms)
+{
+    budgetMs_ = Max(ms, 1);
+}
+
+void PrefabCache::RemovePrefab(const String& name)
+{
+    prefabs_.Erase(StringHash(name));
+}
+
+void PrefabCache::Clear()
+{
+    for (unsigned i = 0; i < batches_.Size(); ++i)
+        batches_[i]->Cancel();
+
+    batches_.Clear();
+    prefabs_.Clear();
+}
+
+const PreparedSubtree* PrefabCache::GetPrefab(const String& name)
+{
+    PrefabEntry* entry = GetEntry(name);
+    return entry ? &entry->prefab_ : 0;
+}
+
+unsigned PrefabCache::GetPoolSize(const String& name) const
+{
+    HashMap<StringHash, PrefabEntry>::ConstIterator i = prefabs_.Find(StringHash(name));
+    return i != prefabs_.End() ? i->second_.pool_.Size() : 0;
+}
+
+PrefabCache::PrefabEntry* PrefabCache::GetEntry(const String& name)
+{
+    StringHash nameHash(name);
+    HashMap<StringHash, PrefabEntry>::Iterator i = prefabs_.Find(nameHash);
+    if (i != prefabs_.End())
+        return &i->second_;
+
+    ATOMIC_PROFILE(ParsePrefab);
+
+    // Load the prefab once into a detached hierarchy, keeping the IDs of the file for resolving references between its
+    // nodes and components on each instantiation. Then describe it through its binary serialization
+    ResourceCache* cache = GetSubsystem<ResourceCache>();
+    SharedPtr<Node> root(new Node(context_));
+    SceneResolver resolver;
+    Resource* resource;
+    bool success;
+
+    if (GetExtension(name) == ".json")
+    {
+        JSONFile* json = cache->GetResource<JSONFile>(name);
+        resource = json;
+        if (!json)
+            return 0;
+        root->SetID(json->GetRoot().Get("id").GetUInt());
+        success = root->LoadJSON(json->GetRoot(), resolver, true, false);
+    }
+    else
+    {
+        XMLFile* xml = cache->GetResource<XMLFile>(name);
+        resource = xml;
+        if (!xml)
+            return 0;
+        root->SetID(xml->GetRoot().GetUInt("id"));
+        success = root->LoadXML(xml->GetRoot(), resolver, true, false);
+    }
+
+    VectorBuffer buffer;
+    if (!success || !root->Save(buffer))
+    {
+        ATOMIC_LOGERROR("Failed to parse prefab " + name);
+        return 0;
+    }
+
+    PrefabEntry& entry = prefabs_[nameHash];
+    buffer.Seek(0);
+    entry.prefab_.valid_ = entry.prefab_.Decode(context_, buffer);
+    if (!entry.prefab_.valid_)
+    {
+        ATOMIC_LOGERROR("Failed to parse prefab " + name);
+        prefabs_.Erase(nameHash);
+        return 0;
+    }
+
+    SubscribeToEvent(resource, E_RELOADFINISHED, ATOMIC_HANDLER(PrefabCache, HandleReloadFinished));
+    return &entry;
+}
+
+void PrefabCache::HandleReloadFinished(StringHash eventType, VariantMap& eventData)
+{
+    // Parse again on next use. Pooled instances may no longer match, so drop them as well
+    Resource* resource = static_cast<Resource*>(GetEventSender());
+    if (resource)
+        RemovePrefab(resource->GetName());
+}
+
+}
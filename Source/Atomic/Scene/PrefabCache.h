@@ -0,0 +1,150 @@
+//
+// Copyright (c) 2014-2017 THUNDERBEAST GAMES LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "../Core/Object.h"
+#include "../Math/Quaternion.h"
+#include "../Scene/AsyncSceneLoader.h"
+
+namespace Atomic
+{
+
+class Scene;
+
+/// Instantiations of a prefab spread over several frames.
+class ATOMIC_API PrefabBatch : public RefCounted
+{
+    ATOMIC_REFCOUNTED(PrefabBatch)
+
+    friend class PrefabCache;
+
+public:
+    /// Construct.
+    PrefabBatch(const String& name, CreateMode mode);
+
+    /// Stop instantiating. The instances created so far are kept.
+    void Cancel() { cancelled_ = true; }
+
+    /// Return prefab resource name.
+    const String& GetName() const { return name_; }
+    /// Return number of instances requested.
+    unsigned GetNumRequested() const { return positions_.Size(); }
+    /// Return root nodes of the instances created so far.
+    const Vector<WeakPtr<Node> >& GetNodes() const { return nodes_; }
+    /// Return whether was cancelled.
+    bool IsCancelled() const { return cancelled_; }
+    /// Return whether all instances have been created or the batch was cancelled.
+    bool IsFinished() const { return cancelled_ || nodes_.Size() >= positions_.Size(); }
+
+private:
+    /// Prefab resource name.
+    String name_;
+    /// Create mode.
+    CreateMode mode_;
+    /// Instance positions.
+    PODVector<Vector3> positions_;
+    /// Instance rotations.
+    PODVector<Quaternion> rotations_;
+    /// Created root nodes.
+    Vector<WeakPtr<Node> > nodes_;
+    /// Cancel flag.
+    bool cancelled_;
+};
+
+/// Per-scene prefab instantiation. Keeps each XML or JSON prefab resource parsed into a node description, recycles
+/// released instances instead of destroying them, and creates batches of instances within a per-frame time budget.
+///
+/// A released instance leaves the scene but keeps its nodes and components, so Stop() of logic components is not called.
+/// When it is reused, all attributes are reset to the prefab's values and then Component::OnReuse() is called on each
+/// component. Logic components run Start() again and DelayedStart() before their next update, and Javascript components
+/// also reapply their field values to the script object. Components with other per-instance state, such as members set
+/// in code after instantiation, must reset it in OnReuse().
+class ATOMIC_API PrefabCache : public Object
+{
+    ATOMIC_OBJECT(PrefabCache, Object);
+
+public:
+    /// Construct for a scene.
+    PrefabCache(Scene* scene);
+    /// Destruct.
+    virtual ~PrefabCache();
+
+    /// Instantiate a prefab resource at root level, reusing a released instance if available. Return root node if successful.
+    Node* Instantiate(const String& name, const Vector3& position, const Quaternion& rotation, CreateMode mode = REPLICATED);
+    /// Queue instantiations of a prefab resource, created during the following scene updates within the time budget. Rotations may be empty for identity.
+    SharedPtr<PrefabBatch> InstantiateBatch(const String& name, const PODVector<Vector3>& positions,
+        const PODVector<Quaternion>& rotations = PODVector<Quaternion>(), CreateMode mode = REPLICATED);
+    /// Remove an instance of a prefab resource from the scene and keep it for reuse. The hierarchy is pooled only if it still matches the prefab, otherwise it is destroyed if not referenced elsewhere. Return true if pooled.
+    bool Release(Node* node, const String& name);
+    /// Create the instances of queued batches until out of time. Called by Scene::Update().
+    void Update();
+
+    /// Set maximum number of pooled instances per prefab.
+    void SetMaxPoolSize(unsigned size);
+    /// Set maximum milliseconds per frame to spend on batched instantiation.
+    void SetBudgetMs(int ms);
+    /// Forget a parsed prefab and its pooled instances.
+    void RemovePrefab(const String& name);
+    /// Forget all parsed prefabs and pooled instances, and cancel queued batches.
+    void Clear();
+
+    /// Return parsed description of a prefab resource, parsing it on first use. Return null if the resource could not be loaded.
+    const PreparedSubtree* GetPrefab(const String& name);
+    /// Return number of pooled instances of a prefab resource.
+    unsigned GetPoolSize(const String& name) const;
+    /// Return maximum number of pooled instances per prefab.
+    unsigned GetMaxPoolSize() const { return maxPoolSize_; }
+    /// Return maximum milliseconds per frame to spend on batched instantiation.
+    int GetBudgetMs() const { return budgetMs_; }
+    /// Return number of queued batches.
+    unsigned GetNumBatches() const { return batches_.Size(); }
+
+private:
+    /// Parsed prefab with its pooled instances.
+    struct PrefabEntry
+    {
+        /// Node description.
+        PreparedSubtree prefab_;
+        /// Released instances.
+        Vector<SharedPtr<Node> > pool_;
+    };
+
+    /// Return the entry of a prefab resource, parsing it on first use.
+    PrefabEntry* GetEntry(const String& name);
+    /// Handle a prefab resource being reloaded.
+    void HandleReloadFinished(StringHash eventType, VariantMap& eventData);
+
+    /// Scene.
+    Scene* scene_;
+    /// Prefabs by resource name.
+    HashMap<StringHash, PrefabEntry> prefabs_;
+    /// Queued batches.
+    Vector<SharedPtr<PrefabBatch> > batches_;
+    /// Maximum pooled instances per prefab.
+    unsigned maxPoolSize_;
+    /// Maximum milliseconds per frame for batched instantiation.
+    int budgetMs_;
+};
+
+}
@@ -0,0 +1,121 @@
+//
+// Copyright (c) 2014-2017 THUNDERBEAST GAMES LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../Precompiled.h"
+
+#include "../Scene/ReplicationFanout.h"
+#include "../Scene/Serializable.h"
+
+#include "../DebugNew.h"
+
+namespace Atomic
+{
+
+ReplicationFanout::ReplicationFanout() :
+    tick_(1),
+    numSharedWrites_(0)
+{
+}
+
+void ReplicationFanout::BeginTick()
+{
+    // Zero marks objects that have never been encoded
+    if (!++tick_)
+        tick_ = 1;
+
+    data_.Clear();
+    numSharedWrites_.store(0, std::memory_order_relaxed);
+}
+
+void ReplicationFanout::Encode(Serializable* object, const DirtyBits& changedAttributes)
+{
+    NetworkState* state = object->GetNetworkState();
+    if (!state || !state->attributes_)
+        return;
+
+    const Vector<AttributeInfo>& attributes = *state->attributes_;
+
+    // Split the changes the same way as the connections do: latest data attributes are always sent as a whole
+    DirtyBits deltaBits(changedAttributes);
+    bool hasLatestData = false;
+    for (unsigned i = 0; i < attributes.Size(); ++i)
+    {
+        if (deltaBits.IsSet(i) && (attributes[i].mode_ & AM_LATESTDATA))
+        {
+            hasLatestData = true;
+            deltaBits.Clear(i);
+        }
+    }
+
+    state->sharedTick_ = tick_;
+    state->sharedLatestDataSize_ = 0;
+    state->sharedDeltaSize_ = 0;
+
+    // Leave out the time stamp, which differs between connections
+    if (hasLatestData)
+    {
+        unsigned start = data_.GetSize();
+        object->WriteLatestDataUpdate(data_, 0);
+        state->sharedLatestDataOffset_ = start + 1;
+        state->sharedLatestDataSize_ = data_.GetSize() - start - 1;
+    }
+
+    if (deltaBits.Count())
+    {
+        unsigned start = data_.GetSize();
+        object->WriteDeltaUpdate(data_, deltaBits, 0);
+        state->sharedDeltaOffset_ = start + 1;
+        state->sharedDeltaSize_ = data_.GetSize() - start - 1;
+        state->sharedDeltaBits_ = deltaBits;
+    }
+}
+
+void ReplicationFanout::WriteLatestDataUpdate(Serializable* object, Serializer& dest, unsigned char timeStamp)
+{
+    // The latest data update depends only on the current values, so it can be shared regardless of why it is sent
+    NetworkState* state = object->GetNetworkState();
+    if (state && state->sharedTick_ == tick_ && state->sharedLatestDataSize_)
+    {
+        dest.WriteUByte(timeStamp);
+        dest.Write(data_.GetData() + state->sharedLatestDataOffset_, state->sharedLatestDataSize_);
+        numSharedWrites_.fetch_add(1, std::memory_order_relaxed);
+    }
+    else
+        object->WriteLatestDataUpdate(dest, timeStamp);
+}
+
+void ReplicationFanout::WriteDeltaUpdate(Serializable* object, Serializer& dest, const DirtyBits& attributeBits, unsigned char timeStamp)
+{
+    NetworkState* state = object->GetNetworkState();
+    if (state && state->sharedTick_ == tick_ && state->sharedDeltaSize_ &&
+        !memcmp(state->sharedDeltaBits_.data_, attributeBits.data_, sizeof attributeBits.data_))
+    {
+        dest.WriteUByte(timeStamp);
+        dest.Write(data_.GetData() + state->sharedDeltaOffset_, state->sharedDeltaSize_);
+        numSharedWrites_.fetch_add(1, std::memory_order_relaxed);
+    }
+    else
+        object->WriteDeltaUpdate(dest, attributeBits, timeStamp);
+}
+
+}
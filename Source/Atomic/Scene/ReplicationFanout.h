@@ -0,0 +1,69 @@
+//
+// Copyright (c) 2014-2017 THUNDERBEAST GAMES LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "../IO/VectorBuffer.h"
+#include "../Scene/ReplicationState.h"
+
+#include <atomic>
+
+namespace Atomic
+{
+
+class Serializable;
+
+/// Network attribute updates of one server tick, each serialized once and shared by all client connections that need
+/// the same update. Connections copy the shared bytes behind their own message header and time stamp. Encoding happens on
+/// the main thread; the writes are safe from several connection update threads at once.
+class ATOMIC_API ReplicationFanout
+{
+public:
+    /// Construct.
+    ReplicationFanout();
+
+    /// Start a new tick, invalidating the updates of the previous one.
+    void BeginTick();
+    /// Serialize the updates of an object's attributes that changed during this tick. Called when preparing the network update.
+    void Encode(Serializable* object, const DirtyBits& changedAttributes);
+
+    /// Write a latest data update, copying the shared update when available.
+    void WriteLatestDataUpdate(Serializable* object, Serializer& dest, unsigned char timeStamp);
+    /// Write a delta update according to dirty attribute bits, copying the shared update when the bits match.
+    void WriteDeltaUpdate(Serializable* object, Serializer& dest, const DirtyBits& attributeBits, unsigned char timeStamp);
+
+    /// Return number of bytes serialized for sharing during this tick.
+    unsigned GetEncodedSize() const { return data_.GetSize(); }
+    /// Return number of updates written from shared data during this tick.
+    unsigned GetNumSharedWrites() const { return numSharedWrites_.load(std::memory_order_relaxed); }
+
+private:
+    /// Shared update data of the tick.
+    VectorBuffer data_;
+    /// Tick number, never zero.
+    unsigned tick_;
+    /// Shared writes during the tick.
+    std::atomic<unsigned> numSharedWrites_;
+};
+
+}
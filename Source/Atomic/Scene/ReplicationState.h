@@ -126,7 +126,14 @@ struct ATOMIC_API NetworkState
 {
     /// Construct with defaults.
     NetworkState() :
-        interceptMask_(0)
+        interceptMask_(0),
+// ATOMIC BEGIN
+        sharedTick_(0),
+        sharedLatestDataOffset_(0),
+        sharedLatestDataSize_(0),
+        sharedDeltaOffset_(0),
+        sharedDeltaSize_(0)
+// ATOMIC END
     {
     }
 
@@ -142,6 +149,20 @@ struct ATOMIC_API NetworkState
     VariantMap previousVars_;
     /// Bitmask for intercepting network messages. Used on the client only.
     unsigned long long interceptMask_;
+    // ATOMIC BEGIN
+    /// Replication fan-out tick of the shared updates below.
+    unsigned sharedTick_;
+    /// Offset of the shared latest data update.
+    unsigned sharedLatestDataOffset_;
+    /// Size of the shared latest data update, zero if none.
+    unsigned sharedLatestDataSize_;
+    /// Offset of the shared delta update.
+    unsigned sharedDeltaOffset_;
+    /// Size of the shared delta update, zero if none.
+    unsigned sharedDeltaSize_;
+    /// Attribute bits of the shared delta update.
+    DirtyBits sharedDeltaBits_;
+    // ATOMIC END
 };
 
 /// Base class for per-user network replication states.
@@ -28,16 +28,28 @@
 #include "../Core/WorkQueue.h"
 #include "../IO/File.h"
 #include "../IO/Log.h"
+// ATOMIC BEGIN
+#include "../IO/MemoryBuffer.h"
+// ATOMIC END
 #include "../IO/PackageFile.h"
 #include "../Resource/ResourceCache.h"
 #include "../Resource/ResourceEvents.h"
 #include "../Resource/XMLFile.h"
 #include "../Resource/JSONFile.h"
 #include "../Scene/Component.h"
+// ATOMIC BEGIN
+#include "../Scene/LogicComponent.h"
+// ATOMIC END
 #include "../Scene/ObjectAnimation.h"
+// ATOMIC BEGIN
+#include "../Scene/PrefabCache.h"
+// ATOMIC END
 #include "../Scene/ReplicationState.h"
 #include "../Scene/Scene.h"
 #include "../Scene/SceneEvents.h"
+// ATOMIC BEGIN
+#include "../Scene/SceneTransforms.h"
+// ATOMIC END
 #include "../Scene/SmoothedTransform.h"
 #include "../Scene/SplinePath.h"
 #include "../Scene/UnknownComponent.h"
@@ -61,6 +73,12 @@ static const float DEFAULT_SNAP_THRESHOLD = 5.0f;
 
 Scene::Scene(Context* context) :
     Node(context),
+// ATOMIC BEGIN
+    indexingEnabled_(false),
+    transformsThreaded_(false),
+    asyncLoadingThreaded_(false),
+    parallelUpdateRemoved_(false),
+// ATOMIC END
     replicatedNodeID_(FIRST_REPLICATED_ID),
     replicatedComponentID_(FIRST_REPLICATED_ID),
     localNodeID_(FIRST_LOCAL_ID),
@@ -79,7 +97,14 @@ Scene::Scene(Context* context) :
     SetID(GetFreeNodeID(REPLICATED));
     NodeAdded(this);
 
-    SubscribeToEvent(E_UPDATE, ATOMIC_HANDLER(Scene, HandleUpdate));
+    // ATOMIC BEGIN
+    sceneUpdateChannel_.Resolve(this, E_SCENEUPDATE);
+    attributeAnimationUpdateChannel_.Resolve(this, E_ATTRIBUTEANIMATIONUPDATE);
+    sceneSubsystemUpdateChannel_.Resolve(this, E_SCENESUBSYSTEMUPDATE);
+    scenePostUpdateChannel_.Resolve(this, E_SCENEPOSTUPDATE);
+
+    SubscribeToEvent(E_UPDATE, ATOMIC_PAYLOAD_HANDLER(Scene, UpdateEventPayload, HandleUpdate));
+    // ATOMIC END
     SubscribeToEvent(E_RESOURCEBACKGROUNDLOADED, ATOMIC_HANDLER(Scene, HandleResourceBackgroundLoaded));
 }
 
@@ -91,9 +116,9 @@ Scene::~Scene()
     RemoveAllChildren();
 
     // Remove scene reference and owner from all nodes that still exist
-    for (HashMap<unsigned, Node*>::Iterator i = replicatedNodes_.Begin(); i != replicatedNodes_.End(); ++i)
+    for (FlatHashMap<unsigned, Node*>::Iterator i = replicatedNodes_.Begin(); i != replicatedNodes_.End(); ++i)
         i->second_->ResetScene();
-    for (HashMap<unsigned, Node*>::Iterator i = localNodes_.Begin(); i != localNodes_.End(); ++i)
+    for (FlatHashMap<unsigned, Node*>::Iterator i = localNodes_.Begin(); i != localNodes_.End(); ++i)
         i->second_->ResetScene();
 }
 
@@ -122,7 +147,12 @@ bool Scene::Load(Deserializer& source, bool setInstanceDefault)
     StopAsyncLoading();
 
     // Check ID
-    if (source.ReadFileID() != "USCN")
+    // ATOMIC BEGIN
+    String fileID = source.ReadFileID();
+    if (fileID == PACKED_SCENE_ID)
+        return LoadPacked(source, setInstanceDefault);
+    if (fileID != "USCN")
+    // ATOMIC END
     {
         ATOMIC_LOGERROR(source.GetName() + " is not a valid scene file");
         return false;
@@ -214,7 +244,7 @@ void Scene::AddReplicationState(NodeReplicationState* state)
     Node::AddReplicationState(state);
 
     // This is the first update for a new connection. Mark all replicated nodes dirty
-    for (HashMap<unsigned, Node*>::ConstIterator i = replicatedNodes_.Begin(); i != replicatedNodes_.End(); ++i)
+    for (FlatHashMap<unsigned, Node*>::ConstIterator i = replicatedNodes_.Begin(); i != replicatedNodes_.End(); ++i)
         state->sceneState_->dirtyNodes_.Insert(i->first_);
 }
 
@@ -321,7 +351,12 @@ bool Scene::LoadAsync(File* file, LoadMode mode)
     StopAsyncLoading();
 
     // Check ID
-    bool isSceneFile = file->ReadFileID() == "USCN";
+    // ATOMIC BEGIN
+    String fileID = file->ReadFileID();
+    if (fileID == PACKED_SCENE_ID)
+        return LoadAsyncPacked(file, mode);
+    bool isSceneFile = fileID == "USCN";
+    // ATOMIC END
     if (!isSceneFile)
     {
         // In resource load mode can load also object prefabs, which have no identifier
@@ -371,6 +406,16 @@ bool Scene::LoadAsync(File* file, LoadMode mode)
 
         // Then prepare to load child nodes in the async updates
         asyncProgress_.totalNodes_ = file->ReadVLE();
+
+        // ATOMIC BEGIN
+        // Or decode them in worker threads, leaving only their attachment to the async updates
+        WorkQueue* queue = GetSubsystem<WorkQueue>();
+        if (asyncLoadingThreaded_ && queue && queue->GetNumThreads())
+        {
+            asyncProgress_.loader_ = new AsyncSceneLoader(context_);
+            asyncProgress_.loader_->Start(file, asyncProgress_.totalNodes_);
+        }
+        // ATOMIC END
     }
     else
     {
@@ -517,6 +562,110 @@ bool Scene::LoadAsyncJSON(File* file, LoadMode mode)
     return true;
 }
 
+// ATOMIC BEGIN
+
+bool Scene::SavePacked(Serializer& dest) const
+{
+    ATOMIC_PROFILE(SaveScenePacked);
+
+    Deserializer* ptr = dynamic_cast<Deserializer*>(&dest);
+    if (ptr)
+        ATOMIC_LOGINFO("Saving scene to " + ptr->GetName());
+
+    if (PackedScene::Save(dest, this))
+    {
+        FinishSaving(&dest);
+        return true;
+    }
+    else
+        return false;
+}
+
+bool Scene::LoadPacked(Deserializer& source, bool setInstanceDefault)
+{
+    // Map the file if possible, otherwise read it into memory as a whole
+    SharedPtr<PackedScene> packedScene(new PackedScene());
+    File* file = dynamic_cast<File*>(&source);
+    if (!(file ? packedScene->Open(file) : packedScene->Open(source)))
+        return false;
+
+    ATOMIC_LOGINFO("Loading scene from " + source.GetName());
+
+    Clear();
+
+    SceneResolver resolver;
+    resolver.AddNode(packedScene->GetNode(0).id_, this);
+
+    bool success = packedScene->LoadNode(this, 0, resolver, setInstanceDefault);
+    for (unsigned i = 1; success && i < packedScene->GetNumNodes(); i = packedScene->GetNode(i).end_)
+        success = packedScene->LoadSubtree(this, i, resolver);
+
+    if (!success)
+        return false;
+
+    resolver.Resolve();
+    ApplyAttributes();
+    FinishLoading(&source);
+    return true;
+}
+
+bool Scene::LoadAsyncPacked(File* file, LoadMode mode)
+{
+    SharedPtr<PackedScene> packedScene(new PackedScene());
+    if (!packedScene->Open(file))
+        return false;
+
+    if (mode > LOAD_RESOURCES_ONLY)
+    {
+        ATOMIC_LOGINFO("Loading scene from " + file->GetName());
+        Clear();
+    }
+
+    asyncLoading_ = true;
+    asyncProgress_.file_ = file;
+    asyncProgress_.packedScene_ = packedScene;
+    asyncProgress_.packedIndex_ = 1;
+    asyncProgress_.mode_ = mode;
+    asyncProgress_.loadedNodes_ = asyncProgress_.totalNodes_ = asyncProgress_.loadedResources_ = asyncProgress_.totalResources_ = 0;
+    asyncProgress_.resources_.Clear();
+
+    if (mode != LOAD_SCENE)
+    {
+        ATOMIC_PROFILE(FindResourcesToPreload);
+
+        if (mode == LOAD_RESOURCES_ONLY)
+            ATOMIC_LOGINFO("Preloading resources from " + file->GetName());
+        PreloadResourcesPacked(packedScene);
+    }
+
+    if (mode > LOAD_RESOURCES_ONLY)
+    {
+        // Store own old ID for resolving possible root node references, then load the root level components
+        resolver_.AddNode(packedScene->GetNode(0).id_, this);
+        if (!packedScene->LoadNode(this, 0, resolver_))
+        {
+            StopAsyncLoading();
+            return false;
+        }
+
+        // Then prepare to load each root level child node with its subtree in the async updates
+        for (unsigned i = 1; i < packedScene->GetNumNodes(); i = packedScene->GetNode(i).end_)
+            ++asyncProgress_.totalNodes_;
+
+        // Or decode the subtrees in worker threads, leaving only their attachment to the async updates
+        WorkQueue* queue = GetSubsystem<WorkQueue>();
+        if (asyncLoadingThreaded_ && queue && queue->GetNumThreads())
+        {
+            asyncProgress_.loader_ = new AsyncSceneLoader(context_);
+            asyncProgress_.loader_->Start(packedScene);
+        }
+    }
+
+    return true;
+}
+
+// ATOMIC END
+
 void Scene::StopAsyncLoading()
 {
     asyncLoading_ = false;
@@ -525,6 +674,12 @@ void Scene::StopAsyncLoading()
     asyncProgress_.jsonFile_.Reset();
     asyncProgress_.xmlElement_ = XMLElement::EMPTY;
     asyncProgress_.jsonIndex_ = 0;
+    // ATOMIC BEGIN
+    // Stop the worker threads first, as they may still be reading the file
+    asyncProgress_.loader_.Reset();
+    asyncProgress_.packedScene_.Reset();
+    asyncProgress_.packedIndex_ = 0;
+    // ATOMIC END
     asyncProgress_.resources_.Clear();
     resolver_.Reset();
 }
@@ -711,12 +866,12 @@ Node* Scene::GetNode(unsigned id) const
 {
     if (id < FIRST_LOCAL_ID)
     {
-        HashMap<unsigned, Node*>::ConstIterator i = replicatedNodes_.Find(id);
+        FlatHashMap<unsigned, Node*>::ConstIterator i = replicatedNodes_.Find(id);
         return i != replicatedNodes_.End() ? i->second_ : 0;
     }
     else
     {
-        HashMap<unsigned, Node*>::ConstIterator i = localNodes_.Find(id);
+        FlatHashMap<unsigned, Node*>::ConstIterator i = localNodes_.Find(id);
         return i != localNodes_.End() ? i->second_ : 0;
     }
 }
@@ -734,16 +889,155 @@ bool Scene::GetNodesWithTag(PODVector<Node*>& dest, const String& tag) const
         return false;
 }
 
+// ATOMIC BEGIN
+
+void Scene::SetIndexingEnabled(bool enable)
+{
+    if (enable == indexingEnabled_)
+        return;
+
+    indexingEnabled_ = enable;
+    componentsByType_.Clear();
+    nodesByName_.Clear();
+
+    if (!enable)
+        return;
+
+    for (FlatHashMap<unsigned, Node*>::ConstIterator i = replicatedNodes_.Begin(); i != replicatedNodes_.End(); ++i)
+        IndexNode(i->second_, i->second_->GetNameHash());
+    for (FlatHashMap<unsigned, Node*>::ConstIterator i = localNodes_.Begin(); i != localNodes_.End(); ++i)
+        IndexNode(i->second_, i->second_->GetNameHash());
+    for (FlatHashMap<unsigned, Component*>::ConstIterator i = replicatedComponents_.Begin(); i != replicatedComponents_.End(); ++i)
+        IndexComponent(i->second_);
+    for (FlatHashMap<unsigned, Component*>::ConstIterator i = localComponents_.Begin(); i != localComponents_.End(); ++i)
+        IndexComponent(i->second_);
+}
+
+const PODVector<Component*>& Scene::GetComponentsOfType(StringHash type) const
+{
+    static const PODVector<Component*> noComponents;
+
+    FlatHashMap<StringHash, PODVector<Component*> >::ConstIterator i = componentsByType_.Find(type);
+    return i != componentsByType_.End() ? i->second_ : noComponents;
+}
+
+void Scene::SetTransformBatching(bool enable, bool threaded)
+{
+    transformsThreaded_ = threaded;
+
+    if (enable == transforms_.NotNull())
+        return;
+
+    if (enable)
+        transforms_ = new SceneTransforms(this);
+    else
+        transforms_.Reset();
+}
+
+PrefabCache* Scene::GetPrefabCache()
+{
+    if (!prefabCache_)
+        prefabCache_ = new PrefabCache(this);
+
+    return prefabCache_;
+}
+
+void Scene::UpdateTransforms()
+{
+    if (transforms_)
+        transforms_->Update(transformsThreaded_ ? GetSubsystem<WorkQueue>() : 0);
+}
+
+const PODVector<Node*>& Scene::GetNodesWithName(StringHash nameHash) const
+{
+    static const PODVector<Node*> noNodes;
+
+    FlatHashMap<StringHash, PODVector<Node*> >::ConstIterator i = nodesByName_.Find(nameHash);
+    return i != nodesByName_.End() ? i->second_ : noNodes;
+}
+
+void Scene::NodeNameChanged(Node* node, StringHash oldNameHash)
+{
+    if (!indexingEnabled_)
+        return;
+
+    UnindexNode(node, oldNameHash);
+    IndexNode(node, node->GetNameHash());
+}
+
+void Scene::IndexComponent(Component* component)
+{
+    PODVector<Component*>& components = componentsByType_[component->GetType()];
+    if (component->sceneIndex_ < components.Size() && components[component->sceneIndex_] == component)
+        return;
+
+    component->sceneIndex_ = components.Size();
+    components.Push(component);
+}
+
+void Scene::UnindexComponent(Component* component)
+{
+    if (component->sceneIndex_ == M_MAX_UNSIGNED)
+        return;
+
+    FlatHashMap<StringHash, PODVector<Component*> >::Iterator i = componentsByType_.Find(component->GetType());
+    if (i != componentsByType_.End())
+    {
+        // Swap with the last entry for constant time removal
+        PODVector<Component*>& components = i->second_;
+        Component* last = components.Back();
+        components[component->sceneIndex_] = last;
+        last->sceneIndex_ = component->sceneIndex_;
+        components.Pop();
+    }
+
+    component->sceneIndex_ = M_MAX_UNSIGNED;
+}
+
+void Scene::IndexNode(Node* node, StringHash nameHash)
+{
+    // Unnamed nodes are the majority and are never looked up by name
+    if (nameHash == StringHash::ZERO)
+        return;
+
+    PODVector<Node*>& nodes = nodesByName_[nameHash];
+    if (node->impl_->sceneIndex_ < nodes.Size() && nodes[node->impl_->sceneIndex_] == node)
+        return;
+
+    node->impl_->sceneIndex_ = nodes.Size();
+    nodes.Push(node);
+}
+
+void Scene::UnindexNode(Node* node, StringHash nameHash)
+{
+    if (node->impl_->sceneIndex_ == M_MAX_UNSIGNED)
+        return;
+
+    FlatHashMap<StringHash, PODVector<Node*> >::Iterator i = nodesByName_.Find(nameHash);
+    if (i != nodesByName_.End())
+    {
+        PODVector<Node*>& nodes = i->second_;
+        Node* last = nodes.Back();
+        nodes[node->impl_->sceneIndex_] = last;
+        last->impl_->sceneIndex_ = node->impl_->sceneIndex_;
+        nodes.Pop();
+    }
+
+    node->impl_->sceneIndex_ = M_MAX_UNSIGNED;
+}
+
+// ATOMIC END
+
 Component* Scene::GetComponent(unsigned id) const
 {
     if (id < FIRST_LOCAL_ID)
     {
-        HashMap<unsigned, Component*>::ConstIterator i = replicatedComponents_.Find(id);
+        FlatHashMap<unsigned, Component*>::ConstIterator i = replicatedComponents_.Find(id);
         return i != replicatedComponents_.End() ? i->second_ : 0;
     }
     else
     {
-        HashMap<unsigned, Component*>::ConstIterator i = localComponents_.Find(id);
+        FlatHashMap<unsigned, Component*>::ConstIterator i = localComponents_.Find(id);
         return i != localComponents_.End() ? i->second_ : 0;
     }
 }
@@ -775,20 +1069,25 @@ void Scene::Update(float timeStep)
 
     timeStep *= timeScale_;
 
-    using namespace SceneUpdate;
+    // ATOMIC BEGIN
+    // Create queued prefab instances within their time budget
+    if (prefabCache_)
+        prefabCache_->Update();
 
-    VariantMap& eventData = GetEventDataMap();
-    eventData[P_SCENE] = this;
-    eventData[P_TIMESTEP] = timeStep;
+    SceneUpdateEventPayload payload(this, timeStep);
 
     // Update variable timestep logic
-    SendEvent(E_SCENEUPDATE, eventData);
+    sceneUpdateChannel_.Send(payload);
+
+    // Update logic components that opted in to running in worker threads
+    UpdateParallelLogic(timeStep);
 
     // Update scene attribute animation.
-    SendEvent(E_ATTRIBUTEANIMATIONUPDATE, eventData);
+    attributeAnimationUpdateChannel_.Send(payload);
 
     // Update scene subsystems. If a physics world is present, it will be updated, triggering fixed timestep logic updates
-    SendEvent(E_SCENESUBSYSTEMUPDATE, eventData);
+    sceneSubsystemUpdateChannel_.Send(payload);
+    // ATOMIC END
 
     // Update transform smoothing
     {
@@ -805,7 +1104,12 @@ void Scene::Update(float timeStep)
     }
 
     // Post-update variable timestep logic
-    SendEvent(E_SCENEPOSTUPDATE, eventData);
+    // ATOMIC BEGIN
+    scenePostUpdateChannel_.Send(payload);
+
+    // Resolve all world transforms changed during the update in one pass, instead of on demand from the renderer
+    UpdateTransforms();
+    // ATOMIC END
 
     // Note: using a float for elapsed time accumulation is inherently inaccurate. The purpose of this value is
     // primarily to update material animation effects, as it is available to shaders. It can be reset by calling
@@ -835,6 +1139,19 @@ void Scene::EndThreadedUpdate()
             (*i)->OnMarkedDirty((*i)->GetNode());
         delayedDirtyComponents_.Clear();
     }
+
+    // ATOMIC BEGIN
+    if (!delayedCalls_.Empty())
+    {
+        ATOMIC_PROFILE(DelayedCalls);
+
+        // Swap out first, as the calls may queue more (which then run immediately) or trigger another threaded update
+        Vector<std::function<void()> > calls;
+        calls.Swap(delayedCalls_);
+        for (unsigned i = 0; i < calls.Size(); ++i)
+            calls[i]();
+    }
+    // ATOMIC END
 }
 
 void Scene::DelayedMarkedDirty(Component* component)
@@ -843,6 +1160,121 @@ void Scene::DelayedMarkedDirty(Component* component)
     delayedDirtyComponents_.Push(component);
 }
 
+// ATOMIC BEGIN
+
+void Scene::DelayedCall(const std::function<void()>& function)
+{
+    if (!threadedUpdate_)
+    {
+        function();
+        return;
+    }
+
+    MutexLock lock(sceneMutex_);
+    delayedCalls_.Push(function);
+}
+
+void Scene::AddParallelUpdate(LogicComponent* component)
+{
+    if (!component || component->parallelUpdateScene_)
+        return;
+
+    component->parallelUpdateScene_ = this;
+    component->parallelUpdateIndex_ = parallelUpdateComponents_.Size();
+    parallelUpdateComponents_.Push(component);
+}
+
+void Scene::RemoveParallelUpdate(LogicComponent* component)
+{
+    if (!component || component->parallelUpdateScene_ != this)
+        return;
+
+    unsigned index = component->parallelUpdateIndex_;
+    if (threadedUpdate_)
+    {
+        // Worker threads may be iterating the components, so only clear the slot and drop it after the parallel phase
+        parallelUpdateComponents_[index] = 0;
+        MutexLock lock(sceneMutex_);
+        parallelUpdateRemoved_ = true;
+    }
+    else
+    {
+        if (parallelUpdateRemoved_)
+            PurgeParallelUpdate();
+
+        LogicComponent* last = parallelUpdateComponents_.Back();
+        parallelUpdateComponents_[index] = last;
+        last->parallelUpdateIndex_ = index;
+        parallelUpdateComponents_.Pop();
+    }
+
+    component->parallelUpdateScene_ = 0;
+    component->parallelUpdateIndex_ = M_MAX_UNSIGNED;
+}
+
+void Scene::UpdateParallelLogic(float timeStep)
+{
+    if (parallelUpdateRemoved_)
+        PurgeParallelUpdate();
+    if (parallelUpdateComponents_.Empty())
+        return;
+
+    ATOMIC_PROFILE(UpdateParallelLogic);
+
+    // Delayed starts typically look up or create other components and nodes, so run them on the main thread first.
+    // A start may remove components from the phase, which swaps the last one into the current slot
+    for (unsigned i = 0; i < parallelUpdateComponents_.Size();)
+    {
+        LogicComponent* component = parallelUpdateComponents_[i];
+        if (!component->delayedStartCalled_)
+        {
+            component->DelayedStart();
+            component->delayedStartCalled_ = true;
+            component->UpdateEventSubscription();
+        }
+
+        if (i < parallelUpdateComponents_.Size() && parallelUpdateComponents_[i] == component)
+            ++i;
+    }
+
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
+
+    BeginThreadedUpdate();
+    queue->ParallelFor(0, parallelUpdateComponents_.Size(), 0, [this, timeStep](unsigned begin, unsigned end, unsigned threadIndex)
+    {
+        for (unsigned i = begin; i < end; ++i)
+        {
+            LogicComponent* component = parallelUpdateComponents_[i];
+            if (component)
+                component->Update(timeStep);
+        }
+    });
+
+    // Drop the removed components before the delayed calls run, as they may add and remove more
+    if (parallelUpdateRemoved_)
+        PurgeParallelUpdate();
+    EndThreadedUpdate();
+}
+
+void Scene::PurgeParallelUpdate()
+{
+    unsigned count = 0;
+    for (unsigned i = 0; i < parallelUpdateComponents_.Size(); ++i)
+    {
+        LogicComponent* component = parallelUpdateComponents_[i];
+        if (component)
+        {
+            component->parallelUpdateIndex_ = count;
+            parallelUpdateComponents_[count++] = component;
+        }
+    }
+
+    parallelUpdateComponents_.Resize(count);
+    parallelUpdateRemoved_ = false;
+}
+
+// ATOMIC END
+
 unsigned Scene::GetFreeNodeID(CreateMode mode)
 {
     if (mode == REPLICATED)
@@ -930,7 +1362,7 @@ void Scene::NodeAdded(Node* node)
     // If node with same ID exists, remove the scene reference from it and overwrite with the new node
     if (id < FIRST_LOCAL_ID)
     {
-        HashMap<unsigned, Node*>::Iterator i = replicatedNodes_.Find(id);
+        FlatHashMap<unsigned, Node*>::Iterator i = replicatedNodes_.Find(id);
         if (i != replicatedNodes_.End() && i->second_ != node)
         {
             ATOMIC_LOGWARNING("Overwriting node with ID " + String(id));
@@ -944,7 +1376,7 @@ void Scene::NodeAdded(Node* node)
     }
     else
     {
-        HashMap<unsigned, Node*>::Iterator i = localNodes_.Find(id);
+        FlatHashMap<unsigned, Node*>::Iterator i = localNodes_.Find(id);
         if (i != localNodes_.End() && i->second_ != node)
         {
             ATOMIC_LOGWARNING("Overwriting node with ID " + String(id));
@@ -961,6 +1393,11 @@ void Scene::NodeAdded(Node* node)
             taggedNodes_[tags[i]].Push(node);
     }
 
+    // ATOMIC BEGIN
+    if (indexingEnabled_)
+        IndexNode(node, node->GetNameHash());
+    // ATOMIC END
+
     // Add already created components and child nodes now
     const Vector<SharedPtr<Component> >& components = node->GetComponents();
     for (Vector<SharedPtr<Component> >::ConstIterator i = components.Begin(); i != components.End(); ++i)
@@ -994,6 +1431,12 @@ void Scene::NodeRemoved(Node* node)
     else
         localNodes_.Erase(id);
 
+    // ATOMIC BEGIN
+    // Removes the whole subtree, the recursive calls for the child nodes find them already removed
+    if (transforms_)
+        transforms_->RemoveNode(node);
+    // ATOMIC END
+
     node->ResetScene();
 
     // Remove node from tag cache
@@ -1004,6 +1447,11 @@ void Scene::NodeRemoved(Node* node)
             taggedNodes_[tags[i]].Remove(node);
     }
 
+    // ATOMIC BEGIN
+    if (indexingEnabled_)
+        UnindexNode(node, node->GetNameHash());
+    // ATOMIC END
+
     // Remove components and child nodes as well
     const Vector<SharedPtr<Component> >& components = node->GetComponents();
     for (Vector<SharedPtr<Component> >::ConstIterator i = components.Begin(); i != components.End(); ++i)
@@ -1029,7 +1477,7 @@ void Scene::ComponentAdded(Component* component)
 
     if (id < FIRST_LOCAL_ID)
     {
-        HashMap<unsigned, Component*>::Iterator i = replicatedComponents_.Find(id);
+        FlatHashMap<unsigned, Component*>::Iterator i = replicatedComponents_.Find(id);
         if (i != replicatedComponents_.End() && i->second_ != component)
         {
             ATOMIC_LOGWARNING("Overwriting component with ID " + String(id));
@@ -1040,7 +1488,7 @@ void Scene::ComponentAdded(Component* component)
     }
     else
     {
-        HashMap<unsigned, Component*>::Iterator i = localComponents_.Find(id);
+        FlatHashMap<unsigned, Component*>::Iterator i = localComponents_.Find(id);
         if (i != localComponents_.End() && i->second_ != component)
         {
             ATOMIC_LOGWARNING("Overwriting component with ID " + String(id));
@@ -1050,6 +1498,11 @@ void Scene::ComponentAdded(Component* component)
         localComponents_[id] = component;
     }
 
+    // ATOMIC BEGIN
+    if (indexingEnabled_)
+        IndexComponent(component);
+    // ATOMIC END
+
     component->OnSceneSet(this);
 }
 
@@ -1064,6 +1517,11 @@ void Scene::ComponentRemoved(Component* component)
     else
         localComponents_.Erase(id);
 
+    // ATOMIC BEGIN
+    if (indexingEnabled_)
+        UnindexComponent(component);
+    // ATOMIC END
+
     component->SetID(0);
     component->OnSceneSet(0);
 }
@@ -1092,20 +1550,22 @@ String Scene::GetVarNamesAttr() const
     return ret;
 }
 
-void Scene::PrepareNetworkUpdate()
+// ATOMIC BEGIN
+void Scene::PrepareNetworkUpdate(ReplicationFanout* fanout)
+// ATOMIC END
 {
-    for (HashSet<unsigned>::Iterator i = networkUpdateNodes_.Begin(); i != networkUpdateNodes_.End(); ++i)
+    for (FlatHashSet<unsigned>::Iterator i = networkUpdateNodes_.Begin(); i != networkUpdateNodes_.End(); ++i)
     {
         Node* node = GetNode(*i);
         if (node)
-            node->PrepareNetworkUpdate();
+            node->PrepareNetworkUpdate(fanout);
     }
 
-    for (HashSet<unsigned>::Iterator i = networkUpdateComponents_.Begin(); i != networkUpdateComponents_.End(); ++i)
+    for (FlatHashSet<unsigned>::Iterator i = networkUpdateComponents_.Begin(); i != networkUpdateComponents_.End(); ++i)
     {
         Component* component = GetComponent(*i);
         if (component)
-            component->PrepareNetworkUpdate();
+            component->PrepareNetworkUpdate(fanout);
     }
 
     networkUpdateNodes_.Clear();
@@ -1116,10 +1576,10 @@ void Scene::CleanupConnection(Connection* connection)
 {
     Node::CleanupConnection(connection);
 
-    for (HashMap<unsigned, Node*>::Iterator i = replicatedNodes_.Begin(); i != replicatedNodes_.End(); ++i)
+    for (FlatHashMap<unsigned, Node*>::Iterator i = replicatedNodes_.Begin(); i != replicatedNodes_.End(); ++i)
         i->second_->CleanupConnection(connection);
 
-    for (HashMap<unsigned, Component*>::Iterator i = replicatedComponents_.Begin(); i != replicatedComponents_.End(); ++i)
+    for (FlatHashMap<unsigned, Component*>::Iterator i = replicatedComponents_.Begin(); i != replicatedComponents_.End(); ++i)
         i->second_->CleanupConnection(connection);
 }
 
@@ -1166,14 +1626,15 @@ void Scene::MarkReplicationDirty(Node* node)
     }
 }
 
-void Scene::HandleUpdate(StringHash eventType, VariantMap& eventData)
+// ATOMIC BEGIN
+void Scene::HandleUpdate(StringHash eventType, const UpdateEventPayload& payload)
 {
     if (!updateEnabled_)
         return;
 
-    using namespace Update;
-    Update(eventData[P_TIMESTEP].GetFloat());
+    Update(payload.timeStep_);
 }
+// ATOMIC END
 
 void Scene::HandleResourceBackgroundLoaded(StringHash eventType, VariantMap& eventData)
 {
@@ -1229,6 +1690,20 @@ void Scene::UpdateAsyncLoading()
             newNode->LoadJSON(childValue, resolver_);
             ++asyncProgress_.jsonIndex_;
         }
+        // ATOMIC BEGIN
+        else if (asyncProgress_.loader_)
+        {
+            // Attach nodes decoded by the worker threads. Wait for the next frame if none are ready or out of time
+            if (!asyncProgress_.loader_->Attach(this, resolver_, asyncLoadTimer, asyncLoadingMs_ * 1000))
+                break;
+        }
+        else if (asyncProgress_.packedScene_)
+        {
+            PackedScene* packedScene = asyncProgress_.packedScene_;
+            packedScene->LoadSubtree(this, asyncProgress_.packedIndex_, resolver_);
+            asyncProgress_.packedIndex_ = packedScene->GetNode(asyncProgress_.packedIndex_).end_;
+        }
+        // ATOMIC END
         else // Load from binary
         {
             unsigned nodeID = asyncProgress_.file_->ReadUInt();
@@ -1260,6 +1735,11 @@ void Scene::FinishAsyncLoading()
 {
     if (asyncProgress_.mode_ > LOAD_RESOURCES_ONLY)
     {
+        // ATOMIC BEGIN
+        // Release the file from the worker threads before it is checksummed
+        if (asyncProgress_.loader_)
+            asyncProgress_.loader_->Stop();
+        // ATOMIC END
         resolver_.Resolve();
         ApplyAttributes();
         FinishLoading(asyncProgress_.file_);
@@ -1532,6 +2012,82 @@ void Scene::PreloadResourcesJSON(const JSONValue& value)
 #endif
 }
 
+// ATOMIC BEGIN
+void Scene::PreloadResourcesPacked(PackedScene* packedScene)
+{
+    // If not threaded, can not background load resources, so rather load synchronously later when needed
+#ifdef ATOMIC_THREADING
+    ResourceCache* cache = GetSubsystem<ResourceCache>();
+
+    // Node or Scene attributes do not include any resources, and the component blobs can be read in any order
+    for (unsigned i = 0; i < packedScene->GetNumComponents(); ++i)
+    {
+        const PackedComponentEntry& entry = packedScene->GetComponent(i);
+        const Vector<AttributeInfo>* attributes = context_->GetAttributes(StringHash(entry.type_));
+        if (!attributes)
+            continue;
+
+        MemoryBuffer compBuffer(packedScene->GetData(entry.dataOffset_), entry.dataSize_);
+        for (unsigned j = 0; j < attributes->Size() && !compBuffer.IsEof(); ++j)
+        {
+            const AttributeInfo& attr = attributes->At(j);
+            if (!(attr.mode_ & AM_FILE))
+                continue;
+            Variant varValue = compBuffer.ReadVariant(attr.type_);
+            if (attr.type_ == VAR_RESOURCEREF)
+            {
+                const ResourceRef& ref = varValue.GetResourceRef();
+                // Sanitate resource name beforehand so that when we get the background load event, the name matches exactly
+                String name = cache->SanitateResourceName(ref.name_);
+                bool success = cache->BackgroundLoadResource(ref.type_, name);
+                if (success)
+                {
+                    ++asyncProgress_.totalResources_;
+                    asyncProgress_.resources_.Insert(StringHash(name));
+                }
+            }
+            else if (attr.type_ == VAR_RESOURCEREFLIST)
+            {
+                const ResourceRefList& refList = varValue.GetResourceRefList();
+                for (unsigned k = 0; k < refList.names_.Size(); ++k)
+                {
+                    String name = cache->SanitateResourceName(refList.names_[k]);
+                    bool success = cache->BackgroundLoadResource(refList.type_, name);
+                    if (success)
+                    {
+                        ++asyncProgress_.totalResources_;
+                        asyncProgress_.resources_.Insert(StringHash(name));
+                    }
+                }
+            }
+        }
+    }
+#endif
+}
+// ATOMIC END
+
+// ATOMIC BEGIN
+
+void SceneUpdateEventPayload::ToVariantMap(VariantMap& eventData) const
+{
+    using namespace SceneUpdate;
+
+    eventData[P_SCENE] = scene_;
+    eventData[P_TIMESTEP] = timeStep_;
+}
+
+void SceneUpdateEventPayload::FromVariantMap(const VariantMap& eventData)
+{
+    using namespace SceneUpdate;
+
+    VariantMap::ConstIterator i = eventData.Find(P_SCENE);
+    scene_ = i != eventData.End() ? static_cast<Scene*>(i->second_.GetPtr()) : 0;
+    i = eventData.Find(P_TIMESTEP);
+    timeStep_ = i != eventData.End() ? i->second_.GetFloat() : 0.0f;
+}
+
+// ATOMIC END
+
 void RegisterSceneLibrary(Context* context)
 {
     ValueAnimation::RegisterObject(context);
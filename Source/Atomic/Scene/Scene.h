@@ -23,17 +23,34 @@
 #pragma once
 
 #include "../Container/HashSet.h"
+// ATOMIC BEGIN
+#include "../Container/FlatHashMap.h"
+#include "../Container/FlatHashSet.h"
+#include "../Core/Context.h"
+// ATOMIC END
 #include "../Core/Mutex.h"
 #include "../Resource/XMLElement.h"
 #include "../Resource/JSONFile.h"
 #include "../Scene/Node.h"
 #include "../Scene/SceneResolver.h"
+// ATOMIC BEGIN
+#include "../Scene/AsyncSceneLoader.h"
+#include "../Scene/PackedScene.h"
+// ATOMIC END
 
 namespace Atomic
 {
 
 class File;
 class PackageFile;
+// ATOMIC BEGIN
+class LogicComponent;
+class PrefabCache;
+class SceneTransforms;
+// ATOMIC END
+// ATOMIC BEGIN
+struct UpdateEventPayload;
+// ATOMIC END
 
 static const unsigned FIRST_REPLICATED_ID = 0x1;
 static const unsigned LAST_REPLICATED_ID = 0xffffff;
@@ -67,6 +84,15 @@ struct AsyncProgress
     /// Current JSON child array and for JSON mode
     unsigned jsonIndex_;
 
+    // ATOMIC BEGIN
+    /// Packed scene for packed binary mode.
+    SharedPtr<PackedScene> packedScene_;
+    /// Next root-level node entry for packed binary mode.
+    unsigned packedIndex_;
+    /// Worker thread decoder for binary and packed binary modes, when threaded async loading is enabled.
+    SharedPtr<AsyncSceneLoader> loader_;
+    // ATOMIC END
+
     /// Current load mode.
     LoadMode mode_;
     /// Resource name hashes left to load.
@@ -98,7 +124,7 @@ public:
     /// Register object factory. Node must be registered first.
     static void RegisterObject(Context* context);
 
-    /// Load from binary data. Removes all existing child nodes and components first. Return true if successful.
+    /// Load from binary or packed binary data. Removes all existing child nodes and components first. Return true if successful.
     virtual bool Load(Deserializer& source, bool setInstanceDefault = false);
     /// Save to binary data. Return true if successful.
     virtual bool Save(Serializer& dest) const;
@@ -119,7 +145,11 @@ public:
     bool SaveXML(Serializer& dest, const String& indentation = "\t") const;
     /// Save to a JSON file. Return true if successful.
     bool SaveJSON(Serializer& dest, const String& indentation = "\t") const;
-    /// Load from a binary file asynchronously. Return true if started successfully. The LOAD_RESOURCES_ONLY mode can also be used to preload resources from object prefab files.
+    // ATOMIC BEGIN
+    /// Save to a packed binary file, which Load() and LoadAsync() read through a memory mapping. Return true if successful.
+    bool SavePacked(Serializer& dest) const;
+    // ATOMIC END
+    /// Load from a binary or packed binary file asynchronously. Return true if started successfully. The LOAD_RESOURCES_ONLY mode can also be used to preload resources from object prefab files.
     bool LoadAsync(File* file, LoadMode mode = LOAD_SCENE_AND_RESOURCES);
     /// Load from an XML file asynchronously. Return true if started successfully. The LOAD_RESOURCES_ONLY mode can also be used to preload resources from object prefab files.
     bool LoadAsyncXML(File* file, LoadMode mode = LOAD_SCENE_AND_RESOURCES);
@@ -171,6 +201,32 @@ public:
     Component* GetComponent(unsigned id) const;
     /// Get nodes with specific tag from the whole scene, return false if empty.
     bool GetNodesWithTag(PODVector<Node*>& dest, const String& tag)  const;
+    // ATOMIC BEGIN
+    /// Enable or disable the lookup index of components by type and nodes by name. While enabled, recursive lookups from the scene itself use the index instead of walking the whole tree, and return matches in index order rather than depth-first order. Lookups from other nodes always walk their subtree, which is cheaper than filtering the scene-wide index.
+    void SetIndexingEnabled(bool enable);
+    /// Return whether the lookup index is enabled.
+    bool IsIndexingEnabled() const { return indexingEnabled_; }
+    /// Return all components of an exact type in the scene, in unspecified order. Requires the lookup index, empty otherwise.
+    const PODVector<Component*>& GetComponentsOfType(StringHash type) const;
+    /// Template version of returning all components of a type in the scene. Copies them to the destination vector, which is cleared first.
+    template <class T> void GetComponentsOfType(PODVector<T*>& dest) const;
+    /// Return all named nodes in the scene with a name hash, in unspecified order. Requires the lookup index, empty otherwise.
+    const PODVector<Node*>& GetNodesWithName(StringHash nameHash) const;
+    /// Enable or disable batched world transform update. While enabled, marking a node dirty walks the scene's depth level arrays instead of recursing through the child nodes, and the world transforms of the dirty nodes are recomputed at the end of each scene update in depth order, optionally split between worker threads. Listener components are still notified when a node is marked, and nodes still resolve their world transform lazily if queried before the update.
+    void SetTransformBatching(bool enable, bool threaded = false);
+    /// Return whether batched world transform update is enabled.
+    bool IsTransformBatchingEnabled() const { return transforms_.NotNull(); }
+    /// Recompute the world transforms of all dirty nodes now. No-op unless transform batching is enabled.
+    void UpdateTransforms();
+    /// Return batched transform state, or null if transform batching is disabled.
+    SceneTransforms* GetTransforms() const { return transforms_.Get(); }
+    /// Enable or disable decoding binary and packed scene content in worker threads during async loading. The main thread then only attaches the decoded nodes. Takes effect on the next LoadAsync().
+    void SetAsyncLoadingThreaded(bool enable) { asyncLoadingThreaded_ = enable; }
+    /// Return whether async loading decodes scene content in worker threads.
+    bool IsAsyncLoadingThreaded() const { return asyncLoadingThreaded_; }
+    /// Return the prefab cache for pooled and batched prefab instantiation, creating it on first use.
+    PrefabCache* GetPrefabCache();
+    // ATOMIC END
 
     /// Return whether updates are enabled.
     bool IsUpdateEnabled() const { return updateEnabled_; }
@@ -219,6 +275,14 @@ public:
     void EndThreadedUpdate();
     /// Add a component to the delayed dirty notify queue. Is thread-safe.
     void DelayedMarkedDirty(Component* component);
+    // ATOMIC BEGIN
+    /// Queue a function to run on the main thread at the end of a threaded update, for operations that are not thread-safe. Runs the function immediately outside threaded update. Is thread-safe.
+    void DelayedCall(const std::function<void()>& function);
+    /// Add a logic component to the parallel update phase. Called by LogicComponent.
+    void AddParallelUpdate(LogicComponent* component);
+    /// Remove a logic component from the parallel update phase. Called by LogicComponent. During threaded update only clears the component's slot, which is dropped after the parallel phase.
+    void RemoveParallelUpdate(LogicComponent* component);
+    // ATOMIC END
 
     /// Return threaded update flag.
     bool IsThreadedUpdate() const { return threadedUpdate_; }
@@ -233,6 +297,10 @@ public:
     /// Cache node by tag if tag not zero.
     void NodeTagRemoved(Node* node, const String& tag);
 
+    // ATOMIC BEGIN
+    /// Update the lookup index after a node was renamed. Called by Node::SetName.
+    void NodeNameChanged(Node* node, StringHash oldNameHash);
+    // ATOMIC END
     /// Node added. Assign scene pointer and add to ID map.
     void NodeAdded(Node* node);
     /// Node removed. Remove from ID map.
@@ -245,8 +313,12 @@ public:
     void SetVarNamesAttr(const String& value);
     /// Return node user variable reverse mappings.
     String GetVarNamesAttr() const;
-    /// Prepare network update by comparing attributes and marking replication states dirty as necessary.
-    void PrepareNetworkUpdate();
+    // ATOMIC BEGIN
+    /// Prepare network update by comparing attributes and marking replication states dirty as necessary. When a fan-out is given, also serialize the changes once for all connections.
+    void PrepareNetworkUpdate(ReplicationFanout* fanout = 0);
+    /// Return IDs of the nodes marked for network update since the last prepared network update.
+    const FlatHashSet<unsigned>& GetNetworkUpdateNodes() const { return networkUpdateNodes_; }
+    // ATOMIC END
     /// Clean up all references to a network connection that is about to be removed.
     void CleanupConnection(Connection* connection);
     /// Mark a node for attribute check on the next network update.
@@ -257,8 +329,10 @@ public:
     void MarkReplicationDirty(Node* node);
 
 private:
+    // ATOMIC BEGIN
     /// Handle the logic update event to update the scene, if active.
-    void HandleUpdate(StringHash eventType, VariantMap& eventData);
+    void HandleUpdate(StringHash eventType, const UpdateEventPayload& payload);
+    // ATOMIC END
     /// Handle a background loaded resource completing.
     void HandleResourceBackgroundLoaded(StringHash eventType, VariantMap& eventData);
     /// Update asynchronous loading.
@@ -275,15 +349,35 @@ private:
     void PreloadResourcesXML(const XMLElement& element);
     /// Preload resources from a JSON scene or object prefab file.
     void PreloadResourcesJSON(const JSONValue& value);
+    // ATOMIC BEGIN
+    /// Add component to the lookup index.
+    void IndexComponent(Component* component);
+    /// Remove component from the lookup index.
+    void UnindexComponent(Component* component);
+    /// Add node to the lookup index under a name hash.
+    void IndexNode(Node* node, StringHash nameHash);
+    /// Remove node from the lookup index under a name hash.
+    void UnindexNode(Node* node, StringHash nameHash);
+    /// Load from packed binary data after the file ID has been read.
+    bool LoadPacked(Deserializer& source, bool setInstanceDefault);
+    /// Start asynchronous loading from a packed binary file after the file ID has been read.
+    bool LoadAsyncPacked(File* file, LoadMode mode);
+    /// Preload resources from a packed binary scene file.
+    void PreloadResourcesPacked(PackedScene* packedScene);
+    /// Run the parallel update phase of logic components.
+    void UpdateParallelLogic(float timeStep);
+    /// Drop the parallel update slots cleared during threaded update.
+    void PurgeParallelUpdate();
+    // ATOMIC END
 
     /// Replicated scene nodes by ID.
-    HashMap<unsigned, Node*> replicatedNodes_;
+    FlatHashMap<unsigned, Node*> replicatedNodes_;
     /// Local scene nodes by ID.
-    HashMap<unsigned, Node*> localNodes_;
+    FlatHashMap<unsigned, Node*> localNodes_;
     /// Replicated components by ID.
-    HashMap<unsigned, Component*> replicatedComponents_;
+    FlatHashMap<unsigned, Component*> replicatedComponents_;
     /// Local components by ID.
-    HashMap<unsigned, Component*> localComponents_;
+    FlatHashMap<unsigned, Component*> localComponents_;
     /// Cached tagged nodes by tag.
     HashMap<StringHash, PODVector<Node*> > taggedNodes_;
     /// Asynchronous loading progress.
@@ -297,15 +391,45 @@ private:
     /// Registered node user variable reverse mappings.
     HashMap<StringHash, String> varNames_;
     /// Nodes to check for attribute changes on the next network update.
-    HashSet<unsigned> networkUpdateNodes_;
+    FlatHashSet<unsigned> networkUpdateNodes_;
     /// Components to check for attribute changes on the next network update.
-    HashSet<unsigned> networkUpdateComponents_;
+    FlatHashSet<unsigned> networkUpdateComponents_;
     /// Delayed dirty notification queue for components.
     PODVector<Component*> delayedDirtyComponents_;
     /// Mutex for the delayed dirty notification queue.
     Mutex sceneMutex_;
     /// Preallocated event data map for smoothing update events.
     VariantMap smoothingData_;
+    // ATOMIC BEGIN
+    /// Channel for the scene update event.
+    EventChannel sceneUpdateChannel_;
+    /// Channel for the attribute animation update event.
+    EventChannel attributeAnimationUpdateChannel_;
+    /// Channel for the scene subsystem update event.
+    EventChannel sceneSubsystemUpdateChannel_;
+    /// Channel for the scene post-update event.
+    EventChannel scenePostUpdateChannel_;
+    /// Components by exact type, when indexing is enabled.
+    FlatHashMap<StringHash, PODVector<Component*> > componentsByType_;
+    /// Named nodes by name hash, when indexing is enabled.
+    FlatHashMap<StringHash, PODVector<Node*> > nodesByName_;
+    /// Lookup index enabled flag.
+    bool indexingEnabled_;
+    /// Batched world transform state, when transform batching is enabled.
+    UniquePtr<SceneTransforms> transforms_;
+    /// Split batched world transform update between worker threads flag.
+    bool transformsThreaded_;
+    /// Decode async loaded scene content in worker threads flag.
+    bool asyncLoadingThreaded_;
+    /// Prefab cache, created on first use.
+    SharedPtr<PrefabCache> prefabCache_;
+    /// Logic components updated in worker threads. Null for components removed during threaded update.
+    PODVector<LogicComponent*> parallelUpdateComponents_;
+    /// Components removed from the parallel update phase during threaded update flag.
+    bool parallelUpdateRemoved_;
+    /// Functions queued to run at the end of the threaded update.
+    Vector<std::function<void()> > delayedCalls_;
+    // ATOMIC END
     /// Next free non-local node ID.
     unsigned replicatedNodeID_;
     /// Next free non-local component ID.
@@ -334,6 +458,16 @@ private:
     bool threadedUpdate_;
 };
 
+// ATOMIC BEGIN
+template <class T> void Scene::GetComponentsOfType(PODVector<T*>& dest) const
+{
+    const PODVector<Component*>& components = GetComponentsOfType(T::GetTypeStatic());
+    dest.Resize(components.Size());
+    for (unsigned i = 0; i < components.Size(); ++i)
+        dest[i] = static_cast<T*>(components[i]);
+}
+// ATOMIC END
+
 /// Register Scene library objects.
 void ATOMIC_API RegisterSceneLibrary(Context* context);
 
@@ -212,4 +212,31 @@ ATOMIC_EVENT(E_INTERCEPTNETWORKUPDATE, InterceptNetworkUpdate)
     ATOMIC_PARAM(P_VALUE, Value);                  // Variant
 }
 
+// ATOMIC BEGIN
+
+class Scene;
+
+/// Typed payload of the E_SCENEUPDATE, E_SCENESUBSYSTEMUPDATE, E_ATTRIBUTEANIMATIONUPDATE and E_SCENEPOSTUPDATE events.
+struct ATOMIC_API SceneUpdateEventPayload : public EventPayload
+{
+    /// Construct.
+    SceneUpdateEventPayload(Scene* scene = 0, float timeStep = 0.0f) :
+        scene_(scene),
+        timeStep_(timeStep)
+    {
+    }
+
+    /// Write the parameters to an event data map.
+    virtual void ToVariantMap(VariantMap& eventData) const;
+    /// Read the parameters from an event data map.
+    virtual void FromVariantMap(const VariantMap& eventData);
+
+    /// Scene being updated.
+    Scene* scene_;
+    /// Frame timestep.
+    float timeStep_;
+};
+
+// ATOMIC END
+
 }
@@ -0,0 +1,305 @@
+//
+// Copyright (c) 2014-2017 THUNDERBEAST GAMES LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../Precompiled.h"
+
+#include "../Core/Profiler.h"
+#include "../Core/WorkQueue.h"
+#include "../Scene/Scene.h"
+#include "../Scene/SceneTransforms.h"
+
+#include "../DebugNew.h"
+
+namespace Atomic
+{
+
+/// Dirty list size below which splitting between worker threads is not worth it.
+static const unsigned MIN_THREADED_LEVEL_SIZE = 1024;
+
+SceneTransforms::SceneTransforms(Scene* scene) :
+    scene_(scene),
+    numNodes_(0)
+{
+    const Vector<SharedPtr<Node> >& rootChildren = scene_->children_;
+    for (unsigned i = 0; i < rootChildren.Size(); ++i)
+        AddNode(rootChildren[i]);
+}
+
+SceneTransforms::~SceneTransforms()
+{
+    for (unsigned i = 0; i < levels_.Size(); ++i)
+    {
+        const PODVector<Node*>& nodes = levels_[i].nodes_;
+        for (unsigned j = 0; j < nodes.Size(); ++j)
+            nodes[j]->impl_->transformIndex_ = M_MAX_UNSIGNED;
+    }
+}
+
+void SceneTransforms::AddNode(Node* node)
+{
+    if (node->impl_->transformIndex_ != M_MAX_UNSIGNED)
+        return;
+
+    Node* parent = node->parent_;
+    if (!parent)
+        return;
+
+    if (parent == scene_)
+        AddEntry(node, 0, M_MAX_UNSIGNED);
+    else if (parent->impl_->transformIndex_ != M_MAX_UNSIGNED)
+        AddEntry(node, parent->impl_->transformLevel_ + 1, parent->impl_->transformIndex_);
+    else
+        return;
+
+    const Vector<SharedPtr<Node> >& children = node->children_;
+    for (unsigned i = 0; i < children.Size(); ++i)
+        AddNode(children[i]);
+}
+
+void SceneTransforms::RemoveNode(Node* node)
+{
+    if (node->impl_->transformIndex_ != M_MAX_UNSIGNED)
+        RemoveSubtree(node->impl_->transformLevel_, node->impl_->transformIndex_);
+}
+
+void SceneTransforms::MarkDirty(Node* node)
+{
+    if (scene_->IsThreadedUpdate())
+    {
+        MutexLock lock(mutex_);
+        MarkSubtree(node);
+    }
+    else
+        MarkSubtree(node);
+}
+
+void SceneTransforms::MarkSubtree(Node* node)
+{
+    unsigned level = node->impl_->transformLevel_;
+    MarkEntry(levels_[level], node->impl_->transformIndex_);
+
+    // Walk down one level at a time. The nodes marked on a level are the tail of its dirty list, and their children are
+    // marked next. Children that already are dirty have dirty descendants as well and are skipped
+    unsigned begin = levels_[level].dirty_.Size() - 1;
+    unsigned end = begin + 1;
+    while (++level < levels_.Size() && begin < end)
+    {
+        Level& parents = levels_[level - 1];
+        Level& children = levels_[level];
+        unsigned nextBegin = children.dirty_.Size();
+
+        for (unsigned i = begin; i < end; ++i)
+        {
+            unsigned parent = parents.dirty_[i];
+            if (parent == M_MAX_UNSIGNED)
+                continue;
+
+            for (unsigned child = parents.firstChildren_[parent]; child != M_MAX_UNSIGNED; child = children.nextSiblings_[child])
+            {
+                if (!children.nodes_[child]->dirty_)
+                    MarkEntry(children, child);
+            }
+        }
+
+        begin = nextBegin;
+        end = children.dirty_.Size();
+    }
+}
+
+void SceneTransforms::Update(WorkQueue* queue)
+{
+    ATOMIC_PROFILE(UpdateSceneTransforms);
+
+    if (queue && !queue->GetNumThreads())
+        queue = 0;
+
+    // Each level only reads the world transforms of the previous one, so the dirty nodes of a level are independent
+    for (unsigned i = 0; i < levels_.Size(); ++i)
+    {
+        Level& level = levels_[i];
+        unsigned numDirty = level.dirty_.Size();
+        if (!numDirty)
+            continue;
+
+        if (queue && numDirty >= MIN_THREADED_LEVEL_SIZE)
+        {
+            queue->ParallelFor(0, numDirty, 0, [this, &level](unsigned rangeBegin, unsigned rangeEnd, unsigned threadIndex)
+            {
+                UpdateRange(level, rangeBegin, rangeEnd);
+            });
+        }
+        else
+            UpdateRange(level, 0, numDirty);
+
+        level.dirty_.Clear();
+    }
+
+    while (levels_.Size() && levels_.Back().nodes_.Empty())
+        levels_.Pop();
+}
+
+void SceneTransforms::AddEntry(Node* node, unsigned level, unsigned parent)
+{
+    if (levels_.Size() <= level)
+        levels_.Resize(level + 1);
+
+    Level& dest = levels_[level];
+    unsigned index = dest.nodes_.Size();
+    unsigned next = M_MAX_UNSIGNED;
+
+    // Link as the first child of the parent
+    if (parent != M_MAX_UNSIGNED)
+    {
+        unsigned& firstChild = levels_[level - 1].firstChildren_[parent];
+        next = firstChild;
+        if (next != M_MAX_UNSIGNED)
+            dest.prevSiblings_[next] = index;
+        firstChild = index;
+    }
+
+    dest.nodes_.Push(node);
+    dest.parents_.Push(parent);
+    dest.firstChildren_.Push(M_MAX_UNSIGNED);
+    dest.prevSiblings_.Push(M_MAX_UNSIGNED);
+    dest.nextSiblings_.Push(next);
+    dest.dirtySlots_.Push(M_MAX_UNSIGNED);
+    node->impl_->transformLevel_ = level;
+    node->impl_->transformIndex_ = index;
+    ++numNodes_;
+
+    if (node->dirty_)
+    {
+        dest.dirtySlots_[index] = dest.dirty_.Size();
+        dest.dirty_.Push(index);
+    }
+}
+
+void SceneTransforms::RemoveSubtree(unsigned level, unsigned index)
+{
+    // Remove the children first, so that no remaining entry refers to the removed one as its parent
+    while (levels_[level].firstChildren_[index] != M_MAX_UNSIGNED)
+        RemoveSubtree(level + 1, levels_[level].firstChildren_[index]);
+
+    Level& src = levels_[level];
+    unsigned parent = src.parents_[index];
+    unsigned prev = src.prevSiblings_[index];
+    unsigned next = src.nextSiblings_[index];
+
+    if (prev != M_MAX_UNSIGNED)
+        src.nextSiblings_[prev] = next;
+    else if (parent != M_MAX_UNSIGNED)
+        levels_[level - 1].firstChildren_[parent] = next;
+    if (next != M_MAX_UNSIGNED)
+        src.prevSiblings_[next] = prev;
+
+    if (src.dirtySlots_[index] != M_MAX_UNSIGNED)
+        src.dirty_[src.dirtySlots_[index]] = M_MAX_UNSIGNED;
+
+    src.nodes_[index]->impl_->transformIndex_ = M_MAX_UNSIGNED;
+    --numNodes_;
+
+    // Move the last node of the level into the hole and redirect everything that refers to it
+    unsigned last = src.nodes_.Size() - 1;
+    if (index != last)
+    {
+        Node* moved = src.nodes_[last];
+        moved->impl_->transformIndex_ = index;
+        src.nodes_[index] = moved;
+        parent = src.parents_[index] = src.parents_[last];
+        prev = src.prevSiblings_[index] = src.prevSiblings_[last];
+        next = src.nextSiblings_[index] = src.nextSiblings_[last];
+        unsigned firstChild = src.firstChildren_[index] = src.firstChildren_[last];
+        unsigned dirtySlot = src.dirtySlots_[index] = src.dirtySlots_[last];
+
+        if (prev != M_MAX_UNSIGNED)
+            src.nextSiblings_[prev] = index;
+        else if (parent != M_MAX_UNSIGNED)
+            levels_[level - 1].firstChildren_[parent] = index;
+        if (next != M_MAX_UNSIGNED)
+            src.prevSiblings_[next] = index;
+        if (dirtySlot != M_MAX_UNSIGNED)
+            src.dirty_[dirtySlot] = index;
+
+        if (firstChild != M_MAX_UNSIGNED)
+        {
+            Level& children = levels_[level + 1];
+            for (unsigned child = firstChild; child != M_MAX_UNSIGNED; child = children.nextSiblings_[child])
+                children.parents_[child] = index;
+        }
+    }
+
+    src.nodes_.Pop();
+    src.parents_.Pop();
+    src.firstChildren_.Pop();
+    src.prevSiblings_.Pop();
+    src.nextSiblings_.Pop();
+    src.dirtySlots_.Pop();
+}
+
+void SceneTransforms::MarkEntry(Level& level, unsigned index)
+{
+    Node* node = level.nodes_[index];
+    node->dirty_ = true;
+
+    // A node resolved lazily since it was listed is moved to the tail, where MarkDirty expects the newly marked nodes
+    unsigned& dirtySlot = level.dirtySlots_[index];
+    if (dirtySlot != M_MAX_UNSIGNED)
+        level.dirty_[dirtySlot] = M_MAX_UNSIGNED;
+    dirtySlot = level.dirty_.Size();
+    level.dirty_.Push(index);
+
+    node->NotifyListeners();
+}
+
+void SceneTransforms::UpdateRange(Level& level, unsigned begin, unsigned end)
+{
+    for (unsigned i = begin; i < end; ++i)
+    {
+        unsigned index = level.dirty_[i];
+        if (index == M_MAX_UNSIGNED)
+            continue;
+
+        level.dirtySlots_[index] = M_MAX_UNSIGNED;
+        Node* node = level.nodes_[index];
+
+        // Skip nodes resolved lazily since they were marked. A dirty parent was recomputed with the previous level
+        if (!node->dirty_)
+            continue;
+
+        Node* parent = node->parent_;
+        if (!parent || parent == scene_)
+        {
+            node->worldTransform_ = node->GetTransform();
+            node->worldRotation_ = node->rotation_;
+        }
+        else
+        {
+            node->worldTransform_ = parent->worldTransform_ * node->GetTransform();
+            node->worldRotation_ = parent->worldRotation_ * node->rotation_;
+        }
+
+        node->dirty_ = false;
+    }
+}
+
+}
@@ -0,0 +1,104 @@
+//
+// Copyright (c) 2014-2017 THUNDERBEAST GAMES LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "../Container/Vector.h"
+#include "../Core/Mutex.h"
+
+namespace Atomic
+{
+
+class Node;
+class Scene;
+class WorkQueue;
+
+/// Scene-level batched world transform update. Keeps the scene hierarchy in per-depth-level arrays, propagates dirty flags
+/// through them and recomputes the world transforms of the dirty nodes level by level, optionally in worker threads. The
+/// world transforms themselves are stored in the nodes only.
+class ATOMIC_API SceneTransforms
+{
+public:
+    /// Construct and add all nodes already in the scene.
+    SceneTransforms(Scene* scene);
+    /// Destruct. Detaches the nodes still in the arrays.
+    ~SceneTransforms();
+
+    /// Add a node and its children to the arrays. Called after the node was attached to its parent.
+    void AddNode(Node* node);
+    /// Remove a node and its children from the arrays. Called when the node is removed from the scene or reparented.
+    void RemoveNode(Node* node);
+    /// Mark a clean node and all its clean descendants dirty, notifying their listener components. Called by Node::MarkDirty.
+    /// Serialized during threaded update, when logic components in worker threads move their nodes.
+    void MarkDirty(Node* node);
+    /// Recompute the world transforms of nodes marked dirty since the last update. Splits large depth levels between worker
+    /// threads if a work queue is given.
+    void Update(WorkQueue* queue = 0);
+
+    /// Return number of nodes in the arrays.
+    unsigned GetNumNodes() const { return numNodes_; }
+    /// Return number of depth levels in the arrays.
+    unsigned GetNumLevels() const { return levels_.Size(); }
+
+private:
+    /// Nodes of one depth level. Children of a node are linked through sibling indices in the next level.
+    struct Level
+    {
+        /// Nodes.
+        PODVector<Node*> nodes_;
+        /// Parent index in the previous level, M_MAX_UNSIGNED for children of the scene root.
+        PODVector<unsigned> parents_;
+        /// First child index in the next level.
+        PODVector<unsigned> firstChildren_;
+        /// Previous sibling index.
+        PODVector<unsigned> prevSiblings_;
+        /// Next sibling index.
+        PODVector<unsigned> nextSiblings_;
+        /// Position in the dirty list of each node, M_MAX_UNSIGNED if not listed.
+        PODVector<unsigned> dirtySlots_;
+        /// Indices of nodes marked dirty since the last update, M_MAX_UNSIGNED for removed entries.
+        PODVector<unsigned> dirty_;
+    };
+
+    /// Append a node to a depth level.
+    void AddEntry(Node* node, unsigned level, unsigned parent);
+    /// Mark a node and its clean descendants dirty.
+    void MarkSubtree(Node* node);
+    /// Remove a node and its children from the arrays, children first.
+    void RemoveSubtree(unsigned level, unsigned index);
+    /// Mark a node dirty, add it to its level's dirty list and notify its listener components.
+    void MarkEntry(Level& level, unsigned index);
+    /// Recompute world transforms for a range of a level's dirty list.
+    void UpdateRange(Level& level, unsigned begin, unsigned end);
+
+    /// Scene.
+    Scene* scene_;
+    /// Depth levels.
+    Vector<Level> levels_;
+    /// Total number of nodes.
+    unsigned numNodes_;
+    /// Mutex for marking nodes dirty during threaded update.
+    Mutex mutex_;
+};
+
+}
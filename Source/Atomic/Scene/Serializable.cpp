@@ -23,8 +23,14 @@
 #include "../Precompiled.h"
 
 #include "../Core/Context.h"
+// ATOMIC BEGIN
+#include "../IO/BitStream.h"
+// ATOMIC END
 #include "../IO/Deserializer.h"
 #include "../IO/Log.h"
+// ATOMIC BEGIN
+#include "../IO/MemoryBuffer.h"
+// ATOMIC END
 #include "../IO/Serializer.h"
 #include "../Resource/XMLElement.h"
 #include "../Resource/JSONValue.h"
@@ -55,6 +61,135 @@ static unsigned RemapAttributeIndex(const Vector<AttributeInfo>* attributes, con
     return netAttrIndex; // Could not remap
 }
 
+// ATOMIC BEGIN
+/// Maximum size of the bit-packed attributes of one network update: 64 attributes of up to 4 x 32 bits.
+static const unsigned MAX_PACKED_ATTRIBUTE_BYTES = MAX_NETWORK_ATTRIBUTES * 16;
+
+/// Return number of bits the selected bit-packed network attributes take.
+static unsigned GetNumPackedBits(const Vector<AttributeInfo>& attributes, const DirtyBits& attributeBits)
+{
+    unsigned numBits = 0;
+    for (unsigned i = 0; i < attributes.Size(); ++i)
+    {
+        if (attributeBits.IsSet(i))
+            numBits += attributes[i].netEncoding_.GetNumBits(attributes[i].type_);
+    }
+    return numBits;
+}
+
+/// Write a bit-packed network attribute value.
+static void WritePackedAttribute(BitWriter& packed, const AttributeInfo& attr, const Variant& value)
+{
+    const AttributeNetEncoding& encoding = attr.netEncoding_;
+    if (attr.type_ == VAR_QUATERNION)
+    {
+        packed.WriteSmallestThree(value.GetQuaternion(), encoding.bits_);
+        return;
+    }
+
+    float floatValue = value.GetFloat();
+    const float* data = &floatValue;
+    unsigned numComponents = 1;
+    if (attr.type_ == VAR_VECTOR2)
+    {
+        data = value.GetVector2().Data();
+        numComponents = 2;
+    }
+    else if (attr.type_ == VAR_VECTOR3)
+    {
+        data = value.GetVector3().Data();
+        numComponents = 3;
+    }
+    else if (attr.type_ == VAR_VECTOR4)
+    {
+        data = value.GetVector4().Data();
+        numComponents = 4;
+    }
+
+    for (unsigned i = 0; i < numComponents; ++i)
+    {
+        if (encoding.mode_ == NET_ENCODING_HALF)
+            packed.WriteHalf(data[i]);
+        else
+            packed.WriteFixed(data[i], encoding.minValue_, encoding.maxValue_, encoding.bits_);
+    }
+}
+
+/// Write the selected network attribute values: first the bit-packed attributes, then the others as variant data.
+static void WriteNetworkAttributes(Serializer& dest, const Vector<AttributeInfo>& attributes, const Vector<Variant>& values,
+    const DirtyBits& attributeBits)
+{
+    {
+        BitWriter packed(dest);
+        for (unsigned i = 0; i < attributes.Size(); ++i)
+        {
+            if (attributeBits.IsSet(i) && attributes[i].netEncoding_.GetNumBits(attributes[i].type_))
+                WritePackedAttribute(packed, attributes[i], values[i]);
+        }
+    }
+
+    for (unsigned i = 0; i < attributes.Size(); ++i)
+    {
+        if (attributeBits.IsSet(i) && !attributes[i].netEncoding_.GetNumBits(attributes[i].type_))
+            dest.WriteVariantData(values[i]);
+    }
+}
+
+/// Read a bit-packed network attribute value.
+static Variant ReadPackedAttribute(BitReader& source, const AttributeInfo& attr)
+{
+    const AttributeNetEncoding& encoding = attr.netEncoding_;
+    if (attr.type_ == VAR_QUATERNION)
+        return source.ReadSmallestThree(encoding.bits_);
+
+    float data[4];
+    unsigned numComponents = attr.type_ == VAR_VECTOR2 ? 2 : attr.type_ == VAR_VECTOR3 ? 3 : attr.type_ == VAR_VECTOR4 ? 4 : 1;
+    for (unsigned i = 0; i < numComponents; ++i)
+    {
+        if (encoding.mode_ == NET_ENCODING_HALF)
+            data[i] = source.ReadHalf();
+        else
+            data[i] = source.ReadFixed(encoding.minValue_, encoding.maxValue_, encoding.bits_);
+    }
+
+    switch (attr.type_)
+    {
+    case VAR_VECTOR2:
+        return Vector2(data);
+    case VAR_VECTOR3:
+        return Vector3(data);
+    case VAR_VECTOR4:
+        return Vector4(data);
+    default:
+        return data[0];
+    }
+}
+// ATOMIC END
+
+// ATOMIC BEGIN
+bool Serializable::IsNetworkAttributeChanged(const AttributeInfo& attr, const Variant& current, const Variant& previous)
+{
+    if (current == previous)
+        return false;
+    if (!attr.netEncoding_.GetNumBits(attr.type_) || current.GetType() != attr.type_ || previous.GetType() != attr.type_)
+        return true;
+
+    // Compare the values as they would be sent, so that changes below the precision of the encoding are not sent
+    unsigned char currentData[16];
+    unsigned char previousData[16];
+    {
+        MemoryBuffer currentDest(currentData, sizeof currentData);
+        MemoryBuffer previousDest(previousData, sizeof previousData);
+        BitWriter currentPacked(currentDest);
+        BitWriter previousPacked(previousDest);
+        WritePackedAttribute(currentPacked, attr, current);
+        WritePackedAttribute(previousPacked, attr, previous);
+    }
+
+    return memcmp(currentData, previousData, (attr.netEncoding_.GetNumBits(attr.type_) + 7) >> 3) != 0;
+}
+// ATOMIC END
+
 Serializable::Serializable(Context* context) :
     Object(context),
     temporary_(false)
@@ -307,6 +442,40 @@ bool Serializable::Load(Deserializer& source, bool setInstanceDefault)
     return true;
 }
 
+// ATOMIC BEGIN
+
+bool Serializable::LoadValues(const VariantVector& values, bool setInstanceDefault)
+{
+    const Vector<AttributeInfo>* attributes = GetAttributes();
+    if (!attributes)
+        return true;
+
+    unsigned index = 0;
+    for (unsigned i = 0; i < attributes->Size(); ++i)
+    {
+        const AttributeInfo& attr = attributes->At(i);
+        if (!(attr.mode_ & AM_FILE))
+            continue;
+
+        if (index >= values.Size())
+        {
+            ATOMIC_LOGERROR("Could not load " + GetTypeName() + ", not enough attribute values");
+            return false;
+        }
+
+        OnSetAttribute(attr, values[index]);
+
+        if (setInstanceDefault)
+            SetInstanceDefault(attr.name_, values[index]);
+
+        ++index;
+    }
+
+    return true;
+}
+
+// ATOMIC END
+
 bool Serializable::Save(Serializer& dest) const
 {
     const Vector<AttributeInfo>* attributes = GetAttributes();
@@ -763,11 +932,9 @@ void Serializable::WriteInitialDeltaUpdate(Serializer& dest, unsigned char timeS
     dest.WriteUByte(timeStamp);
     dest.Write(attributeBits.data_, (numAttributes + 7) >> 3);
 
-    for (unsigned i = 0; i < numAttributes; ++i)
-    {
-        if (attributeBits.IsSet(i))
-            dest.WriteVariantData(networkState_->currentValues_[i]);
-    }
+    // ATOMIC BEGIN
+    WriteNetworkAttributes(dest, *attributes, networkState_->currentValues_, attributeBits);
+    // ATOMIC END
 }
 
 void Serializable::WriteDeltaUpdate(Serializer& dest, const DirtyBits& attributeBits, unsigned char timeStamp)
@@ -789,11 +956,9 @@ void Serializable::WriteDeltaUpdate(Serializer& dest, const DirtyBits& attribute
     dest.WriteUByte(timeStamp);
     dest.Write(attributeBits.data_, (numAttributes + 7) >> 3);
 
-    for (unsigned i = 0; i < numAttributes; ++i)
-    {
-        if (attributeBits.IsSet(i))
-            dest.WriteVariantData(networkState_->currentValues_[i]);
-    }
+    // ATOMIC BEGIN
+    WriteNetworkAttributes(dest, *attributes, networkState_->currentValues_, attributeBits);
+    // ATOMIC END
 }
 
 void Serializable::WriteLatestDataUpdate(Serializer& dest, unsigned char timeStamp)
@@ -812,11 +977,16 @@ void Serializable::WriteLatestDataUpdate(Serializer& dest, unsigned char timeSta
 
     dest.WriteUByte(timeStamp);
 
+    // ATOMIC BEGIN
+    DirtyBits latestDataBits;
     for (unsigned i = 0; i < numAttributes; ++i)
     {
         if (attributes->At(i).mode_ & AM_LATESTDATA)
-            dest.WriteVariantData(networkState_->currentValues_[i]);
+            latestDataBits.Set(i);
     }
+
+    WriteNetworkAttributes(dest, *attributes, networkState_->currentValues_, latestDataBits);
+    // ATOMIC END
 }
 
 bool Serializable::ReadDeltaUpdate(Deserializer& source)
@@ -833,14 +1003,26 @@ bool Serializable::ReadDeltaUpdate(Deserializer& source)
     unsigned char timeStamp = source.ReadUByte();
     source.Read(attributeBits.data_, (numAttributes + 7) >> 3);
 
-    for (unsigned i = 0; i < numAttributes && !source.IsEof(); ++i)
+    // ATOMIC BEGIN
+    // The bit-packed attributes precede the others, so read them aside to apply all attributes in order
+    unsigned char packedData[MAX_PACKED_ATTRIBUTE_BYTES];
+    unsigned packedSize = source.Read(packedData, (GetNumPackedBits(*attributes, attributeBits) + 7) >> 3);
+    MemoryBuffer packedBuffer(packedData, packedSize);
+    BitReader packed(packedBuffer);
+    // ATOMIC END
+
+    for (unsigned i = 0; i < numAttributes && !(source.IsEof() && packedBuffer.IsEof()); ++i)
     {
         if (attributeBits.IsSet(i))
         {
             const AttributeInfo& attr = attributes->At(i);
+            // ATOMIC BEGIN
+            Variant value = attr.netEncoding_.GetNumBits(attr.type_) ? ReadPackedAttribute(packed, attr) :
+                source.ReadVariant(attr.type_);
+            // ATOMIC END
             if (!(interceptMask & (1ULL << i)))
             {
-                OnSetAttribute(attr, source.ReadVariant(attr.type_));
+                OnSetAttribute(attr, value);
                 changed = true;
             }
             else
@@ -852,7 +1034,7 @@ bool Serializable::ReadDeltaUpdate(Deserializer& source)
                 eventData[P_TIMESTAMP] = (unsigned)timeStamp;
                 eventData[P_INDEX] = RemapAttributeIndex(GetAttributes(), attr, i);
                 eventData[P_NAME] = attr.name_;
-                eventData[P_VALUE] = source.ReadVariant(attr.type_);
+                eventData[P_VALUE] = value;
                 SendEvent(E_INTERCEPTNETWORKUPDATE, eventData);
             }
         }
@@ -873,14 +1055,33 @@ bool Serializable::ReadLatestDataUpdate(Deserializer& source)
     unsigned long long interceptMask = networkState_ ? networkState_->interceptMask_ : 0;
     unsigned char timeStamp = source.ReadUByte();
 
-    for (unsigned i = 0; i < numAttributes && !source.IsEof(); ++i)
+    // ATOMIC BEGIN
+    DirtyBits latestDataBits;
+    for (unsigned i = 0; i < numAttributes; ++i)
+    {
+        if (attributes->At(i).mode_ & AM_LATESTDATA)
+            latestDataBits.Set(i);
+    }
+
+    // The bit-packed attributes precede the others, so read them aside to apply all attributes in order
+    unsigned char packedData[MAX_PACKED_ATTRIBUTE_BYTES];
+    unsigned packedSize = source.Read(packedData, (GetNumPackedBits(*attributes, latestDataBits) + 7) >> 3);
+    MemoryBuffer packedBuffer(packedData, packedSize);
+    BitReader packed(packedBuffer);
+    // ATOMIC END
+
+    for (unsigned i = 0; i < numAttributes && !(source.IsEof() && packedBuffer.IsEof()); ++i)
     {
         const AttributeInfo& attr = attributes->At(i);
         if (attr.mode_ & AM_LATESTDATA)
         {
+            // ATOMIC BEGIN
+            Variant value = attr.netEncoding_.GetNumBits(attr.type_) ? ReadPackedAttribute(packed, attr) :
+                source.ReadVariant(attr.type_);
+            // ATOMIC END
             if (!(interceptMask & (1ULL << i)))
             {
-                OnSetAttribute(attr, source.ReadVariant(attr.type_));
+                OnSetAttribute(attr, value);
                 changed = true;
             }
             else
@@ -892,7 +1093,7 @@ bool Serializable::ReadLatestDataUpdate(Deserializer& source)
                 eventData[P_TIMESTAMP] = (unsigned)timeStamp;
                 eventData[P_INDEX] = RemapAttributeIndex(GetAttributes(), attr, i);
                 eventData[P_NAME] = attr.name_;
-                eventData[P_VALUE] = source.ReadVariant(attr.type_);
+                eventData[P_VALUE] = value;
                 SendEvent(E_INTERCEPTNETWORKUPDATE, eventData);
             }
         }
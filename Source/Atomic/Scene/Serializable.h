@@ -61,6 +61,10 @@ public:
     virtual const Vector<AttributeInfo>* GetNetworkAttributes() const;
     /// Load from binary data. When setInstanceDefault is set to true, after setting the attribute value, store the value as instance's default value. Return true if successful.
     virtual bool Load(Deserializer& source, bool setInstanceDefault = false);
+    // ATOMIC BEGIN
+    /// Load from attribute values decoded in advance, in the order of the file attributes. When setInstanceDefault is set to true, after setting the attribute value, store the value as instance's default value. Return true if successful.
+    virtual bool LoadValues(const VariantVector& values, bool setInstanceDefault = false);
+    // ATOMIC END
     /// Save as binary data. Return true if successful.
     virtual bool Save(Serializer& dest) const;
     /// Load from XML data. When setInstanceDefault is set to true, after setting the attribute value, store the value as instance's default value. Return true if successful.
@@ -129,6 +133,11 @@ public:
     NetworkState* GetNetworkState() const { return networkState_.Get(); }
 
 protected:
+    // ATOMIC BEGIN
+    /// Return whether a network attribute value differs from the previously sent value. Bit-packed attributes are compared after encoding, so changes below their precision are not sent.
+    static bool IsNetworkAttributeChanged(const AttributeInfo& attr, const Variant& current, const Variant& previous);
+    // ATOMIC END
+
     /// Network attribute state.
     UniquePtr<NetworkState> networkState_;
 
@@ -365,6 +374,10 @@ public:
 #define ATOMIC_MIXED_ACCESSOR_ATTRIBUTE_FREE(name, getFunction, setFunction, typeName, defaultValue, mode) context->RegisterAttribute<ClassName>(Atomic::AttributeInfo(Atomic::GetVariantType<typeName >(), name, new Atomic::AttributeAccessorFreeImpl<ClassName, typeName, Atomic::MixedAttributeTrait<typeName > >(getFunction, setFunction), defaultValue, mode))
 /// Update the default value of an already registered attribute.
 #define ATOMIC_UPDATE_ATTRIBUTE_DEFAULT_VALUE(name, defaultValue) context->UpdateAttributeDefaultValue<ClassName>(name, defaultValue)
+// ATOMIC BEGIN
+/// Set the network encoding hint of an already registered attribute.
+#define ATOMIC_ATTRIBUTE_NET_ENCODING(name, encoding) context->SetAttributeNetEncoding<ClassName>(name, encoding)
+// ATOMIC END
 /// Define a variant structure attribute that uses get and set functions.
 #define ATOMIC_ACCESSOR_VARIANT_VECTOR_STRUCTURE_ATTRIBUTE(name, getFunction, setFunction, typeName, defaultValue, variantStructureElementNames, mode) context->RegisterAttribute<ClassName>(Atomic::AttributeInfo(Atomic::GetVariantType<typeName >(), name, new Atomic::AttributeAccessorImpl<ClassName, typeName, Atomic::AttributeTrait<typeName > >(&ClassName::getFunction, &ClassName::setFunction), defaultValue, variantStructureElementNames, mode))
 /// Define a variant structure attribute that uses get and set functions, where the get function returns by value, but the set function uses a reference.
@@ -288,6 +288,29 @@ void SplinePath::OnMarkedDirty(Node* point)
     if (!point)
         return;
 
+    // ATOMIC BEGIN
+    // Weak pointer manipulation is not safe from worker threads. The delayed notification names the own node, so all
+    // knots are refreshed then
+    Scene* scene = GetScene();
+    if (scene && scene->IsThreadedUpdate())
+    {
+        scene->DelayedMarkedDirty(this);
+        return;
+    }
+
+    if (point == node_)
+    {
+        for (unsigned i = 0; i < controlPoints_.Size(); ++i)
+        {
+            if (controlPoints_[i])
+                spline_.SetKnot(controlPoints_[i]->GetWorldPosition(), i);
+        }
+
+        CalculateLength();
+        return;
+    }
+    // ATOMIC END
+
     WeakPtr<Node> controlPoint(point);
 
     for (unsigned i = 0; i < controlPoints_.Size(); ++i)
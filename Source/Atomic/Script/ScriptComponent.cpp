@@ -51,22 +51,51 @@ ScriptComponent::~ScriptComponent()
 
 bool ScriptComponent::Load(Deserializer& source, bool setInstanceDefault)
 {
-    loading_ = true;
+    OnLoadStart();
     bool success = Component::Load(source, setInstanceDefault);
-    loading_ = false;
+    OnLoadEnd(success);
 
     return success;
 }
 
 bool ScriptComponent::LoadXML(const XMLElement& source, bool setInstanceDefault)
 {
-    loading_ = true;
+    OnLoadStart();
     bool success = Component::LoadXML(source, setInstanceDefault);
-    loading_ = false;
+    OnLoadEnd(success);
+
+    return success;
+}
+
+bool ScriptComponent::LoadJSON(const JSONValue& source, bool setInstanceDefault)
+{
+    OnLoadStart();
+    bool success = Component::LoadJSON(source, setInstanceDefault);
+    OnLoadEnd(success);
+
+    return success;
+}
+
+bool ScriptComponent::LoadValues(const VariantVector& values, bool setInstanceDefault)
+{
+    OnLoadStart();
+    bool success = Component::LoadValues(values, setInstanceDefault);
+    OnLoadEnd(success);
 
     return success;
 }
 
+void ScriptComponent::OnLoadStart()
+{
+    // Field values set while loading are converted by the component file, such as enum names to values
+    loading_ = true;
+}
+
+void ScriptComponent::OnLoadEnd(bool success)
+{
+    loading_ = false;
+}
+
 bool ScriptComponent::Save(Serializer& dest) const
 {
     saving_ = true;    
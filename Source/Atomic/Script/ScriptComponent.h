@@ -53,6 +53,10 @@ public:
     bool Load(Deserializer& source, bool setInstanceDefault);
     /// Load from XML data. Return true if successful.
     bool LoadXML(const XMLElement& source, bool setInstanceDefault);
+    /// Load from JSON data. Return true if successful.
+    bool LoadJSON(const JSONValue& source, bool setInstanceDefault);
+    /// Load from attribute values decoded in advance, as done by prefab instantiation and asynchronous scene loading. Return true if successful.
+    bool LoadValues(const VariantVector& values, bool setInstanceDefault);
 
     /// Save as binary data. Return true if successful.
     virtual bool Save(Serializer& dest) const;
@@ -61,6 +65,11 @@ public:
 
 protected:
 
+    /// Handle the start of loading from any format.
+    virtual void OnLoadStart();
+    /// Handle the end of loading from any format.
+    virtual void OnLoadEnd(bool success);
+
     const VariantMap& GetFieldValuesAttr() const;
     void SetFieldValuesAttr(const VariantMap& value);
 
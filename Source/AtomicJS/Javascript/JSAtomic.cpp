@@ -31,6 +31,7 @@
 #include <Atomic/Audio/Audio.h>
 #include <Atomic/UI/UI.h>
 #include <Atomic/Metrics/Metrics.h>
+#include <Atomic/Metrics/FrameStatistics.h>
 
 #ifdef ATOMIC_NETWORK
 #include <Atomic/Network/Network.h>
@@ -444,6 +445,9 @@ void jsapi_init_atomic(JSVM* vm)
     js_push_class_object_instance(ctx, vm->GetSubsystem<Metrics>(), "Metrics");
     duk_put_prop_string(ctx, -2, "metrics");
 
+    js_push_class_object_instance(ctx, vm->GetSubsystem<FrameStatistics>(), "FrameStatistics");
+    duk_put_prop_string(ctx, -2, "frameStatistics");
+
     duk_push_c_function(ctx, js_atomic_GetFileSystem, 0);
     duk_put_prop_string(ctx, -2, "getFileSystem");
 
@@ -169,42 +169,7 @@ void JSComponent::InitInstance(bool hasArgs, int argIdx)
 
     duk_idx_t top = duk_get_top(ctx);
 
-    // apply fields
-
-    const FieldMap& fields = componentFile_->GetFields();
-
-    if (fields.Size())
-    {
-        // push self
-        js_push_class_object_instance(ctx, this, "JSComponent");
-
-        FieldMap::ConstIterator itr = fields.Begin();
-        while (itr != fields.End())
-        {
-            if (fieldValues_.Contains(itr->first_))
-            {
-                Variant& v = fieldValues_[itr->first_];
-
-                if (v.GetType() == itr->second_.variantType_)
-                {
-                    js_push_variant(ctx, v);
-                    duk_put_prop_string(ctx, -2, itr->first_.CString());
-                }
-            }
-            else
-            {
-                Variant v;
-                componentFile_->GetDefaultFieldValue(itr->first_, v);
-                js_push_variant(ctx,  v);
-                duk_put_prop_string(ctx, -2, itr->first_.CString());
-            }
-
-            itr++;
-        }
-
-        // pop self
-        duk_pop(ctx);
-    }
+    ApplyFieldValues();
 
     // apply args if any
     if (hasArgs)
@@ -271,6 +236,57 @@ void JSComponent::InitInstance(bool hasArgs, int argIdx)
 
 }
 
+void JSComponent::ApplyFieldValues()
+{
+    duk_context* ctx = vm_->GetJSContext();
+
+    const FieldMap& fields = componentFile_->GetFields();
+
+    if (fields.Size())
+    {
+        // push self
+        js_push_class_object_instance(ctx, this, "JSComponent");
+
+        FieldMap::ConstIterator itr = fields.Begin();
+        while (itr != fields.End())
+        {
+            if (fieldValues_.Contains(itr->first_))
+            {
+                Variant& v = fieldValues_[itr->first_];
+
+                if (v.GetType() == itr->second_.variantType_)
+                {
+                    js_push_variant(ctx, v);
+                    duk_put_prop_string(ctx, -2, itr->first_.CString());
+                }
+            }
+            else
+            {
+                Variant v;
+                componentFile_->GetDefaultFieldValue(itr->first_, v);
+                js_push_variant(ctx,  v);
+                duk_put_prop_string(ctx, -2, itr->first_.CString());
+            }
+
+            itr++;
+        }
+
+        // pop self
+        duk_pop(ctx);
+    }
+}
+
+void JSComponent::OnReuse()
+{
+    // Pooled prefab instances keep their script object, so reset its fields and start it again like a new one
+    if (instanceInitialized_ && componentFile_.NotNull())
+        ApplyFieldValues();
+
+    started_ = false;
+    delayedStartCalled_ = false;
+    UpdateEventSubscription();
+}
+
 void JSComponent::CallScriptMethod(const String& name, bool passValue, float value)
 {
     if (destroyed_ || !node_ || !node_->GetScene())
@@ -94,6 +94,8 @@ protected:
     virtual void OnNodeSet(Node* node);
     /// Handle scene being assigned.
     virtual void OnSceneSet(Scene* scene);
+    /// Handle being reused from a prefab instance pool. Reapplies the field values to the script object and runs start and delayedStart again.
+    virtual void OnReuse();
 
 private:
     /// Subscribe/unsubscribe to update events based on current enabled state and update event mask.
@@ -110,6 +112,8 @@ private:
 #endif
 
     void CallScriptMethod(const String& name, bool passValue = false, float value = 0.0f);
+    /// Push the field values, or the defaults of fields without one, to the script object.
+    void ApplyFieldValues();
 
     /// Called when the component is added to a scene node. Other components may not yet exist.
     virtual void Start();
@@ -169,20 +169,8 @@ namespace Atomic
 
         ATOMIC_EXPORT_API unsigned csi_Atomic_AtomicNET_StringToStringHash(const char* str)
         {
-            unsigned hash = 0;
-
-            if (!str)
-                return hash;
-
-            while (*str)
-            {
-                // Perform the actual hashing as case-insensitive
-                char c = *str;
-                hash = SDBMHash(hash, (unsigned char)tolower(c));
-                ++str;
-            }
-
-            return hash;
+            // Same as the native StringHash, including the hash function selected at build time
+            return StringHash::Calculate(str);
         }
 
         ATOMIC_EXPORT_API void csi_Atomic_AtomicNET_ScriptVariantMapCopyVariantMap(ScriptVariantMap* svm, VariantMap* vm)
@@ -118,24 +118,12 @@ void CSComponent::SendLoadEvent()
 
 }
 
-bool CSComponent::Load(Deserializer& source, bool setInstanceDefault)
+void CSComponent::OnLoadEnd(bool success)
 {
-    bool success = ScriptComponent::Load(source, setInstanceDefault);
+    ScriptComponent::OnLoadEnd(success);
 
     if (success)
         SendLoadEvent();
-
-    return success;
-}
-
-bool CSComponent::LoadXML(const XMLElement& source, bool setInstanceDefault)
-{
-    bool success = ScriptComponent::LoadXML(source, setInstanceDefault);
-
-    if (success)
-        SendLoadEvent();
-
-    return success;
 }
 
 ScriptComponentFile* CSComponent::GetComponentFile() const
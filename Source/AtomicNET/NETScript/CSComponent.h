@@ -46,9 +46,6 @@ public:
     /// Register object factory.
     static void RegisterObject(Context* context);
 
-    bool Load(Deserializer& source, bool setInstanceDefault);
-    bool LoadXML(const XMLElement& source, bool setInstanceDefault);
-
     void ApplyAttributes();
 
     /// Handle enabled/disabled state change. Changes update event subscription.
@@ -64,6 +61,8 @@ public:
 
 protected:
 
+    /// Handle the end of loading from any format. Sends the load event to the managed component.
+    virtual void OnLoadEnd(bool success);
     /// Handle scene node being assigned at creation.
     virtual void OnNodeSet(Node* node);
     /// Handle scene being assigned.
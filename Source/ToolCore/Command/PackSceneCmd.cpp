@@ -0,0 +1,112 @@
+//
+// Copyright (c) 2014-2017 THUNDERBEAST GAMES LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <Atomic/Core/StringUtils.h>
+#include <Atomic/IO/File.h>
+#include <Atomic/IO/FileSystem.h>
+#include <Atomic/IO/Log.h>
+#include <Atomic/Scene/Scene.h>
+
+#include "../ToolSystem.h"
+#include "../Project/Project.h"
+
+#include "PackSceneCmd.h"
+
+namespace ToolCore
+{
+
+PackSceneCmd::PackSceneCmd(Context* context) : Command(context)
+{
+
+}
+
+PackSceneCmd::~PackSceneCmd()
+{
+
+}
+
+bool PackSceneCmd::ParseInternal(const Vector<String>& arguments, unsigned startIndex, String& errorMsg)
+{
+    String argument = arguments[startIndex].ToLower();
+
+    if (argument != "packscene")
+    {
+        errorMsg = "Unable to parse packscene command";
+        return false;
+    }
+
+    sourceFilename_ = startIndex + 1 < arguments.Size() ? arguments[startIndex + 1] : String::EMPTY;
+    destFilename_ = startIndex + 2 < arguments.Size() ? arguments[startIndex + 2] : String::EMPTY;
+
+    if (!sourceFilename_.Length() || sourceFilename_.StartsWith("-"))
+    {
+        errorMsg = "Unable to parse source scene filename";
+        return false;
+    }
+
+    if (!destFilename_.Length() || destFilename_.StartsWith("-"))
+        destFilename_ = ReplaceExtension(sourceFilename_, ".ascn");
+
+    return true;
+}
+
+void PackSceneCmd::Run()
+{
+    ToolSystem* tsystem = GetSubsystem<ToolSystem>();
+    Project* project = tsystem->GetProject();
+    String resourcePath = project->GetResourcePath();
+
+    String sourcePath = IsAbsolutePath(sourceFilename_) ? sourceFilename_ : resourcePath + sourceFilename_;
+    String destPath = IsAbsolutePath(destFilename_) ? destFilename_ : resourcePath + destFilename_;
+
+    SharedPtr<File> source(new File(context_));
+    if (!source->Open(sourcePath))
+    {
+        Error("Unable to open scene " + sourcePath);
+        return;
+    }
+
+    // Load through the scene itself, so that every component, including script components, serializes its own attributes
+    SharedPtr<Scene> scene(new Scene(context_));
+    bool loaded = GetExtension(sourcePath) == ".json" ? scene->LoadJSON(*source) : scene->LoadXML(*source);
+    source->Close();
+
+    if (!loaded)
+    {
+        Error("Unable to load scene " + sourcePath);
+        return;
+    }
+
+    SharedPtr<File> dest(new File(context_));
+    if (!dest->Open(destPath, FILE_WRITE) || !scene->SavePacked(*dest))
+    {
+        Error("Unable to save packed scene " + destPath);
+        return;
+    }
+
+    ATOMIC_LOGINFOF("Packed %s to %s", sourcePath.CString(), destPath.CString());
+
+    Finished();
+}
+
+}
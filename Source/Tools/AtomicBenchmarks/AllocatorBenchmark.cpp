@@ -0,0 +1,177 @@
+//
+// Copyright (c) 2014-2017 THUNDERBEAST GAMES LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <Atomic/Container/Allocator.h>
+#include <Atomic/Core/Mutex.h>
+#include <Atomic/Core/StringUtils.h>
+#include <Atomic/Core/Thread.h>
+#include <Atomic/Core/Timer.h>
+
+#include "Benchmark.h"
+
+namespace Atomic
+{
+
+static const unsigned ALLOCATOR_NUM_ROUNDS = 20000;
+static const unsigned ALLOCATOR_BATCH_SIZE = 16;
+static const unsigned ALLOCATOR_NUM_SAMPLES = 20;
+static const unsigned ALLOCATOR_MAX_THREADS = 8;
+
+/// Object allocated by the benchmark.
+struct AllocatorBenchmarkObject
+{
+    unsigned data_[16];
+};
+
+/// Allocation strategy under test.
+enum AllocatorBenchmarkMode
+{
+    ABM_MALLOC = 0,
+    ABM_LOCKED_ALLOCATOR,
+    ABM_CONCURRENT_ALLOCATOR
+};
+
+static const char* allocatorBenchmarkModeNames[] =
+{
+    "malloc",
+    "Allocator+Mutex",
+    "Allocator<ThreadSafe>"
+};
+
+/// Thread that repeatedly reserves and frees batches of objects.
+class AllocatorBenchmarkThread : public Thread
+{
+public:
+    /// Construct.
+    AllocatorBenchmarkThread(AllocatorBenchmarkMode mode, Allocator<AllocatorBenchmarkObject>* lockedAllocator, Mutex* mutex,
+        Allocator<AllocatorBenchmarkObject, true>* concurrentAllocator) :
+        mode_(mode),
+        lockedAllocator_(lockedAllocator),
+        mutex_(mutex),
+        concurrentAllocator_(concurrentAllocator)
+    {
+    }
+
+    /// Run the allocation rounds.
+    virtual void ThreadFunction()
+    {
+        AllocatorBenchmarkObject* objects[ALLOCATOR_BATCH_SIZE];
+
+        for (unsigned round = 0; round < ALLOCATOR_NUM_ROUNDS; ++round)
+        {
+            for (unsigned i = 0; i < ALLOCATOR_BATCH_SIZE; ++i)
+            {
+                switch (mode_)
+                {
+                case ABM_MALLOC:
+                    objects[i] = new AllocatorBenchmarkObject();
+                    break;
+
+                case ABM_LOCKED_ALLOCATOR:
+                    {
+                        MutexLock lock(*mutex_);
+                        objects[i] = lockedAllocator_->Reserve();
+                    }
+                    break;
+
+                case ABM_CONCURRENT_ALLOCATOR:
+                    objects[i] = concurrentAllocator_->Reserve();
+                    break;
+                }
+                objects[i]->data_[0] = round;
+            }
+
+            for (unsigned i = 0; i < ALLOCATOR_BATCH_SIZE; ++i)
+            {
+                switch (mode_)
+                {
+                case ABM_MALLOC:
+                    delete objects[i];
+                    break;
+
+                case ABM_LOCKED_ALLOCATOR:
+                    {
+                        MutexLock lock(*mutex_);
+                        lockedAllocator_->Free(objects[i]);
+                    }
+                    break;
+
+                case ABM_CONCURRENT_ALLOCATOR:
+                    concurrentAllocator_->Free(objects[i]);
+                    break;
+                }
+            }
+        }
+    }
+
+private:
+    /// Allocation strategy.
+    AllocatorBenchmarkMode mode_;
+    /// Single-threaded allocator, used under the mutex.
+    Allocator<AllocatorBenchmarkObject>* lockedAllocator_;
+    /// Mutex for the single-threaded allocator.
+    Mutex* mutex_;
+    /// Thread-safe allocator.
+    Allocator<AllocatorBenchmarkObject, true>* concurrentAllocator_;
+};
+
+static void RunAllocatorCase(AllocatorBenchmarkMode mode, unsigned numThreads)
+{
+    Allocator<AllocatorBenchmarkObject> lockedAllocator(ALLOCATOR_BATCH_SIZE * numThreads);
+    Mutex mutex;
+    Allocator<AllocatorBenchmarkObject, true> concurrentAllocator(ALLOCATOR_BATCH_SIZE * numThreads);
+
+    PODVector<float> samples;
+    HiresTimer timer;
+
+    for (unsigned sample = 0; sample < ALLOCATOR_NUM_SAMPLES; ++sample)
+    {
+        PODVector<AllocatorBenchmarkThread*> threads;
+        for (unsigned i = 0; i < numThreads; ++i)
+            threads.Push(new AllocatorBenchmarkThread(mode, &lockedAllocator, &mutex, &concurrentAllocator));
+
+        timer.Reset();
+        for (unsigned i = 0; i < numThreads; ++i)
+            threads[i]->Run();
+        for (unsigned i = 0; i < numThreads; ++i)
+            threads[i]->Stop();
+        samples.Push(timer.GetUSec(false) / 1000.0f);
+
+        for (unsigned i = 0; i < numThreads; ++i)
+            delete threads[i];
+    }
+
+    ReportSamples("Allocator", ToString("mode=%s,threads=%u", allocatorBenchmarkModeNames[mode], numThreads), samples);
+}
+
+void RunAllocatorBenchmark(Context* context)
+{
+    for (unsigned numThreads = 1; numThreads <= ALLOCATOR_MAX_THREADS; numThreads <<= 1)
+    {
+        RunAllocatorCase(ABM_MALLOC, numThreads);
+        RunAllocatorCase(ABM_LOCKED_ALLOCATOR, numThreads);
+        RunAllocatorCase(ABM_CONCURRENT_ALLOCATOR, numThreads);
+    }
+}
+
+}
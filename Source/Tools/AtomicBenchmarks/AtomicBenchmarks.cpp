@@ -0,0 +1,113 @@
+//
+// Copyright (c) 2014-2017 THUNDERBEAST GAMES LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <Atomic/Atomic.h>
+
+#include <Atomic/Core/Context.h>
+#include <Atomic/Core/ProcessUtils.h>
+#include <Atomic/Core/StringUtils.h>
+#include <Atomic/Core/Timer.h>
+
+#ifdef WIN32
+#include <windows.h>
+#endif
+
+#include "Benchmark.h"
+
+#include <Atomic/DebugNew.h>
+
+using namespace Atomic;
+
+struct BenchmarkEntry
+{
+    const char* name_;
+    BenchmarkFunction function_;
+};
+
+static const BenchmarkEntry benchmarks[] =
+{
+    { "Allocator", RunAllocatorBenchmark },
+    { "Containers", RunContainerBenchmark },
+    { "Events", RunEventBenchmark },
+#ifdef ATOMIC_JAVASCRIPT
+    { "Javascript", RunJavascriptBenchmark },
+#endif
+#if defined(ATOMIC_NAVIGATION) && defined(ATOMIC_PHYSICS)
+    { "Navigation", RunNavigationBenchmark },
+#endif
+#ifdef ATOMIC_NETWORK
+    { "Network", RunNetworkBenchmark },
+#endif
+#ifdef ATOMIC_PHYSICS
+    { "Physics", RunPhysicsBenchmark },
+#endif
+    { "Scene", RunSceneBenchmark },
+    { "Variant", RunVariantBenchmark },
+    { "WorkQueue", RunWorkQueueBenchmark },
+    { 0, 0 }
+};
+
+int main(int argc, char** argv);
+void Run(const Vector<String>& arguments);
+
+int main(int argc, char** argv)
+{
+    Vector<String> arguments;
+
+    #ifdef WIN32
+    arguments = ParseArguments(GetCommandLineW());
+    #else
+    arguments = ParseArguments(argc, argv);
+    #endif
+
+    Run(arguments);
+    return 0;
+}
+
+void Run(const Vector<String>& arguments)
+{
+    if (arguments.Size() && (arguments[0] == "-h" || arguments[0] == "--help"))
+    {
+        String usage = "Usage: AtomicBenchmarks [benchmark names]\n\nRuns all benchmarks if no names are given. Available benchmarks:\n";
+        for (const BenchmarkEntry* entry = benchmarks; entry->name_; ++entry)
+            usage += String(entry->name_) + "\n";
+        ErrorExit(usage);
+    }
+
+    SharedPtr<Context> context(new Context());
+    // Time subsystem initializes the high-resolution timer
+    context->RegisterSubsystem(new Time(context));
+
+    for (const BenchmarkEntry* entry = benchmarks; entry->name_; ++entry)
+    {
+        bool selected = arguments.Empty();
+        for (unsigned i = 0; i < arguments.Size(); ++i)
+        {
+            if (arguments[i].Compare(entry->name_, false) == 0)
+                selected = true;
+        }
+
+        if (selected)
+            entry->function_(context);
+    }
+}
@@ -0,0 +1,89 @@
+//
+// Copyright (c) 2014-2017 THUNDERBEAST GAMES LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <Atomic/Container/Sort.h>
+#include <Atomic/Core/ProcessUtils.h>
+#include <Atomic/Core/StringUtils.h>
+#include <Atomic/Engine/Engine.h>
+#include <Atomic/Engine/EngineDefs.h>
+
+#include "Benchmark.h"
+
+namespace Atomic
+{
+
+static float GetPercentile(const PODVector<float>& sortedSamples, float percentile)
+{
+    if (sortedSamples.Empty())
+        return 0.0f;
+
+    unsigned index = (unsigned)(percentile * (sortedSamples.Size() - 1) + 0.5f);
+    return sortedSamples[Min(index, sortedSamples.Size() - 1)];
+}
+
+void ReportSamples(const String& benchmark, const String& caseName, PODVector<float>& samplesMs)
+{
+    Sort(samplesMs.Begin(), samplesMs.End());
+
+    float total = 0.0f;
+    for (unsigned i = 0; i < samplesMs.Size(); ++i)
+        total += samplesMs[i];
+
+    float mean = samplesMs.Size() ? total / samplesMs.Size() : 0.0f;
+    float max = samplesMs.Size() ? samplesMs.Back() : 0.0f;
+
+    PrintLine(ToString("{\"benchmark\":\"%s\",\"case\":\"%s\",\"samples\":%u,\"meanMs\":%f,\"p50Ms\":%f,\"p90Ms\":%f,\"p99Ms\":%f,\"maxMs\":%f}",
+        benchmark.CString(), caseName.CString(), samplesMs.Size(), mean, GetPercentile(samplesMs, 0.5f),
+        GetPercentile(samplesMs, 0.9f), GetPercentile(samplesMs, 0.99f), max));
+}
+
+void ReportValue(const String& benchmark, const String& caseName, const String& valueName, double value)
+{
+    PrintLine(ToString("{\"benchmark\":\"%s\",\"case\":\"%s\",\"%s\":%f}", benchmark.CString(), caseName.CString(),
+        valueName.CString(), value));
+}
+
+SharedPtr<Engine> CreateHeadlessEngine(Context* context)
+{
+    SharedPtr<Engine> engine(new Engine(context));
+
+    VariantMap parameters;
+    parameters[EP_HEADLESS] = true;
+    parameters[EP_LOG_NAME] = String::EMPTY;
+    parameters[EP_LOG_QUIET] = true;
+    parameters[EP_RESOURCE_PATHS] = String::EMPTY;
+    parameters[EP_AUTOLOAD_PATHS] = String::EMPTY;
+
+    if (!engine->Initialize(parameters))
+    {
+        PrintLine("Failed to initialize headless engine", true);
+        return SharedPtr<Engine>();
+    }
+
+    // Benchmarks drive their own fixed time steps, so never sleep in RunFrame()
+    engine->SetMaxFps(0);
+    engine->SetMaxInactiveFps(0);
+    return engine;
+}
+
+}
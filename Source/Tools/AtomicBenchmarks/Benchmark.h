@@ -0,0 +1,65 @@
+//
+// Copyright (c) 2014-2017 THUNDERBEAST GAMES LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include <Atomic/Container/Str.h>
+#include <Atomic/Core/Context.h>
+
+namespace Atomic
+{
+
+class Engine;
+
+/// Benchmark entry point. Results are written to standard output with ReportSamples().
+typedef void (*BenchmarkFunction)(Context* context);
+
+/// Report timing samples of a benchmark case as one JSON line: sample count, mean, percentiles and maximum in milliseconds.
+void ReportSamples(const String& benchmark, const String& caseName, PODVector<float>& samplesMs);
+/// Report a single named value of a benchmark case as one JSON line.
+void ReportValue(const String& benchmark, const String& caseName, const String& valueName, double value);
+/// Create and initialize a headless engine in a newly created context, without resource paths or a log file. Return null on failure.
+SharedPtr<Engine> CreateHeadlessEngine(Context* context);
+
+/// Fixed-size allocator contention from 1 to 8 threads: malloc, the single-threaded allocator behind a mutex and the thread-safe allocator.
+void RunAllocatorBenchmark(Context* context);
+/// HashMap and HashSet against their open addressing counterparts: insert, lookup, iteration and erase at sizes from 8 to 20000.
+void RunContainerBenchmark(Context* context);
+/// Event dispatch to specific receivers: SendEvent() with a VariantMap, and an EventChannel with a typed payload to VariantMap and payload handlers.
+void RunEventBenchmark(Context* context);
+/// JSComponent update() calls from a script component on 1000 nodes.
+void RunJavascriptBenchmark(Context* context);
+/// Navigation mesh build and path queries on a 200x200 area with 400 box obstacles.
+void RunNavigationBenchmark(Context* context);
+/// Scene replication from a server to loopback clients, 1000 moving nodes: server tick time for 1 to 16 clients with serial and threaded connection updates, attribute bytes per tick with quantized positions, 16 clients with interest management on 1000 and 10000 nodes, and client position error at 10% packet loss with reliable and snapshot replication.
+void RunNetworkBenchmark(Context* context);
+/// Rigid body simulation of 1000 falling boxes at a fixed 60 Hz step.
+void RunPhysicsBenchmark(Context* context);
+/// 10000 node scene: creation, transform hierarchy updates with octree reinsertion, octree queries, and binary, XML and JSON save and load.
+void RunSceneBenchmark(Context* context);
+/// Variant and VariantMap: building maps of 4 and 8 parameters, sending them as events and serializing them.
+void RunVariantBenchmark(Context* context);
+/// Work queue scaling from 0 to N worker threads, with and without work stealing, and using ParallelFor().
+void RunWorkQueueBenchmark(Context* context);
+
+}
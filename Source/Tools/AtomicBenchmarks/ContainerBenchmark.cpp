@@ -0,0 +1,165 @@
+//
+// Copyright (c) 2014-2017 THUNDERBEAST GAMES LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <Atomic/Container/FlatHashMap.h>
+#include <Atomic/Container/FlatHashSet.h>
+#include <Atomic/Container/HashMap.h>
+#include <Atomic/Container/HashSet.h>
+#include <Atomic/Core/StringUtils.h>
+#include <Atomic/Core/Timer.h>
+#include <Atomic/Math/Random.h>
+
+#include "Benchmark.h"
+
+namespace Atomic
+{
+
+static const unsigned CONTAINER_NUM_SAMPLES = 20;
+/// Total number of elements processed per sample, split into repeats of the map size.
+static const unsigned CONTAINER_OPERATIONS = 200000;
+
+/// Generate unique keys in random order, as scene node IDs and resource name hashes look to a map.
+static void GenerateKeys(PODVector<unsigned>& keys, unsigned numKeys)
+{
+    HashSet<unsigned> used;
+    keys.Clear();
+    while (keys.Size() < numKeys)
+    {
+        unsigned key = (unsigned)Rand() << 16 ^ (unsigned)Rand();
+        if (!used.Contains(key))
+        {
+            used.Insert(key);
+            keys.Push(key);
+        }
+    }
+}
+
+template <class T> static void RunMapCase(const char* mapName, const PODVector<unsigned>& keys)
+{
+    unsigned numKeys = keys.Size();
+    unsigned repeats = Max(CONTAINER_OPERATIONS / numKeys, 1U);
+    PODVector<float> insertSamples;
+    PODVector<float> lookupSamples;
+    PODVector<float> iterateSamples;
+    PODVector<float> eraseSamples;
+    HiresTimer timer;
+    unsigned checksum = 0;
+
+    // Lookups in a scattered order that is the same for both map types
+    PODVector<unsigned> lookupKeys(numKeys);
+    for (unsigned i = 0; i < numKeys; ++i)
+        lookupKeys[i] = keys[(i * 7) % numKeys];
+
+    for (unsigned sample = 0; sample < CONTAINER_NUM_SAMPLES; ++sample)
+    {
+        // Use a separate map per repeat, so that small maps are not measured from the cache only
+        Vector<T> maps(repeats);
+
+        timer.Reset();
+        for (unsigned r = 0; r < repeats; ++r)
+        {
+            T& map = maps[r];
+            for (unsigned i = 0; i < numKeys; ++i)
+                map[keys[i]] = i;
+        }
+        insertSamples.Push(timer.GetUSec(true) / 1000.0f);
+
+        for (unsigned r = 0; r < repeats; ++r)
+        {
+            const T& map = maps[r];
+            for (unsigned i = 0; i < numKeys; ++i)
+                checksum += map.Find(lookupKeys[i])->second_;
+        }
+        lookupSamples.Push(timer.GetUSec(true) / 1000.0f);
+
+        for (unsigned r = 0; r < repeats; ++r)
+        {
+            const T& map = maps[r];
+            for (typename T::ConstIterator j = map.Begin(); j != map.End(); ++j)
+                checksum += j->second_;
+        }
+        iterateSamples.Push(timer.GetUSec(true) / 1000.0f);
+
+        for (unsigned r = 0; r < repeats; ++r)
+        {
+            T& map = maps[r];
+            for (unsigned i = 0; i < numKeys; ++i)
+                map.Erase(keys[i]);
+        }
+        eraseSamples.Push(timer.GetUSec(true) / 1000.0f);
+    }
+
+    String params = ToString("map=%s,size=%u,repeats=%u", mapName, numKeys, repeats);
+    ReportSamples("Containers", "case=Insert," + params, insertSamples);
+    ReportSamples("Containers", "case=Lookup," + params, lookupSamples);
+    ReportSamples("Containers", "case=Iterate," + params, iterateSamples);
+    ReportSamples("Containers", "case=Erase," + params, eraseSamples);
+    ReportValue("Containers", params, "checksum", checksum);
+}
+
+template <class T> static void RunSetCase(const char* setName, const PODVector<unsigned>& keys)
+{
+    unsigned numKeys = keys.Size();
+    unsigned repeats = Max(CONTAINER_OPERATIONS / numKeys, 1U);
+    PODVector<float> samples;
+    HiresTimer timer;
+    unsigned checksum = 0;
+
+    for (unsigned sample = 0; sample < CONTAINER_NUM_SAMPLES; ++sample)
+    {
+        timer.Reset();
+        for (unsigned r = 0; r < repeats; ++r)
+        {
+            // Insert every key, test membership of each and clear, as done with the per-frame network update sets
+            T set;
+            for (unsigned i = 0; i < numKeys; ++i)
+                set.Insert(keys[i]);
+            for (unsigned i = 0; i < numKeys; ++i)
+                checksum += set.Contains(keys[(i * 7) % numKeys]) ? 1 : 0;
+            set.Clear();
+        }
+        samples.Push(timer.GetUSec(false) / 1000.0f);
+    }
+
+    ReportSamples("Containers", ToString("case=InsertContains,set=%s,size=%u,repeats=%u,checksum=%u", setName, numKeys, repeats,
+        checksum), samples);
+}
+
+void RunContainerBenchmark(Context* context)
+{
+    static const unsigned sizes[] = { 8, 64, 1000, 20000 };
+
+    SetRandomSeed(1);
+    PODVector<unsigned> keys;
+
+    for (unsigned i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i)
+    {
+        GenerateKeys(keys, sizes[i]);
+        RunMapCase<HashMap<unsigned, unsigned> >("HashMap", keys);
+        RunMapCase<FlatHashMap<unsigned, unsigned> >("FlatHashMap", keys);
+        RunSetCase<HashSet<unsigned> >("HashSet", keys);
+        RunSetCase<FlatHashSet<unsigned> >("FlatHashSet", keys);
+    }
+}
+
+}
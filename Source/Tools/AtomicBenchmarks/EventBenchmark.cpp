@@ -0,0 +1,141 @@
+//
+// Copyright (c) 2014-2017 THUNDERBEAST GAMES LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+
+#include <Atomic/Core/CoreEvents.h>
+#include <Atomic/Core/StringUtils.h>
+#include <Atomic/Core/Timer.h>
+
+#include "Benchmark.h"
+
+namespace Atomic
+{
+
+static const unsigned EVENT_NUM_SENDS = 10000;
+static const unsigned EVENT_NUM_SAMPLES = 20;
+static const unsigned EVENT_NUM_RECEIVERS = 16;
+
+/// Dispatch path under test.
+enum EventBenchmarkMode
+{
+    EBM_SENDEVENT = 0,
+    EBM_CHANNEL_VARIANTMAP,
+    EBM_CHANNEL_PAYLOAD
+};
+
+static const char* eventBenchmarkModeNames[] =
+{
+    "SendEvent",
+    "EventChannel+VariantMapHandler",
+    "EventChannel+PayloadHandler"
+};
+
+/// Sender of the benchmark events.
+class EventBenchmarkSender : public Object
+{
+    ATOMIC_OBJECT(EventBenchmarkSender, Object)
+
+public:
+    /// Construct.
+    EventBenchmarkSender(Context* context) :
+        Object(context)
+    {
+    }
+};
+
+/// Receiver of the benchmark events.
+class EventBenchmarkReceiver : public Object
+{
+    ATOMIC_OBJECT(EventBenchmarkReceiver, Object)
+
+public:
+    /// Construct.
+    EventBenchmarkReceiver(Context* context) :
+        Object(context),
+        elapsed_(0.0f)
+    {
+    }
+
+    /// Handle update event with a VariantMap.
+    void HandleUpdate(StringHash eventType, VariantMap& eventData)
+    {
+        elapsed_ += eventData[Update::P_TIMESTEP].GetFloat();
+    }
+
+    /// Handle update event with a typed payload.
+    void HandleUpdatePayload(StringHash eventType, const UpdateEventPayload& payload)
+    {
+        elapsed_ += payload.timeStep_;
+    }
+
+    /// Accumulated timestep.
+    float elapsed_;
+};
+
+static void RunEventCase(Context* context, EventBenchmarkMode mode)
+{
+    SharedPtr<EventBenchmarkSender> sender(new EventBenchmarkSender(context));
+    Vector<SharedPtr<EventBenchmarkReceiver> > receivers;
+    for (unsigned i = 0; i < EVENT_NUM_RECEIVERS; ++i)
+    {
+        SharedPtr<EventBenchmarkReceiver> receiver(new EventBenchmarkReceiver(context));
+        if (mode == EBM_CHANNEL_PAYLOAD)
+            receiver->SubscribeToEvent(sender, E_UPDATE, new EventHandlerPayloadImpl<EventBenchmarkReceiver, UpdateEventPayload>(receiver,
+                &EventBenchmarkReceiver::HandleUpdatePayload));
+        else
+            receiver->SubscribeToEvent(sender, E_UPDATE, new EventHandlerImpl<EventBenchmarkReceiver>(receiver, &EventBenchmarkReceiver::HandleUpdate));
+        receivers.Push(receiver);
+    }
+
+    EventChannel channel(sender, E_UPDATE);
+    PODVector<float> samples;
+    HiresTimer timer;
+
+    for (unsigned sample = 0; sample < EVENT_NUM_SAMPLES; ++sample)
+    {
+        timer.Reset();
+        for (unsigned i = 0; i < EVENT_NUM_SENDS; ++i)
+        {
+            if (mode == EBM_SENDEVENT)
+            {
+                VariantMap& eventData = sender->GetEventDataMap();
+                eventData[Update::P_TIMESTEP] = 0.016f;
+                sender->SendEvent(E_UPDATE, eventData);
+            }
+            else
+                channel.Send(UpdateEventPayload(0.016f));
+        }
+        samples.Push(timer.GetUSec(false) / 1000.0f);
+    }
+
+    ReportSamples("Events", ToString("mode=%s,receivers=%u,sends=%u", eventBenchmarkModeNames[mode], EVENT_NUM_RECEIVERS, EVENT_NUM_SENDS), samples);
+}
+
+void RunEventBenchmark(Context* context)
+{
+    RunEventCase(context, EBM_SENDEVENT);
+    RunEventCase(context, EBM_CHANNEL_VARIANTMAP);
+    RunEventCase(context, EBM_CHANNEL_PAYLOAD);
+}
+
+}
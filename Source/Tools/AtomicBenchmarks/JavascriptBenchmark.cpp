@@ -0,0 +1,219 @@
+//
+// Copyright (c) 2014-2017 THUNDERBEAST GAMES LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <Atomic/Core/ProcessUtils.h>
+#include <Atomic/Core/StringUtils.h>
+#include <Atomic/Core/Timer.h>
+#include <Atomic/Engine/Engine.h>
+#include <Atomic/IO/File.h>
+#include <Atomic/IO/FileSystem.h>
+#include <Atomic/Resource/ResourceCache.h>
+#include <Atomic/Scene/PrefabCache.h>
+#include <Atomic/Scene/Scene.h>
+
+#ifdef ATOMIC_JAVASCRIPT
+#include <AtomicJS/Javascript/Javascript.h>
+#include <AtomicJS/Javascript/JSComponent.h>
+#include <AtomicJS/Javascript/JSComponentFile.h>
+#include <AtomicJS/Javascript/JSVM.h>
+#endif
+
+#include "Benchmark.h"
+
+namespace Atomic
+{
+
+#ifdef ATOMIC_JAVASCRIPT
+
+static const unsigned JAVASCRIPT_NUM_NODES = 1000;
+static const unsigned JAVASCRIPT_NUM_FRAMES = 300;
+static const unsigned JAVASCRIPT_NUM_PREFAB_INSTANCES = 500;
+static const unsigned JAVASCRIPT_NUM_PREFAB_REPEATS = 10;
+static const float JAVASCRIPT_PREFAB_SPEED = 2.0f;
+static const char* javascriptPrefabName = "Prefabs/BenchmarkSpinner.xml";
+
+static const char* javascriptComponentSource =
+    "\"atomic component\";\n"
+    "\n"
+    "var inspectorFields = {\n"
+    "  speed: 1.0\n"
+    "}\n"
+    "\n"
+    "exports.component = function(self) {\n"
+    "\n"
+    "  self.update = function(timeStep) {\n"
+    "    self.node.yaw(timeStep * 75 * self.speed);\n"
+    "  }\n"
+    "\n"
+    "}\n";
+
+/// Write the benchmark component to a resource directory and return the directory, or an empty string on failure.
+static String WriteComponentResources(Context* context)
+{
+    FileSystem* fileSystem = context->GetSubsystem<FileSystem>();
+    String resourceDir = fileSystem->GetAppPreferencesDir("AtomicGameEngine", "AtomicBenchmarks");
+    if (resourceDir.Empty() || !fileSystem->CreateDir(resourceDir + "Components"))
+        return String::EMPTY;
+
+    File file(context, resourceDir + "Components/BenchmarkSpinner.js", FILE_WRITE);
+    if (!file.IsOpen())
+        return String::EMPTY;
+    file.Write(javascriptComponentSource, String::CStringLength(javascriptComponentSource));
+    return resourceDir;
+}
+
+/// Write a prefab with the benchmark component and a non-default field value to the resource directory. Return true if successful.
+static bool WritePrefabResource(Context* context, const String& resourceDir, JSComponentFile* componentFile)
+{
+    FileSystem* fileSystem = context->GetSubsystem<FileSystem>();
+    if (!fileSystem->CreateDir(resourceDir + "Prefabs"))
+        return false;
+
+    SharedPtr<Scene> scene(new Scene(context));
+    Node* node = scene->CreateChild("Spinner");
+    SharedPtr<JSComponent> component = componentFile->CreateJSComponent();
+    node->AddComponent(component, component->GetID(), REPLICATED);
+    component->GetFieldValues()["speed"] = JAVASCRIPT_PREFAB_SPEED;
+
+    File file(context, resourceDir + javascriptPrefabName, FILE_WRITE);
+    return file.IsOpen() && node->SaveXML(file);
+}
+
+/// Instantiate the prefab repeatedly, releasing the instances in between, and check that the script fields survive.
+static void RunPrefabCase(Scene* scene, bool pooled)
+{
+    PrefabCache* prefabCache = scene->GetPrefabCache();
+    prefabCache->SetMaxPoolSize(pooled ? JAVASCRIPT_NUM_PREFAB_INSTANCES : 0);
+
+    PODVector<Node*> instances;
+    unsigned numMismatches = 0;
+
+    PODVector<float> samples;
+    HiresTimer timer;
+
+    for (unsigned i = 0; i < JAVASCRIPT_NUM_PREFAB_REPEATS; ++i)
+    {
+        instances.Clear();
+        timer.Reset();
+        for (unsigned j = 0; j < JAVASCRIPT_NUM_PREFAB_INSTANCES; ++j)
+        {
+            Vector3 position((float)(j % 32), 0.0f, (float)(j / 32));
+            instances.Push(prefabCache->Instantiate(javascriptPrefabName, position, Quaternion::IDENTITY, LOCAL));
+        }
+        samples.Push(timer.GetUSec(false) / 1000.0f);
+
+        for (unsigned j = 0; j < instances.Size(); ++j)
+        {
+            JSComponent* component = instances[j] ? instances[j]->GetComponent<JSComponent>() : 0;
+            if (!component || component->GetFieldValues()["speed"].GetFloat() != JAVASCRIPT_PREFAB_SPEED)
+                ++numMismatches;
+        }
+
+        // Run the script start functions as a spawned instance would on its first frame
+        scene->Update(1.0f / 60.0f);
+
+        for (unsigned j = 0; j < instances.Size(); ++j)
+            prefabCache->Release(instances[j], javascriptPrefabName);
+    }
+
+    prefabCache->Clear();
+
+    String name = ToString(pooled ? "PrefabInstantiatePooled,instances=%u" : "PrefabInstantiate,instances=%u",
+        JAVASCRIPT_NUM_PREFAB_INSTANCES);
+    ReportSamples("Javascript", name, samples);
+    ReportValue("Javascript", name, "fieldMismatches", numMismatches);
+}
+
+void RunJavascriptBenchmark(Context* context)
+{
+    SharedPtr<Context> engineContext(new Context());
+    SharedPtr<Engine> engine = CreateHeadlessEngine(engineContext);
+    if (!engine)
+        return;
+
+    String resourceDir = WriteComponentResources(engineContext);
+    if (resourceDir.Empty())
+    {
+        PrintLine("Failed to write benchmark component script", true);
+        return;
+    }
+
+    ResourceCache* cache = engineContext->GetSubsystem<ResourceCache>();
+    cache->AddResourceDir(resourceDir);
+
+    engineContext->RegisterSubsystem(new Javascript(engineContext));
+    SharedPtr<JSVM> vm(engineContext->GetSubsystem<Javascript>()->InstantiateVM("MainVM"));
+    vm->InitJSContext();
+
+    JSComponentFile* componentFile = cache->GetResource<JSComponentFile>("Components/BenchmarkSpinner.js");
+    if (!componentFile)
+    {
+        PrintLine("Failed to load benchmark component script", true);
+        return;
+    }
+
+    SharedPtr<Scene> scene(new Scene(engineContext));
+    for (unsigned i = 0; i < JAVASCRIPT_NUM_NODES; ++i)
+    {
+        Node* node = scene->CreateChild("Spinner");
+        node->SetPosition(Vector3((float)(i % 32), 0.0f, (float)(i / 32)));
+
+        SharedPtr<JSComponent> component = componentFile->CreateJSComponent();
+        node->AddComponent(component, component->GetID(), LOCAL);
+        component->InitInstance();
+    }
+
+    // The first update runs the script start functions
+    scene->Update(1.0f / 60.0f);
+
+    PODVector<float> samples;
+    HiresTimer timer;
+
+    for (unsigned i = 0; i < JAVASCRIPT_NUM_FRAMES; ++i)
+    {
+        timer.Reset();
+        scene->Update(1.0f / 60.0f);
+        samples.Push(timer.GetUSec(false) / 1000.0f);
+    }
+
+    ReportSamples("Javascript", ToString("ComponentUpdate,nodes=%u", JAVASCRIPT_NUM_NODES), samples);
+
+    scene->RemoveAllChildren();
+
+    if (WritePrefabResource(engineContext, resourceDir, componentFile))
+    {
+        RunPrefabCase(scene, false);
+        RunPrefabCase(scene, true);
+    }
+    else
+        PrintLine("Failed to write benchmark prefab", true);
+
+    // Script objects hold references to the scene, so release the scene and the VM before the Javascript subsystem
+    scene.Reset();
+    vm.Reset();
+    engineContext->RemoveSubsystem<Javascript>();
+}
+
+#endif
+
+}
@@ -0,0 +1,119 @@
+//
+// Copyright (c) 2014-2017 THUNDERBEAST GAMES LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <Atomic/Core/ProcessUtils.h>
+#include <Atomic/Core/Timer.h>
+#include <Atomic/Engine/Engine.h>
+#include <Atomic/Math/Random.h>
+#include <Atomic/Scene/Scene.h>
+
+#if defined(ATOMIC_NAVIGATION) && defined(ATOMIC_PHYSICS)
+#include <Atomic/Navigation/Navigable.h>
+#include <Atomic/Navigation/NavigationMesh.h>
+#include <Atomic/Physics/CollisionShape.h>
+#endif
+
+#include "Benchmark.h"
+
+namespace Atomic
+{
+
+// Geometry comes from collision shapes, as there are no model resources to build from in headless mode
+#if defined(ATOMIC_NAVIGATION) && defined(ATOMIC_PHYSICS)
+
+static const float NAVIGATION_EXTENT = 100.0f;
+static const unsigned NAVIGATION_NUM_OBSTACLES = 400;
+static const unsigned NAVIGATION_NUM_BUILDS = 3;
+static const unsigned NAVIGATION_NUM_FRAMES = 120;
+static const unsigned NAVIGATION_QUERIES_PER_FRAME = 50;
+
+void RunNavigationBenchmark(Context* context)
+{
+    SharedPtr<Context> engineContext(new Context());
+    SharedPtr<Engine> engine = CreateHeadlessEngine(engineContext);
+    if (!engine)
+        return;
+
+    SharedPtr<Scene> scene(new Scene(engineContext));
+    Node* level = scene->CreateChild("Level");
+    level->CreateComponent<Navigable>();
+
+    Node* ground = level->CreateChild("Ground");
+    ground->SetPosition(Vector3(0.0f, -0.5f, 0.0f));
+    ground->CreateComponent<CollisionShape>()->SetBox(Vector3(NAVIGATION_EXTENT * 2.0f, 1.0f, NAVIGATION_EXTENT * 2.0f));
+
+    SetRandomSeed(1);
+    for (unsigned i = 0; i < NAVIGATION_NUM_OBSTACLES; ++i)
+    {
+        Node* obstacle = level->CreateChild("Obstacle");
+        obstacle->SetPosition(Vector3(Random(-NAVIGATION_EXTENT, NAVIGATION_EXTENT) * 0.95f, 1.0f,
+            Random(-NAVIGATION_EXTENT, NAVIGATION_EXTENT) * 0.95f));
+        obstacle->SetRotation(Quaternion(Random(360.0f), Vector3::UP));
+        obstacle->CreateComponent<CollisionShape>()->SetBox(Vector3(Random(2.0f, 6.0f), 2.0f, Random(2.0f, 6.0f)));
+    }
+
+    NavigationMesh* navMesh = scene->CreateComponent<NavigationMesh>();
+
+    PODVector<float> buildSamples;
+    HiresTimer timer;
+
+    for (unsigned i = 0; i < NAVIGATION_NUM_BUILDS; ++i)
+    {
+        timer.Reset();
+        if (!navMesh->Build())
+        {
+            PrintLine("Failed to build navigation mesh", true);
+            return;
+        }
+        buildSamples.Push(timer.GetUSec(false) / 1000.0f);
+    }
+
+    ReportSamples("Navigation", "Build", buildSamples);
+
+    PODVector<Vector3> path;
+    unsigned numPathPoints = 0;
+    PODVector<float> querySamples;
+
+    SetRandomSeed(2);
+    for (unsigned i = 0; i < NAVIGATION_NUM_FRAMES; ++i)
+    {
+        timer.Reset();
+
+        for (unsigned j = 0; j < NAVIGATION_QUERIES_PER_FRAME; ++j)
+        {
+            Vector3 start(Random(-NAVIGATION_EXTENT, NAVIGATION_EXTENT), 0.0f, Random(-NAVIGATION_EXTENT, NAVIGATION_EXTENT));
+            Vector3 end(Random(-NAVIGATION_EXTENT, NAVIGATION_EXTENT), 0.0f, Random(-NAVIGATION_EXTENT, NAVIGATION_EXTENT));
+            navMesh->FindPath(path, start, end, Vector3(5.0f, 2.0f, 5.0f));
+            numPathPoints += path.Size();
+        }
+
+        querySamples.Push(timer.GetUSec(false) / 1000.0f);
+    }
+
+    ReportSamples("Navigation", "FindPath", querySamples);
+    ReportValue("Navigation", "FindPath", "pointsPerPath", (double)numPathPoints / (NAVIGATION_NUM_FRAMES * NAVIGATION_QUERIES_PER_FRAME));
+}
+
+#endif
+
+}
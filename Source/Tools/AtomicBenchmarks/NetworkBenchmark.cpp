@@ -0,0 +1,297 @@
+//
+// Copyright (c) 2014-2017 THUNDERBEAST GAMES LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <Atomic/Core/ProcessUtils.h>
+#include <Atomic/Core/StringUtils.h>
+#include <Atomic/Core/Timer.h>
+#include <Atomic/Core/WorkQueue.h>
+#include <Atomic/Engine/Engine.h>
+#include <Atomic/Math/Random.h>
+#include <Atomic/Scene/Scene.h>
+#include <Atomic/Scene/SmoothedTransform.h>
+
+#ifdef ATOMIC_NETWORK
+#include <Atomic/Network/Connection.h>
+#include <Atomic/Network/Network.h>
+#endif
+
+#include "Benchmark.h"
+
+namespace Atomic
+{
+
+#ifdef ATOMIC_NETWORK
+
+static const unsigned short NETWORK_PORT = 23451;
+static const unsigned NETWORK_NUM_CLIENTS = 4;
+static const unsigned NETWORK_NUM_NODES = 1000;
+static const unsigned NETWORK_NUM_FRAMES = 300;
+static const unsigned NETWORK_SCALING_FRAMES = 120;
+static const unsigned NETWORK_INTEREST_NODES = 10000;
+static const unsigned NETWORK_INTEREST_CLIENTS = 16;
+static const float NETWORK_INTEREST_RADIUS = 20.0f;
+static const unsigned NETWORK_POSITION_BITS = 20;
+static const float NETWORK_PACKET_LOSS = 0.1f;
+static const unsigned NETWORK_CONNECT_TIMEOUT = 10000;
+static const float NETWORK_TIMESTEP = 1.0f / 60.0f;
+
+/// Headless client engine with its own context and scene.
+struct NetworkBenchmarkClient
+{
+    SharedPtr<Context> context_;
+    SharedPtr<Engine> engine_;
+    SharedPtr<Scene> scene_;
+};
+
+static bool IsClientReady(const NetworkBenchmarkClient& client)
+{
+    Connection* connection = client.context_->GetSubsystem<Network>()->GetServerConnection();
+    return connection && connection->IsSceneLoaded();
+}
+
+static void UpdateClients(Vector<NetworkBenchmarkClient>& clients)
+{
+    for (unsigned i = 0; i < clients.Size(); ++i)
+    {
+        Network* network = clients[i].context_->GetSubsystem<Network>();
+        network->Update(NETWORK_TIMESTEP);
+        network->PostUpdate(NETWORK_TIMESTEP);
+    }
+}
+
+/// Return the mean distance of the replicated node positions, before smoothing, from the server node positions.
+static float GetPositionError(const PODVector<Node*>& nodes, Scene* clientScene)
+{
+    float error = 0.0f;
+    for (unsigned i = 0; i < nodes.Size(); ++i)
+    {
+        Node* node = clientScene->GetNode(nodes[i]->GetID());
+        if (!node)
+            continue;
+
+        SmoothedTransform* transform = node->GetComponent<SmoothedTransform>();
+        Vector3 position = transform ? transform->GetTargetPosition() : node->GetPosition();
+        error += (position - nodes[i]->GetPosition()).Length();
+    }
+
+    return nodes.Size() ? error / nodes.Size() : 0.0f;
+}
+
+static void UpdateServer(Network* network, Scene* scene)
+{
+    network->Update(NETWORK_TIMESTEP);
+
+    // Assign the scene to newly connected clients, which starts replication
+    Vector<SharedPtr<Connection> > connections = network->GetClientConnections();
+    for (unsigned i = 0; i < connections.Size(); ++i)
+    {
+        if (!connections[i]->GetScene())
+            connections[i]->SetScene(scene);
+    }
+
+    network->PostUpdate(NETWORK_TIMESTEP);
+}
+
+/// Replicate moving nodes to loopback clients and report the server and client update times. The case index selects a separate port.
+/// The nodes cover an area that grows with their count, so that a non-zero interest radius keeps the nodes per client constant.
+/// When quantized, node positions are replicated as fixed point values within the area instead of full precision floats.
+/// With packet loss, the mean distance of the first client's node positions from the server's is reported as well.
+static void RunReplicationCase(unsigned caseIndex, unsigned numClients, unsigned numNodes, bool threaded, float interestRadius,
+    bool quantized, float packetLoss, bool snapshot, unsigned numFrames, bool reportClients)
+{
+    float extent = 100.0f * Sqrt((float)numNodes / (float)NETWORK_NUM_NODES);
+    AttributeNetEncoding positionEncoding;
+    if (quantized)
+        positionEncoding = AttributeNetEncoding(NET_ENCODING_FIXED, NETWORK_POSITION_BITS, -2.0f * extent, 2.0f * extent);
+
+    SharedPtr<Context> serverContext(new Context());
+    SharedPtr<Engine> serverEngine = CreateHeadlessEngine(serverContext);
+    if (!serverEngine)
+        return;
+
+    Network* serverNetwork = serverContext->GetSubsystem<Network>();
+    serverNetwork->SetUpdateFps(60);
+    serverNetwork->SetServerUpdateThreaded(threaded);
+    serverNetwork->SetInterestRadius(interestRadius);
+    serverNetwork->SetSnapshotReplication(snapshot);
+    unsigned short port = (unsigned short)(NETWORK_PORT + caseIndex);
+    if (!serverNetwork->StartServer(port, kNet::SocketOverUDP))
+    {
+        PrintLine(ToString("Failed to start server on port %d", port), true);
+        return;
+    }
+
+    SharedPtr<Scene> serverScene(new Scene(serverContext));
+    PODVector<Node*> nodes;
+    // Server and clients must agree on the encoding
+    serverContext->SetAttributeNetEncoding<Node>("Network Position", positionEncoding);
+
+    SetRandomSeed(1);
+    for (unsigned i = 0; i < numNodes; ++i)
+    {
+        Node* node = serverScene->CreateChild("Node");
+        node->SetPosition(Vector3(Random(-extent, extent), 0.0f, Random(-extent, extent)));
+        nodes.Push(node);
+    }
+
+    Vector<NetworkBenchmarkClient> clients(numClients);
+    for (unsigned i = 0; i < clients.Size(); ++i)
+    {
+        NetworkBenchmarkClient& client = clients[i];
+        client.context_ = new Context();
+        client.engine_ = CreateHeadlessEngine(client.context_);
+        if (!client.engine_)
+            return;
+        client.context_->SetAttributeNetEncoding<Node>("Network Position", positionEncoding);
+        client.scene_ = new Scene(client.context_);
+        client.context_->GetSubsystem<Network>()->Connect("127.0.0.1", port, kNet::SocketOverUDP, client.scene_);
+        // The observer position is sent with the client controls and selects the nodes of interest
+        Connection* connection = client.context_->GetSubsystem<Network>()->GetServerConnection();
+        if (connection)
+            connection->SetPosition(Vector3(Random(-extent, extent), 0.0f, Random(-extent, extent)));
+    }
+
+    // Wait until every client has joined the scene
+    HiresTimer timer;
+    unsigned numReady = 0;
+    while (numReady < clients.Size())
+    {
+        if (timer.GetUSec(false) > NETWORK_CONNECT_TIMEOUT * 1000LL)
+        {
+            PrintLine(ToString("Only %u of %u loopback clients connected", numReady, clients.Size()), true);
+            serverNetwork->StopServer();
+            return;
+        }
+
+        UpdateServer(serverNetwork, serverScene);
+        UpdateClients(clients);
+
+        numReady = 0;
+        for (unsigned i = 0; i < clients.Size(); ++i)
+        {
+            if (IsClientReady(clients[i]))
+                ++numReady;
+        }
+
+        Time::Sleep(1);
+    }
+
+    // Worker threads only take part when the update is threaded; the main thread always does
+    unsigned numThreads = threaded ? serverContext->GetSubsystem<WorkQueue>()->GetNumThreads() + 1 : 1;
+    String caseName = ToString("clients=%u,nodes=%u,threads=%u", numClients, numNodes, numThreads);
+    if (interestRadius > 0.0f)
+        caseName += ToString(",interestRadius=%g", interestRadius);
+    if (quantized)
+        caseName += ToString(",positionBits=%u", NETWORK_POSITION_BITS);
+    if (packetLoss > 0.0f)
+        caseName += ToString(",packetLoss=%g", packetLoss);
+    if (snapshot)
+        caseName += ",snapshot";
+    ReportValue("Network", "Connect," + caseName, "ms", timer.GetUSec(false) / 1000.0);
+
+    PODVector<float> serverSamples;
+    PODVector<float> clientSamples;
+    // Attribute updates are serialized once per tick for all clients when more than one client receives them
+    ReplicationFanout* fanout = serverNetwork->GetReplicationFanout();
+    double attributeBytes = 0.0;
+    double positionError = 0.0;
+
+    // Lose packets both ways only after joining, so that connecting takes the same time
+    serverNetwork->SetSimulatedPacketLoss(packetLoss);
+    for (unsigned i = 0; i < clients.Size(); ++i)
+        clients[i].context_->GetSubsystem<Network>()->SetSimulatedPacketLoss(packetLoss);
+
+    for (unsigned i = 0; i < numFrames; ++i)
+    {
+        // Move every node so that each update replicates all of them
+        for (unsigned j = 0; j < nodes.Size(); ++j)
+            nodes[j]->Translate(Vector3(Sin(i * 3.0f + j) * 0.1f, 0.0f, Cos(i * 3.0f + j) * 0.1f));
+
+        timer.Reset();
+        UpdateServer(serverNetwork, serverScene);
+        serverSamples.Push(timer.GetUSec(false) / 1000.0f);
+        if (fanout)
+            attributeBytes += fanout->GetEncodedSize();
+
+        timer.Reset();
+        UpdateClients(clients);
+        clientSamples.Push(timer.GetUSec(false) / 1000.0f / clients.Size());
+
+        if (packetLoss > 0.0f)
+            positionError += GetPositionError(nodes, clients[0].scene_);
+    }
+
+    ReportSamples("Network", "ServerUpdate," + caseName, serverSamples);
+    if (fanout && numClients > 1 && interestRadius <= 0.0f)
+        ReportValue("Network", "AttributeUpdates," + caseName, "bytesPerTick", attributeBytes / numFrames);
+    if (reportClients)
+    {
+        ReportSamples("Network", ToString("ClientUpdate,nodes=%u", NETWORK_NUM_NODES), clientSamples);
+        ReportValue("Network", "ClientUpdate", "replicatedNodes", clients[0].scene_->GetNumChildren());
+    }
+    if (interestRadius > 0.0f)
+        ReportValue("Network", "ReplicatedNodes," + caseName, "nodes", clients[0].scene_->GetNumChildren());
+    if (packetLoss > 0.0f)
+        ReportValue("Network", "PositionError," + caseName, "meanDistance", positionError / numFrames);
+
+    for (unsigned i = 0; i < clients.Size(); ++i)
+        clients[i].context_->GetSubsystem<Network>()->Disconnect();
+    serverNetwork->StopServer();
+}
+
+void RunNetworkBenchmark(Context* context)
+{
+    static const unsigned clientCounts[] = { 1, 2, 4, 8, 16 };
+
+    unsigned caseIndex = 0;
+    RunReplicationCase(caseIndex++, NETWORK_NUM_CLIENTS, NETWORK_NUM_NODES, true, 0.0f, false, 0.0f, false, NETWORK_NUM_FRAMES,
+        true);
+    // Same scene with quantized positions: compare the attribute update bytes per tick
+    RunReplicationCase(caseIndex++, NETWORK_NUM_CLIENTS, NETWORK_NUM_NODES, true, 0.0f, true, 0.0f, false, NETWORK_NUM_FRAMES,
+        false);
+
+    // Server tick time against client count, with the connections updated serially and in worker threads
+    for (unsigned i = 0; i < sizeof(clientCounts) / sizeof(clientCounts[0]); ++i)
+    {
+        RunReplicationCase(caseIndex++, clientCounts[i], NETWORK_NUM_NODES, false, 0.0f, false, 0.0f, false,
+            NETWORK_SCALING_FRAMES, false);
+        RunReplicationCase(caseIndex++, clientCounts[i], NETWORK_NUM_NODES, true, 0.0f, false, 0.0f, false,
+            NETWORK_SCALING_FRAMES, false);
+    }
+
+    // Large scene with interest management: each client only receives the nodes around its observer position
+    RunReplicationCase(caseIndex++, NETWORK_INTEREST_CLIENTS, NETWORK_NUM_NODES, true, NETWORK_INTEREST_RADIUS, false, 0.0f,
+        false, NETWORK_SCALING_FRAMES, false);
+    RunReplicationCase(caseIndex++, NETWORK_INTEREST_CLIENTS, NETWORK_INTEREST_NODES, true, NETWORK_INTEREST_RADIUS, false, 0.0f,
+        false, NETWORK_SCALING_FRAMES, false);
+
+    // Lossy link: reliable latest data messages against unreliable snapshots, compare how far behind the client falls
+    RunReplicationCase(caseIndex++, NETWORK_NUM_CLIENTS, NETWORK_NUM_NODES, true, 0.0f, false, NETWORK_PACKET_LOSS, false,
+        NETWORK_NUM_FRAMES, false);
+    RunReplicationCase(caseIndex++, NETWORK_NUM_CLIENTS, NETWORK_NUM_NODES, true, 0.0f, false, NETWORK_PACKET_LOSS, true,
+        NETWORK_NUM_FRAMES, false);
+}
+
+#endif
+
+}
@@ -0,0 +1,94 @@
+//
+// Copyright (c) 2014-2017 THUNDERBEAST GAMES LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <Atomic/Core/Timer.h>
+#include <Atomic/Engine/Engine.h>
+#include <Atomic/Math/Random.h>
+#include <Atomic/Scene/Scene.h>
+
+#ifdef ATOMIC_PHYSICS
+#include <Atomic/Physics/CollisionShape.h>
+#include <Atomic/Physics/PhysicsWorld.h>
+#include <Atomic/Physics/RigidBody.h>
+#endif
+
+#include "Benchmark.h"
+
+namespace Atomic
+{
+
+#ifdef ATOMIC_PHYSICS
+
+static const unsigned PHYSICS_GRID_SIZE = 10;
+static const unsigned PHYSICS_NUM_FRAMES = 600;
+
+void RunPhysicsBenchmark(Context* context)
+{
+    SharedPtr<Context> engineContext(new Context());
+    SharedPtr<Engine> engine = CreateHeadlessEngine(engineContext);
+    if (!engine)
+        return;
+
+    SharedPtr<Scene> scene(new Scene(engineContext));
+    PhysicsWorld* physicsWorld = scene->CreateComponent<PhysicsWorld>();
+
+    Node* ground = scene->CreateChild("Ground");
+    ground->SetPosition(Vector3(0.0f, -1.0f, 0.0f));
+    ground->CreateComponent<RigidBody>();
+    ground->CreateComponent<CollisionShape>()->SetBox(Vector3(200.0f, 2.0f, 200.0f));
+
+    // A grid of slightly offset boxes that fall, collide and settle into piles
+    SetRandomSeed(1);
+    for (unsigned y = 0; y < PHYSICS_GRID_SIZE; ++y)
+    {
+        for (unsigned z = 0; z < PHYSICS_GRID_SIZE; ++z)
+        {
+            for (unsigned x = 0; x < PHYSICS_GRID_SIZE; ++x)
+            {
+                Node* box = scene->CreateChild("Box");
+                box->SetPosition(Vector3(x * 1.5f - 7.0f + Random(-0.2f, 0.2f), y * 1.5f + 5.0f, z * 1.5f - 7.0f + Random(-0.2f, 0.2f)));
+                box->SetRotation(Quaternion(Random(360.0f), Vector3::UP));
+                RigidBody* body = box->CreateComponent<RigidBody>();
+                body->SetMass(1.0f);
+                body->SetFriction(0.75f);
+                box->CreateComponent<CollisionShape>()->SetBox(Vector3::ONE);
+            }
+        }
+    }
+
+    PODVector<float> samples;
+    HiresTimer timer;
+
+    for (unsigned i = 0; i < PHYSICS_NUM_FRAMES; ++i)
+    {
+        timer.Reset();
+        physicsWorld->Update(1.0f / 60.0f);
+        samples.Push(timer.GetUSec(false) / 1000.0f);
+    }
+
+    ReportSamples("Physics", "FallingBoxes", samples);
+}
+
+#endif
+
+}
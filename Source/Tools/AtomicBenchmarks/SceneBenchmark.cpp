@@ -0,0 +1,402 @@
+//
+// Copyright (c) 2014-2017 THUNDERBEAST GAMES LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <Atomic/Core/ProcessUtils.h>
+#include <Atomic/Core/StringUtils.h>
+#include <Atomic/Core/Timer.h>
+#include <Atomic/Engine/Engine.h>
+#include <Atomic/Graphics/Geometry.h>
+#include <Atomic/Graphics/Model.h>
+#include <Atomic/Graphics/Octree.h>
+#include <Atomic/Graphics/OctreeQuery.h>
+#include <Atomic/Graphics/StaticModel.h>
+#include <Atomic/IO/MemoryBuffer.h>
+#include <Atomic/IO/VectorBuffer.h>
+#include <Atomic/Math/Random.h>
+#include <Atomic/Scene/LogicComponent.h>
+#include <Atomic/Scene/Scene.h>
+
+#include "Benchmark.h"
+
+namespace Atomic
+{
+
+static const unsigned SCENE_NUM_GROUPS = 100;
+static const unsigned SCENE_NODES_PER_GROUP = 100;
+static const float SCENE_EXTENT = 500.0f;
+static const unsigned SCENE_NUM_FRAMES = 120;
+static const unsigned SCENE_NUM_REPEATS = 10;
+static const unsigned SCENE_QUERIES_PER_FRAME = 100;
+
+enum SceneFormat
+{
+    SCENE_BINARY = 0,
+    SCENE_XML,
+    SCENE_JSON,
+    SCENE_PACKED
+};
+
+static const char* sceneFormatNames[] =
+{
+    "Binary",
+    "XML",
+    "JSON",
+    "Packed"
+};
+
+/// Logic component that steers its node around a circle, standing in for per-agent gameplay logic.
+class BenchmarkAgent : public LogicComponent
+{
+    ATOMIC_OBJECT(BenchmarkAgent, LogicComponent);
+
+public:
+    /// Construct.
+    BenchmarkAgent(Context* context) :
+        LogicComponent(context),
+        angle_(0.0f)
+    {
+        SetUpdateEventMask(USE_UPDATE);
+    }
+
+    /// Steer towards the next point on the circle around the parent.
+    virtual void Update(float timeStep)
+    {
+        Node* node = GetNode();
+        Vector3 position = node->GetPosition();
+        float radius = Vector2(position.x_, position.z_).Length();
+
+        angle_ += timeStep * 30.0f;
+        Vector3 target(Cos(angle_) * radius, position.y_, Sin(angle_) * radius);
+        Vector3 velocity = (target - position) * 0.5f;
+        for (unsigned i = 0; i < 8; ++i)
+            velocity = velocity.Lerp((target - position - velocity).Normalized(), 0.1f);
+
+        node->SetPosition(position + velocity * timeStep);
+        node->SetRotation(Quaternion(angle_, Vector3::UP));
+    }
+
+private:
+    /// Current angle around the parent.
+    float angle_;
+};
+
+/// Create a unit box model without vertex data. Enough for octree insertion and bounding box queries in headless mode.
+static SharedPtr<Model> CreateBoxModel(Context* context)
+{
+    SharedPtr<Model> model(new Model(context));
+    model->SetNumGeometries(1);
+    model->SetNumGeometryLodLevels(0, 1);
+    model->SetGeometry(0, 0, new Geometry(context));
+    model->SetBoundingBox(BoundingBox(-0.5f, 0.5f));
+    return model;
+}
+
+/// Fill a scene with groups of boxes at deterministic random positions.
+static void CreateBenchmarkScene(Scene* scene, Model* model)
+{
+    SetRandomSeed(1);
+
+    scene->CreateComponent<Octree>()->SetSize(BoundingBox(-SCENE_EXTENT, SCENE_EXTENT), 8);
+
+    for (unsigned i = 0; i < SCENE_NUM_GROUPS; ++i)
+    {
+        Node* group = scene->CreateChild("Group");
+        group->SetPosition(Vector3(Random(-SCENE_EXTENT, SCENE_EXTENT), Random(-20.0f, 20.0f), Random(-SCENE_EXTENT, SCENE_EXTENT)) * 0.9f);
+
+        for (unsigned j = 0; j < SCENE_NODES_PER_GROUP; ++j)
+        {
+            Node* node = group->CreateChild(j == SCENE_NODES_PER_GROUP - 1 ? "Target" + String(i) : String("Box"));
+            node->SetPosition(Vector3(Random(-20.0f, 20.0f), Random(-5.0f, 5.0f), Random(-20.0f, 20.0f)));
+            node->SetRotation(Quaternion(Random(360.0f), Vector3::UP));
+            node->CreateComponent<StaticModel>()->SetModel(model);
+        }
+    }
+}
+
+static void RunCreateCase(Context* context, Model* model)
+{
+    PODVector<float> samples;
+    HiresTimer timer;
+
+    for (unsigned i = 0; i < SCENE_NUM_REPEATS; ++i)
+    {
+        timer.Reset();
+        SharedPtr<Scene> scene(new Scene(context));
+        CreateBenchmarkScene(scene, model);
+        samples.Push(timer.GetUSec(false) / 1000.0f);
+    }
+
+    ReportSamples("Scene", "Create", samples);
+}
+
+static void RunTransformCase(Scene* scene, bool batched)
+{
+    scene->SetTransformBatching(batched, true);
+
+    Octree* octree = scene->GetComponent<Octree>();
+    PODVector<Node*> groups;
+    scene->GetChildren(groups);
+    PODVector<Node*> nodes;
+    scene->GetChildren(nodes, true);
+
+    FrameInfo frame;
+    frame.timeStep_ = 1.0f / 60.0f;
+    frame.viewSize_ = IntVector2::ZERO;
+    frame.camera_ = 0;
+
+    // Insert the newly created drawables before timing
+    frame.frameNumber_ = 0;
+    octree->Update(frame);
+
+    PODVector<float> samples;
+    HiresTimer timer;
+
+    for (unsigned i = 0; i < SCENE_NUM_FRAMES; ++i)
+    {
+        timer.Reset();
+
+        // Rotate the groups, then resolve every world transform and reinsert the moved drawables as rendering would
+        for (unsigned j = 0; j < groups.Size(); ++j)
+            groups[j]->Yaw(1.0f);
+        if (batched)
+            scene->UpdateTransforms();
+        for (unsigned j = 0; j < nodes.Size(); ++j)
+            nodes[j]->GetWorldTransform();
+
+        frame.frameNumber_ = i + 1;
+        octree->Update(frame);
+
+        samples.Push(timer.GetUSec(false) / 1000.0f);
+    }
+
+    scene->SetTransformBatching(false);
+
+    ReportSamples("Scene", batched ? "TransformUpdateBatched" : "TransformUpdate", samples);
+}
+
+static void RunLogicCase(Scene* scene, bool parallel)
+{
+    PODVector<Node*> nodes;
+    scene->GetChildrenWithComponent<StaticModel>(nodes, true);
+
+    PODVector<BenchmarkAgent*> agents;
+    for (unsigned i = 0; i < nodes.Size(); ++i)
+    {
+        BenchmarkAgent* agent = nodes[i]->CreateComponent<BenchmarkAgent>(LOCAL);
+        agent->SetParallelUpdate(parallel);
+        agents.Push(agent);
+    }
+
+    PODVector<float> samples;
+    HiresTimer timer;
+
+    for (unsigned i = 0; i < SCENE_NUM_FRAMES; ++i)
+    {
+        timer.Reset();
+        scene->Update(1.0f / 60.0f);
+        samples.Push(timer.GetUSec(false) / 1000.0f);
+    }
+
+    for (unsigned i = 0; i < agents.Size(); ++i)
+        agents[i]->Remove();
+
+    ReportSamples("Scene", parallel ? "LogicUpdateParallel" : "LogicUpdate", samples);
+}
+
+static void RunQueryCase(Scene* scene)
+{
+    Octree* octree = scene->GetComponent<Octree>();
+    PODVector<Drawable*> drawables;
+    PODVector<RayQueryResult> rayResults;
+    unsigned numResults = 0;
+
+    SetRandomSeed(2);
+
+    PODVector<float> samples;
+    HiresTimer timer;
+
+    for (unsigned i = 0; i < SCENE_NUM_FRAMES; ++i)
+    {
+        timer.Reset();
+
+        for (unsigned j = 0; j < SCENE_QUERIES_PER_FRAME; ++j)
+        {
+            Vector3 center(Random(-SCENE_EXTENT, SCENE_EXTENT), Random(-20.0f, 20.0f), Random(-SCENE_EXTENT, SCENE_EXTENT));
+
+            drawables.Clear();
+            BoxOctreeQuery boxQuery(drawables, BoundingBox(center - Vector3(25.0f, 25.0f, 25.0f), center + Vector3(25.0f, 25.0f, 25.0f)),
+                DRAWABLE_GEOMETRY);
+            octree->GetDrawables(boxQuery);
+
+            rayResults.Clear();
+            Vector3 direction(Random(-1.0f, 1.0f), Random(-0.1f, 0.1f), Random(-1.0f, 1.0f));
+            RayOctreeQuery rayQuery(rayResults, Ray(center, direction.Normalized()), RAY_AABB, 250.0f, DRAWABLE_GEOMETRY);
+            octree->Raycast(rayQuery);
+
+            numResults += drawables.Size() + rayResults.Size();
+        }
+
+        samples.Push(timer.GetUSec(false) / 1000.0f);
+    }
+
+    ReportSamples("Scene", "OctreeQuery", samples);
+    ReportValue("Scene", "OctreeQuery", "resultsPerFrame", (double)numResults / SCENE_NUM_FRAMES);
+}
+
+static void RunLookupCase(Scene* scene, bool indexed)
+{
+    scene->SetIndexingEnabled(indexed);
+
+    PODVector<Node*> nodes;
+    unsigned numResults = 0;
+
+    SetRandomSeed(3);
+
+    PODVector<float> samples;
+    HiresTimer timer;
+
+    for (unsigned i = 0; i < SCENE_NUM_FRAMES; ++i)
+    {
+        timer.Reset();
+
+        // Name lookups from the root as scripts do, plus one full component gather per frame
+        for (unsigned j = 0; j < SCENE_QUERIES_PER_FRAME; ++j)
+        {
+            if (scene->GetChild("Target" + String(Rand() % SCENE_NUM_GROUPS), true))
+                ++numResults;
+        }
+
+        scene->GetChildrenWithComponent<StaticModel>(nodes, true);
+        numResults += nodes.Size();
+
+        samples.Push(timer.GetUSec(false) / 1000.0f);
+    }
+
+    scene->SetIndexingEnabled(false);
+
+    String name = indexed ? "LookupIndexed" : "Lookup";
+    ReportSamples("Scene", name, samples);
+    ReportValue("Scene", name, "resultsPerFrame", (double)numResults / SCENE_NUM_FRAMES);
+}
+
+static bool SaveScene(Scene* scene, SceneFormat format, VectorBuffer& dest)
+{
+    switch (format)
+    {
+    case SCENE_XML:
+        return scene->SaveXML(dest);
+
+    case SCENE_JSON:
+        return scene->SaveJSON(dest);
+
+    case SCENE_PACKED:
+        return scene->SavePacked(dest);
+
+    default:
+        return scene->Save(dest);
+    }
+}
+
+static bool LoadScene(Scene* scene, SceneFormat format, MemoryBuffer& source)
+{
+    switch (format)
+    {
+    case SCENE_XML:
+        return scene->LoadXML(source);
+
+    case SCENE_JSON:
+        return scene->LoadJSON(source);
+
+    // Binary and packed binary scenes are told apart by the file ID
+    default:
+        return scene->Load(source);
+    }
+}
+
+static void RunSerializationCase(Context* context, Scene* scene, SceneFormat format)
+{
+    String formatName = sceneFormatNames[format];
+    VectorBuffer buffer;
+    PODVector<float> saveSamples;
+    PODVector<float> loadSamples;
+    HiresTimer timer;
+
+    for (unsigned i = 0; i < SCENE_NUM_REPEATS; ++i)
+    {
+        buffer.Clear();
+        timer.Reset();
+        if (!SaveScene(scene, format, buffer))
+        {
+            PrintLine("Failed to save scene as " + formatName, true);
+            return;
+        }
+        saveSamples.Push(timer.GetUSec(false) / 1000.0f);
+    }
+
+    for (unsigned i = 0; i < SCENE_NUM_REPEATS; ++i)
+    {
+        SharedPtr<Scene> loaded(new Scene(context));
+        MemoryBuffer source(buffer.GetData(), buffer.GetSize());
+        timer.Reset();
+        if (!LoadScene(loaded, format, source))
+        {
+            PrintLine("Failed to load scene from " + formatName, true);
+            return;
+        }
+        loadSamples.Push(timer.GetUSec(false) / 1000.0f);
+    }
+
+    ReportSamples("Scene", "Save" + formatName, saveSamples);
+    ReportValue("Scene", "Save" + formatName, "bytes", buffer.GetSize());
+    ReportSamples("Scene", "Load" + formatName, loadSamples);
+}
+
+void RunSceneBenchmark(Context* context)
+{
+    SharedPtr<Context> engineContext(new Context());
+    SharedPtr<Engine> engine = CreateHeadlessEngine(engineContext);
+    if (!engine)
+        return;
+
+    engineContext->RegisterFactory<BenchmarkAgent>();
+
+    SharedPtr<Model> model = CreateBoxModel(engineContext);
+    RunCreateCase(engineContext, model);
+
+    SharedPtr<Scene> scene(new Scene(engineContext));
+    CreateBenchmarkScene(scene, model);
+
+    RunTransformCase(scene, false);
+    RunTransformCase(scene, true);
+    RunLogicCase(scene, false);
+    RunLogicCase(scene, true);
+    RunQueryCase(scene);
+    RunLookupCase(scene, false);
+    RunLookupCase(scene, true);
+    RunSerializationCase(engineContext, scene, SCENE_BINARY);
+    RunSerializationCase(engineContext, scene, SCENE_XML);
+    RunSerializationCase(engineContext, scene, SCENE_JSON);
+    RunSerializationCase(engineContext, scene, SCENE_PACKED);
+}
+
+}
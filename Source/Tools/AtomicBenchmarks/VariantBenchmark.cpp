@@ -0,0 +1,190 @@
+//
+// Copyright (c) 2014-2017 THUNDERBEAST GAMES LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+
+#include <Atomic/Core/StringUtils.h>
+#include <Atomic/Core/Timer.h>
+#include <Atomic/IO/VectorBuffer.h>
+
+#include "Benchmark.h"
+
+namespace Atomic
+{
+
+static const unsigned VARIANT_NUM_ITERATIONS = 10000;
+static const unsigned VARIANT_NUM_SAMPLES = 20;
+static const unsigned VARIANT_NUM_RECEIVERS = 4;
+
+static const StringHash VARIANT_EVENT("VariantBenchmark");
+
+/// Parameter keys of the benchmark events and maps.
+static const StringHash variantBenchmarkKeys[] =
+{
+    StringHash("Param0"),
+    StringHash("Param1"),
+    StringHash("Param2"),
+    StringHash("Param3"),
+    StringHash("Param4"),
+    StringHash("Param5"),
+    StringHash("Param6"),
+    StringHash("Param7")
+};
+
+/// Receiver of the benchmark events.
+class VariantBenchmarkReceiver : public Object
+{
+    ATOMIC_OBJECT(VariantBenchmarkReceiver, Object)
+
+public:
+    /// Construct.
+    VariantBenchmarkReceiver(Context* context) :
+        Object(context),
+        sum_(0)
+    {
+    }
+
+    /// Handle the benchmark event.
+    void HandleEvent(StringHash eventType, VariantMap& eventData)
+    {
+        sum_ += eventData[variantBenchmarkKeys[0]].GetInt();
+    }
+
+    /// Accumulated first parameter.
+    int sum_;
+};
+
+/// Fill a map with integer, float, vector, string and matrix parameters.
+template <class T> static void FillVariantMap(T& map, unsigned numParams, int value)
+{
+    for (unsigned i = 0; i < numParams; ++i)
+    {
+        switch (i % 4)
+        {
+        case 0:
+            map[variantBenchmarkKeys[i]] = value;
+            break;
+
+        case 1:
+            map[variantBenchmarkKeys[i]] = (float)value;
+            break;
+
+        case 2:
+            map[variantBenchmarkKeys[i]] = Vector3((float)value, 0.0f, 0.0f);
+            break;
+
+        case 3:
+            map[variantBenchmarkKeys[i]] = Matrix3x4::IDENTITY;
+            break;
+        }
+    }
+}
+
+static void RunSendEventCase(Context* context, unsigned numParams)
+{
+    SharedPtr<Object> sender(new VariantBenchmarkReceiver(context));
+    Vector<SharedPtr<VariantBenchmarkReceiver> > receivers;
+    for (unsigned i = 0; i < VARIANT_NUM_RECEIVERS; ++i)
+    {
+        SharedPtr<VariantBenchmarkReceiver> receiver(new VariantBenchmarkReceiver(context));
+        receiver->SubscribeToEvent(sender, VARIANT_EVENT, new EventHandlerImpl<VariantBenchmarkReceiver>(receiver,
+            &VariantBenchmarkReceiver::HandleEvent));
+        receivers.Push(receiver);
+    }
+
+    PODVector<float> samples;
+    HiresTimer timer;
+
+    for (unsigned sample = 0; sample < VARIANT_NUM_SAMPLES; ++sample)
+    {
+        timer.Reset();
+        for (unsigned i = 0; i < VARIANT_NUM_ITERATIONS; ++i)
+        {
+            // A fresh map per event, as in code that does not use GetEventDataMap()
+            VariantMap eventData;
+            FillVariantMap(eventData, numParams, i);
+            sender->SendEvent(VARIANT_EVENT, eventData);
+        }
+        samples.Push(timer.GetUSec(false) / 1000.0f);
+    }
+
+    ReportSamples("Variant", ToString("case=SendEvent,params=%u,receivers=%u,iterations=%u", numParams, VARIANT_NUM_RECEIVERS,
+        VARIANT_NUM_ITERATIONS), samples);
+}
+
+template <class T> static void RunBuildMapCase(const char* mapName, unsigned numParams)
+{
+    PODVector<float> samples;
+    HiresTimer timer;
+    unsigned checksum = 0;
+
+    for (unsigned sample = 0; sample < VARIANT_NUM_SAMPLES; ++sample)
+    {
+        timer.Reset();
+        for (unsigned i = 0; i < VARIANT_NUM_ITERATIONS; ++i)
+        {
+            T map;
+            FillVariantMap(map, numParams, i);
+            checksum += map.Size();
+        }
+        samples.Push(timer.GetUSec(false) / 1000.0f);
+    }
+
+    ReportSamples("Variant", ToString("case=BuildMap,map=%s,params=%u,iterations=%u,checksum=%u", mapName, numParams,
+        VARIANT_NUM_ITERATIONS, checksum), samples);
+}
+
+static void RunWriteVariantMapCase(unsigned numParams)
+{
+    VariantMap map;
+    FillVariantMap(map, numParams, 1);
+
+    VectorBuffer buffer;
+    PODVector<float> samples;
+    HiresTimer timer;
+
+    for (unsigned sample = 0; sample < VARIANT_NUM_SAMPLES; ++sample)
+    {
+        timer.Reset();
+        for (unsigned i = 0; i < VARIANT_NUM_ITERATIONS; ++i)
+        {
+            buffer.Clear();
+            buffer.WriteVariantMap(map);
+        }
+        samples.Push(timer.GetUSec(false) / 1000.0f);
+    }
+
+    ReportSamples("Variant", ToString("case=WriteVariantMap,params=%u,iterations=%u", numParams, VARIANT_NUM_ITERATIONS), samples);
+}
+
+void RunVariantBenchmark(Context* context)
+{
+    for (unsigned numParams = 4; numParams <= 8; numParams += 4)
+    {
+        RunBuildMapCase<HashMap<StringHash, Variant> >("HashMap", numParams);
+        RunBuildMapCase<VariantMap>("VariantMap", numParams);
+        RunSendEventCase(context, numParams);
+        RunWriteVariantMapCase(numParams);
+    }
+}
+
+}
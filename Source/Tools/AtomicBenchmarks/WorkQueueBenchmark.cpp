@@ -0,0 +1,127 @@
+//
+// Copyright (c) 2014-2017 THUNDERBEAST GAMES LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <Atomic/Core/ProcessUtils.h>
+#include <Atomic/Core/StringUtils.h>
+#include <Atomic/Core/Timer.h>
+#include <Atomic/Core/WorkQueue.h>
+#include <Atomic/Math/MathDefs.h>
+
+#include "Benchmark.h"
+
+namespace Atomic
+{
+
+static const unsigned WORKQUEUE_NUM_ELEMENTS = 1024 * 1024;
+static const unsigned WORKQUEUE_NUM_ITEMS = 256;
+static const unsigned WORKQUEUE_NUM_FRAMES = 200;
+
+static void WorkQueueBenchmarkWork(const WorkItem* item, unsigned threadIndex)
+{
+    float* start = reinterpret_cast<float*>(item->start_);
+    float* end = reinterpret_cast<float*>(item->end_);
+
+    while (start != end)
+    {
+        *start = Sqrt(*start * 0.5f + 1.0f) + Sin(*start);
+        ++start;
+    }
+}
+
+static void RunParallelForCase(Context* context, unsigned numThreads, PODVector<float>& data)
+{
+    SharedPtr<WorkQueue> queue(new WorkQueue(context));
+    if (numThreads)
+        queue->CreateThreads(numThreads);
+
+    PODVector<float> samples;
+    HiresTimer timer;
+
+    for (unsigned frame = 0; frame < WORKQUEUE_NUM_FRAMES; ++frame)
+    {
+        timer.Reset();
+
+        queue->ParallelFor(0, data.Size(), 0, [&data](unsigned begin, unsigned end, unsigned threadIndex)
+        {
+            for (unsigned i = begin; i < end; ++i)
+                data[i] = Sqrt(data[i] * 0.5f + 1.0f) + Sin(data[i]);
+        });
+
+        samples.Push(timer.GetUSec(false) / 1000.0f);
+    }
+
+    ReportSamples("WorkQueue", ToString("threads=%u,parallelFor=true", numThreads), samples);
+}
+
+static void RunWorkQueueCase(Context* context, unsigned numThreads, bool workStealing, PODVector<float>& data)
+{
+    SharedPtr<WorkQueue> queue(new WorkQueue(context));
+    if (numThreads)
+        queue->CreateThreads(numThreads);
+    queue->SetWorkStealing(workStealing);
+
+    PODVector<float> samples;
+    HiresTimer timer;
+    unsigned elementsPerItem = data.Size() / WORKQUEUE_NUM_ITEMS;
+
+    for (unsigned frame = 0; frame < WORKQUEUE_NUM_FRAMES; ++frame)
+    {
+        timer.Reset();
+
+        float* start = &data[0];
+        for (unsigned i = 0; i < WORKQUEUE_NUM_ITEMS; ++i)
+        {
+            SharedPtr<WorkItem> item = queue->GetFreeItem();
+            item->priority_ = M_MAX_UNSIGNED;
+            item->workFunction_ = WorkQueueBenchmarkWork;
+            item->start_ = start;
+            item->end_ = start + elementsPerItem;
+            queue->AddWorkItem(item);
+            start += elementsPerItem;
+        }
+
+        queue->Complete(M_MAX_UNSIGNED);
+        samples.Push(timer.GetUSec(false) / 1000.0f);
+    }
+
+    ReportSamples("WorkQueue", ToString("threads=%u,stealing=%s", numThreads, workStealing ? "true" : "false"), samples);
+}
+
+void RunWorkQueueBenchmark(Context* context)
+{
+    PODVector<float> data(WORKQUEUE_NUM_ELEMENTS);
+    for (unsigned i = 0; i < data.Size(); ++i)
+        data[i] = (float)(i % 1000);
+
+    unsigned maxThreads = Max((int)GetNumLogicalCPUs() - 1, 0);
+
+    for (unsigned numThreads = 0; numThreads <= maxThreads; ++numThreads)
+    {
+        RunWorkQueueCase(context, numThreads, false, data);
+        if (numThreads)
+            RunWorkQueueCase(context, numThreads, true, data);
+        RunParallelForCase(context, numThreads, data);
+    }
+}
+
+}